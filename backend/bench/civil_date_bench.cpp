@@ -0,0 +1,137 @@
+// Benchmark for utils/civil_date against the std::get_time + mktime/gmtime
+// helpers the sales routes used before. Reports nanoseconds per call for
+// validating, parsing to a day number and formatting back to YYYY-MM-DD,
+// single-threaded (gmtime's shared buffer made the old path unsafe to run
+// concurrently anyway).
+//
+// Usage: CivilDateBench [dates=1000000] [rounds=5]
+#include "utils/civil_date.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    // The previous sales.cpp implementations, kept verbatim for comparison.
+    bool legacyIsValidDate(const std::string& date) {
+        std::tm tm = {};
+        std::istringstream ss(date);
+        ss >> std::get_time(&tm, "%Y-%m-%d");
+        if (ss.fail()) return false;
+        tm.tm_isdst = -1;
+        std::time_t t = std::mktime(&tm);
+        if (t == -1) return false;
+        std::tm check = *std::gmtime(&t);
+        return check.tm_year == tm.tm_year && check.tm_mon == tm.tm_mon && check.tm_mday == tm.tm_mday;
+    }
+
+    std::time_t legacyToTimeT(const std::string& date) {
+        std::tm tm = {};
+        std::istringstream ss(date);
+        ss >> std::get_time(&tm, "%Y-%m-%d");
+        tm.tm_isdst = -1;
+        return std::mktime(&tm);
+    }
+
+    std::string legacyToDateString(std::time_t t) {
+        std::tm tm = *std::gmtime(&t);
+        char buf[11];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+        return std::string(buf);
+    }
+
+    template <typename F>
+    double nsPerCall(size_t calls, size_t rounds, F&& body) {
+        double best = 1e300;
+        for (size_t r = 0; r < rounds; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            if (ns < best) best = ns;
+        }
+        return best / calls;
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const size_t rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+
+    // Sale dates over 2000-2030, plus 5% malformed or impossible ones.
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> day(daysFromCivil({2000, 1, 1}), daysFromCivil({2030, 12, 31}));
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<std::string> dates(n);
+    for (auto& d : dates) {
+        d = toDateString(day(rng));
+        if (percent(rng) < 5) d[8] = '3', d[9] = '9';
+    }
+
+    std::vector<int> days(n);
+    for (size_t i = 0; i < n; ++i) days[i] = day(rng);
+    std::vector<std::time_t> times(n);
+    for (size_t i = 0; i < n; ++i) times[i] = static_cast<std::time_t>(days[i]) * 86400;
+
+    volatile long sink = 0;
+
+    std::printf("%-10s %14s %14s %9s\n", "operation", "legacy ns/call", "civil ns/call", "speedup");
+    auto report = [](const char* name, double legacy, double civil) {
+        std::printf("%-10s %14.1f %14.1f %8.1fx\n", name, legacy, civil, legacy / civil);
+    };
+
+    double legacy = nsPerCall(n, rounds, [&] {
+        long valid = 0;
+        for (const auto& d : dates) valid += legacyIsValidDate(d);
+        sink = sink + valid;
+    });
+    double civil = nsPerCall(n, rounds, [&] {
+        long valid = 0;
+        for (const auto& d : dates) valid += isValidDate(d);
+        sink = sink + valid;
+    });
+    report("validate", legacy, civil);
+
+    legacy = nsPerCall(n, rounds, [&] {
+        long total = 0;
+        for (const auto& d : dates) total += static_cast<long>(legacyToTimeT(d) / 86400);
+        sink = sink + total;
+    });
+    civil = nsPerCall(n, rounds, [&] {
+        long total = 0;
+        for (const auto& d : dates) {
+            if (auto date = parseDate(d)) total += daysFromCivil(*date);
+        }
+        sink = sink + total;
+    });
+    report("parse", legacy, civil);
+
+    legacy = nsPerCall(n, rounds, [&] {
+        long total = 0;
+        for (std::time_t t : times) total += legacyToDateString(t)[9];
+        sink = sink + total;
+    });
+    civil = nsPerCall(n, rounds, [&] {
+        long total = 0;
+        for (int d : days) total += toDateString(d)[9];
+        sink = sink + total;
+    });
+    report("format", legacy, civil);
+
+    civil = nsPerCall(n, rounds, [&] {
+        long total = 0;
+        char buf[10];
+        for (int d : days) {
+            formatDate(civilFromDays(d), buf);
+            total += buf[9];
+        }
+        sink = sink + total;
+    });
+    std::printf("%-10s %14s %14.1f %9s\n", "format(buf)", "-", civil, "-");
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Throughput benchmark for customer lookups against a live database.
+// Compares three ways of serving GET /customers/<id>:
+//   legacy   - one dedicated connection per worker thread and an unprepared
+//              exec_params query, as the module did before CustomerRepository
+//              (its connections sat outside the pool's budget),
+//   held     - a pooled connection and the prepared statement, but the JSON
+//              is built while the connection is still held,
+//   released - CustomerRepository as the routes use it: the guard is dropped
+//              before the JSON is built.
+// With more workers than pooled connections the last two show what holding a
+// connection through serialization costs.
+//
+// Usage: CustomerRepositoryBench [conninfo] [threads=64] [requests=50000] [pool=20]
+#include "db/db_connection.h"
+#include "modules/customer/customer_repository.h"
+#include "external/crow/crow_all.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    std::string toJson(const Customer& c) {
+        crow::json::wvalue item;
+        item["id"] = c.id;
+        item["first_name"] = c.first_name;
+        item["last_name"] = c.last_name;
+        if (c.address.empty()) item["address"] = nullptr;
+        else item["address"] = c.address;
+        item["ph_number"] = c.ph_number;
+        item["email"] = c.email;
+        item["driving_licence"] = c.driving_licence;
+        return item.dump();
+    }
+
+    // Runs `request(thread, i)` `total` times over `threads` workers; returns requests per second.
+    double run(unsigned threads, size_t total, const std::function<void(unsigned, size_t)>& request) {
+        std::atomic<size_t> next{0};
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                for (size_t i; (i = next.fetch_add(1)) < total;) request(t, i);
+            });
+        }
+        for (auto& w : workers) w.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return total / seconds;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::string conninfo = argc > 1 ? argv[1]
+        : "host=localhost port=5432 dbname=dealerdrive user=dealerdrive password=dealerdrive";
+    const unsigned threads = argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 64;
+    const size_t requests = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 50000;
+    const int poolSize = argc > 4 ? std::atoi(argv[4]) : 20;
+
+    std::vector<std::string> ids;
+    {
+        pqxx::connection conn(conninfo);
+        pqxx::work txn(conn);
+        for (const auto& row : txn.exec("SELECT id FROM Customers LIMIT 1000")) ids.push_back(row[0].c_str());
+    }
+    if (ids.empty()) {
+        std::fprintf(stderr, "Customers table is empty; seed it first\n");
+        return 1;
+    }
+
+    std::atomic<size_t> bytes{0};
+
+    std::vector<std::unique_ptr<pqxx::connection>> dedicated;
+    for (unsigned t = 0; t < threads; ++t) dedicated.push_back(std::make_unique<pqxx::connection>(conninfo));
+    double legacy = run(threads, requests, [&](unsigned t, size_t i) {
+        pqxx::work txn(*dedicated[t]);
+        pqxx::result r = txn.exec_params(
+            "SELECT id, first_name, last_name, address, ph_number, email, driving_licence "
+            "FROM Customers WHERE id = $1", ids[i % ids.size()]);
+        txn.commit();
+        Customer c;
+        c.id = r[0]["id"].c_str();
+        c.first_name = r[0]["first_name"].c_str();
+        c.last_name = r[0]["last_name"].c_str();
+        c.address = r[0]["address"].is_null() ? "" : r[0]["address"].c_str();
+        c.ph_number = r[0]["ph_number"].c_str();
+        c.email = r[0]["email"].c_str();
+        c.driving_licence = r[0]["driving_licence"].c_str();
+        bytes += toJson(c).size();
+    });
+    dedicated.clear();
+
+    ConnectionPool pool(poolSize, conninfo);
+    double held = run(threads, requests, [&](unsigned, size_t i) {
+        ConnectionGuard guard(pool);
+        auto c = CustomerRepository(guard).getCustomerById(ids[i % ids.size()]);
+        bytes += toJson(*c).size();
+    });
+
+    double released = run(threads, requests, [&](unsigned, size_t i) {
+        std::optional<Customer> c;
+        {
+            ConnectionGuard guard(pool);
+            c = CustomerRepository(guard).getCustomerById(ids[i % ids.size()]);
+        }
+        bytes += toJson(*c).size();
+    });
+
+    std::printf("threads=%u requests=%zu pool=%d\n", threads, requests, poolSize);
+    std::printf("%-9s %12.0f req/s  (%u connections)\n", "legacy", legacy, threads);
+    std::printf("%-9s %12.0f req/s  (%d connections)\n", "held", held, poolSize);
+    std::printf("%-9s %12.0f req/s  (%d connections)\n", "released", released, poolSize);
+    std::printf("(%zu response bytes)\n", bytes.load());
+    return 0;
+}
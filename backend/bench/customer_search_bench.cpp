@@ -0,0 +1,105 @@
+// Benchmark for the in-memory customer search index. Builds the index from
+// synthetic customers, then reports per-query latency percentiles for name,
+// email and phone prefixes, misspelled names (the fuzzy path), and upserts.
+//
+// Usage: CustomerSearchBench [customers=500000] [queries=20000]
+#include "modules/customer/customer_search.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    const std::vector<std::string> FIRST = {"James", "Mary", "John", "Patricia", "Robert", "Jennifer", "Michael",
+                                            "Linda", "William", "Elizabeth", "David", "Barbara", "Richard", "Susan",
+                                            "Joseph", "Jessica", "Thomas", "Sarah", "Charles", "Karen", "Priya",
+                                            "Wei", "Mohammed", "Aisha", "Carlos", "Sofia", "Kuldeep", "Olga"};
+    const std::vector<std::string> LAST = {"Smith", "Johnson", "Williams", "Brown", "Jones", "Garcia", "Miller",
+                                           "Davis", "Rodriguez", "Martinez", "Hernandez", "Lopez", "Gonzalez",
+                                           "Wilson", "Anderson", "Thomas", "Taylor", "Moore", "Jackson", "Martin",
+                                           "Lee", "Thompson", "White", "Harris", "Singh", "Patel", "Nguyen", "Chen",
+                                           "Kowalski", "Okafor", "MacDonald", "Tremblay", "Gagnon", "Roy"};
+
+    std::string digits(std::mt19937& rng, int n) {
+        std::string out;
+        for (int i = 0; i < n; ++i) out += static_cast<char>('0' + rng() % 10);
+        return out;
+    }
+
+    Customer makeCustomer(std::mt19937& rng, size_t i) {
+        Customer c;
+        c.id = "c" + std::to_string(i);
+        c.first_name = FIRST[rng() % FIRST.size()];
+        // A numeric suffix on some surnames keeps the name space realistic in size.
+        c.last_name = LAST[rng() % LAST.size()] + (rng() % 4 == 0 ? "" : std::string(1, 'a' + rng() % 26));
+        c.email = c.first_name + "." + std::to_string(i) + "@example.com";
+        c.ph_number = "519" + digits(rng, 7);
+        c.driving_licence = "ON-" + digits(rng, 8);
+        return c;
+    }
+
+    // Drops one character, so "Johnson" becomes e.g. "Jonson".
+    std::string misspell(std::mt19937& rng, const std::string& word) {
+        std::string out = word;
+        out.erase(1 + rng() % (out.size() - 1), 1);
+        return out;
+    }
+
+    template <typename F>
+    void report(const char* label, size_t n, F&& op) {
+        std::vector<double> micros;
+        micros.reserve(n);
+        size_t results = 0;
+        for (size_t i = 0; i < n; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            results += op(i);
+            micros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(micros.begin(), micros.end());
+        auto at = [&](double q) { return micros[static_cast<size_t>(q * (micros.size() - 1))]; };
+        std::printf("%-14s p50 %8.1f us   p95 %8.1f us   p99 %8.1f us   avg hits %.1f\n",
+                    label, at(0.50), at(0.95), at(0.99), static_cast<double>(results) / n);
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t customers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+    const size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+    std::mt19937 rng(44);
+
+    std::vector<Customer> rows;
+    rows.reserve(customers);
+    for (size_t i = 0; i < customers; ++i) rows.push_back(makeCustomer(rng, i));
+
+    CustomerSearchIndex index;
+    auto start = std::chrono::steady_clock::now();
+    index.reload([&](const CustomerSearchIndex::Sink& sink) {
+        for (const auto& c : rows) sink(c);
+    });
+    std::printf("built index of %zu customers in %.0f ms\n", index.size(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    std::vector<std::string> names, emails, phones, typos;
+    for (size_t i = 0; i < queries; ++i) {
+        const Customer& c = rows[rng() % rows.size()];
+        names.push_back(c.last_name.substr(0, 3 + rng() % 3));
+        emails.push_back(c.email.substr(0, c.email.find('@')));
+        phones.push_back("(519) " + c.ph_number.substr(3, 3));
+        typos.push_back(misspell(rng, LAST[rng() % LAST.size()]));
+    }
+
+    report("name prefix", queries, [&](size_t i) { return index.search(names[i], 20).size(); });
+    report("email prefix", queries, [&](size_t i) { return index.search(emails[i], 20).size(); });
+    report("phone prefix", queries, [&](size_t i) { return index.search(phones[i], 20).size(); });
+    report("fuzzy name", queries, [&](size_t i) { return index.search(typos[i], 20).size(); });
+    report("upsert", queries, [&](size_t i) {
+        Customer c = rows[rng() % rows.size()];
+        c.last_name = LAST[i % LAST.size()];
+        index.upsert(c);
+        return size_t{0};
+    });
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Benchmark for upload variant generation. Encodes a synthetic photo-sized
+// JPEG, then times a full-size decode against libjpeg's scaled decode, the
+// area-averaging resize, and the whole card/gallery/full pipeline, and prints
+// the size of each variant next to the original.
+//
+// Usage: ImageVariantsBench [width=4032] [height=3024] [iterations=10] [dir=/tmp]
+#include "modules/images/image_variants.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    // Smooth gradients plus sensor-like noise, so the encoder sees something
+    // closer to a photo than a flat fill.
+    RgbImage syntheticPhoto(int width, int height) {
+        RgbImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(static_cast<size_t>(width) * height * 3);
+        std::mt19937 rng(49);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                uint8_t* px = image.pixels.data() + (static_cast<size_t>(y) * width + x) * 3;
+                const int noise = static_cast<int>(rng() % 17) - 8;
+                px[0] = static_cast<uint8_t>(std::clamp(x * 255 / width + noise, 0, 255));
+                px[1] = static_cast<uint8_t>(std::clamp(y * 255 / height + noise, 0, 255));
+                px[2] = static_cast<uint8_t>(std::clamp(((x / 64 + y / 64) % 2) * 160 + noise + 40, 0, 255));
+            }
+        }
+        return image;
+    }
+
+    template <typename F>
+    void report(const char* label, int iterations, F&& op) {
+        std::vector<double> millis;
+        for (int i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            op();
+            millis.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(millis.begin(), millis.end());
+        std::printf("%-22s median %8.1f ms   min %8.1f ms\n", label, millis[millis.size() / 2], millis.front());
+    }
+}
+
+int main(int argc, char** argv) {
+    const int width = argc > 1 ? std::atoi(argv[1]) : 4032;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 3024;
+    const int iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+    const std::string dir = std::string(argc > 4 ? argv[4] : "/tmp") + "/";
+    const std::string name = "image_variants_bench.jpg";
+
+    encodeJpegFile(dir + name, syntheticPhoto(width, height), 90);
+    std::printf("original %dx%d, %ju bytes\n", width, height,
+                static_cast<uintmax_t>(std::filesystem::file_size(dir + name)));
+
+    DecodedJpeg full = decodeJpegFile(dir + name);
+    report("decode full", iterations, [&] { decodeJpegFile(dir + name); });
+    report("decode scaled (>=1920)", iterations, [&] { decodeJpegFile(dir + name, 1920); });
+    report("resize full -> 320", iterations, [&] { resizeToWidth(full.image, 320); });
+    report("all variants", iterations, [&] { generateImageVariants(dir, name); });
+
+    for (const ImageVariantSpec& spec : IMAGE_VARIANTS) {
+        const std::string path = dir + variantFileName(name, spec.width);
+        if (!std::filesystem::exists(path)) continue;
+        std::printf("%-8s %5d px  %9ju bytes\n", spec.name, spec.width,
+                    static_cast<uintmax_t>(std::filesystem::file_size(path)));
+        std::filesystem::remove(path);
+    }
+    std::filesystem::remove(dir + name);
+    return 0;
+}
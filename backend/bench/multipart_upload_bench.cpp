@@ -0,0 +1,76 @@
+// Benchmark for image upload parsing. Builds a multipart body of several
+// phone-sized photos and handles it either the old way (crow::multipart
+// parses every part into memory, then each is written with std::ofstream) or
+// with UploadStaging (parts streamed to fsynced temp files). Reports time and
+// how far peak RSS grew beyond the request body itself. Peak RSS only grows,
+// so run one mode per process.
+//
+// Usage: MultipartUploadBench <crow|staging> [files=8] [mib_per_file=10] [dir=/tmp]
+#include "external/crow/crow_all.h"
+#include "modules/images/multipart_upload.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+
+namespace {
+    long peakRssKiB() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || (std::strcmp(argv[1], "crow") != 0 && std::strcmp(argv[1], "staging") != 0)) {
+        std::fprintf(stderr, "usage: %s <crow|staging> [files] [mib_per_file] [dir]\n", argv[0]);
+        return 1;
+    }
+    const bool staging = std::strcmp(argv[1], "staging") == 0;
+    const int files = argc > 2 ? std::atoi(argv[2]) : 8;
+    const size_t fileBytes = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10) << 20;
+    const std::string dir = std::string(argc > 4 ? argv[4] : "/tmp") + "/multipart_upload_bench/";
+    std::filesystem::create_directories(dir);
+
+    crow::request req;
+    req.add_header("Content-Type", "multipart/form-data; boundary=BenchBoundary");
+    std::mt19937 rng(50);
+    std::string photo(fileBytes, '\0');
+    for (char& c : photo) c = static_cast<char>(rng());
+    for (int i = 0; i < files; ++i) {
+        req.body += "--BenchBoundary\r\nContent-Disposition: form-data; name=\"file\"; filename=\"p" +
+                    std::to_string(i) + ".jpg\"\r\nContent-Type: image/jpeg\r\n\r\n";
+        req.body += photo;
+        req.body += "\r\n";
+    }
+    req.body += "--BenchBoundary--\r\n";
+    photo = std::string();
+
+    const long baseline = peakRssKiB();
+    auto start = std::chrono::steady_clock::now();
+    if (staging) {
+        UploadLimits limits{fileBytes + 1, req.body.size() + 1, static_cast<size_t>(files)};
+        UploadStaging stage(dir, limits);
+        stage.receive(req.body, "BenchBoundary");
+        std::vector<std::string> names;
+        for (int i = 0; i < files; ++i) names.push_back("p" + std::to_string(i) + ".jpg");
+        stage.publish(names);
+    } else {
+        crow::multipart::message message(req);
+        for (size_t i = 0; i < message.parts.size(); ++i) {
+            std::ofstream out(dir + "p" + std::to_string(i) + ".jpg", std::ios::binary);
+            out.write(message.parts[i].body.data(), message.parts[i].body.size());
+        }
+    }
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-8s %d x %zu MiB: %8.1f ms   peak RSS +%ld MiB over the %zu MiB body\n", argv[1], files,
+                fileBytes >> 20, ms, (peakRssKiB() - baseline) / 1024, req.body.size() >> 20);
+    std::filesystem::remove_all(dir);
+    return 0;
+}
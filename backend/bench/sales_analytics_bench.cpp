@@ -0,0 +1,91 @@
+// Benchmark for SalesFactTable: loads synthetic sales and reports aggregation
+// latency percentiles for a few typical dashboard queries.
+//
+// Usage: SalesAnalyticsBench [sales=10000000] [runs=50] [threads=0 (auto)]
+#include "modules/analytics/sales_facts.h"
+#include "utils/uuid.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    const size_t saleCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    const size_t runs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50;
+    const unsigned threads = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 0;
+
+    const std::vector<std::string> makes = {"Toyota", "Honda", "Ford", "Chevrolet", "Nissan",
+                                            "Hyundai", "Kia", "Mazda", "Subaru", "Volkswagen",
+                                            "BMW", "Audi", "Mercedes-Benz", "Lexus", "Tesla"};
+    const std::vector<std::string> fuels = {"Gasoline", "Diesel", "Electric", "Hybrid"};
+    const std::vector<std::string> transmissions = {"Manual", "Automatic", "CVT"};
+
+    std::mt19937 rng(7);
+    SalesFactTable table;
+
+    // Ten years of history in date order, as a real table would be appended.
+    auto loadStart = std::chrono::steady_clock::now();
+    table.reload([&](const SalesFactTable::Sink& sink) {
+        SaleFact fact;
+        char date[11];
+        for (size_t i = 0; i < saleCount; ++i) {
+            size_t dayIndex = i * 3650 / saleCount;
+            int year = 2016 + static_cast<int>(dayIndex / 365);
+            int month = static_cast<int>(dayIndex % 365 / 31) + 1;
+            int day = static_cast<int>(dayIndex % 31 % 28) + 1;
+            std::snprintf(date, sizeof(date), "%04d-%02d-%02d", year, std::min(month, 12), day);
+
+            size_t makeIndex = rng() % makes.size();
+            fact.saleId = newUuidV7();
+            fact.date = date;
+            fact.make = makes[makeIndex];
+            fact.model = makes[makeIndex] + " Model " + std::to_string(rng() % 12);
+            fact.fuelType = fuels[rng() % fuels.size()];
+            fact.transmission = transmissions[rng() % transmissions.size()];
+            fact.vehicleYear = 2005 + static_cast<int>(rng() % 20);
+            fact.marketPrice = 8000 + (rng() % 9000000) / 100.0;
+            fact.salePrice = fact.marketPrice * (0.85 + (rng() % 3000) / 10000.0);
+            sink(fact);
+        }
+    });
+    auto loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    std::cout << "Loaded " << table.size() << " sales in " << loadMs << " ms\n";
+
+    using D = SalesFactTable::Dimension;
+    struct Case {
+        const char* label;
+        SalesFactTable::Query query;
+    };
+    int32_t from2022 = 0, to2022 = 0;
+    SalesFactTable::dayNumber("2022-01-01", from2022);
+    SalesFactTable::dayNumber("2022-12-31", to2022);
+
+    std::vector<Case> cases = {
+        {"revenue by make by month", {{D::Make, D::Month}}},
+        {"margin by fuel type", {{D::FuelType}}},
+        {"year over year", {{D::SaleYear}}},
+        {"make x model x month, 2022 only", {{D::Make, D::Model, D::Month}, from2022, to2022}},
+    };
+
+    for (auto& c : cases) {
+        c.query.threads = threads;
+        std::vector<double> latencies;
+        size_t groups = 0, scanned = 0;
+        for (size_t i = 0; i < runs; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            auto result = table.aggregate(c.query);
+            latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            groups = result.groups.size();
+            scanned = result.scannedRows;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << c.label << ": " << groups << " groups, " << scanned << " rows"
+                  << "  p50 " << latencies[latencies.size() / 2] << " ms"
+                  << "  p99 " << latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] << " ms\n";
+    }
+    return 0;
+}
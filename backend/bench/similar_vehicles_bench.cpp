@@ -0,0 +1,76 @@
+// Benchmark for SimilarVehicleIndex: builds a synthetic inventory and reports
+// query latency percentiles on one core.
+//
+// Usage: SimilarVehiclesBench [vehicles=100000] [queries=5000] [k=10]
+#include "modules/inventory/similar_vehicles.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    const size_t vehicleCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    const size_t queryCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5000;
+    const size_t k = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10;
+
+    const std::vector<std::string> makes = {"Toyota", "Honda", "Ford", "Chevrolet", "Nissan",
+                                            "Hyundai", "Kia", "Mazda", "Subaru", "Volkswagen"};
+    const std::vector<std::string> models = {"Camry", "Civic", "Accord", "CR-V", "F-150",
+                                             "Escape", "RAV4", "Corolla", "CX-5", "Outback"};
+    const std::vector<std::string> fuels = {"Gasoline", "Diesel", "Electric", "Hybrid"};
+    const std::vector<std::string> transmissions = {"Manual", "Automatic", "CVT"};
+
+    std::mt19937 rng(42);
+    auto pick = [&](const std::vector<std::string>& v) { return v[rng() % v.size()]; };
+
+    SimilarVehicleIndex index;
+    std::vector<std::string> ids;
+    ids.reserve(vehicleCount);
+
+    auto buildStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < vehicleCount; ++i) {
+        VehicleFeatures v;
+        v.id = "vehicle-" + std::to_string(i);
+        v.make = pick(makes);
+        v.model = pick(models);
+        v.year = 2010 + static_cast<int>(rng() % 15);
+        v.odometer = static_cast<int>(rng() % 200000);
+        v.marketPrice = 10000 + static_cast<double>(rng() % 60000);
+        v.fuelType = pick(fuels);
+        v.transmission = pick(transmissions);
+        v.available = rng() % 10 < 7;
+        index.upsert(v);
+        ids.push_back(v.id);
+    }
+    auto buildEnd = std::chrono::steady_clock::now();
+
+    std::vector<double> latenciesUs;
+    latenciesUs.reserve(queryCount);
+    size_t checksum = 0;
+    for (size_t q = 0; q < queryCount; ++q) {
+        const std::string& id = ids[rng() % ids.size()];
+        bool found = false;
+        auto start = std::chrono::steady_clock::now();
+        auto matches = index.nearest(id, k, found);
+        auto end = std::chrono::steady_clock::now();
+        checksum += matches.size();
+        latenciesUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    auto percentile = [&](double p) {
+        return latenciesUs[static_cast<size_t>(p * (latenciesUs.size() - 1))];
+    };
+
+    std::cout << "vehicles: " << vehicleCount << ", queries: " << queryCount << ", k: " << k << "\n"
+              << "build: " << std::chrono::duration<double, std::milli>(buildEnd - buildStart).count() << " ms\n"
+              << "p50: " << percentile(0.50) << " us\n"
+              << "p90: " << percentile(0.90) << " us\n"
+              << "p99: " << percentile(0.99) << " us\n"
+              << "max: " << latenciesUs.back() << " us\n"
+              << "(matches returned: " << checksum << ")\n";
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Benchmark for TDigest against exact quantiles (percentile_cont semantics:
+// sort, then interpolate between the two nearest ranks). Reports build and
+// query time, rank error and memory for a single digest and for one merged
+// from monthly parts, the way GET /sales/distribution uses them.
+//
+// Usage: TDigestBench [values=1000000] [parts=120]
+#include "utils/tdigest.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+    double exactQuantile(const std::vector<double>& sorted, double q) {
+        double rank = q * (sorted.size() - 1);
+        size_t lo = static_cast<size_t>(rank);
+        if (lo + 1 >= sorted.size()) return sorted.back();
+        return sorted[lo] + (sorted[lo + 1] - sorted[lo]) * (rank - lo);
+    }
+
+    double rankError(const std::vector<double>& sorted, double q, double estimate) {
+        double rank = std::lower_bound(sorted.begin(), sorted.end(), estimate) - sorted.begin();
+        return std::fabs(rank / sorted.size() - q);
+    }
+
+    double msSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const size_t parts = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 120;
+    const double quantiles[] = {0.01, 0.1, 0.5, 0.9, 0.99};
+
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> uniform(5000, 90000);
+    std::normal_distribution<double> normal(30000, 8000);
+    std::lognormal_distribution<double> lognormal(10, 0.5);
+
+    const char* names[] = {"uniform", "normal", "log-normal"};
+    for (int dist = 0; dist < 3; ++dist) {
+        std::vector<double> values(n);
+        for (auto& v : values) v = dist == 0 ? uniform(rng) : dist == 1 ? normal(rng) : lognormal(rng);
+
+        auto start = std::chrono::steady_clock::now();
+        TDigest single;
+        for (double v : values) single.add(v);
+        single.compress();
+        double buildMs = msSince(start);
+
+        std::vector<TDigest> monthly(parts);
+        for (size_t i = 0; i < n; ++i) monthly[i % parts].add(values[i]);
+        for (auto& d : monthly) d.compress();
+
+        start = std::chrono::steady_clock::now();
+        TDigest merged;
+        for (const auto& d : monthly) merged.merge(d);
+        double mergeMs = msSince(start);
+
+        start = std::chrono::steady_clock::now();
+        std::vector<double> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        double exactMs = msSince(start);
+
+        std::printf("%s, n=%zu: build %.1f ms, merge of %zu parts %.2f ms, exact sort %.1f ms, "
+                    "%zu centroids, %zu bytes\n",
+                    names[dist], n, buildMs, parts, mergeMs, exactMs,
+                    single.centroidCount(), single.memoryBytes());
+        for (double q : quantiles) {
+            std::printf("  q=%.2f exact %10.2f  digest %10.2f (rank err %.4f%%)  merged %10.2f (rank err %.4f%%)\n",
+                        q, exactQuantile(sorted, q),
+                        single.quantile(q), 100 * rankError(sorted, q, single.quantile(q)),
+                        merged.quantile(q), 100 * rankError(sorted, q, merged.quantile(q)));
+        }
+    }
+    return 0;
+}
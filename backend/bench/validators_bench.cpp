@@ -0,0 +1,72 @@
+// Benchmark for utils/validators against the std::regex patterns the customer
+// module used before. Reports validations per second for phone, licence and
+// email inputs (a mix of valid and invalid values, as a bulk import would
+// see), plus the VIN check digit, which had no regex equivalent.
+//
+// Usage: ValidatorsBench [values=1000000]
+#include "utils/validators.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+    template <typename F>
+    double perSecond(const std::vector<std::string>& values, F&& valid, size_t& accepted) {
+        accepted = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& v : values) accepted += valid(v);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return values.size() / seconds;
+    }
+
+    std::string digits(std::mt19937& rng, int n) {
+        std::string out;
+        for (int i = 0; i < n; ++i) out += static_cast<char>('0' + rng() % 10);
+        return out;
+    }
+}
+
+int main(int argc, char** argv) {
+    const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::mt19937 rng(9);
+
+    // About one value in ten is malformed.
+    std::vector<std::string> phones(n), licences(n), emails(n), vins(n);
+    const std::string vinAlphabet = "0123456789ABCDEFGHJKLMNPRSTUVWXYZ";
+    for (size_t i = 0; i < n; ++i) {
+        const bool bad = rng() % 10 == 0;
+        phones[i] = digits(rng, bad ? 9 : 10);
+        licences[i] = (bad ? "ON" : "ON-") + digits(rng, 8);
+        emails[i] = "customer" + digits(rng, 6) + (bad ? "@example" : "@example.com");
+        for (int c = 0; c < 17; ++c) vins[i] += vinAlphabet[rng() % vinAlphabet.size()];
+    }
+
+    const std::regex phoneRegex(R"(^\d{10}$)");
+    const std::regex licenceRegex(R"(^ON-\d{8}$)");
+    const std::regex emailRegex(R"(^[^\s@]+@[^\s@]+\.[^\s@]+$)");
+
+    std::printf("%-8s %16s %16s %9s\n", "field", "regex /s", "validator /s", "speedup");
+    auto compare = [&](const char* name, const std::vector<std::string>& values, const std::regex& re,
+                       bool (*validator)(std::string_view)) {
+        size_t regexAccepted = 0, validatorAccepted = 0;
+        double regexRate = perSecond(values, [&](const std::string& v) { return std::regex_match(v, re); },
+                                     regexAccepted);
+        double validatorRate = perSecond(values, [&](const std::string& v) { return validator(v); },
+                                         validatorAccepted);
+        std::printf("%-8s %16.0f %16.0f %8.1fx%s\n", name, regexRate, validatorRate, validatorRate / regexRate,
+                    regexAccepted == validatorAccepted ? "" : "  (MISMATCH)");
+    };
+    compare("phone", phones, phoneRegex, [](std::string_view v) { return isValidPhone(v); });
+    compare("licence", licences, licenceRegex, [](std::string_view v) { return isValidLicence(v); });
+    compare("email", emails, emailRegex, [](std::string_view v) { return isValidEmail(v); });
+
+    size_t accepted = 0;
+    double vinRate = perSecond(vins, [](const std::string& v) { return isValidVin(v); }, accepted);
+    std::printf("%-8s %16s %16.0f %9s  (%zu of %zu random VINs pass the check digit)\n",
+                "vin", "-", vinRate, "-", accepted, n);
+    return 0;
+}
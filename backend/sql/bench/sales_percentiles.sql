@@ -0,0 +1,25 @@
+-- Exact sale-price and profit quantiles with percentile_cont, the query that
+-- GET /sales/distribution answers from t-digests instead. Compare its time
+-- with the endpoint on the same data (TDigestBench covers the accuracy side).
+--
+-- Run with psql against a database holding realistic sales history:
+--   psql -d dealerdrive -f backend/sql/bench/sales_percentiles.sql
+\timing on
+
+-- One make/model over one year.
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT
+    percentile_cont(ARRAY[0.1, 0.5, 0.9]) WITHIN GROUP (ORDER BY s.sale_price) AS sale_price,
+    percentile_cont(ARRAY[0.1, 0.5, 0.9]) WITHIN GROUP (ORDER BY s.sale_price - v.market_price) AS profit
+FROM Sales s
+JOIN Vehicles v ON v.id = s.vehicle_id
+WHERE v.make = 'Toyota' AND v.model = 'Camry'
+  AND s.date >= DATE '2024-01-01' AND s.date < DATE '2025-01-01';
+
+-- Whole history, all models: the worst case for the exact query.
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT
+    percentile_cont(ARRAY[0.1, 0.5, 0.9]) WITHIN GROUP (ORDER BY s.sale_price) AS sale_price,
+    percentile_cont(ARRAY[0.1, 0.5, 0.9]) WITHIN GROUP (ORDER BY s.sale_price - v.market_price) AS profit
+FROM Sales s
+JOIN Vehicles v ON v.id = s.vehicle_id;
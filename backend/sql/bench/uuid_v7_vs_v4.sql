@@ -0,0 +1,57 @@
+-- Insert throughput and primary-key index size: UUIDv4 vs UUIDv7 keys.
+--
+-- Run with psql against a scratch database that has uuid_generate_v7()
+-- (schema.sql or migration 003):
+--     psql -U dealerdrive -d dealerdrive -f sql/bench/uuid_v7_vs_v4.sql
+--
+-- Each table gets :rows rows inserted in batches of :batch, the way the
+-- backend inserts (many small transactions), then the pkey index is measured.
+-- The gap widens once the v4 index no longer fits in shared_buffers.
+
+\set rows 2000000
+\set batch 1000
+\timing on
+
+DROP TABLE IF EXISTS bench_uuid_v4;
+DROP TABLE IF EXISTS bench_uuid_v7;
+CREATE TABLE bench_uuid_v4 (id uuid PRIMARY KEY DEFAULT gen_random_uuid(), payload int NOT NULL);
+CREATE TABLE bench_uuid_v7 (id uuid PRIMARY KEY DEFAULT uuid_generate_v7(), payload int NOT NULL);
+
+SELECT set_config('bench.rows', :'rows', false), set_config('bench.batch', :'batch', false);
+
+\echo 'UUIDv4 inserts'
+DO $$
+DECLARE
+    total int := current_setting('bench.rows')::int;
+    step int := current_setting('bench.batch')::int;
+    started timestamptz := clock_timestamp();
+BEGIN
+    FOR i IN 0 .. (total / step) - 1 LOOP
+        INSERT INTO bench_uuid_v4 (payload) SELECT g FROM generate_series(1, step) g;
+        COMMIT;
+    END LOOP;
+    RAISE NOTICE 'v4: % rows/s', round(total / extract(epoch FROM clock_timestamp() - started));
+END $$;
+
+\echo 'UUIDv7 inserts'
+DO $$
+DECLARE
+    total int := current_setting('bench.rows')::int;
+    step int := current_setting('bench.batch')::int;
+    started timestamptz := clock_timestamp();
+BEGIN
+    FOR i IN 0 .. (total / step) - 1 LOOP
+        INSERT INTO bench_uuid_v7 (payload) SELECT g FROM generate_series(1, step) g;
+        COMMIT;
+    END LOOP;
+    RAISE NOTICE 'v7: % rows/s', round(total / extract(epoch FROM clock_timestamp() - started));
+END $$;
+
+\timing off
+\echo 'Primary-key index size'
+SELECT 'v4' AS keys, pg_size_pretty(pg_relation_size('bench_uuid_v4_pkey')) AS pkey_size
+UNION ALL
+SELECT 'v7', pg_size_pretty(pg_relation_size('bench_uuid_v7_pkey'));
+
+DROP TABLE bench_uuid_v4;
+DROP TABLE bench_uuid_v7;
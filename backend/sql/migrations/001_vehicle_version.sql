@@ -0,0 +1,3 @@
+-- Adds the optimistic-concurrency version counter used by PATCH /vehicles/<id>.
+-- Safe to run more than once on databases created before the column existed.
+ALTER TABLE Vehicles ADD COLUMN IF NOT EXISTS version INTEGER NOT NULL DEFAULT 1;
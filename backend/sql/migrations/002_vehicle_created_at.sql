@@ -0,0 +1,4 @@
+-- Records when a vehicle entered stock; POST /vehicles/reprice filters on it
+-- for "days in stock". Rows that predate the column are stamped with the
+-- migration time, so their days-in-stock count starts from zero.
+ALTER TABLE Vehicles ADD COLUMN IF NOT EXISTS created_at TIMESTAMPTZ NOT NULL DEFAULT now();
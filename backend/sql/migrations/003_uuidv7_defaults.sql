@@ -0,0 +1,22 @@
+-- Switches primary-key defaults from random UUIDv4 to time-ordered UUIDv7.
+-- The backend already supplies v7 IDs on insert; the defaults keep ad-hoc SQL
+-- inserts ordered too. Existing v4 keys stay valid: both versions share the
+-- uuid type, so no foreign key or client changes are needed. New rows append
+-- to the right edge of each index from now on; rewriting the old keys is
+-- optional (see 004_uuidv7_rewrite_ids.sql).
+
+CREATE OR REPLACE FUNCTION uuid_generate_v7() RETURNS uuid AS $$
+    SELECT encode(
+        set_bit(set_bit(
+            overlay(uuid_send(gen_random_uuid())
+                    PLACING substring(int8send(floor(extract(epoch FROM clock_timestamp()) * 1000)::bigint) FROM 3)
+                    FROM 1 FOR 6),
+            52, 1), 53, 1),
+        'hex')::uuid;
+$$ LANGUAGE sql VOLATILE;
+
+ALTER TABLE Vehicles ALTER COLUMN id SET DEFAULT uuid_generate_v7();
+ALTER TABLE Customers ALTER COLUMN id SET DEFAULT uuid_generate_v7();
+ALTER TABLE Images ALTER COLUMN id SET DEFAULT uuid_generate_v7();
+ALTER TABLE Sales ALTER COLUMN id SET DEFAULT uuid_generate_v7();
+ALTER TABLE Test_Drive_Record ALTER COLUMN id SET DEFAULT uuid_generate_v7();
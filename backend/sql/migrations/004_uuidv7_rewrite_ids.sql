@@ -0,0 +1,80 @@
+-- OPTIONAL: rewrites existing UUIDv4 keys as UUIDv7 so historical rows are
+-- time-ordered as well. Run after 003 in a maintenance window with the
+-- backend stopped: it rewrites every key and foreign key and rebuilds the
+-- indexes. Clients holding old IDs (bookmarks, exports) will no longer
+-- resolve them.
+--
+-- Each row's timestamp comes from the best date it has: Vehicles.created_at,
+-- Sales.date and Test_Drive_Record.date; Customers and Images, which carry no
+-- date, use the earliest related vehicle/sale date or the current time. Rows
+-- sharing a timestamp keep a random order, which is harmless.
+
+BEGIN;
+
+CREATE OR REPLACE FUNCTION uuid_v7_at(ts timestamptz) RETURNS uuid AS $$
+    SELECT encode(
+        set_bit(set_bit(
+            overlay(uuid_send(gen_random_uuid())
+                    PLACING substring(int8send(floor(extract(epoch FROM ts) * 1000)::bigint) FROM 3)
+                    FROM 1 FOR 6),
+            52, 1), 53, 1),
+        'hex')::uuid;
+$$ LANGUAGE sql VOLATILE;
+
+-- Old -> new key maps.
+CREATE TEMP TABLE vehicle_ids AS
+    SELECT id AS old_id, uuid_v7_at(created_at) AS new_id FROM Vehicles;
+CREATE TEMP TABLE customer_ids AS
+    SELECT c.id AS old_id,
+           uuid_v7_at(COALESCE((SELECT min(s.date) FROM Sales s WHERE s.customer_id = c.id)::timestamptz, now())) AS new_id
+    FROM Customers c;
+CREATE TEMP TABLE sale_ids AS
+    SELECT id AS old_id, uuid_v7_at(date::timestamptz) AS new_id FROM Sales;
+CREATE TEMP TABLE test_drive_ids AS
+    SELECT id AS old_id, uuid_v7_at(date::timestamptz) AS new_id FROM Test_Drive_Record;
+CREATE TEMP TABLE image_ids AS
+    SELECT i.id AS old_id, uuid_v7_at(v.created_at) AS new_id
+    FROM Images i JOIN Vehicles v ON v.id = i.vehicle_id;
+
+CREATE UNIQUE INDEX ON vehicle_ids (old_id);
+CREATE UNIQUE INDEX ON customer_ids (old_id);
+
+-- Foreign keys have no ON UPDATE CASCADE, so lift them while keys move.
+ALTER TABLE Images DROP CONSTRAINT IF EXISTS images_vehicle_id_fkey;
+ALTER TABLE Sales DROP CONSTRAINT IF EXISTS sales_vehicle_id_fkey;
+ALTER TABLE Sales DROP CONSTRAINT IF EXISTS sales_customer_id_fkey;
+ALTER TABLE Test_Drive_Record DROP CONSTRAINT IF EXISTS test_drive_record_vehicle_id_fkey;
+ALTER TABLE Test_Drive_Record DROP CONSTRAINT IF EXISTS test_drive_record_customer_id_fkey;
+
+UPDATE Vehicles t SET id = m.new_id FROM vehicle_ids m WHERE t.id = m.old_id;
+UPDATE Customers t SET id = m.new_id FROM customer_ids m WHERE t.id = m.old_id;
+UPDATE Sales t SET id = m.new_id FROM sale_ids m WHERE t.id = m.old_id;
+UPDATE Test_Drive_Record t SET id = m.new_id FROM test_drive_ids m WHERE t.id = m.old_id;
+UPDATE Images t SET id = m.new_id FROM image_ids m WHERE t.id = m.old_id;
+
+UPDATE Images t SET vehicle_id = m.new_id FROM vehicle_ids m WHERE t.vehicle_id = m.old_id;
+UPDATE Sales t SET vehicle_id = m.new_id FROM vehicle_ids m WHERE t.vehicle_id = m.old_id;
+UPDATE Sales t SET customer_id = m.new_id FROM customer_ids m WHERE t.customer_id = m.old_id;
+UPDATE Test_Drive_Record t SET vehicle_id = m.new_id FROM vehicle_ids m WHERE t.vehicle_id = m.old_id;
+UPDATE Test_Drive_Record t SET customer_id = m.new_id FROM customer_ids m WHERE t.customer_id = m.old_id;
+
+ALTER TABLE Images ADD CONSTRAINT images_vehicle_id_fkey
+    FOREIGN KEY (vehicle_id) REFERENCES Vehicles(id) ON DELETE CASCADE;
+ALTER TABLE Sales ADD CONSTRAINT sales_vehicle_id_fkey
+    FOREIGN KEY (vehicle_id) REFERENCES Vehicles(id);
+ALTER TABLE Sales ADD CONSTRAINT sales_customer_id_fkey
+    FOREIGN KEY (customer_id) REFERENCES Customers(id);
+ALTER TABLE Test_Drive_Record ADD CONSTRAINT test_drive_record_vehicle_id_fkey
+    FOREIGN KEY (vehicle_id) REFERENCES Vehicles(id);
+ALTER TABLE Test_Drive_Record ADD CONSTRAINT test_drive_record_customer_id_fkey
+    FOREIGN KEY (customer_id) REFERENCES Customers(id);
+
+COMMIT;
+
+-- The updates left every index full of dead, randomly ordered entries.
+REINDEX TABLE Vehicles;
+REINDEX TABLE Customers;
+REINDEX TABLE Sales;
+REINDEX TABLE Images;
+REINDEX TABLE Test_Drive_Record;
+VACUUM ANALYZE Vehicles, Customers, Sales, Images, Test_Drive_Record;
@@ -0,0 +1,16 @@
+-- Daily per-model sales rollups read by GET /sales/weekly-report. POST and
+-- PUT /sales keep them current from then on; run
+-- sql/tools/backfill_sales_rollup.sql once after this migration to load the
+-- sales recorded before it.
+CREATE TABLE IF NOT EXISTS Sales_Daily_Rollup (
+    day DATE NOT NULL,
+    make VARCHAR(50) NOT NULL,
+    model VARCHAR(50) NOT NULL,
+    sales_count INTEGER NOT NULL,
+    revenue NUMERIC(14,2) NOT NULL,
+    market_value NUMERIC(14,2) NOT NULL,
+    profit NUMERIC(14,2) NOT NULL,
+    min_sale_price NUMERIC(10,2) NOT NULL,
+    max_sale_price NUMERIC(10,2) NOT NULL,
+    PRIMARY KEY (day, make, model)
+);
@@ -0,0 +1,4 @@
+-- Adds the revision counter PUT /sales/<id> bumps, so a cached invoice
+-- rendered from an older revision is never installed over a newer one.
+-- Safe to run more than once on databases created before the column existed.
+ALTER TABLE Sales ADD COLUMN IF NOT EXISTS version INTEGER NOT NULL DEFAULT 1;
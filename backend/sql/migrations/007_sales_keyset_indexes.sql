@@ -0,0 +1,14 @@
+-- Indexes behind the keyset-paginated sales lists. Each one matches an
+-- ORDER BY s.date DESC, s.id DESC walk, so a page starting below a cursor
+-- is an index range scan however deep it is. The per-vehicle and
+-- per-customer indexes lead with the foreign key and replace the
+-- single-column ones, which they also cover for FK checks.
+-- CONCURRENTLY keeps Sales writable while they build; run outside a
+-- transaction block (plain psql, no -1).
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_sales_date_id ON Sales (date DESC, id DESC);
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_sales_vehicle_date_id ON Sales (vehicle_id, date DESC, id DESC);
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_sales_customer_date_id ON Sales (customer_id, date DESC, id DESC);
+
+DROP INDEX CONCURRENTLY IF EXISTS idx_sales_date;
+DROP INDEX CONCURRENTLY IF EXISTS idx_sales_vehicle_id;
+DROP INDEX CONCURRENTLY IF EXISTS idx_sales_customer_id;
@@ -0,0 +1,17 @@
+-- Stores Idempotency-Key claims and the responses they produced for
+-- POST /sales and POST /vehicles. A row without status_code is a request
+-- still in progress; expires_at is its lease, then the replay TTL.
+-- Safe to run more than once.
+CREATE TABLE IF NOT EXISTS Idempotency_Keys (
+    scope VARCHAR(32) NOT NULL,
+    key VARCHAR(255) NOT NULL,
+    request_hash VARCHAR(20) NOT NULL,
+    status_code INTEGER,
+    response_body TEXT,
+    content_type VARCHAR(100),
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    expires_at TIMESTAMPTZ NOT NULL,
+    PRIMARY KEY (scope, key)
+);
+
+CREATE INDEX IF NOT EXISTS idx_idempotency_keys_expires ON Idempotency_Keys(expires_at);
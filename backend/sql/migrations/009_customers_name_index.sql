@@ -0,0 +1,6 @@
+-- Index behind the keyset-paginated customer list. It matches the
+-- ORDER BY first_name, last_name, id walk, so GET /customers reads one
+-- index range per page instead of scanning and sorting the whole table.
+-- CONCURRENTLY keeps Customers writable while it builds; run outside a
+-- transaction block (plain psql, no -1).
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_customers_name_id ON Customers (first_name, last_name, id);
@@ -0,0 +1,6 @@
+-- Adds the revision counter behind the ETag of GET /customers/<id>/overview.
+-- PATCH /customers/<id> bumps it, and so does every sale or test drive
+-- written for the customer, so the overview's validator can be checked
+-- without re-running its aggregation.
+-- Safe to run more than once on databases created before the column existed.
+ALTER TABLE Customers ADD COLUMN IF NOT EXISTS version INTEGER NOT NULL DEFAULT 1;
@@ -0,0 +1,10 @@
+-- Records the resized variants the backend generates for each upload.
+-- width/height are the original's pixel size, filled in by the background
+-- variant queue: NULL means not processed yet, 0 means the file could not
+-- be decoded. variant_widths lists the "<name>_w<width>.jpg" files written
+-- beside the original, which GET /uploads/<name>?w= chooses from.
+-- Existing uploads are picked up by the queue when the backend starts.
+-- Safe to run more than once.
+ALTER TABLE Images ADD COLUMN IF NOT EXISTS width INTEGER;
+ALTER TABLE Images ADD COLUMN IF NOT EXISTS height INTEGER;
+ALTER TABLE Images ADD COLUMN IF NOT EXISTS variant_widths INTEGER[] NOT NULL DEFAULT '{}';
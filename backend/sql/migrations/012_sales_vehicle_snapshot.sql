@@ -0,0 +1,41 @@
+-- Copies the sold vehicle's make, model and market price onto each sale.
+-- The daily rollups, the weekly report, the sales facts and the price
+-- distribution read these columns, so repricing or editing a sold vehicle
+-- no longer changes what its sale was counted with.
+--
+-- The backend writes the columns itself; the trigger fills them for inserts
+-- made directly in SQL (seeds, tools) that leave them out. Existing sales
+-- take the vehicle's current values, which is what their rollups hold.
+-- Safe to run more than once.
+BEGIN;
+
+ALTER TABLE Sales ADD COLUMN IF NOT EXISTS make VARCHAR(50);
+ALTER TABLE Sales ADD COLUMN IF NOT EXISTS model VARCHAR(50);
+ALTER TABLE Sales ADD COLUMN IF NOT EXISTS market_price NUMERIC(10,2);
+
+UPDATE Sales s
+SET make = v.make, model = v.model, market_price = v.market_price
+FROM Vehicles v
+WHERE v.id = s.vehicle_id AND (s.make IS NULL OR s.model IS NULL OR s.market_price IS NULL);
+
+ALTER TABLE Sales ALTER COLUMN make SET NOT NULL;
+ALTER TABLE Sales ALTER COLUMN model SET NOT NULL;
+ALTER TABLE Sales ALTER COLUMN market_price SET NOT NULL;
+
+CREATE OR REPLACE FUNCTION sales_snapshot_vehicle() RETURNS trigger AS $$
+BEGIN
+    IF NEW.make IS NULL OR NEW.model IS NULL OR NEW.market_price IS NULL THEN
+        SELECT COALESCE(NEW.make, v.make), COALESCE(NEW.model, v.model),
+               COALESCE(NEW.market_price, v.market_price)
+        INTO NEW.make, NEW.model, NEW.market_price
+        FROM Vehicles v WHERE v.id = NEW.vehicle_id;
+    END IF;
+    RETURN NEW;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS sales_snapshot_vehicle ON Sales;
+CREATE TRIGGER sales_snapshot_vehicle BEFORE INSERT ON Sales
+    FOR EACH ROW EXECUTE FUNCTION sales_snapshot_vehicle();
+
+COMMIT;
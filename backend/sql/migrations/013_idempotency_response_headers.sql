@@ -0,0 +1,5 @@
+-- Stores every header of an idempotent response (Content-Type, ETag,
+-- Location, ...) as "Name: value" lines, so a replay matches the original.
+-- Rows written before this column replay with their content_type only.
+-- Safe to run more than once.
+ALTER TABLE Idempotency_Keys ADD COLUMN IF NOT EXISTS response_headers TEXT;
@@ -1,4 +1,9 @@
+-- gen_random_uuid() defaults below need pgcrypto on PostgreSQL < 13
+CREATE EXTENSION IF NOT EXISTS "pgcrypto";
+
 -- Drop tables if they exist (in reverse order of dependencies)
+DROP TABLE IF EXISTS Idempotency_Keys CASCADE;
+DROP TABLE IF EXISTS Sales_Daily_Rollup CASCADE;
 DROP TABLE IF EXISTS Test_Drive_Record CASCADE;
 DROP TABLE IF EXISTS Sales CASCADE;
 DROP TABLE IF EXISTS Images CASCADE;
@@ -13,6 +18,19 @@ DROP TYPE IF EXISTS status_enum CASCADE;
 -- Enable UUID extension (for older PostgreSQL versions)
 CREATE EXTENSION IF NOT EXISTS "uuid-ossp";
 
+-- Time-ordered UUIDv7 (RFC 9562): 48-bit Unix milliseconds in front of a
+-- random v4 body, with the version nibble switched from 4 to 7. The backend
+-- generates its own IDs; this default covers inserts made directly in SQL.
+CREATE OR REPLACE FUNCTION uuid_generate_v7() RETURNS uuid AS $$
+    SELECT encode(
+        set_bit(set_bit(
+            overlay(uuid_send(gen_random_uuid())
+                    PLACING substring(int8send(floor(extract(epoch FROM clock_timestamp()) * 1000)::bigint) FROM 3)
+                    FROM 1 FOR 6),
+            52, 1), 53, 1),
+        'hex')::uuid;
+$$ LANGUAGE sql VOLATILE;
+
 -- Create ENUM types
 CREATE TYPE fuel_type_enum AS ENUM ('Gasoline', 'Diesel', 'Electric', 'Hybrid');
 CREATE TYPE transmission_enum AS ENUM ('Manual', 'Automatic', 'CVT');
@@ -20,7 +38,7 @@ CREATE TYPE status_enum AS ENUM ('Available', 'Sold');
 
 -- 1. Vehicles Table
 CREATE TABLE Vehicles (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     vin VARCHAR(17) NOT NULL UNIQUE,
     make VARCHAR(50) NOT NULL,
     model VARCHAR(50) NOT NULL,
@@ -30,39 +48,66 @@ CREATE TABLE Vehicles (
     transmission transmission_enum NOT NULL,
     trim VARCHAR(50),
     market_price NUMERIC(10,2) NOT NULL,
-    status status_enum NOT NULL DEFAULT 'Available'
+    status status_enum NOT NULL DEFAULT 'Available',
+    version INTEGER NOT NULL DEFAULT 1,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now()
 );
 
 -- 2. Customers Table
 CREATE TABLE Customers (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     first_name VARCHAR(50) NOT NULL,
     last_name VARCHAR(50) NOT NULL,
     address TEXT,
     ph_number VARCHAR(20) NOT NULL,
     email VARCHAR(100) NOT NULL UNIQUE,
-    driving_licence VARCHAR(50) NOT NULL UNIQUE
+    driving_licence VARCHAR(50) NOT NULL UNIQUE,
+    version INTEGER NOT NULL DEFAULT 1
 );
 
 -- 3. Images Table
 CREATE TABLE Images (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     vehicle_id UUID NOT NULL REFERENCES Vehicles(id) ON DELETE CASCADE,
-    img_url TEXT NOT NULL
+    img_url TEXT NOT NULL,
+    width INTEGER,
+    height INTEGER,
+    variant_widths INTEGER[] NOT NULL DEFAULT '{}'
 );
 
 -- 4. Sales Table
 CREATE TABLE Sales (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     vehicle_id UUID NOT NULL REFERENCES Vehicles(id) ON DELETE RESTRICT,
     customer_id UUID NOT NULL REFERENCES Customers(id) ON DELETE RESTRICT,
     date DATE NOT NULL,
-    sale_price NUMERIC(10,2) NOT NULL
+    sale_price NUMERIC(10,2) NOT NULL,
+    version INTEGER NOT NULL DEFAULT 1,
+    -- The vehicle as sold; rollups and reports read these, not Vehicles.
+    make VARCHAR(50) NOT NULL,
+    model VARCHAR(50) NOT NULL,
+    market_price NUMERIC(10,2) NOT NULL
 );
 
+-- Fills the vehicle snapshot for inserts that leave it out (seeds, ad-hoc SQL).
+CREATE OR REPLACE FUNCTION sales_snapshot_vehicle() RETURNS trigger AS $$
+BEGIN
+    IF NEW.make IS NULL OR NEW.model IS NULL OR NEW.market_price IS NULL THEN
+        SELECT COALESCE(NEW.make, v.make), COALESCE(NEW.model, v.model),
+               COALESCE(NEW.market_price, v.market_price)
+        INTO NEW.make, NEW.model, NEW.market_price
+        FROM Vehicles v WHERE v.id = NEW.vehicle_id;
+    END IF;
+    RETURN NEW;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER sales_snapshot_vehicle BEFORE INSERT ON Sales
+    FOR EACH ROW EXECUTE FUNCTION sales_snapshot_vehicle();
+
 -- 5. Test_Drive_Record Table
 CREATE TABLE Test_Drive_Record (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     first_name VARCHAR(50) NOT NULL,
     last_name VARCHAR(50) NOT NULL,
     email VARCHAR(100) NOT NULL,
@@ -73,11 +118,44 @@ CREATE TABLE Test_Drive_Record (
     comments TEXT
 );
 
+-- 6. Sales_Daily_Rollup Table
+-- One row per (day, make, model), maintained by POST/PUT /sales in the same
+-- transaction as the sale. Rebuild with sql/tools/backfill_sales_rollup.sql.
+CREATE TABLE Sales_Daily_Rollup (
+    day DATE NOT NULL,
+    make VARCHAR(50) NOT NULL,
+    model VARCHAR(50) NOT NULL,
+    sales_count INTEGER NOT NULL,
+    revenue NUMERIC(14,2) NOT NULL,
+    market_value NUMERIC(14,2) NOT NULL,
+    profit NUMERIC(14,2) NOT NULL,
+    min_sale_price NUMERIC(10,2) NOT NULL,
+    max_sale_price NUMERIC(10,2) NOT NULL,
+    PRIMARY KEY (day, make, model)
+);
+
+-- 7. Idempotency_Keys Table
+-- Idempotency-Key claims for POST /sales and POST /vehicles. A row without
+-- status_code is still in progress; expires_at is its lease, then the TTL
+-- for replaying the stored response.
+CREATE TABLE Idempotency_Keys (
+    scope VARCHAR(32) NOT NULL,
+    key VARCHAR(255) NOT NULL,
+    request_hash VARCHAR(20) NOT NULL,
+    status_code INTEGER,
+    response_body TEXT,
+    content_type VARCHAR(100),
+    response_headers TEXT,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    expires_at TIMESTAMPTZ NOT NULL,
+    PRIMARY KEY (scope, key)
+);
+
 -- Create indexes for better query performance
 CREATE INDEX idx_images_vehicle_id ON Images(vehicle_id);
-CREATE INDEX idx_sales_vehicle_id ON Sales(vehicle_id);
-CREATE INDEX idx_sales_customer_id ON Sales(customer_id);
-CREATE INDEX idx_sales_date ON Sales(date);
+CREATE INDEX idx_sales_vehicle_date_id ON Sales(vehicle_id, date DESC, id DESC);
+CREATE INDEX idx_sales_customer_date_id ON Sales(customer_id, date DESC, id DESC);
+CREATE INDEX idx_sales_date_id ON Sales(date DESC, id DESC);
 CREATE INDEX idx_test_drive_vehicle_id ON Test_Drive_Record(vehicle_id);
 CREATE INDEX idx_test_drive_customer_id ON Test_Drive_Record(customer_id);
 CREATE INDEX idx_test_drive_date ON Test_Drive_Record(date);
@@ -85,4 +163,6 @@ CREATE INDEX idx_vehicles_status ON Vehicles(status);
 CREATE INDEX idx_vehicles_make_model ON Vehicles(make, model);
 CREATE INDEX idx_vehicles_year ON Vehicles(year);
 CREATE INDEX idx_customers_email ON Customers(email);
-CREATE INDEX idx_customers_last_name ON Customers(last_name);
\ No newline at end of file
+CREATE INDEX idx_customers_last_name ON Customers(last_name);
+CREATE INDEX idx_customers_name_id ON Customers(first_name, last_name, id);
+CREATE INDEX idx_idempotency_keys_expires ON Idempotency_Keys(expires_at);
\ No newline at end of file
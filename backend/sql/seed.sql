@@ -8,7 +8,7 @@ CREATE EXTENSION IF NOT EXISTS "uuid-ossp";
 DO $$ 
 BEGIN
     IF EXISTS (SELECT FROM information_schema.tables WHERE table_name = 'vehicles') THEN
-        TRUNCATE TABLE Test_Drive_Record, Sales, Images, Customers, Vehicles CASCADE;
+        TRUNCATE TABLE Sales_Daily_Rollup, Test_Drive_Record, Sales, Images, Customers, Vehicles CASCADE;
     END IF;
 END $$;
 
@@ -18,7 +18,7 @@ END $$;
 -- Insert 600 Vehicles with realistic data
 INSERT INTO Vehicles (id, vin, make, model, year, odometer, fuel_type, transmission, trim, market_price, status)
 SELECT 
-    uuid_generate_v4(),
+    uuid_generate_v7(),
     LPAD((row_number() OVER ())::text, 17, '0'),
     makes[1 + floor(random() * array_length(makes, 1))::int],
     models[1 + floor(random() * array_length(models, 1))::int],
@@ -40,7 +40,7 @@ FROM
 -- Insert 600 Customers with realistic data
 INSERT INTO Customers (id, first_name, last_name, address, ph_number, email, driving_licence)
 SELECT 
-    uuid_generate_v4(),
+    uuid_generate_v7(),
     first_names[1 + floor(random() * array_length(first_names, 1))::int],
     last_names[1 + floor(random() * array_length(last_names, 1))::int],
     CASE WHEN random() > 0.2 THEN 
@@ -83,7 +83,7 @@ random_customers AS (
 )
 INSERT INTO Sales (id, vehicle_id, customer_id, date, sale_price)
 SELECT 
-    uuid_generate_v4(),
+    uuid_generate_v7(),
     sv.id,
     rc.id,
     CURRENT_DATE - (floor(random() * 730)::int),
@@ -95,6 +95,14 @@ FROM
 WHERE sv.id = (SELECT id FROM sold_vehicles OFFSET (gs - 1) LIMIT 1)
   AND rc.id = (SELECT id FROM random_customers OFFSET (gs - 1) LIMIT 1);
 
+-- Build the daily sales rollups for the seeded sales
+INSERT INTO Sales_Daily_Rollup
+    (day, make, model, sales_count, revenue, market_value, profit, min_sale_price, max_sale_price)
+SELECT s.date, s.make, s.model, COUNT(*), SUM(s.sale_price), SUM(s.market_price),
+       SUM(s.sale_price - s.market_price), MIN(s.sale_price), MAX(s.sale_price)
+FROM Sales s
+GROUP BY s.date, s.make, s.model;
+
 -- Insert 120 Test Drive Records with realistic data
 
 WITH available_vehicles AS (
@@ -105,7 +113,7 @@ random_customers AS (
 )
 INSERT INTO Test_Drive_Record (id, vehicle_id, customer_id, date, comments)
 SELECT 
-    uuid_generate_v4(),
+    uuid_generate_v7(),
     av.id,
     rc.id,
     CURRENT_DATE - (floor(random() * 365)::int),
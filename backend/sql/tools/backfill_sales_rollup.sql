@@ -0,0 +1,34 @@
+-- Rebuilds Sales_Daily_Rollup from the raw Sales history.
+--
+-- Run after migration 005, or at any time to re-sync the rollups. Sales are
+-- grouped by the make, model and market price copied onto them when they were
+-- recorded (migration 012), so later edits to the vehicle do not move them.
+--
+-- The SHARE lock lets reads continue but holds new and updated sales until
+-- the rebuild commits, so no write can slip between the delete and the insert.
+--
+--   psql -d dealerdrive -f backend/sql/tools/backfill_sales_rollup.sql
+BEGIN;
+
+LOCK TABLE Sales IN SHARE MODE;
+
+DELETE FROM Sales_Daily_Rollup;
+
+INSERT INTO Sales_Daily_Rollup
+    (day, make, model, sales_count, revenue, market_value, profit, min_sale_price, max_sale_price)
+SELECT
+    s.date,
+    s.make,
+    s.model,
+    COUNT(*),
+    SUM(s.sale_price),
+    SUM(s.market_price),
+    SUM(s.sale_price - s.market_price),
+    MIN(s.sale_price),
+    MAX(s.sale_price)
+FROM Sales s
+GROUP BY s.date, s.make, s.model;
+
+COMMIT;
+
+SELECT COUNT(*) AS rollup_rows, COALESCE(SUM(sales_count), 0) AS sales_covered FROM Sales_Daily_Rollup;
@@ -1,30 +1,3 @@
-// #include "db_connection.h"
-// #include <iostream>
-// #include <memory>
-// #include <pqxx/pqxx>
-
-// std::shared_ptr<pqxx::connection> getDbConnection() {
-//     try {
-//         thread_local std::shared_ptr<pqxx::connection> conn =
-//         std::make_shared<pqxx::connection>(
-//             "host=db "
-//             "port=5432 "
-//             "dbname=dealerdrive "
-//             "user=dealerdrive "
-//             "password=dealerdrive"
-//         );
-
-//         if (!conn->is_open()) {
-//             throw std::runtime_error("Database connection is not open");
-//         }
-
-//         return conn;
-//     } catch (const std::exception& e) {
-//         std::cerr << "DB connection failed: " << e.what() << std::endl;
-//         throw;
-//     }
-// }
-
 #include "db_connection.h"
 #include <iostream>
 
@@ -33,6 +6,7 @@ ConnectionPool::ConnectionPool(int size, const std::string& connStr) {
         auto conn = std::make_shared<pqxx::connection>(connStr);
         pool.push_back(conn);
         available.push(conn);
+        prepared[conn.get()];
     }
 }
 
@@ -50,6 +24,17 @@ void ConnectionPool::release(std::shared_ptr<pqxx::connection> conn) {
     cv.notify_one();
 }
 
+void ConnectionPool::prepareOnce(pqxx::connection& conn, const std::string& name, const std::string& sql) {
+    auto it = prepared.find(&conn);
+    if (it == prepared.end()) {
+        conn.prepare(name, sql);
+        return;
+    }
+    if (it->second.count(name)) return;
+    conn.prepare(name, sql);
+    it->second.insert(name);
+}
+
 ConnectionPool& getPool() {
     static ConnectionPool pool(20,
         "host=db port=5432 dbname=dealerdrive "
@@ -1,16 +1,12 @@
-// #pragma once
-// #include <pqxx/pqxx>
-// #include <memory>
-
-// // Returns a shared database connection
-// std::shared_ptr<pqxx::connection> getDbConnection();
-
 #pragma once
 #include <pqxx/pqxx>
 #include <memory>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 class ConnectionPool {
     std::vector<std::shared_ptr<pqxx::connection>> pool;
@@ -18,10 +14,18 @@ class ConnectionPool {
     std::mutex mtx;
     std::condition_variable cv;
 
+    // Names of the statements already prepared on each pooled connection.
+    // The keys are fixed at construction and a connection is only ever used
+    // by the thread holding it, so the inner sets need no locking.
+    std::unordered_map<pqxx::connection*, std::unordered_set<std::string>> prepared;
+
 public:
     ConnectionPool(int size, const std::string& connStr);
     std::shared_ptr<pqxx::connection> acquire();
     void release(std::shared_ptr<pqxx::connection> conn);
+
+    // Prepares `sql` as `name` on `conn` the first time it is requested there.
+    void prepareOnce(pqxx::connection& conn, const std::string& name, const std::string& sql);
 };
 
 // RAII guard - auto releases connection when it goes out of scope
@@ -32,6 +36,9 @@ public:
     ConnectionGuard(ConnectionPool& p) : pool(p), conn(p.acquire()) {}
     ~ConnectionGuard() { pool.release(conn); }
     pqxx::connection& get() { return *conn; }
+
+    // Makes a named prepared statement available on the guarded connection.
+    void prepare(const std::string& name, const std::string& sql) { pool.prepareOnce(*conn, name, sql); }
 };
 
 // Global pool accessor
@@ -0,0 +1,15 @@
+#include "sql_errors.h"
+
+SqlErrorStatus classifySqlState(const std::string& sqlstate) {
+    if (sqlstate.size() != 5) return {500, "Database error"};
+
+    const std::string cls = sqlstate.substr(0, 2);
+    if (cls == "22") return {400, "Invalid value"};
+    if (sqlstate == "23502" || sqlstate == "23514") return {400, "Constraint violated"};
+    if (sqlstate == "23503") return {409, "Referenced record does not exist"};
+    if (sqlstate == "23505") return {409, "Duplicate record"};
+    if (sqlstate == "40001" || sqlstate == "40P01") return {503, "Concurrent update conflict, retry"};
+    if (sqlstate == "55P03" || sqlstate == "57014") return {503, "Database busy, retry"};
+    if (cls == "08" || cls == "53") return {503, "Database unavailable"};
+    return {500, "Database error"};
+}
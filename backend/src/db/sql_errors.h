@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+
+// Maps PostgreSQL errors to HTTP answers by SQLSTATE code, so handlers do not
+// have to search driver-specific message text.
+
+struct SqlErrorStatus {
+    int status;         // HTTP status to answer with
+    const char* error;  // short client-facing description
+};
+
+// Classifies a SQLSTATE (pqxx::sql_error::sqlstate()):
+//   22xxx data exceptions (bad date, number out of range) -> 400
+//   23502/23514 not-null and check violations           -> 400
+//   23503 foreign key violation                         -> 409
+//   23505 unique violation                              -> 409
+//   40001/40P01 serialization failure, deadlock         -> 503 (retryable)
+//   55P03 lock not available, 57014 query canceled      -> 503
+//   08xxx connection and 53xxx resource errors          -> 503
+//   anything else                                       -> 500
+SqlErrorStatus classifySqlState(const std::string& sqlstate);
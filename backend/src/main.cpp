@@ -5,6 +5,7 @@
 #include "modules/inventory/inventory.h"
 #include "modules/customer/customer.h"
 #include "modules/images/images.h"
+#include "modules/analytics/analytics.h"
 
     int
     main()
@@ -27,6 +28,9 @@
     // Register routes from the images module
 	registerImagesRoutes(app);
 
+    // Register routes from the analytics module
+    registerAnalyticsRoutes(app);
+
 	// Start the server on port 3000
     app.port(3000).multithreaded().run();
 	
@@ -0,0 +1,195 @@
+#include "analytics.h"
+#include "../../db/db_connection.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+/// @file analytics.cpp
+/// @brief Ad-hoc sales analytics served from the in-memory fact table.
+
+namespace {
+    const char* FACT_COLUMNS =
+        "s.id, s.date, s.sale_price, s.market_price, s.make, s.model, "
+        "v.fuel_type, v.transmission, v.year "
+        "FROM Sales s JOIN Vehicles v ON v.id = s.vehicle_id";
+
+    // Rows fetched per cursor round trip while loading the fact table.
+    constexpr int LOAD_BATCH_ROWS = 10000;
+
+    SaleFact factFromRow(const pqxx::row& row) {
+        SaleFact fact;
+        fact.saleId = row["id"].c_str();
+        fact.date = row["date"].c_str();
+        fact.salePrice = row["sale_price"].as<double>();
+        fact.marketPrice = row["market_price"].as<double>();
+        fact.make = row["make"].c_str();
+        fact.model = row["model"].c_str();
+        fact.fuelType = row["fuel_type"].c_str();
+        fact.transmission = row["transmission"].c_str();
+        fact.vehicleYear = row["year"].as<int>();
+        return fact;
+    }
+
+    // Loads every sale into the fact table once. A failed load leaves the
+    // flag unset, so the next request tries again.
+    void ensureSalesFactsLoaded() {
+        static std::once_flag loaded;
+        std::call_once(loaded, [] {
+            auto& table = salesFactTable();
+            table.reload([](const SalesFactTable::Sink& sink) {
+                ConnectionGuard guard(getPool());
+                pqxx::work txn(guard.get());
+                pqxx::icursorstream cursor(txn, std::string("SELECT ") + FACT_COLUMNS + " ORDER BY s.id",
+                                           "sales_facts", LOAD_BATCH_ROWS);
+                pqxx::result batch;
+                while (cursor >> batch) {
+                    for (const auto& row : batch) sink(factFromRow(row));
+                }
+                txn.commit();
+            });
+            CROW_LOG_INFO << "Sales fact table loaded with " << table.size() << " sales";
+        });
+    }
+
+    // Splits a comma-separated parameter, dropping empty items.
+    std::vector<std::string> splitList(const char* param) {
+        std::vector<std::string> items;
+        if (!param) return items;
+        std::string list(param);
+        size_t start = 0;
+        while (start <= list.size()) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) end = list.size();
+            if (end > start) items.push_back(list.substr(start, end - start));
+            start = end + 1;
+        }
+        return items;
+    }
+
+    crow::response badRequest(const std::string& message) {
+        crow::json::wvalue error;
+        error["error"] = message;
+        return crow::response(400, error);
+    }
+}
+
+std::optional<SaleFact> fetchSaleFact(pqxx::transaction_base& txn, const std::string& saleId) {
+    pqxx::result r = txn.exec_params(std::string("SELECT ") + FACT_COLUMNS + " WHERE s.id = $1::uuid", saleId);
+    if (r.empty()) return std::nullopt;
+    return factFromRow(r[0]);
+}
+
+std::vector<SaleFact> fetchVehicleSaleFacts(pqxx::transaction_base& txn, const std::string& vehicleId) {
+    pqxx::result r = txn.exec_params(std::string("SELECT ") + FACT_COLUMNS + " WHERE s.vehicle_id = $1::uuid",
+                                     vehicleId);
+    std::vector<SaleFact> facts;
+    facts.reserve(r.size());
+    for (const auto& row : r) facts.push_back(factFromRow(row));
+    return facts;
+}
+
+/// @brief Registers the analytics HTTP routes and starts loading the fact table.
+/// @param app The Crow application instance to register routes on.
+void registerAnalyticsRoutes(crow::SimpleApp& app) {
+
+    // Warm the fact table in the background so the first query is not the
+    // one paying for the load.
+    std::thread([] {
+        try {
+            ensureSalesFactsLoaded();
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Sales fact table load failed: " << e.what();
+        }
+    }).detach();
+
+    //------------------------------------------------------------------
+    // GET /analytics/sales
+    //------------------------------------------------------------------
+    /// @brief Grouped sales aggregates, e.g. revenue by make by month.
+    /// @route GET /analytics/sales
+    /// @param group_by Up to three of: make, model, fuel_type, transmission,
+    ///                 vehicle_year, month, sale_year. Empty for one total row.
+    /// @param metrics Any of: count, revenue, avg_price, min_price, max_price,
+    ///                market_value, profit, avg_profit, margin. Default: count,revenue.
+    /// @param from Optional first sale date (YYYY-MM-DD, inclusive).
+    /// @param to Optional last sale date (YYYY-MM-DD, inclusive).
+    CROW_ROUTE(app, "/analytics/sales")
+    .methods("GET"_method)
+    ([](const crow::request& req) {
+        SalesFactTable::Query query;
+        for (const auto& item : splitList(req.url_params.get("group_by"))) {
+            SalesFactTable::Dimension dimension;
+            if (!SalesFactTable::parseDimension(item, dimension)) {
+                return badRequest("Unknown group_by dimension: " + item);
+            }
+            query.groupBy.push_back(dimension);
+        }
+        if (query.groupBy.size() > SalesFactTable::MAX_GROUP_BY) {
+            return badRequest("At most 3 group_by dimensions are supported");
+        }
+
+        std::vector<SalesFactTable::Metric> metrics;
+        std::vector<std::string> metricNames = splitList(req.url_params.get("metrics"));
+        if (metricNames.empty()) metricNames = {"count", "revenue"};
+        for (const auto& item : metricNames) {
+            SalesFactTable::Metric metric;
+            if (!SalesFactTable::parseMetric(item, metric)) {
+                return badRequest("Unknown metric: " + item);
+            }
+            metrics.push_back(metric);
+        }
+
+        const char* fromParam = req.url_params.get("from");
+        const char* toParam = req.url_params.get("to");
+        if ((fromParam && !SalesFactTable::dayNumber(fromParam, query.fromDay)) ||
+            (toParam && !SalesFactTable::dayNumber(toParam, query.toDay))) {
+            return badRequest("Invalid date format. Use YYYY-MM-DD");
+        }
+        if (query.fromDay > query.toDay) {
+            return badRequest("from must not be after to");
+        }
+
+        try {
+            ensureSalesFactsLoaded();
+
+            auto start = std::chrono::steady_clock::now();
+            SalesFactTable::Result result = salesFactTable().aggregate(query);
+            double elapsedMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+
+            crow::json::wvalue::list rows;
+            rows.reserve(result.groups.size());
+            for (const auto& group : result.groups) {
+                crow::json::wvalue row;
+                for (size_t d = 0; d < query.groupBy.size(); ++d) {
+                    row[SalesFactTable::name(query.groupBy[d])] = group.key[d];
+                }
+                for (auto metric : metrics) {
+                    if (metric == SalesFactTable::Metric::Count) {
+                        row["count"] = group.count;
+                    } else {
+                        row[SalesFactTable::name(metric)] = group.value(metric);
+                    }
+                }
+                rows.push_back(std::move(row));
+            }
+
+            crow::json::wvalue out;
+            crow::json::wvalue::list groupBy, metricList;
+            for (auto dimension : query.groupBy) groupBy.push_back(SalesFactTable::name(dimension));
+            for (auto metric : metrics) metricList.push_back(SalesFactTable::name(metric));
+            out["group_by"] = std::move(groupBy);
+            out["metrics"] = std::move(metricList);
+            out["rows"] = std::move(rows);
+            out["scanned_rows"] = result.scannedRows;
+            out["elapsed_ms"] = elapsedMs;
+            return crow::response(200, out);
+
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Error in GET /analytics/sales: " << e.what();
+            crow::json::wvalue error;
+            error["error"] = "Internal server error";
+            return crow::response(500, error);
+        }
+    });
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "../../external/crow/crow_all.h"
+#include "sales_facts.h"
+#include <optional>
+#include <pqxx/pqxx>
+#include <string>
+#include <vector>
+
+void registerAnalyticsRoutes(crow::SimpleApp& app);
+
+/// @brief Reads the fact row of one sale, for writers to upsert after commit.
+/// @param txn The transaction that wrote the sale.
+/// @param saleId The sale ID (UUID).
+/// @return The fact, or nothing if the sale does not exist.
+std::optional<SaleFact> fetchSaleFact(pqxx::transaction_base& txn, const std::string& saleId);
+
+/// @brief Reads the fact rows of every sale of one vehicle, for vehicle
+/// edits to upsert after commit (fuel type, transmission and year follow the
+/// vehicle; make, model and market price keep their sale-time values).
+/// @param txn The transaction that changed the vehicle.
+/// @param vehicleId The vehicle ID (UUID).
+std::vector<SaleFact> fetchVehicleSaleFacts(pqxx::transaction_base& txn, const std::string& vehicleId);
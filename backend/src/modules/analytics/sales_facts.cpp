@@ -0,0 +1,455 @@
+#include "sales_facts.h"
+#include "../../utils/civil_date.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    constexpr size_t BATCH_ROWS = 1024;
+    // Largest key space aggregated into a dense array instead of a hash map.
+    constexpr uint64_t DENSE_LIMIT = 1 << 16;
+    // Rows one aggregation thread should have to itself to be worth starting.
+    constexpr size_t ROWS_PER_THREAD = 1 << 18;
+
+    struct Accumulator {
+        int64_t count = 0;
+        int64_t revenue = 0;
+        int64_t market = 0;
+        int64_t min = INT64_MAX;
+        int64_t max = INT64_MIN;
+
+        void add(int64_t sale, int64_t marketValue) {
+            ++count;
+            revenue += sale;
+            market += marketValue;
+            min = std::min(min, sale);
+            max = std::max(max, sale);
+        }
+
+        void merge(const Accumulator& o) {
+            count += o.count;
+            revenue += o.revenue;
+            market += o.market;
+            min = std::min(min, o.min);
+            max = std::max(max, o.max);
+        }
+    };
+
+    struct Partial {
+        std::vector<Accumulator> dense;
+        std::unordered_map<uint64_t, Accumulator> sparse;
+        size_t scanned = 0;
+    };
+
+    const char* DIMENSION_NAMES[] = {"make", "model", "fuel_type", "transmission", "vehicle_year", "month", "sale_year"};
+    const char* METRIC_NAMES[] = {"count", "revenue", "avg_price", "min_price", "max_price",
+                                  "market_value", "profit", "avg_profit", "margin"};
+
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    template <size_t N>
+    bool parseUuid(const std::string& text, std::array<unsigned char, N>& out) {
+        if (text.size() != 36) return false;
+        size_t byte = 0;
+        for (size_t i = 0; i < 36;) {
+            if (i == 8 || i == 13 || i == 18 || i == 23) {
+                if (text[i] != '-') return false;
+                ++i;
+                continue;
+            }
+            int hi = hexValue(text[i]), lo = hexValue(text[i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            out[byte++] = static_cast<unsigned char>(hi << 4 | lo);
+            i += 2;
+        }
+        return true;
+    }
+
+    int32_t toCents(double price) {
+        double cents = std::round(price * 100.0);
+        return static_cast<int32_t>(std::clamp(cents, double(INT32_MIN), double(INT32_MAX)));
+    }
+}
+
+uint16_t SalesFactTable::Dictionary::encode(const std::string& value) {
+    auto it = codes.find(value);
+    if (it != codes.end()) return it->second;
+    if (values.size() > UINT16_MAX) {
+        throw std::length_error("too many distinct values for a 16-bit dictionary");
+    }
+    uint16_t code = static_cast<uint16_t>(values.size());
+    values.push_back(value);
+    codes.emplace(value, code);
+    return code;
+}
+
+bool SalesFactTable::dayNumber(std::string_view date, int32_t& day) {
+    const auto parsed = parseDate(date);
+    if (!parsed) return false;
+    day = daysFromCivil(*parsed);
+    return true;
+}
+
+bool SalesFactTable::parseDimension(std::string_view name, Dimension& out) {
+    for (size_t i = 0; i < std::size(DIMENSION_NAMES); ++i) {
+        if (name == DIMENSION_NAMES[i]) {
+            out = static_cast<Dimension>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SalesFactTable::parseMetric(std::string_view name, Metric& out) {
+    for (size_t i = 0; i < std::size(METRIC_NAMES); ++i) {
+        if (name == METRIC_NAMES[i]) {
+            out = static_cast<Metric>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* SalesFactTable::name(Dimension dimension) {
+    return DIMENSION_NAMES[static_cast<size_t>(dimension)];
+}
+
+const char* SalesFactTable::name(Metric metric) {
+    return METRIC_NAMES[static_cast<size_t>(metric)];
+}
+
+double SalesFactTable::Group::value(Metric metric) const {
+    const double profitCents = static_cast<double>(revenueCents - marketCents);
+    switch (metric) {
+        case Metric::Count:       return static_cast<double>(count);
+        case Metric::Revenue:     return revenueCents / 100.0;
+        case Metric::AvgPrice:    return count ? revenueCents / 100.0 / count : 0;
+        case Metric::MinPrice:    return minCents / 100.0;
+        case Metric::MaxPrice:    return maxCents / 100.0;
+        case Metric::MarketValue: return marketCents / 100.0;
+        case Metric::Profit:      return profitCents / 100.0;
+        case Metric::AvgProfit:   return count ? profitCents / 100.0 / count : 0;
+        case Metric::Margin:      return revenueCents ? profitCents * 100.0 / revenueCents : 0;
+    }
+    return 0;
+}
+
+void SalesFactTable::reload(const std::function<void(const Sink&)>& source) {
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        reloading = true;
+        pendingUpserts.clear();
+    }
+
+    // Stream into a local table; aggregations keep reading the old contents
+    // and upserts only queue, so nobody waits on the database here.
+    SalesFactTable fresh;
+    try {
+        source([&fresh](const SaleFact& fact) {
+            SaleKey key;
+            int32_t day;
+            if (parseUuid(fact.saleId, key) && dayNumber(fact.date, day)) {
+                fresh.appendLocked(key, fact, day);
+            }
+        });
+    } catch (...) {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        reloading = false;
+        pendingUpserts.clear();
+        throw;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    for (const PendingUpsert& p : pendingUpserts) fresh.upsertLocked(p.key, p.fact, p.day);
+    pendingUpserts.clear();
+    reloading = false;
+    swapContentsLocked(fresh);
+    isLoaded = true;
+}
+
+bool SalesFactTable::upsert(const SaleFact& fact) {
+    SaleKey key;
+    int32_t day;
+    if (!parseUuid(fact.saleId, key) || !dayNumber(fact.date, day)) return false;
+
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    if (reloading) pendingUpserts.push_back(PendingUpsert{key, fact, day});
+    if (isLoaded) upsertLocked(key, fact, day);
+    return true;
+}
+
+void SalesFactTable::upsertLocked(const SaleKey& key, const SaleFact& fact, int32_t day) {
+    auto it = rowOfSale.find(key);
+    if (it == rowOfSale.end()) {
+        appendLocked(key, fact, day);
+    } else {
+        writeRowLocked(it->second, fact, day);
+    }
+}
+
+void SalesFactTable::swapContentsLocked(SalesFactTable& other) {
+    saleIds.swap(other.saleIds);
+    rowOfSale.swap(other.rowOfSale);
+    days.swap(other.days);
+    months.swap(other.months);
+    saleCents.swap(other.saleCents);
+    marketCents.swap(other.marketCents);
+    makes.swap(other.makes);
+    models.swap(other.models);
+    fuelTypes.swap(other.fuelTypes);
+    transmissions.swap(other.transmissions);
+    vehicleYears.swap(other.vehicleYears);
+    blocks.swap(other.blocks);
+    std::swap(makeDict, other.makeDict);
+    std::swap(modelDict, other.modelDict);
+    std::swap(fuelDict, other.fuelDict);
+    std::swap(transmissionDict, other.transmissionDict);
+    std::swap(maxMonth, other.maxMonth);
+    std::swap(maxVehicleYear, other.maxVehicleYear);
+}
+
+void SalesFactTable::appendLocked(const SaleKey& key, const SaleFact& fact, int32_t day) {
+    size_t row = saleIds.size();
+    saleIds.push_back(key);
+    rowOfSale.emplace(key, static_cast<uint32_t>(row));
+    days.emplace_back();
+    months.emplace_back();
+    saleCents.emplace_back();
+    marketCents.emplace_back();
+    makes.emplace_back();
+    models.emplace_back();
+    fuelTypes.emplace_back();
+    transmissions.emplace_back();
+    vehicleYears.emplace_back();
+    if (row % BLOCK_ROWS == 0) blocks.emplace_back();
+    writeRowLocked(row, fact, day);
+}
+
+void SalesFactTable::writeRowLocked(size_t row, const SaleFact& fact, int32_t day) {
+    days[row] = day;
+    months[row] = static_cast<uint16_t>(std::max(0, monthIndex(civilFromDays(day))));
+    saleCents[row] = toCents(fact.salePrice);
+    marketCents[row] = toCents(fact.marketPrice);
+    makes[row] = makeDict.encode(fact.make);
+    models[row] = modelDict.encode(fact.model);
+    fuelTypes[row] = fuelDict.encode(fact.fuelType);
+    transmissions[row] = transmissionDict.encode(fact.transmission);
+    vehicleYears[row] = static_cast<uint16_t>(std::clamp(fact.vehicleYear - 1900, 0, 1000));
+
+    // Zone maps only widen; an updated row at worst makes a block scanned
+    // when it could have been skipped.
+    Block& block = blocks[row / BLOCK_ROWS];
+    block.minDay = std::min(block.minDay, day);
+    block.maxDay = std::max(block.maxDay, day);
+    maxMonth = std::max(maxMonth, months[row]);
+    maxVehicleYear = std::max(maxVehicleYear, vehicleYears[row]);
+}
+
+uint32_t SalesFactTable::cardinalityLocked(Dimension dimension) const {
+    size_t n = 1;
+    switch (dimension) {
+        case Dimension::Make:         n = makeDict.values.size(); break;
+        case Dimension::Model:        n = modelDict.values.size(); break;
+        case Dimension::FuelType:     n = fuelDict.values.size(); break;
+        case Dimension::Transmission: n = transmissionDict.values.size(); break;
+        case Dimension::VehicleYear:  n = maxVehicleYear + 1u; break;
+        case Dimension::Month:        n = maxMonth + 1u; break;
+        case Dimension::SaleYear:     n = maxMonth / 12u + 1u; break;
+    }
+    return static_cast<uint32_t>(std::max<size_t>(n, 1));
+}
+
+std::string SalesFactTable::labelLocked(Dimension dimension, uint32_t code) const {
+    char buf[16];
+    switch (dimension) {
+        case Dimension::Make:         return makeDict.values[code];
+        case Dimension::Model:        return modelDict.values[code];
+        case Dimension::FuelType:     return fuelDict.values[code];
+        case Dimension::Transmission: return transmissionDict.values[code];
+        case Dimension::VehicleYear:  return std::to_string(1900 + code);
+        case Dimension::SaleYear:     return std::to_string(1970 + code);
+        case Dimension::Month:
+            std::snprintf(buf, sizeof(buf), "%04u-%02u", 1970 + code / 12, code % 12 + 1);
+            return buf;
+    }
+    return {};
+}
+
+SalesFactTable::Result SalesFactTable::aggregate(const Query& query) const {
+    if (query.groupBy.size() > MAX_GROUP_BY) {
+        throw std::invalid_argument("at most 3 group_by dimensions are supported");
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    const size_t n = days.size();
+
+    // Mixed-radix group key: code_0 * stride_0 + code_1 * stride_1 + ...
+    const size_t dims = query.groupBy.size();
+    std::vector<uint32_t> cards(dims);
+    std::vector<uint64_t> strides(dims);
+    uint64_t keySpace = 1;
+    for (size_t d = dims; d-- > 0;) {
+        cards[d] = cardinalityLocked(query.groupBy[d]);
+        strides[d] = keySpace;
+        keySpace *= cards[d];
+    }
+    const bool dense = keySpace <= DENSE_LIMIT;
+
+    std::vector<size_t> active;
+    size_t activeRows = 0;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (blocks[b].maxDay < query.fromDay || blocks[b].minDay > query.toDay) continue;
+        active.push_back(b);
+        activeRows += std::min(BLOCK_ROWS, n - b * BLOCK_ROWS);
+    }
+
+    unsigned threads = query.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::min<size_t>(threads, activeRows / ROWS_PER_THREAD + 1));
+    }
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, active.size())));
+
+    std::vector<Partial> partials(threads);
+    auto work = [&](unsigned t) {
+        Partial& p = partials[t];
+        if (dense) p.dense.assign(keySpace, Accumulator{});
+
+        uint64_t keys[BATCH_ROWS];
+        unsigned char pass[BATCH_ROWS];
+
+        const size_t first = active.size() * t / threads;
+        const size_t last = active.size() * (t + 1) / threads;
+        for (size_t i = first; i < last; ++i) {
+            const size_t b = active[i];
+            const bool whole = blocks[b].minDay >= query.fromDay && blocks[b].maxDay <= query.toDay;
+            const size_t blockEnd = std::min(n, (b + 1) * BLOCK_ROWS);
+
+            for (size_t start = b * BLOCK_ROWS; start < blockEnd; start += BATCH_ROWS) {
+                const size_t len = std::min(BATCH_ROWS, blockEnd - start);
+
+                std::fill(keys, keys + len, 0);
+                for (size_t d = 0; d < dims; ++d) {
+                    const uint64_t stride = strides[d];
+                    switch (query.groupBy[d]) {
+                        case Dimension::Make:
+                            for (size_t r = 0; r < len; ++r) keys[r] += makes[start + r] * stride;
+                            break;
+                        case Dimension::Model:
+                            for (size_t r = 0; r < len; ++r) keys[r] += models[start + r] * stride;
+                            break;
+                        case Dimension::FuelType:
+                            for (size_t r = 0; r < len; ++r) keys[r] += fuelTypes[start + r] * stride;
+                            break;
+                        case Dimension::Transmission:
+                            for (size_t r = 0; r < len; ++r) keys[r] += transmissions[start + r] * stride;
+                            break;
+                        case Dimension::VehicleYear:
+                            for (size_t r = 0; r < len; ++r) keys[r] += vehicleYears[start + r] * stride;
+                            break;
+                        case Dimension::Month:
+                            for (size_t r = 0; r < len; ++r) keys[r] += months[start + r] * stride;
+                            break;
+                        case Dimension::SaleYear:
+                            for (size_t r = 0; r < len; ++r) keys[r] += (months[start + r] / 12u) * stride;
+                            break;
+                    }
+                }
+
+                if (whole) {
+                    std::fill(pass, pass + len, 1);
+                } else {
+                    for (size_t r = 0; r < len; ++r) {
+                        const int32_t day = days[start + r];
+                        pass[r] = (day >= query.fromDay) & (day <= query.toDay);
+                    }
+                }
+
+                const int32_t* sale = saleCents.data() + start;
+                const int32_t* market = marketCents.data() + start;
+                if (dense) {
+                    Accumulator* table = p.dense.data();
+                    for (size_t r = 0; r < len; ++r) {
+                        if (pass[r]) table[keys[r]].add(sale[r], market[r]);
+                    }
+                } else {
+                    for (size_t r = 0; r < len; ++r) {
+                        if (pass[r]) p.sparse[keys[r]].add(sale[r], market[r]);
+                    }
+                }
+                for (size_t r = 0; r < len; ++r) p.scanned += pass[r];
+            }
+        }
+    };
+
+    if (threads == 1) {
+        work(0);
+    } else {
+        std::vector<std::thread> pool;
+        pool.reserve(threads);
+        for (unsigned t = 0; t < threads; ++t) pool.emplace_back(work, t);
+        for (auto& th : pool) th.join();
+    }
+
+    // Fold every partial table into the first one.
+    Partial& total = partials[0];
+    for (unsigned t = 1; t < threads; ++t) {
+        total.scanned += partials[t].scanned;
+        if (dense) {
+            for (size_t k = 0; k < keySpace; ++k) total.dense[k].merge(partials[t].dense[k]);
+        } else {
+            for (const auto& [key, acc] : partials[t].sparse) total.sparse[key].merge(acc);
+        }
+    }
+
+    Result result;
+    result.scannedRows = total.scanned;
+    auto emit = [&](uint64_t key, const Accumulator& acc) {
+        if (acc.count == 0) return;
+        Group g;
+        g.key.reserve(dims);
+        for (size_t d = 0; d < dims; ++d) {
+            g.key.push_back(labelLocked(query.groupBy[d], static_cast<uint32_t>(key / strides[d] % cards[d])));
+        }
+        g.count = acc.count;
+        g.revenueCents = acc.revenue;
+        g.marketCents = acc.market;
+        g.minCents = acc.min;
+        g.maxCents = acc.max;
+        result.groups.push_back(std::move(g));
+    };
+    if (active.empty()) return result;
+    if (dense) {
+        for (size_t k = 0; k < total.dense.size(); ++k) emit(k, total.dense[k]);
+    } else {
+        for (const auto& [key, acc] : total.sparse) emit(key, acc);
+    }
+
+    std::sort(result.groups.begin(), result.groups.end(),
+              [](const Group& a, const Group& b) { return a.key < b.key; });
+    return result;
+}
+
+size_t SalesFactTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return days.size();
+}
+
+bool SalesFactTable::loaded() const {
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return isLoaded;
+}
+
+SalesFactTable& salesFactTable() {
+    static SalesFactTable table;
+    return table;
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// @struct SaleFact
+/// @brief One sale joined with the vehicle attributes analytics can group by.
+/// Make, model and market price are the values the sale was recorded with;
+/// the other attributes follow the vehicle.
+struct SaleFact {
+    std::string saleId;
+    std::string date;       // YYYY-MM-DD
+    double salePrice = 0;
+    double marketPrice = 0;
+    std::string make;
+    std::string model;
+    std::string fuelType;
+    std::string transmission;
+    int vehicleYear = 0;
+};
+
+/// @class SalesFactTable
+/// @brief In-memory, column-oriented copy of Sales x Vehicles for ad-hoc reports.
+///
+/// Each attribute lives in its own contiguous array: strings are dictionary
+/// encoded to 16-bit codes, prices are kept as integer cents (so sums are
+/// exact) and dates as day and month numbers. Rows are grouped in blocks of
+/// 64K with a min/max day per block, so date filters skip whole blocks.
+///
+/// aggregate() splits the blocks across threads. Each thread builds group keys
+/// a batch at a time with branch-free loops over the key columns (which the
+/// compiler vectorizes), then folds the batch into a thread-local table: a
+/// dense array when the key space is small, a hash map otherwise. The partial
+/// tables are merged at the end.
+class SalesFactTable {
+public:
+    enum class Dimension { Make, Model, FuelType, Transmission, VehicleYear, Month, SaleYear };
+    enum class Metric { Count, Revenue, AvgPrice, MinPrice, MaxPrice, MarketValue, Profit, AvgProfit, Margin };
+
+    static constexpr size_t MAX_GROUP_BY = 3;
+    static constexpr size_t BLOCK_ROWS = 1 << 16;
+
+    /// @brief Aggregation request; days are inclusive day numbers (see dayNumber).
+    struct Query {
+        std::vector<Dimension> groupBy;
+        int32_t fromDay = INT32_MIN;
+        int32_t toDay = INT32_MAX;
+        unsigned threads = 0; // 0 = pick from the table size and core count
+    };
+
+    /// @brief One output group: its labels (in groupBy order) and accumulators.
+    struct Group {
+        std::vector<std::string> key;
+        int64_t count = 0;
+        int64_t revenueCents = 0;
+        int64_t marketCents = 0;
+        int64_t minCents = 0;
+        int64_t maxCents = 0;
+
+        /// @brief Value of a metric in dollars (count and margin % excepted).
+        double value(Metric metric) const;
+    };
+
+    /// @brief Query result: groups sorted by key, plus the rows inspected.
+    struct Result {
+        std::vector<Group> groups;
+        size_t scannedRows = 0;
+    };
+
+    using Sink = std::function<void(const SaleFact&)>;
+
+    /// @brief Replaces the contents with the facts `source` feeds to its sink.
+    ///
+    /// The new table is built without the lock and swapped in under a short
+    /// write lock, so writers never wait for the load. Upserts issued
+    /// meanwhile are queued and applied on top of the loaded snapshot.
+    /// Reloads must not run concurrently.
+    void reload(const std::function<void(const Sink&)>& source);
+
+    /// @brief Adds a sale, or updates it if the sale ID is already present.
+    /// Ignored before the first reload() unless one is running: that load
+    /// will include the sale.
+    /// @return false if the sale has a malformed id or date.
+    bool upsert(const SaleFact& fact);
+
+    /// @brief Runs a grouped aggregation.
+    Result aggregate(const Query& query) const;
+
+    /// @brief Number of stored sales.
+    size_t size() const;
+
+    /// @brief True once reload() has completed.
+    bool loaded() const;
+
+    /// @brief Days since 1970-01-01 for a YYYY-MM-DD date.
+    /// @return false if the text is not a valid calendar date.
+    static bool dayNumber(std::string_view date, int32_t& day);
+
+    static bool parseDimension(std::string_view name, Dimension& out);
+    static bool parseMetric(std::string_view name, Metric& out);
+    static const char* name(Dimension dimension);
+    static const char* name(Metric metric);
+
+private:
+    using SaleKey = std::array<unsigned char, 16>;
+
+    // UUIDv7 keys end in 62 random bits, so the last eight bytes hash well as is.
+    struct SaleKeyHash {
+        size_t operator()(const SaleKey& key) const {
+            uint64_t tail;
+            std::memcpy(&tail, key.data() + 8, sizeof(tail));
+            return static_cast<size_t>(tail);
+        }
+    };
+
+    struct Dictionary {
+        std::vector<std::string> values;
+        std::unordered_map<std::string, uint16_t> codes;
+        uint16_t encode(const std::string& value);
+    };
+
+    struct Block {
+        int32_t minDay = INT32_MAX;
+        int32_t maxDay = INT32_MIN;
+    };
+
+    struct PendingUpsert {
+        SaleKey key;
+        SaleFact fact;
+        int32_t day;
+    };
+
+    void upsertLocked(const SaleKey& key, const SaleFact& fact, int32_t day);
+    void appendLocked(const SaleKey& key, const SaleFact& fact, int32_t day);
+    void swapContentsLocked(SalesFactTable& other);
+    void writeRowLocked(size_t row, const SaleFact& fact, int32_t day);
+    uint32_t cardinalityLocked(Dimension dimension) const;
+    std::string labelLocked(Dimension dimension, uint32_t code) const;
+
+    mutable std::shared_mutex mtx;
+    bool isLoaded = false;
+    bool reloading = false;
+    std::vector<PendingUpsert> pendingUpserts; // upserts made while reload() runs
+
+    std::vector<SaleKey> saleIds;
+    std::unordered_map<SaleKey, uint32_t, SaleKeyHash> rowOfSale;
+    std::vector<int32_t> days;
+    std::vector<uint16_t> months;      // months since 1970-01
+    std::vector<int32_t> saleCents;
+    std::vector<int32_t> marketCents;
+    std::vector<uint16_t> makes;
+    std::vector<uint16_t> models;
+    std::vector<uint16_t> fuelTypes;
+    std::vector<uint16_t> transmissions;
+    std::vector<uint16_t> vehicleYears; // year - 1900
+    std::vector<Block> blocks;
+
+    Dictionary makeDict, modelDict, fuelDict, transmissionDict;
+    uint16_t maxMonth = 0;
+    uint16_t maxVehicleYear = 0;
+};
+
+/// @brief Process-wide fact table shared by the analytics and sales routes.
+SalesFactTable& salesFactTable();
@@ -1,81 +1,29 @@
 #include "customer.h"
+#include "customer_import.h"
+#include "customer_search.h"
+#include "../sales/invoice.h"
 #include "../../db/db_connection.h"
+#include "../../db/sql_errors.h"
+#include "../../utils/http_cache.h"
 
-#include <algorithm>
-#include <cctype>
-#include <regex>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <stdexcept>
 
 // Small Utility Helpers
 namespace
 {
-    // Trims whitespace from both ends.
-    std::string trim(const std::string &s)
-    {
-        size_t start = 0;
-        while (start < s.size() && std::isspace(static_cast<unsigned char>(s[start])))
-            start++;
-
-        size_t end = s.size();
-        while (end > start && std::isspace(static_cast<unsigned char>(s[end - 1])))
-            end--;
-
-        return s.substr(start, end - start);
-    }
-
-    // Uppercase helper.
-    std::string toUpper(std::string s)
-    {
-        std::transform(s.begin(), s.end(), s.begin(),
-                       [](unsigned char c)
-                       { return static_cast<char>(std::toupper(c)); });
-        return s;
-    }
-
-    // Backend validation patterns.
-    // Required driving licence format: ON-12345678 (ON- + 8 digits)
-    const std::regex LICENCE_REGEX(R"(^ON-\d{8}$)");
-
-    // Required phone format: 10 digits (no separators)
-    const std::regex PHONE_REGEX(R"(^\d{10}$)");
-
-    // Simple email format validation
-    const std::regex EMAIL_REGEX(R"(^[^\s@]+@[^\s@]+\.[^\s@]+$)");
+    // Page size limits for GET /customers.
+    constexpr int CUSTOMER_PAGE_DEFAULT = 50;
+    constexpr int CUSTOMER_PAGE_MAX = 500;
 
-    // Validation helpers.
-    bool isValidLicence(const std::string &licence)
-    {
-        return std::regex_match(licence, LICENCE_REGEX);
-    }
-
-    bool isValidPhone(const std::string &phone)
-    {
-        return std::regex_match(phone, PHONE_REGEX);
-    }
-
-    bool isValidEmail(const std::string &email)
-    {
-        return std::regex_match(email, EMAIL_REGEX);
-    }
-
-    // Converts DB row to Customer struct.
-    Customer rowToCustomer(const pqxx::row &row)
-    {
-        Customer c;
-        c.id = row["id"].as<std::string>();
-        c.first_name = row["first_name"].as<std::string>();
-        c.last_name = row["last_name"].as<std::string>();
-
-        // DB can store NULL for address.
-        if (row["address"].is_null())
-            c.address = "";
-        else
-            c.address = row["address"].as<std::string>();
+    // Result limits for GET /customers/search.
+    constexpr int CUSTOMER_SEARCH_DEFAULT = 20;
+    constexpr int CUSTOMER_SEARCH_MAX = 100;
 
-        c.ph_number = row["ph_number"].as<std::string>();
-        c.email = row["email"].as<std::string>();
-        c.driving_licence = row["driving_licence"].as<std::string>();
-        return c;
-    }
+    // Records accepted by one POST /customers/bulk request.
+    constexpr size_t CUSTOMER_BULK_MAX = 100000;
 
     // Creates a consistent JSON representation for the frontend.
     crow::json::wvalue customerToJson(const Customer &c)
@@ -111,219 +59,93 @@ namespace
         return res;
     }
 
-    // Helper: treat explicit JSON null as "null".
-    bool isJsonNull(const crow::json::rvalue &v)
+    // Maps a database error to its HTTP status by SQLSTATE (e.g. 409 for a
+    // duplicate email or licence).
+    crow::response sqlError(const pqxx::sql_error &e)
     {
-        return v.t() == crow::json::type::Null;
-    }
-
-} // namespace
-
-// DB Functions
-
-// Fetches all customers, ordered by first name then last name.
-std::vector<Customer> getAllCustomers(pqxx::connection &conn)
-{
-    pqxx::work txn(conn);
-
-    // Keep ordering stable for UI table.
-    pqxx::result r = txn.exec(R"(
-        SELECT id, first_name, last_name, address, ph_number, email, driving_licence
-        FROM Customers
-        ORDER BY first_name ASC, last_name ASC
-    )");
-
-    txn.commit();
-
-    std::vector<Customer> customers;
-    customers.reserve(r.size());
-    for (const auto &row : r)
-        customers.push_back(rowToCustomer(row));
-
-    return customers;
-}
-
-// Fetches a single customer by ID. Returns std::nullopt if not found.
-std::optional<Customer> getCustomerById(pqxx::connection &conn, const std::string &customer_id)
-{
-    pqxx::work txn(conn);
-
-    pqxx::result r = txn.exec_params(R"(
-        SELECT id, first_name, last_name, address, ph_number, email, driving_licence
-        FROM Customers
-        WHERE id = $1
-    )",
-                                     customer_id);
-
-    txn.commit();
-
-    if (r.empty())
-        return std::nullopt;
-
-    return rowToCustomer(r[0]);
-}
-
-// Creates a new customer and returns the created record with ID.
-Customer createCustomer(pqxx::connection &conn,
-                        const std::string &first_name,
-                        const std::string &last_name,
-                        const std::string &ph_number,
-                        const std::string &email,
-                        const std::string &driving_licence,
-                        const std::optional<std::string> &address)
-{
-    pqxx::work txn(conn);
-
-    // Normalize and validate required fields.
-    const std::string fn = trim(first_name);
-    const std::string ln = trim(last_name);
-    const std::string phone = trim(ph_number);
-    const std::string mail = trim(email);
-    const std::string licence = toUpper(trim(driving_licence));
-
-    // Basic presence check.
-    if (fn.empty() || ln.empty() || phone.empty() || mail.empty() || licence.empty())
-        throw std::runtime_error("Missing required fields.");
-
-    // Format validations.
-    if (!isValidPhone(phone))
-        throw std::runtime_error("Invalid phone number (must be 10 digits).");
-
-    if (!isValidEmail(mail))
-        throw std::runtime_error("Invalid email format.");
-
-    if (!isValidLicence(licence))
-        throw std::runtime_error("Invalid driving licence format (ON-12345678).");
-
-    // Address optional.
-    std::optional<std::string> addrNorm;
-    if (address.has_value())
-    {
-        std::string a = trim(*address);
-        if (!a.empty())
-            addrNorm = a;
-    }
-
-    pqxx::result r = txn.exec_params(R"(
-        INSERT INTO Customers (first_name, last_name, ph_number, email, driving_licence, address)
-        VALUES ($1, $2, $3, $4, $5, $6)
-        RETURNING id, first_name, last_name, address, ph_number, email, driving_licence
-    )",
-                                     fn,
-                                     ln,
-                                     phone,
-                                     mail,
-                                     licence,
-                                     (addrNorm.has_value() ? addrNorm->c_str() : nullptr));
-
-    txn.commit();
-    return rowToCustomer(r[0]);
-}
-
-// Performs a partial update on a customer. Only provided fields are updated.
-Customer patchCustomer(pqxx::connection &conn,
-                       const std::string &customer_id,
-                       const std::optional<std::string> &first_name,
-                       const std::optional<std::string> &last_name,
-                       const std::optional<std::string> &ph_number,
-                       const std::optional<std::string> &email,
-                       const std::optional<std::string> &driving_licence,
-                       const std::optional<std::string> &address)
-{
-    pqxx::work txn(conn);
-
-    // Normalizes inputs if provided.
-    std::optional<std::string> fn, ln, phone, mail, licence, addr;
-
-    if (first_name.has_value())
-    {
-        fn = trim(*first_name);
-        if (fn->empty())
-            throw std::runtime_error("first_name cannot be empty.");
-    }
-
-    if (last_name.has_value())
-    {
-        ln = trim(*last_name);
-        if (ln->empty())
-            throw std::runtime_error("last_name cannot be empty.");
+        const SqlErrorStatus mapped = classifySqlState(e.sqlstate());
+        crow::response res = jsonError(mapped.status, std::string(mapped.error) + ": " + e.what());
+        if (mapped.status == 503)
+            res.set_header("Retry-After", "1");
+        return res;
     }
 
-    if (ph_number.has_value())
+    // Parses a positive integer query parameter no larger than `max`.
+    std::optional<int> parseLimit(const char *param, int max)
     {
-        phone = trim(*ph_number);
-        if (!isValidPhone(*phone))
-            throw std::runtime_error("Invalid phone number (must be 10 digits).");
+        char *end = nullptr;
+        const long value = std::strtol(param, &end, 10);
+        if (end == param || *end != '\0' || value < 1 || value > max)
+            return std::nullopt;
+        return static_cast<int>(value);
     }
 
-    if (email.has_value())
+    // Loads the search index from the database on first use.
+    void ensureSearchIndexLoaded()
     {
-        mail = trim(*email);
-        if (!isValidEmail(*mail))
-            throw std::runtime_error("Invalid email format.");
+        static std::once_flag loaded;
+        std::call_once(loaded, []
+                       {
+            auto &index = customerSearchIndex();
+            index.reload([](const CustomerSearchIndex::Sink &sink)
+                         {
+                ConnectionGuard guard(getPool());
+                CustomerRepository(guard).forEachCustomer(sink); });
+            CROW_LOG_INFO << "Customer search index loaded with " << index.size() << " customers"; });
     }
 
-    if (driving_licence.has_value())
+    // Helper: treat explicit JSON null as "null".
+    bool isJsonNull(const crow::json::rvalue &v)
     {
-        licence = toUpper(trim(*driving_licence));
-        if (!isValidLicence(*licence))
-            throw std::runtime_error("Invalid driving licence format (ON-12345678).");
+        return v.t() == crow::json::type::Null;
     }
 
-    if (address.has_value())
-        addr = trim(*address); // can be empty string, which means "clear the address"
-
-    pqxx::result r = txn.exec_params(R"(
-        UPDATE Customers
-        SET
-            first_name      = COALESCE($1, first_name),
-            last_name       = COALESCE($2, last_name),
-            ph_number       = COALESCE($3, ph_number),
-            email           = COALESCE($4, email),
-            driving_licence = COALESCE($5, driving_licence),
-            address = CASE
-                        WHEN $6 IS NULL THEN address
-                        WHEN $6 = '' THEN NULL
-                        ELSE $6
-                      END
-        WHERE id = $7
-        RETURNING id, first_name, last_name, address, ph_number, email, driving_licence
-    )",
-                                     (fn.has_value() ? fn->c_str() : nullptr),
-                                     (ln.has_value() ? ln->c_str() : nullptr),
-                                     (phone.has_value() ? phone->c_str() : nullptr),
-                                     (mail.has_value() ? mail->c_str() : nullptr),
-                                     (licence.has_value() ? licence->c_str() : nullptr),
-                                     (addr.has_value() ? addr->c_str() : nullptr),
-                                     customer_id);
-
-    txn.commit();
-
-    if (r.empty())
-        throw std::runtime_error("Customer not found.");
-
-    return rowToCustomer(r[0]);
-}
+} // namespace
 
 // Routes
+//
+// Each handler holds its pooled connection only while the repository reads
+// rows: the guard lives in an inner scope and the JSON is built after it has
+// gone back to the pool.
 
 void registerCustomerRoutes(crow::SimpleApp &app)
 {
     // GET /customers
-    // Fetches all customers. Returns empty array if none.
-    CROW_ROUTE(app, "/customers").methods("GET"_method)([]()
+    // Fetches one page of customers ordered by first name, last name, id.
+    // Query: limit (default 50, max 500) and cursor (the previous page's
+    // X-Next-Cursor). X-Estimated-Total-Count carries the table's approximate
+    // size for the paging UI. Returns empty array if none.
+    CROW_ROUTE(app, "/customers").methods("GET"_method)([](const crow::request &req)
                                                         {
-        try
+        int limit = CUSTOMER_PAGE_DEFAULT;
+        if (const char *limitParam = req.url_params.get("limit"))
         {
-            auto connPtr = getDbConnection();
-            pqxx::connection &conn = *connPtr;
+            const std::optional<int> value = parseLimit(limitParam, CUSTOMER_PAGE_MAX);
+            if (!value)
+                return jsonError(400, "limit must be between 1 and " + std::to_string(CUSTOMER_PAGE_MAX));
+            limit = *value;
+        }
 
-            auto customers = getAllCustomers(conn);
+        std::optional<CustomerCursor> after;
+        if (const char *cursorParam = req.url_params.get("cursor"))
+        {
+            after = decodeCustomerCursor(cursorParam);
+            if (!after)
+                return jsonError(400, "Invalid cursor");
+        }
+
+        try
+        {
+            CustomerPage page;
+            {
+                ConnectionGuard guard(getPool());
+                page = CustomerRepository(guard).listCustomers(limit, after);
+            }
 
             // Builds JSON array safely.
             crow::json::wvalue::list outList;
-            outList.reserve(customers.size());
-            for (const auto &c : customers)
+            outList.reserve(page.customers.size());
+            for (const auto &c : page.customers)
                 outList.push_back(customerToJson(c));
 
             crow::json::wvalue out(outList);
@@ -331,24 +153,85 @@ void registerCustomerRoutes(crow::SimpleApp &app)
             crow::response res;
             res.code = 200;
             res.set_header("Content-Type", "application/json");
+            if (page.next)
+                res.set_header("X-Next-Cursor", encodeCustomerCursor(*page.next));
+            if (page.estimatedTotal)
+                res.set_header("X-Estimated-Total-Count", std::to_string(*page.estimatedTotal));
             res.write(out.dump());
             return res;
         }
+        catch (const pqxx::sql_error &e)
+        {
+            return sqlError(e);
+        }
         catch (const std::exception &e)
         {
             return jsonError(500, std::string("Failed to fetch customers: ") + e.what());
         } });
 
+    // GET /customers/search
+    // Type-ahead lookup by last name, first name, "first last", email, phone
+    // digits or licence prefix, with trigram fuzzy matches on names after the
+    // prefix hits ("jonson" finds Johnson). Served from the in-memory
+    // CustomerSearchIndex, loaded on first use. Registered before
+    // /customers/<id> so "search" is not taken as an id.
+    // Query: q (required) and limit (default 20, max 100).
+    CROW_ROUTE(app, "/customers/search").methods("GET"_method)([](const crow::request &req)
+                                                               {
+        const char *q = req.url_params.get("q");
+        if (!q || CustomerSearchIndex::normalize(q).empty())
+            return jsonError(400, "q is required");
+
+        int limit = CUSTOMER_SEARCH_DEFAULT;
+        if (const char *limitParam = req.url_params.get("limit"))
+        {
+            const std::optional<int> value = parseLimit(limitParam, CUSTOMER_SEARCH_MAX);
+            if (!value)
+                return jsonError(400, "limit must be between 1 and " + std::to_string(CUSTOMER_SEARCH_MAX));
+            limit = *value;
+        }
+
+        try
+        {
+            ensureSearchIndexLoaded();
+        }
+        catch (const pqxx::sql_error &e)
+        {
+            return sqlError(e);
+        }
+        catch (const std::exception &e)
+        {
+            return jsonError(500, std::string("Failed to load customer search index: ") + e.what());
+        }
+
+        crow::json::wvalue::list outList;
+        for (const auto &hit : customerSearchIndex().search(q, static_cast<size_t>(limit)))
+        {
+            crow::json::wvalue item = customerToJson(hit.customer);
+            item["match"] = hit.fuzzy ? "fuzzy" : "prefix";
+            item["score"] = hit.score;
+            outList.push_back(std::move(item));
+        }
+
+        crow::json::wvalue out(outList);
+
+        crow::response res;
+        res.code = 200;
+        res.set_header("Content-Type", "application/json");
+        res.write(out.dump());
+        return res; });
+
     // GET /customers/<id>
     // Fetches a single customer by ID. Returns 404 if not found.
     CROW_ROUTE(app, "/customers/<string>").methods("GET"_method)([](const std::string &id)
                                                                  {
         try
         {
-            auto connPtr = getDbConnection();
-            pqxx::connection &conn = *connPtr;
-
-            auto customerOpt = getCustomerById(conn, id);
+            std::optional<Customer> customerOpt;
+            {
+                ConnectionGuard guard(getPool());
+                customerOpt = CustomerRepository(guard).getCustomerById(id);
+            }
             if (!customerOpt.has_value())
                 return jsonError(404, "Customer not found");
 
@@ -360,11 +243,59 @@ void registerCustomerRoutes(crow::SimpleApp &app)
             res.write(out.dump());
             return res;
         }
+        catch (const pqxx::sql_error &e)
+        {
+            return sqlError(e);
+        }
         catch (const std::exception &e)
         {
             return jsonError(500, std::string("Failed to fetch customer: ") + e.what());
         } });
 
+    // GET /customers/<id>/overview
+    // Customer profile, purchases, test drives and lifetime stats (value,
+    // first/last purchase, last and next test drive, last activity) in one
+    // statement on one pooled connection, instead of three requests. The
+    // ETag follows the customer's version, so a revalidation with a current
+    // If-None-Match is answered 304 from a version lookup alone.
+    CROW_ROUTE(app, "/customers/<string>/overview").methods("GET"_method)([](const crow::request &req, const std::string &id)
+                                                                          {
+        try
+        {
+            std::optional<CustomerOverview> overview;
+            {
+                ConnectionGuard guard(getPool());
+                CustomerRepository repo(guard);
+                if (!req.get_header_value("If-None-Match").empty())
+                {
+                    std::optional<std::string> etag = repo.getOverviewETag(id);
+                    if (!etag.has_value())
+                        return jsonError(404, "Customer not found");
+                    if (ifNoneMatchHits(req, *etag))
+                        return notModified(*etag);
+                }
+                overview = repo.getOverview(id);
+            }
+            if (!overview.has_value())
+                return jsonError(404, "Customer not found");
+
+            crow::response res;
+            res.code = 200;
+            res.set_header("Content-Type", "application/json");
+            res.set_header("ETag", overview->etag);
+            res.set_header("Cache-Control", "no-cache");
+            res.write(overview->body);
+            return res;
+        }
+        catch (const pqxx::sql_error &e)
+        {
+            return sqlError(e);
+        }
+        catch (const std::exception &e)
+        {
+            return jsonError(500, std::string("Failed to fetch customer overview: ") + e.what());
+        } });
+
     // POST /customers
     // Creates a new customer. All fields except address are required.
     CROW_ROUTE(app, "/customers").methods("POST"_method)([](const crow::request &req)
@@ -381,28 +312,24 @@ void registerCustomerRoutes(crow::SimpleApp &app)
             return jsonError(400, "Missing required fields.");
         }
 
-        // Optional address.
+        // Optional address (the repository trims it and stores blank as NULL).
         std::optional<std::string> addressOpt;
         if (body.has("address") && !isJsonNull(body["address"]))
-        {
-            std::string a = std::string(body["address"].s());
-            a = trim(a);
-            if (!a.empty())
-                addressOpt = a;
-        }
+            addressOpt = std::string(body["address"].s());
 
         try
         {
-            auto connPtr = getDbConnection();
-            pqxx::connection &conn = *connPtr;
-
-            Customer created = createCustomer(conn,
-                                              std::string(body["first_name"].s()),
-                                              std::string(body["last_name"].s()),
-                                              std::string(body["ph_number"].s()),
-                                              std::string(body["email"].s()),
-                                              std::string(body["driving_licence"].s()),
-                                              addressOpt);
+            Customer created;
+            {
+                ConnectionGuard guard(getPool());
+                created = CustomerRepository(guard).createCustomer(std::string(body["first_name"].s()),
+                                                                   std::string(body["last_name"].s()),
+                                                                   std::string(body["ph_number"].s()),
+                                                                   std::string(body["email"].s()),
+                                                                   std::string(body["driving_licence"].s()),
+                                                                   addressOpt);
+            }
+            customerSearchIndex().upsert(created);
 
             crow::json::wvalue out = customerToJson(created);
 
@@ -412,12 +339,98 @@ void registerCustomerRoutes(crow::SimpleApp &app)
             res.write(out.dump());
             return res;
         }
+        catch (const std::invalid_argument &e)
+        {
+            return jsonError(400, e.what());
+        }
+        catch (const pqxx::sql_error &e)
+        {
+            return sqlError(e);
+        }
         catch (const std::exception &e)
         {
-            // Most failures here are input validation, so 400 is appropriate.
+            // Non-string JSON values land here (crow's s() throws).
             return jsonError(400, e.what());
         } });
 
+    // POST /customers/bulk
+    // Onboards many customers at once. The body is NDJSON (one POST
+    // /customers object per line) or, with Content-Type text/csv, CSV with a
+    // header row; at most 100,000 records. Records are validated with the
+    // POST /customers rules and the valid ones imported in one transaction.
+    // Every record gets an outcome (created, duplicate_email,
+    // duplicate_licence, conflict or invalid), so a clash never aborts the
+    // load and rerunning the same file creates nothing.
+    CROW_ROUTE(app, "/customers/bulk").methods("POST"_method)([](const crow::request &req)
+                                                              {
+        const bool csv = req.get_header_value("Content-Type").find("text/csv") != std::string::npos;
+        const size_t recordCount = countCustomerRecords(req.body, csv);
+        if (recordCount == 0)
+            return jsonError(400, "Empty batch: send one customer per line.");
+        if (recordCount > CUSTOMER_BULK_MAX)
+            return jsonError(413, "At most " + std::to_string(CUSTOMER_BULK_MAX) + " customers per request.");
+
+        std::vector<CustomerImportRow> rows;
+        try
+        {
+            rows = csv ? parseCustomerCsv(req.body) : parseCustomerNdjson(req.body);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return jsonError(400, e.what());
+        }
+
+        try
+        {
+            std::vector<CustomerImportOutcome> outcomes;
+            std::vector<Customer> created;
+            {
+                ConnectionGuard guard(getPool());
+                pqxx::work txn(guard.get());
+                outcomes = importCustomers(txn, rows, created);
+                txn.commit();
+            }
+            for (const auto &c : created)
+                customerSearchIndex().upsert(c);
+
+            std::map<std::string, int> counts = {
+                {"created", 0}, {"duplicate_email", 0}, {"duplicate_licence", 0}, {"conflict", 0}, {"invalid", 0}};
+            crow::json::wvalue::list results;
+            results.reserve(outcomes.size());
+            for (const auto &outcome : outcomes)
+            {
+                ++counts[outcome.outcome];
+                crow::json::wvalue item;
+                item["line"] = outcome.line;
+                item["outcome"] = outcome.outcome;
+                if (!outcome.customerId.empty())
+                    item["customer_id"] = outcome.customerId;
+                if (!outcome.message.empty())
+                    item["message"] = outcome.message;
+                results.push_back(std::move(item));
+            }
+
+            crow::json::wvalue out;
+            out["received"] = static_cast<int>(rows.size());
+            for (const auto &[outcome, count] : counts)
+                out["counts"][outcome] = count;
+            out["results"] = std::move(results);
+
+            crow::response res;
+            res.code = 200;
+            res.set_header("Content-Type", "application/json");
+            res.write(out.dump());
+            return res;
+        }
+        catch (const pqxx::sql_error &e)
+        {
+            return sqlError(e);
+        }
+        catch (const std::exception &e)
+        {
+            return jsonError(500, std::string("Failed to import customers: ") + e.what());
+        } });
+
     // PATCH /customers/<id>
     // This route supports partial updates.
     CROW_ROUTE(app, "/customers/<string>").methods("PATCH"_method)([](const crow::request &req, const std::string &id)
@@ -439,30 +452,35 @@ void registerCustomerRoutes(crow::SimpleApp &app)
             return std::string(body[key].s());
         };
 
-        std::optional<std::string> fn = readOptStr("first_name");
-        std::optional<std::string> ln = readOptStr("last_name");
-        std::optional<std::string> phone = readOptStr("ph_number");
-        std::optional<std::string> mail = readOptStr("email");
-        std::optional<std::string> licence = readOptStr("driving_licence");
-
-        // Address is special: explicit null means "clear the address", while absence means "keep existing".
-        std::optional<std::string> addr = std::nullopt;
-        if (body.has("address"))
-        {
-            if (isJsonNull(body["address"]))
-                addr = std::string(""); // clear
-            else
-                addr = std::string(body["address"].s());
-        }
-
         try
         {
-            auto connPtr = getDbConnection();
-            pqxx::connection &conn = *connPtr;
-
-            Customer updated = patchCustomer(conn, id, fn, ln, phone, mail, licence, addr);
+            std::optional<std::string> fn = readOptStr("first_name");
+            std::optional<std::string> ln = readOptStr("last_name");
+            std::optional<std::string> phone = readOptStr("ph_number");
+            std::optional<std::string> mail = readOptStr("email");
+            std::optional<std::string> licence = readOptStr("driving_licence");
+
+            // Address is special: explicit null means "clear the address", while absence means "keep existing".
+            std::optional<std::string> addr = std::nullopt;
+            if (body.has("address"))
+            {
+                if (isJsonNull(body["address"]))
+                    addr = std::string(""); // clear
+                else
+                    addr = std::string(body["address"].s());
+            }
+
+            std::optional<Customer> updated;
+            {
+                ConnectionGuard guard(getPool());
+                updated = CustomerRepository(guard).patchCustomer(id, fn, ln, phone, mail, licence, addr);
+            }
+            if (!updated.has_value())
+                return jsonError(404, "Customer not found");
+            invoiceCache().invalidateCustomer(id);
+            customerSearchIndex().upsert(*updated);
 
-            crow::json::wvalue out = customerToJson(updated);
+            crow::json::wvalue out = customerToJson(*updated);
 
             crow::response res;
             res.code = 200;
@@ -470,8 +488,16 @@ void registerCustomerRoutes(crow::SimpleApp &app)
             res.write(out.dump());
             return res;
         }
+        catch (const std::invalid_argument &e)
+        {
+            return jsonError(400, e.what());
+        }
+        catch (const pqxx::sql_error &e)
+        {
+            return sqlError(e);
+        }
         catch (const std::exception &e)
         {
             return jsonError(400, e.what());
         } });
-}
\ No newline at end of file
+}
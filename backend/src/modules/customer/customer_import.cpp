@@ -0,0 +1,422 @@
+#include "customer_import.h"
+#include "../../external/crow/crow_all.h"
+#include "../../utils/uuid.h"
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+    // Records one validation thread should have to itself to be worth starting.
+    constexpr size_t MIN_RECORDS_PER_THREAD = 4096;
+
+    // A record's text and the line it starts on.
+    struct Record
+    {
+        int line;
+        std::string_view text;
+    };
+
+    bool isBlank(std::string_view text)
+    {
+        return text.find_first_not_of(" \t") == std::string_view::npos;
+    }
+
+    // Normalizes and validates the parsed fields and assigns the row its id.
+    void finishRow(CustomerImportRow &row)
+    {
+        row.error = normalizeNewCustomer(row.customer);
+        if (row.error.empty())
+            row.id = newUuidV7();
+    }
+
+    // Runs `validate(i)` for every record index, split into contiguous ranges
+    // across up to `threads` threads.
+    void validateInParallel(size_t count, unsigned threads, const std::function<void(size_t)> &validate)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::clamp<size_t>(count / MIN_RECORDS_PER_THREAD, 1, threads));
+
+        auto validateRange = [&](size_t from, size_t to)
+        {
+            for (size_t i = from; i < to; ++i)
+                validate(i);
+        };
+
+        const size_t chunk = (count + threads - 1) / threads;
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t)
+        {
+            const size_t from = std::min(count, t * chunk);
+            const size_t to = std::min(count, from + chunk);
+            workers.emplace_back(validateRange, from, to);
+        }
+        validateRange(0, std::min(count, chunk));
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    void validateJsonLine(std::string_view text, CustomerImportRow &row)
+    {
+        auto json = crow::json::load(text.data(), text.size());
+        if (!json || json.t() != crow::json::type::Object)
+        {
+            row.error = "Invalid JSON";
+            return;
+        }
+        for (const char *key : {"first_name", "last_name", "ph_number", "email", "driving_licence"})
+        {
+            if (!json.has(key) || json[key].t() != crow::json::type::String)
+            {
+                row.error = std::string("Missing or non-string field: ") + key;
+                return;
+            }
+        }
+
+        row.customer.first_name = json["first_name"].s();
+        row.customer.last_name = json["last_name"].s();
+        row.customer.ph_number = json["ph_number"].s();
+        row.customer.email = json["email"].s();
+        row.customer.driving_licence = json["driving_licence"].s();
+        if (json.has("address") && json["address"].t() != crow::json::type::Null)
+        {
+            if (json["address"].t() != crow::json::type::String)
+            {
+                row.error = "Non-string field: address";
+                return;
+            }
+            row.customer.address = std::string(json["address"].s());
+        }
+        finishRow(row);
+    }
+
+    // Calls `visit` with each non-blank record of a CSV body and the line it
+    // starts on. Line breaks inside quotes belong to the field, so this pass
+    // tracks quoting but leaves field parsing to the validation threads.
+    template <typename Visit>
+    void forEachCsvRecord(std::string_view body, Visit &&visit)
+    {
+        bool quoted = false;
+        int line = 1;
+        int recordLine = 1;
+        size_t start = 0;
+        for (size_t i = 0; i <= body.size(); ++i)
+        {
+            if (i < body.size())
+            {
+                const char c = body[i];
+                if (c == '"')
+                    quoted = !quoted;
+                if (c != '\n')
+                    continue;
+                ++line;
+                if (quoted)
+                    continue;
+            }
+
+            std::string_view text = body.substr(start, i - start);
+            if (!text.empty() && text.back() == '\r')
+                text.remove_suffix(1);
+            if (!isBlank(text))
+                visit(Record{recordLine, text});
+            start = i + 1;
+            recordLine = line;
+        }
+    }
+
+    std::vector<Record> splitCsvRecords(std::string_view body)
+    {
+        std::vector<Record> records;
+        forEachCsvRecord(body, [&](const Record &record)
+                         { records.push_back(record); });
+        return records;
+    }
+
+    // Spreadsheet exports often start with a UTF-8 byte order mark.
+    std::string_view stripBom(std::string_view body)
+    {
+        if (body.substr(0, 3) == "\xEF\xBB\xBF")
+            body.remove_prefix(3);
+        return body;
+    }
+
+    // Splits one CSV record into fields, undoing quoting. Returns nullopt for
+    // an unterminated quoted field.
+    std::optional<std::vector<std::string>> parseCsvFields(std::string_view record)
+    {
+        std::vector<std::string> fields(1);
+        bool quoted = false;
+        for (size_t i = 0; i < record.size(); ++i)
+        {
+            const char c = record[i];
+            if (quoted)
+            {
+                if (c != '"')
+                    fields.back() += c;
+                else if (i + 1 < record.size() && record[i + 1] == '"')
+                    fields.back() += record[++i];
+                else
+                    quoted = false;
+            }
+            else if (c == '"')
+                quoted = true;
+            else if (c == ',')
+                fields.emplace_back();
+            else
+                fields.back() += c;
+        }
+        if (quoted)
+            return std::nullopt;
+        return fields;
+    }
+
+    const char *STAGING_SQL =
+        "CREATE TEMP TABLE customers_import ("
+        "  line INTEGER PRIMARY KEY, id UUID NOT NULL, first_name TEXT NOT NULL, "
+        "  last_name TEXT NOT NULL, address TEXT, ph_number TEXT NOT NULL, "
+        "  email TEXT NOT NULL, driving_licence TEXT NOT NULL"
+        ") ON COMMIT DROP";
+
+    // Staged emails and licences are unique within the batch, so only clashes
+    // with existing customers remain. ON CONFLICT covers a customer committed
+    // by another transaction after this statement's snapshot.
+    const char *MERGE_SQL = R"(
+        WITH staged AS (
+            SELECT i.*,
+                   EXISTS (SELECT 1 FROM Customers c WHERE c.email = i.email) AS email_taken,
+                   EXISTS (SELECT 1 FROM Customers c WHERE c.driving_licence = i.driving_licence) AS licence_taken
+            FROM customers_import i
+        ),
+        inserted AS (
+            INSERT INTO Customers (id, first_name, last_name, address, ph_number, email, driving_licence)
+            SELECT id, first_name, last_name, address, ph_number, email, driving_licence
+            FROM staged
+            WHERE NOT email_taken AND NOT licence_taken
+            ON CONFLICT DO NOTHING
+            RETURNING id
+        )
+        SELECT s.line, s.id,
+               CASE
+                   WHEN s.email_taken THEN 'duplicate_email'
+                   WHEN s.licence_taken THEN 'duplicate_licence'
+                   WHEN n.id IS NULL THEN 'conflict'
+                   ELSE 'created'
+               END AS outcome
+        FROM staged s
+        LEFT JOIN inserted n ON n.id = s.id
+        ORDER BY s.line
+    )";
+}
+
+size_t countCustomerRecords(std::string_view body, bool csv)
+{
+    size_t count = 0;
+    if (csv)
+    {
+        forEachCsvRecord(stripBom(body), [&](const Record &)
+                         { ++count; });
+        // The header is not a customer.
+        return count == 0 ? 0 : count - 1;
+    }
+
+    size_t start = 0;
+    while (start < body.size())
+    {
+        size_t end = body.find('\n', start);
+        if (end == std::string_view::npos)
+            end = body.size();
+        std::string_view text = body.substr(start, end - start);
+        if (!text.empty() && text.back() == '\r')
+            text.remove_suffix(1);
+        if (!isBlank(text))
+            ++count;
+        start = end + 1;
+    }
+    return count;
+}
+
+std::vector<CustomerImportRow> parseCustomerNdjson(std::string_view body, unsigned threads)
+{
+    std::vector<std::string_view> lines;
+    std::vector<CustomerImportRow> rows;
+    int lineNumber = 0;
+    size_t start = 0;
+    while (start < body.size())
+    {
+        size_t end = body.find('\n', start);
+        if (end == std::string_view::npos)
+            end = body.size();
+        ++lineNumber;
+        std::string_view text = body.substr(start, end - start);
+        if (!text.empty() && text.back() == '\r')
+            text.remove_suffix(1);
+        if (!isBlank(text))
+        {
+            lines.push_back(text);
+            rows.emplace_back().line = lineNumber;
+        }
+        start = end + 1;
+    }
+
+    validateInParallel(lines.size(), threads, [&](size_t i)
+                       { validateJsonLine(lines[i], rows[i]); });
+    return rows;
+}
+
+std::vector<CustomerImportRow> parseCustomerCsv(std::string_view body, unsigned threads)
+{
+    body = stripBom(body);
+
+    std::vector<Record> records = splitCsvRecords(body);
+    if (records.empty())
+        return {};
+
+    // Map the header's column names to field positions.
+    const std::optional<std::vector<std::string>> header = parseCsvFields(records.front().text);
+    if (!header)
+        throw std::invalid_argument("Unterminated quote in CSV header.");
+
+    const char *const COLUMNS[] = {"first_name", "last_name", "ph_number", "email", "driving_licence", "address"};
+    std::optional<size_t> position[6];
+    for (size_t i = 0; i < header->size(); ++i)
+    {
+        std::string name;
+        for (char ch : (*header)[i])
+        {
+            if (!std::isspace(static_cast<unsigned char>(ch)))
+                name += static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        }
+        for (size_t c = 0; c < 6; ++c)
+        {
+            if (name == COLUMNS[c] && !position[c])
+                position[c] = i;
+        }
+    }
+    for (size_t c = 0; c < 5; ++c)
+    {
+        if (!position[c])
+            throw std::invalid_argument(std::string("CSV header is missing column: ") + COLUMNS[c]);
+    }
+
+    records.erase(records.begin());
+    std::vector<CustomerImportRow> rows(records.size());
+    validateInParallel(records.size(), threads, [&](size_t i)
+                       {
+        CustomerImportRow &row = rows[i];
+        row.line = records[i].line;
+        std::optional<std::vector<std::string>> fields = parseCsvFields(records[i].text);
+        if (!fields)
+        {
+            row.error = "Unterminated quoted field";
+            return;
+        }
+
+        auto field = [&](size_t c) -> std::string
+        { return *position[c] < fields->size() ? std::move((*fields)[*position[c]]) : std::string(); };
+        row.customer.first_name = field(0);
+        row.customer.last_name = field(1);
+        row.customer.ph_number = field(2);
+        row.customer.email = field(3);
+        row.customer.driving_licence = field(4);
+        if (position[5])
+            row.customer.address = field(5);
+        finishRow(row); });
+    return rows;
+}
+
+std::vector<CustomerImportOutcome> importCustomers(pqxx::work &txn,
+                                                   const std::vector<CustomerImportRow> &rows,
+                                                   std::vector<Customer> &created)
+{
+    std::vector<CustomerImportOutcome> outcomes(rows.size());
+
+    // Settle what needs no database: invalid rows, and rows repeating an email
+    // or licence of an earlier row (the first occurrence is the one staged).
+    std::unordered_map<std::string_view, int> emails;
+    std::unordered_map<std::string_view, int> licences;
+    emails.reserve(rows.size());
+    licences.reserve(rows.size());
+    std::vector<bool> staged(rows.size(), false);
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        const CustomerImportRow &row = rows[i];
+        CustomerImportOutcome &outcome = outcomes[i];
+        outcome.line = row.line;
+        if (!row.error.empty())
+        {
+            outcome.outcome = "invalid";
+            outcome.message = row.error;
+            continue;
+        }
+
+        auto email = emails.find(row.customer.email);
+        auto licence = licences.find(row.customer.driving_licence);
+        if (email != emails.end())
+        {
+            outcome.outcome = "duplicate_email";
+            outcome.message = "Same email as line " + std::to_string(email->second);
+        }
+        else if (licence != licences.end())
+        {
+            outcome.outcome = "duplicate_licence";
+            outcome.message = "Same driving licence as line " + std::to_string(licence->second);
+        }
+        else
+        {
+            emails.emplace(row.customer.email, row.line);
+            licences.emplace(row.customer.driving_licence, row.line);
+            staged[i] = true;
+        }
+    }
+
+    txn.exec(STAGING_SQL);
+    {
+        pqxx::stream_to stream(txn, "customers_import",
+                               std::vector<std::string>{"line", "id", "first_name", "last_name", "address",
+                                                        "ph_number", "email", "driving_licence"});
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            if (!staged[i])
+                continue;
+            const CustomerImportRow &row = rows[i];
+            const NewCustomer &c = row.customer;
+            stream << std::make_tuple(row.line, row.id, c.first_name, c.last_name, c.address,
+                                      c.ph_number, c.email, c.driving_licence);
+        }
+        stream.complete();
+    }
+    txn.exec("ANALYZE customers_import");
+    pqxx::result merged = txn.exec(MERGE_SQL);
+
+    // The merge returns the staged rows in line order, as they appear in `rows`.
+    auto result = merged.begin();
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        if (!staged[i])
+            continue;
+        const CustomerImportRow &row = rows[i];
+        CustomerImportOutcome &outcome = outcomes[i];
+        outcome.outcome = (*result)["outcome"].c_str();
+        ++result;
+
+        if (outcome.outcome == "created")
+        {
+            outcome.customerId = row.id;
+            const NewCustomer &c = row.customer;
+            created.push_back(Customer{row.id, c.first_name, c.last_name, c.address.value_or(""),
+                                       c.ph_number, c.email, c.driving_licence});
+        }
+        else if (outcome.outcome == "duplicate_email")
+            outcome.message = "Email already registered";
+        else if (outcome.outcome == "duplicate_licence")
+            outcome.message = "Driving licence already registered";
+        else
+            outcome.message = "Email or driving licence was registered concurrently";
+    }
+    return outcomes;
+}
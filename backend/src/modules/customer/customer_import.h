@@ -0,0 +1,72 @@
+#pragma once
+#include "customer_repository.h"
+#include <pqxx/pqxx>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    Bulk customer onboarding for POST /customers/bulk (CSV or NDJSON).
+
+    Rows are parsed, normalized and validated in parallel with the rules
+    createCustomer applies, without touching the database. Rows repeating an
+    email or licence already seen in the batch are set aside with an in-memory
+    hash set; the rest are COPYed into a temporary staging table and merged
+    into Customers by one set-based statement, so a clash with an existing
+    customer becomes a per-row outcome instead of aborting the load.
+*/
+
+/*
+    One input record after validation.
+*/
+struct CustomerImportRow
+{
+    int line = 0;       // 1-based line in the request body where the record starts
+    std::string id;     // UUIDv7 assigned to the row if it is created
+    NewCustomer customer;
+    std::string error;  // non-empty when the record is invalid
+};
+
+/*
+    Final result of one record.
+*/
+struct CustomerImportOutcome
+{
+    int line = 0;
+    // created, duplicate_email, duplicate_licence, conflict or invalid.
+    std::string outcome;
+    std::string customerId; // set for created rows
+    std::string message;    // set for every outcome except created
+};
+
+// Number of records parseCustomerCsv (`csv`) or parseCustomerNdjson would
+// return for `body`, found by scanning line breaks and quotes only, so an
+// oversized batch is rejected before any record is parsed or validated.
+size_t countCustomerRecords(std::string_view body, bool csv);
+
+// Splits an NDJSON body into lines and validates them. Each non-blank line
+// must be an object with string first_name, last_name, ph_number, email and
+// driving_licence, and optionally address (string or null). Work is split
+// across up to `threads` threads (0: one per core). Returns one row per
+// non-blank line, in input order.
+std::vector<CustomerImportRow> parseCustomerNdjson(std::string_view body, unsigned threads = 0);
+
+// Same for RFC 4180 CSV. The first record is a header naming the columns in
+// any order: first_name, last_name, ph_number, email and driving_licence are
+// required, address is optional and other columns are ignored. Quoted fields
+// may contain commas, doubled quotes and line breaks. Throws
+// std::invalid_argument when the header lacks a required column.
+std::vector<CustomerImportRow> parseCustomerCsv(std::string_view body, unsigned threads = 0);
+
+// Stages the valid rows and merges them into Customers. A row is
+//   - invalid when parsing rejected it,
+//   - duplicate_email / duplicate_licence when an existing customer or an
+//     earlier row of the batch already has that email or licence,
+//   - conflict when a concurrent insert took the email or licence first,
+//   - created otherwise.
+// `txn` is the transaction to import in; the caller commits. `created`
+// receives the inserted customers. Returns one outcome per row, in line
+// order.
+std::vector<CustomerImportOutcome> importCustomers(pqxx::work &txn,
+                                                   const std::vector<CustomerImportRow> &rows,
+                                                   std::vector<Customer> &created);
@@ -0,0 +1,495 @@
+#include "customer_repository.h"
+#include "../../external/crow/crow_all.h"
+#include "../../utils/uuid.h"
+#include "../../utils/validators.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+// Small Utility Helpers
+namespace
+{
+    // Trims whitespace from both ends.
+    std::string trim(const std::string &s)
+    {
+        size_t start = 0;
+        while (start < s.size() && std::isspace(static_cast<unsigned char>(s[start])))
+            start++;
+
+        size_t end = s.size();
+        while (end > start && std::isspace(static_cast<unsigned char>(s[end - 1])))
+            end--;
+
+        return s.substr(start, end - start);
+    }
+
+    // Uppercase helper.
+    std::string toUpper(std::string s)
+    {
+        std::transform(s.begin(), s.end(), s.begin(),
+                       [](unsigned char c)
+                       { return static_cast<char>(std::toupper(c)); });
+        return s;
+    }
+
+    // Length in characters of UTF-8 text, as VARCHAR(n) counts it.
+    size_t characterCount(const std::string &s)
+    {
+        return static_cast<size_t>(std::count_if(s.begin(), s.end(), [](unsigned char c)
+                                                 { return (c & 0xC0) != 0x80; }));
+    }
+
+    // Binds an optional text parameter: a null pointer is sent as SQL NULL.
+    const char *orNull(const std::optional<std::string> &value)
+    {
+        return value.has_value() ? value->c_str() : nullptr;
+    }
+
+    // Quoted ETag from the OVERVIEW_ETAG_SQL columns.
+    std::string overviewETag(const pqxx::row &row)
+    {
+        std::string today = row["today"].as<std::string>();
+        today.erase(std::remove(today.begin(), today.end(), '-'), today.end());
+        return "\"" + row["version"].as<std::string>() + "." +
+               row["vehicle_versions"].as<std::string>() + "." + today + "\"";
+    }
+
+    // Converts DB row to Customer struct.
+    Customer rowToCustomer(const pqxx::row &row)
+    {
+        Customer c;
+        c.id = row["id"].as<std::string>();
+        c.first_name = row["first_name"].as<std::string>();
+        c.last_name = row["last_name"].as<std::string>();
+
+        // DB can store NULL for address.
+        if (row["address"].is_null())
+            c.address = "";
+        else
+            c.address = row["address"].as<std::string>();
+
+        c.ph_number = row["ph_number"].as<std::string>();
+        c.email = row["email"].as<std::string>();
+        c.driving_licence = row["driving_licence"].as<std::string>();
+        return c;
+    }
+
+    // Prepared statements, one per repository operation.
+    const char *LIST_SQL = R"(
+        SELECT id, first_name, last_name, address, ph_number, email, driving_licence
+        FROM Customers
+        ORDER BY first_name ASC, last_name ASC, id ASC
+    )";
+
+    // Keyset pages over idx_customers_name_id; $1 is the page size plus one,
+    // so the extra row tells whether another page follows.
+    const char *PAGE_FIRST_SQL = R"(
+        SELECT id, first_name, last_name, address, ph_number, email, driving_licence
+        FROM Customers
+        ORDER BY first_name ASC, last_name ASC, id ASC
+        LIMIT $1
+    )";
+
+    const char *PAGE_AFTER_SQL = R"(
+        SELECT id, first_name, last_name, address, ph_number, email, driving_licence
+        FROM Customers
+        WHERE (first_name, last_name, id) > ($2, $3, $4::uuid)
+        ORDER BY first_name ASC, last_name ASC, id ASC
+        LIMIT $1
+    )";
+
+    // Row count as of the last ANALYZE or autovacuum; -1 if never analyzed.
+    const char *ESTIMATE_SQL =
+        "SELECT reltuples::bigint FROM pg_class WHERE oid = 'customers'::regclass";
+
+    const char *BY_ID_SQL = R"(
+        SELECT id, first_name, last_name, address, ph_number, email, driving_licence
+        FROM Customers
+        WHERE id = $1
+    )";
+
+    // Columns that make up the overview's ETag. Everything the overview shows
+    // is covered: sales and test drives bump the customer's version when they
+    // are written, vehicle edits bump the vehicle's.
+    const char *OVERVIEW_ETAG_SQL = R"(
+        SELECT c.version,
+               COALESCE((SELECT sum(v.version) FROM Vehicles v
+                         WHERE v.id IN (SELECT vehicle_id FROM Sales WHERE customer_id = c.id
+                                        UNION
+                                        SELECT vehicle_id FROM Test_Drive_Record WHERE customer_id = c.id)),
+                        0) AS vehicle_versions,
+               CURRENT_DATE::text AS today
+        FROM Customers c
+        WHERE c.id = $1::uuid
+    )";
+
+    const char *OVERVIEW_SQL = R"(
+        WITH sales AS (
+            SELECT s.id, s.date, s.sale_price, v.id AS vehicle_id, v.vin, v.make, v.model, v.year, v.version
+            FROM Sales s JOIN Vehicles v ON v.id = s.vehicle_id
+            WHERE s.customer_id = $1::uuid
+        ),
+        drives AS (
+            SELECT t.id, t.date, t.comments, v.id AS vehicle_id, v.make, v.model, v.year, v.version
+            FROM Test_Drive_Record t JOIN Vehicles v ON v.id = t.vehicle_id
+            WHERE t.customer_id = $1::uuid
+        ),
+        last_drive AS (
+            SELECT max(date) FILTER (WHERE date <= CURRENT_DATE) AS last_date,
+                   min(date) FILTER (WHERE date > CURRENT_DATE) AS next_date,
+                   count(*) AS drive_count
+            FROM drives
+        ),
+        purchases AS (
+            SELECT count(*) AS sale_count, COALESCE(sum(sale_price), 0) AS lifetime_value,
+                   min(date) AS first_date, max(date) AS last_date
+            FROM sales
+        )
+        SELECT c.version,
+               (SELECT COALESCE(sum(version), 0)
+                FROM (SELECT vehicle_id, version FROM sales
+                      UNION
+                      SELECT vehicle_id, version FROM drives) shown) AS vehicle_versions,
+               CURRENT_DATE::text AS today,
+               json_build_object(
+                   'customer', json_build_object(
+                       'id', c.id, 'first_name', c.first_name, 'last_name', c.last_name,
+                       'address', c.address, 'ph_number', c.ph_number, 'email', c.email,
+                       'driving_licence', c.driving_licence, 'version', c.version),
+                   'sales', COALESCE((
+                       SELECT json_agg(json_build_object(
+                                  'sale_id', id, 'date', date, 'price', sale_price,
+                                  'vehicle_id', vehicle_id, 'vin', vin,
+                                  'vehicle', make || ' ' || model, 'year', year)
+                              ORDER BY date DESC, id DESC)
+                       FROM sales), '[]'::json),
+                   'test_drives', COALESCE((
+                       SELECT json_agg(json_build_object(
+                                  'id', id, 'date', date, 'comment', comments,
+                                  'vehicle_id', vehicle_id, 'vehicle', make || ' ' || model, 'year', year)
+                              ORDER BY date DESC, id DESC)
+                       FROM drives), '[]'::json),
+                   'stats', json_build_object(
+                       'purchase_count', p.sale_count,
+                       'lifetime_value', p.lifetime_value,
+                       'first_purchase', p.first_date,
+                       'last_purchase', p.last_date,
+                       'test_drive_count', d.drive_count,
+                       'last_test_drive', d.last_date,
+                       'next_test_drive', d.next_date,
+                       'last_activity', GREATEST(p.last_date, d.last_date))
+               )::text AS overview
+        FROM Customers c, purchases p, last_drive d
+        WHERE c.id = $1::uuid
+    )";
+
+    const char *CREATE_SQL = R"(
+        INSERT INTO Customers (id, first_name, last_name, ph_number, email, driving_licence, address)
+        VALUES ($1, $2, $3, $4, $5, $6, $7)
+        RETURNING id, first_name, last_name, address, ph_number, email, driving_licence
+    )";
+
+    const char *PATCH_SQL = R"(
+        UPDATE Customers
+        SET
+            first_name      = COALESCE($1, first_name),
+            last_name       = COALESCE($2, last_name),
+            ph_number       = COALESCE($3, ph_number),
+            email           = COALESCE($4, email),
+            driving_licence = COALESCE($5, driving_licence),
+            address = CASE
+                        WHEN $6::text IS NULL THEN address
+                        WHEN $6::text = '' THEN NULL
+                        ELSE $6::text
+                      END,
+            version = version + 1
+        WHERE id = $7
+        RETURNING id, first_name, last_name, address, ph_number, email, driving_licence
+    )";
+
+} // namespace
+
+std::string normalizeNewCustomer(NewCustomer &customer)
+{
+    customer.first_name = trim(customer.first_name);
+    customer.last_name = trim(customer.last_name);
+    customer.ph_number = trim(customer.ph_number);
+    customer.email = trim(customer.email);
+    customer.driving_licence = toUpper(trim(customer.driving_licence));
+    if (customer.address.has_value())
+    {
+        customer.address = trim(*customer.address);
+        if (customer.address->empty())
+            customer.address.reset();
+    }
+
+    // Basic presence check.
+    if (customer.first_name.empty() || customer.last_name.empty() || customer.ph_number.empty() ||
+        customer.email.empty() || customer.driving_licence.empty())
+        return "Missing required fields.";
+
+    // Column limits, checked here so a bulk load reports them per row.
+    if (characterCount(customer.first_name) > 50 || characterCount(customer.last_name) > 50)
+        return "Names are limited to 50 characters.";
+
+    if (characterCount(customer.email) > 100)
+        return "Email is limited to 100 characters.";
+
+    // Format validations.
+    if (!isValidPhone(customer.ph_number))
+        return "Invalid phone number (must be 10 digits).";
+
+    if (!isValidEmail(customer.email))
+        return "Invalid email format.";
+
+    if (!isValidLicence(customer.driving_licence))
+        return "Invalid driving licence format (ON-12345678).";
+
+    return "";
+}
+
+// The cursor is a JSON array [first_name, last_name, id] in unpadded
+// base64url, so names containing any character round-trip safely.
+std::string encodeCustomerCursor(const CustomerCursor &cursor)
+{
+    crow::json::wvalue key = crow::json::wvalue::list({cursor.first_name, cursor.last_name, cursor.id});
+    const std::string raw = key.dump();
+    std::string text = crow::utility::base64encode_urlsafe(raw, raw.size());
+    while (!text.empty() && text.back() == '=')
+        text.pop_back();
+    return text;
+}
+
+std::optional<CustomerCursor> decodeCustomerCursor(const std::string &text)
+{
+    if (text.empty() || text.size() > 1024)
+        return std::nullopt;
+    for (char c : text)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+            return std::nullopt;
+    }
+
+    auto key = crow::json::load(crow::utility::base64decode(text, text.size()));
+    if (!key || key.t() != crow::json::type::List || key.size() != 3)
+        return std::nullopt;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (key[i].t() != crow::json::type::String)
+            return std::nullopt;
+    }
+
+    CustomerCursor cursor{std::string(key[0].s()), std::string(key[1].s()), std::string(key[2].s())};
+    if (cursor.id.size() != 36)
+        return std::nullopt;
+    for (size_t i = 0; i < cursor.id.size(); ++i)
+    {
+        const bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+        if (dash ? cursor.id[i] != '-' : !std::isxdigit(static_cast<unsigned char>(cursor.id[i])))
+            return std::nullopt;
+    }
+    return cursor;
+}
+
+CustomerRepository::CustomerRepository(ConnectionGuard &guard) : guard(guard)
+{
+    guard.prepare("customer_list", LIST_SQL);
+    guard.prepare("customer_page_first", PAGE_FIRST_SQL);
+    guard.prepare("customer_page_after", PAGE_AFTER_SQL);
+    guard.prepare("customer_estimate", ESTIMATE_SQL);
+    guard.prepare("customer_by_id", BY_ID_SQL);
+    guard.prepare("customer_overview", OVERVIEW_SQL);
+    guard.prepare("customer_overview_etag", OVERVIEW_ETAG_SQL);
+    guard.prepare("customer_create", CREATE_SQL);
+    guard.prepare("customer_patch", PATCH_SQL);
+}
+
+// Fetches all customers, ordered by first name then last name.
+std::vector<Customer> CustomerRepository::getAllCustomers()
+{
+    pqxx::work txn(guard.get());
+
+    // Keep ordering stable for UI table.
+    pqxx::result r = txn.exec_prepared("customer_list");
+    txn.commit();
+
+    std::vector<Customer> customers;
+    customers.reserve(r.size());
+    for (const auto &row : r)
+        customers.push_back(rowToCustomer(row));
+
+    return customers;
+}
+
+CustomerPage CustomerRepository::listCustomers(int limit, const std::optional<CustomerCursor> &after)
+{
+    pqxx::read_transaction txn(guard.get());
+    pqxx::result r = after
+                         ? txn.exec_prepared("customer_page_after", limit + 1,
+                                             after->first_name, after->last_name, after->id)
+                         : txn.exec_prepared("customer_page_first", limit + 1);
+    pqxx::result estimate = txn.exec_prepared("customer_estimate");
+    txn.commit();
+
+    CustomerPage page;
+    const size_t shown = std::min(r.size(), static_cast<size_t>(limit));
+    page.customers.reserve(shown);
+    for (size_t i = 0; i < shown; ++i)
+        page.customers.push_back(rowToCustomer(r[i]));
+
+    if (r.size() > shown)
+    {
+        const Customer &last = page.customers.back();
+        page.next = CustomerCursor{last.first_name, last.last_name, last.id};
+    }
+    if (!estimate.empty() && estimate[0][0].as<long long>() >= 0)
+        page.estimatedTotal = estimate[0][0].as<long long>();
+    return page;
+}
+
+void CustomerRepository::forEachCustomer(const std::function<void(const Customer &)> &sink, int batchRows)
+{
+    pqxx::read_transaction txn(guard.get());
+    pqxx::icursorstream cursor(txn,
+                               "SELECT id, first_name, last_name, address, ph_number, email, driving_licence "
+                               "FROM Customers ORDER BY id",
+                               "customer_scan", batchRows);
+    pqxx::result batch;
+    while (cursor >> batch)
+    {
+        for (const auto &row : batch)
+            sink(rowToCustomer(row));
+    }
+    txn.commit();
+}
+
+// Fetches a single customer by ID. Returns std::nullopt if not found.
+std::optional<Customer> CustomerRepository::getCustomerById(const std::string &customer_id)
+{
+    pqxx::work txn(guard.get());
+    pqxx::result r = txn.exec_prepared("customer_by_id", customer_id);
+    txn.commit();
+
+    if (r.empty())
+        return std::nullopt;
+
+    return rowToCustomer(r[0]);
+}
+
+std::optional<CustomerOverview> CustomerRepository::getOverview(const std::string &customer_id)
+{
+    pqxx::read_transaction txn(guard.get());
+    pqxx::result r = txn.exec_prepared("customer_overview", customer_id);
+    txn.commit();
+
+    if (r.empty())
+        return std::nullopt;
+
+    return CustomerOverview{overviewETag(r[0]), r[0]["overview"].as<std::string>()};
+}
+
+std::optional<std::string> CustomerRepository::getOverviewETag(const std::string &customer_id)
+{
+    pqxx::read_transaction txn(guard.get());
+    pqxx::result r = txn.exec_prepared("customer_overview_etag", customer_id);
+    txn.commit();
+
+    if (r.empty())
+        return std::nullopt;
+
+    return overviewETag(r[0]);
+}
+
+// Creates a new customer and returns the created record with ID.
+Customer CustomerRepository::createCustomer(const std::string &first_name,
+                                            const std::string &last_name,
+                                            const std::string &ph_number,
+                                            const std::string &email,
+                                            const std::string &driving_licence,
+                                            const std::optional<std::string> &address)
+{
+    NewCustomer customer{first_name, last_name, ph_number, email, driving_licence, address};
+    const std::string problem = normalizeNewCustomer(customer);
+    if (!problem.empty())
+        throw std::invalid_argument(problem);
+
+    pqxx::work txn(guard.get());
+    pqxx::result r = txn.exec_prepared("customer_create",
+                                       newUuidV7(), customer.first_name, customer.last_name,
+                                       customer.ph_number, customer.email, customer.driving_licence,
+                                       orNull(customer.address));
+    txn.commit();
+    return rowToCustomer(r[0]);
+}
+
+// Performs a partial update on a customer. Only provided fields are updated.
+std::optional<Customer> CustomerRepository::patchCustomer(const std::string &customer_id,
+                                                          const std::optional<std::string> &first_name,
+                                                          const std::optional<std::string> &last_name,
+                                                          const std::optional<std::string> &ph_number,
+                                                          const std::optional<std::string> &email,
+                                                          const std::optional<std::string> &driving_licence,
+                                                          const std::optional<std::string> &address)
+{
+    // Normalizes inputs if provided.
+    std::optional<std::string> fn, ln, phone, mail, licence, addr;
+
+    if (first_name.has_value())
+    {
+        fn = trim(*first_name);
+        if (fn->empty())
+            throw std::invalid_argument("first_name cannot be empty.");
+        if (characterCount(*fn) > 50)
+            throw std::invalid_argument("Names are limited to 50 characters.");
+    }
+
+    if (last_name.has_value())
+    {
+        ln = trim(*last_name);
+        if (ln->empty())
+            throw std::invalid_argument("last_name cannot be empty.");
+        if (characterCount(*ln) > 50)
+            throw std::invalid_argument("Names are limited to 50 characters.");
+    }
+
+    if (ph_number.has_value())
+    {
+        phone = trim(*ph_number);
+        if (!isValidPhone(*phone))
+            throw std::invalid_argument("Invalid phone number (must be 10 digits).");
+    }
+
+    if (email.has_value())
+    {
+        mail = trim(*email);
+        if (characterCount(*mail) > 100)
+            throw std::invalid_argument("Email is limited to 100 characters.");
+        if (!isValidEmail(*mail))
+            throw std::invalid_argument("Invalid email format.");
+    }
+
+    if (driving_licence.has_value())
+    {
+        licence = toUpper(trim(*driving_licence));
+        if (!isValidLicence(*licence))
+            throw std::invalid_argument("Invalid driving licence format (ON-12345678).");
+    }
+
+    if (address.has_value())
+        addr = trim(*address); // can be empty string, which means "clear the address"
+
+    if (!fn && !ln && !phone && !mail && !licence && !addr)
+        throw std::invalid_argument("No fields to update.");
+
+    pqxx::work txn(guard.get());
+    pqxx::result r = txn.exec_prepared("customer_patch",
+                                       orNull(fn), orNull(ln), orNull(phone), orNull(mail),
+                                       orNull(licence), orNull(addr), customer_id);
+    txn.commit();
+
+    if (r.empty())
+        return std::nullopt;
+
+    return rowToCustomer(r[0]);
+}
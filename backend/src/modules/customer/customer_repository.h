@@ -0,0 +1,138 @@
+#pragma once
+#include "../../db/db_connection.h"
+#include <pqxx/pqxx>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+    Customer struct maps to a row in the Customers table.
+*/
+struct Customer
+{
+    std::string id;
+    std::string first_name;
+    std::string last_name;
+    std::string address; // empty string represents no address; DB NULL is also treated as empty
+    std::string ph_number;
+    std::string email;
+    std::string driving_licence;
+};
+
+/*
+    Fields of a customer about to be inserted.
+*/
+struct NewCustomer
+{
+    std::string first_name;
+    std::string last_name;
+    std::string ph_number;
+    std::string email;
+    std::string driving_licence;
+    std::optional<std::string> address; // nullopt (or blank) stores NULL
+};
+
+// Trims every field, uppercases the licence and drops a blank address, then
+// checks presence, column lengths and formats: the rules createCustomer applies. Returns the
+// first problem found, or an empty string when the customer is valid.
+std::string normalizeNewCustomer(NewCustomer &customer);
+
+/*
+    Position in the customer listing: the sort key of the last row shown.
+*/
+struct CustomerCursor
+{
+    std::string first_name;
+    std::string last_name;
+    std::string id;
+};
+
+/*
+    One page of the customer listing.
+*/
+struct CustomerPage
+{
+    std::vector<Customer> customers;
+    std::optional<CustomerCursor> next;     // set while more rows follow
+    std::optional<long long> estimatedTotal; // planner's row count; nullopt before the first ANALYZE
+};
+
+/*
+    GET /customers/<id>/overview payload, rendered by the database, with the
+    validator it was rendered at.
+*/
+struct CustomerOverview
+{
+    std::string etag;
+    std::string body; // JSON object: customer, sales, test_drives, stats
+};
+
+// Opaque URL-safe cursor for a listing position, and its inverse
+// (nullopt for anything encodeCustomerCursor could not have produced).
+std::string encodeCustomerCursor(const CustomerCursor &cursor);
+std::optional<CustomerCursor> decodeCustomerCursor(const std::string &text);
+
+/*
+    Data access for the Customers table on a pooled connection.
+
+    Every query is a named prepared statement, prepared once per pooled
+    connection when the first repository is built on it, so repeat calls skip
+    parsing and planning. The repository borrows the caller's ConnectionGuard:
+    routes keep the guard in its own scope and let it go before building JSON,
+    so the connection goes back to the pool as soon as the rows are read.
+
+    Invalid input throws std::invalid_argument before any SQL runs; database
+    errors (unique violations and so on) surface as pqxx::sql_error.
+*/
+class CustomerRepository
+{
+public:
+    explicit CustomerRepository(ConnectionGuard &guard);
+
+    // Returns all customers, ordered by first name, last name, then id.
+    std::vector<Customer> getAllCustomers();
+
+    // Returns up to `limit` customers in getAllCustomers() order, starting
+    // after `after`. Served by idx_customers_name_id, so a deep page costs the
+    // same as the first.
+    CustomerPage listCustomers(int limit, const std::optional<CustomerCursor> &after);
+
+    // Feeds every customer to `sink` in batches of `batchRows` through a
+    // server-side cursor, so a full scan never holds the whole table.
+    void forEachCustomer(const std::function<void(const Customer &)> &sink, int batchRows = 5000);
+
+    // Returns a single customer by ID, or nullopt if not found.
+    std::optional<Customer> getCustomerById(const std::string &customer_id);
+
+    // The customer's profile, purchases, test drives and lifetime stats in
+    // one statement, or nullopt if the id does not exist.
+    std::optional<CustomerOverview> getOverview(const std::string &customer_id);
+
+    // The ETag getOverview() would return now, without aggregating anything:
+    // the customer's version, the summed versions of the vehicles the overview
+    // shows, and the current date (the stats split test drives into past and
+    // upcoming). Nullopt if the id does not exist.
+    std::optional<std::string> getOverviewETag(const std::string &customer_id);
+
+    // Validates, normalizes and inserts a customer; returns the stored row.
+    Customer createCustomer(const std::string &first_name,
+                            const std::string &last_name,
+                            const std::string &ph_number,
+                            const std::string &email,
+                            const std::string &driving_licence,
+                            const std::optional<std::string> &address);
+
+    // Applies the provided fields; an empty address clears it.
+    // Returns the updated customer, or nullopt if the id does not exist.
+    std::optional<Customer> patchCustomer(const std::string &customer_id,
+                                          const std::optional<std::string> &first_name,
+                                          const std::optional<std::string> &last_name,
+                                          const std::optional<std::string> &ph_number,
+                                          const std::optional<std::string> &email,
+                                          const std::optional<std::string> &driving_licence,
+                                          const std::optional<std::string> &address);
+
+private:
+    ConnectionGuard &guard;
+};
@@ -0,0 +1,459 @@
+#include "customer_search.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+
+namespace
+{
+    bool isAsciiSpace(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    char lower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    std::string digitsOf(std::string_view text)
+    {
+        std::string out;
+        for (char c : text)
+        {
+            if (c >= '0' && c <= '9')
+                out += c;
+        }
+        return out;
+    }
+
+    bool hasLetter(std::string_view text)
+    {
+        for (char c : text)
+        {
+            const char l = lower(c);
+            if (l >= 'a' && l <= 'z')
+                return true;
+        }
+        return false;
+    }
+
+    uint32_t packTrigram(char a, char b, char c)
+    {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(a)) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(c));
+    }
+
+    // pg_trgm-style trigrams of one normalized word, padded with two spaces
+    // in front and one behind. Returns a sorted set.
+    std::vector<uint32_t> trigramsOf(std::string_view word)
+    {
+        const std::string padded = "  " + std::string(word) + " ";
+        std::vector<uint32_t> out;
+        for (size_t i = 0; i + 3 <= padded.size(); ++i)
+            out.push_back(packTrigram(padded[i], padded[i + 1], padded[i + 2]));
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    // Splits normalized text on its single spaces.
+    std::vector<std::string_view> wordsOf(std::string_view normalized)
+    {
+        std::vector<std::string_view> out;
+        size_t start = 0;
+        while (start < normalized.size())
+        {
+            size_t end = normalized.find(' ', start);
+            if (end == std::string_view::npos)
+                end = normalized.size();
+            out.push_back(normalized.substr(start, end - start));
+            start = end + 1;
+        }
+        return out;
+    }
+
+    // Only name-like words get fuzzy matching; emails, phone numbers and
+    // licences are matched by prefix alone.
+    bool isNameWord(std::string_view word)
+    {
+        for (char c : word)
+        {
+            if (!((c >= 'a' && c <= 'z') || c == '-' || c == '\''))
+                return false;
+        }
+        return true;
+    }
+
+    std::string nameText(const Customer &c)
+    {
+        return CustomerSearchIndex::normalize(c.first_name + " " + c.last_name);
+    }
+}
+
+std::string CustomerSearchIndex::normalize(std::string_view text)
+{
+    std::string out;
+    out.reserve(text.size());
+    bool pendingSpace = false;
+    for (char c : text)
+    {
+        if (isAsciiSpace(c))
+        {
+            pendingSpace = !out.empty();
+            continue;
+        }
+        if (pendingSpace)
+            out += ' ';
+        pendingSpace = false;
+        out += lower(c);
+    }
+    return out;
+}
+
+void CustomerSearchIndex::sortKeys(std::vector<Key> &list) const
+{
+    std::sort(list.begin(), list.end(), [this](const Key &a, const Key &b)
+              { return text(a) < text(b); });
+}
+
+// Appends the keys and postings of docs[doc] at its current generation.
+void CustomerSearchIndex::indexLocked(uint32_t doc, std::vector<Key> &into)
+{
+    const Doc &d = docs[doc];
+    const Customer &c = d.customer;
+    const std::string texts[] = {
+        normalize(c.last_name),
+        normalize(c.first_name),
+        nameText(c),
+        normalize(c.email),
+        digitsOf(c.ph_number),
+        normalize(c.driving_licence),
+    };
+    for (const auto &t : texts)
+    {
+        if (t.empty())
+            continue;
+        into.push_back(Key{static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(t.size()), doc, d.generation});
+        arena += t;
+    }
+
+    for (const std::string &name : {normalize(c.first_name), normalize(c.last_name)})
+    {
+        for (std::string_view w : wordsOf(name))
+        {
+            auto [it, inserted] = wordIds.try_emplace(std::string(w), static_cast<uint32_t>(words.size()));
+            if (inserted)
+            {
+                const std::vector<uint32_t> grams = trigramsOf(w);
+                words.push_back(Word{static_cast<uint32_t>(grams.size()), {}});
+                for (uint32_t g : grams)
+                    trigrams[g].push_back(it->second);
+            }
+            std::vector<Posting> &postings = words[it->second].docs;
+            if (postings.empty() || postings.back().doc != doc || postings.back().generation != d.generation)
+                postings.push_back(Posting{doc, d.generation});
+        }
+    }
+}
+
+void CustomerSearchIndex::mergeRecentLocked()
+{
+    std::vector<Key> merged;
+    merged.reserve(keys.size() + recent.size());
+    auto isLive = [this](const Key &k)
+    { return live(k.doc, k.generation); };
+    auto less = [this](const Key &a, const Key &b)
+    { return text(a) < text(b); };
+
+    auto a = keys.begin();
+    auto b = recent.begin();
+    while (a != keys.end() || b != recent.end())
+    {
+        const bool takeA = b == recent.end() || (a != keys.end() && !less(*b, *a));
+        const Key &k = takeA ? *a++ : *b++;
+        if (isLive(k))
+            merged.push_back(k);
+    }
+    keys.swap(merged);
+    recent.clear();
+}
+
+// Re-indexes every document from scratch, dropping stale keys, postings and
+// their arena text.
+void CustomerSearchIndex::rebuildLocked()
+{
+    arena.clear();
+    keys.clear();
+    recent.clear();
+    words.clear();
+    wordIds.clear();
+    trigrams.clear();
+    staleKeys = 0;
+    for (uint32_t doc = 0; doc < docs.size(); ++doc)
+        indexLocked(doc, keys);
+    sortKeys(keys);
+}
+
+void CustomerSearchIndex::reload(const std::function<void(const Sink &)> &source)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        reloading = true;
+        pendingUpserts.clear();
+    }
+
+    // Scan and index outside the lock; searches keep using the old contents.
+    CustomerSearchIndex fresh;
+    try
+    {
+        source([&fresh](const Customer &c)
+               {
+            auto [it, inserted] = fresh.slots.try_emplace(c.id, static_cast<uint32_t>(fresh.docs.size()));
+            if (inserted)
+                fresh.docs.push_back(Doc{c, 0});
+            else
+                fresh.docs[it->second].customer = c; });
+    }
+    catch (...)
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        reloading = false;
+        pendingUpserts.clear();
+        throw;
+    }
+    fresh.rebuildLocked();
+    fresh.isLoaded = true;
+
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    for (const Customer &c : pendingUpserts)
+        fresh.upsertLocked(c);
+    pendingUpserts.clear();
+    reloading = false;
+
+    docs.swap(fresh.docs);
+    slots.swap(fresh.slots);
+    arena.swap(fresh.arena);
+    keys.swap(fresh.keys);
+    recent.swap(fresh.recent);
+    words.swap(fresh.words);
+    wordIds.swap(fresh.wordIds);
+    trigrams.swap(fresh.trigrams);
+    staleKeys = fresh.staleKeys;
+    isLoaded = true;
+}
+
+void CustomerSearchIndex::upsert(const Customer &customer)
+{
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    if (reloading)
+        pendingUpserts.push_back(customer);
+    if (isLoaded)
+        upsertLocked(customer);
+}
+
+void CustomerSearchIndex::upsertLocked(const Customer &customer)
+{
+    auto [it, inserted] = slots.try_emplace(customer.id, static_cast<uint32_t>(docs.size()));
+    if (inserted)
+    {
+        docs.push_back(Doc{customer, 0});
+    }
+    else
+    {
+        Doc &d = docs[it->second];
+        staleKeys += 6;
+        d.customer = customer;
+        ++d.generation;
+    }
+
+    std::vector<Key> added;
+    indexLocked(it->second, added);
+    sortKeys(added);
+    for (const Key &k : added)
+    {
+        auto pos = std::upper_bound(recent.begin(), recent.end(), k, [this](const Key &a, const Key &b)
+                                    { return text(a) < text(b); });
+        recent.insert(pos, k);
+    }
+
+    if (staleKeys > keys.size() / 2 + MERGE_THRESHOLD)
+        rebuildLocked();
+    else if (recent.size() > MERGE_THRESHOLD)
+        mergeRecentLocked();
+}
+
+// Collects up to `limit` distinct live documents with a key starting with
+// `prefix`, walking the main and recent arrays together in key order.
+void CustomerSearchIndex::prefixMatches(std::string_view prefix, size_t limit, std::vector<uint32_t> &out) const
+{
+    auto startOf = [&](const std::vector<Key> &list)
+    {
+        return std::lower_bound(list.begin(), list.end(), prefix, [this](const Key &k, std::string_view p)
+                                { return text(k) < p; });
+    };
+    auto matches = [&](std::vector<Key>::const_iterator it, const std::vector<Key> &list)
+    {
+        return it != list.end() && text(*it).substr(0, prefix.size()) == prefix;
+    };
+
+    auto a = startOf(keys);
+    auto b = startOf(recent);
+    while (out.size() < limit)
+    {
+        const bool hasA = matches(a, keys);
+        const bool hasB = matches(b, recent);
+        if (!hasA && !hasB)
+            break;
+        const bool takeA = hasA && (!hasB || text(*a) <= text(*b));
+        const Key &k = takeA ? *a++ : *b++;
+        if (live(k.doc, k.generation) && std::find(out.begin(), out.end(), k.doc) == out.end())
+            out.push_back(k.doc);
+    }
+}
+
+// Appends up to `limit` fuzzy hits for documents not in `exclude`. A
+// document's score is the mean, over query words, of the best similarity
+// between that word and any of the document's name words.
+void CustomerSearchIndex::fuzzyMatches(std::string_view query, size_t limit, const std::vector<uint32_t> &exclude,
+                                       std::vector<Hit> &out) const
+{
+    const std::vector<std::string_view> queryWords = wordsOf(query);
+    if (queryWords.empty() || !std::all_of(queryWords.begin(), queryWords.end(), isNameWord))
+        return;
+
+    // Per-thread scratch, sized to the index and left zeroed between calls.
+    thread_local std::vector<uint16_t> shared;
+    thread_local std::vector<uint32_t> touchedWords;
+    thread_local std::vector<float> total;
+    thread_local std::vector<uint32_t> credited;
+    thread_local std::vector<uint32_t> touchedDocs;
+    thread_local uint32_t pass = 0;
+    if (shared.size() < words.size())
+        shared.resize(words.size(), 0);
+    if (total.size() < docs.size())
+    {
+        total.resize(docs.size(), 0.0f);
+        credited.resize(docs.size(), 0);
+    }
+    touchedDocs.clear();
+
+    for (std::string_view word : queryWords)
+    {
+        if (++pass == 0)
+        {
+            std::fill(credited.begin(), credited.end(), 0);
+            pass = 1;
+        }
+
+        const std::vector<uint32_t> grams = trigramsOf(word);
+        touchedWords.clear();
+        for (uint32_t g : grams)
+        {
+            auto it = trigrams.find(g);
+            if (it == trigrams.end())
+                continue;
+            for (uint32_t w : it->second)
+            {
+                if (shared[w]++ == 0)
+                    touchedWords.push_back(w);
+            }
+        }
+
+        std::vector<std::pair<float, uint32_t>> similar;
+        for (uint32_t w : touchedWords)
+        {
+            const float common = shared[w];
+            shared[w] = 0;
+            const float similarity = common / (grams.size() + words[w].trigramCount - common);
+            if (similarity >= FUZZY_THRESHOLD)
+                similar.emplace_back(similarity, w);
+        }
+
+        // Best word first, so a document is credited with its best match.
+        // With a single query word nothing later can outscore what is already
+        // collected, so the walk stops once enough documents are in hand.
+        std::sort(similar.begin(), similar.end(), [](const auto &a, const auto &b)
+                  { return a.first > b.first; });
+        const size_t enough = queryWords.size() == 1 ? limit + exclude.size() : SIZE_MAX;
+        for (size_t i = 0; i < similar.size() && touchedDocs.size() < enough; ++i)
+        {
+            const auto [similarity, w] = similar[i];
+            for (const Posting &p : words[w].docs)
+            {
+                if (!live(p.doc, p.generation) || credited[p.doc] == pass)
+                    continue;
+                credited[p.doc] = pass;
+                if (total[p.doc] == 0.0f)
+                    touchedDocs.push_back(p.doc);
+                total[p.doc] += similarity;
+                if (touchedDocs.size() >= enough)
+                    break;
+            }
+        }
+    }
+
+    std::vector<uint32_t> skip(exclude);
+    std::sort(skip.begin(), skip.end());
+    std::vector<std::pair<double, uint32_t>> scored;
+    for (uint32_t doc : touchedDocs)
+    {
+        const double score = total[doc] / queryWords.size();
+        total[doc] = 0.0f;
+        if (score >= FUZZY_THRESHOLD && !std::binary_search(skip.begin(), skip.end(), doc))
+            scored.emplace_back(score, doc);
+    }
+
+    const size_t room = std::min(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + room, scored.end(),
+                      [](const auto &a, const auto &b)
+                      { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+    for (size_t i = 0; i < room; ++i)
+        out.push_back(Hit{docs[scored[i].second].customer, true, scored[i].first});
+}
+
+std::vector<CustomerSearchIndex::Hit> CustomerSearchIndex::search(std::string_view query, size_t limit) const
+{
+    std::vector<Hit> hits;
+    const std::string q = normalize(query);
+    if (q.empty() || limit == 0)
+        return hits;
+
+    std::shared_lock<std::shared_mutex> lock(mtx);
+
+    std::vector<uint32_t> found;
+    prefixMatches(q, limit, found);
+
+    // "(519) 555-01" finds phone 5195550123.
+    if (!hasLetter(q))
+    {
+        const std::string digits = digitsOf(q);
+        if (digits.size() >= 3 && digits != q)
+            prefixMatches(digits, limit, found);
+    }
+
+    for (uint32_t doc : found)
+        hits.push_back(Hit{docs[doc].customer, false, 1.0});
+    if (hits.size() < limit && q.size() >= 3)
+        fuzzyMatches(q, limit - hits.size(), found, hits);
+    return hits;
+}
+
+size_t CustomerSearchIndex::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return slots.size();
+}
+
+bool CustomerSearchIndex::loaded() const
+{
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return isLoaded;
+}
+
+CustomerSearchIndex &customerSearchIndex()
+{
+    static CustomerSearchIndex index;
+    return index;
+}
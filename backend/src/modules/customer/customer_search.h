@@ -0,0 +1,129 @@
+#pragma once
+#include "customer_repository.h"
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+    In-memory customer lookup for GET /customers/search.
+
+    Prefix matching: every customer contributes a few normalized keys
+    (lowercased last name, first name, "first last", email, phone digits and
+    licence). Keys live in one sorted array, so a prefix is a binary search
+    followed by a short forward walk. Writes go to a small sorted side array
+    that is merged into the main one once it passes MERGE_THRESHOLD, so an
+    upsert never shifts the whole array.
+
+    Fuzzy matching: distinct first- and last-name words form a vocabulary,
+    split into pg_trgm-style trigrams with a posting list of words per
+    trigram. Each query word is scored against the vocabulary by trigram
+    similarity (shared / union, as pg_trgm does); the words at or above
+    FUZZY_THRESHOLD lead to their customers, so "jonson" still finds Johnson.
+    Names repeat heavily, so the vocabulary is far smaller than the customer
+    list and a fuzzy query never walks per-customer trigram lists.
+
+    An update bumps the customer's generation instead of deleting its old
+    keys and postings; readers skip entries from older generations, and the
+    stale ones are dropped at the next rebuild.
+
+    Key text is stored once in a shared character arena and referenced by
+    offset, which keeps each key entry at 16 bytes.
+*/
+class CustomerSearchIndex
+{
+public:
+    // Side-array size at which recent keys are merged into the main array.
+    static constexpr size_t MERGE_THRESHOLD = 4096;
+    static constexpr double FUZZY_THRESHOLD = 0.3;
+
+    struct Hit
+    {
+        Customer customer;
+        bool fuzzy = false; // false: prefix match
+        double score = 1.0; // trigram similarity for fuzzy hits
+    };
+
+    using Sink = std::function<void(const Customer &)>;
+
+    // Replaces the contents with the customers `source` feeds to its sink.
+    // The new index is built without the lock and swapped in under a short
+    // write lock; upserts issued meanwhile are queued and applied on top of
+    // the loaded snapshot. Reloads must not run concurrently.
+    void reload(const std::function<void(const Sink &)> &source);
+
+    // Adds a customer, or replaces the indexed fields of an existing one.
+    // Ignored before the first reload() unless one is running: that load
+    // will include it.
+    void upsert(const Customer &customer);
+
+    // Prefix hits first (in key order), then fuzzy hits by descending score,
+    // at most `limit` customers in total.
+    std::vector<Hit> search(std::string_view query, size_t limit) const;
+
+    size_t size() const;
+    bool loaded() const;
+
+    // Lowercases ASCII letters, trims, and collapses whitespace runs.
+    static std::string normalize(std::string_view text);
+
+private:
+    struct Doc
+    {
+        Customer customer;
+        uint32_t generation = 0;
+    };
+
+    struct Key
+    {
+        uint32_t offset; // into arena
+        uint32_t length;
+        uint32_t doc;
+        uint32_t generation;
+    };
+
+    struct Posting
+    {
+        uint32_t doc;
+        uint32_t generation;
+    };
+
+    struct Word
+    {
+        uint32_t trigramCount;
+        std::vector<Posting> docs;
+    };
+
+    std::string_view text(const Key &key) const { return std::string_view(arena).substr(key.offset, key.length); }
+    bool live(uint32_t doc, uint32_t generation) const { return docs[doc].generation == generation; }
+
+    void upsertLocked(const Customer &customer);
+    void indexLocked(uint32_t doc, std::vector<Key> &into);
+    void sortKeys(std::vector<Key> &keys) const;
+    void mergeRecentLocked();
+    void rebuildLocked();
+
+    void prefixMatches(std::string_view prefix, size_t limit, std::vector<uint32_t> &out) const;
+    void fuzzyMatches(std::string_view query, size_t limit, const std::vector<uint32_t> &exclude,
+                      std::vector<Hit> &out) const;
+
+    mutable std::shared_mutex mtx;
+    bool isLoaded = false;
+    bool reloading = false;
+    std::vector<Customer> pendingUpserts; // upserts made while reload() runs
+    std::vector<Doc> docs;
+    std::unordered_map<std::string, uint32_t> slots; // customer id -> docs index
+    std::string arena;
+    std::vector<Key> keys;   // sorted by text
+    std::vector<Key> recent; // sorted by text, merged into keys past MERGE_THRESHOLD
+    std::vector<Word> words;
+    std::unordered_map<std::string, uint32_t> wordIds;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams; // trigram -> word ids
+    size_t staleKeys = 0;
+};
+
+// Process-wide index used by the customer routes.
+CustomerSearchIndex &customerSearchIndex();
@@ -0,0 +1,429 @@
+#include "image_variants.h"
+#include "upload_files.h"
+#include "../../db/db_connection.h"
+#include "../../external/crow/crow_all.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <jpeglib.h>
+
+namespace {
+    constexpr unsigned VARIANT_WORKERS = 2;
+    // 50 MP of RGB is 150 MB; anything bigger is not a vehicle photo.
+    constexpr uint64_t MAX_DECODED_PIXELS = 50000000;
+
+    // libjpeg's default error handler calls exit(); this one jumps back to
+    // the caller's setjmp instead.
+    struct JpegError {
+        jpeg_error_mgr mgr;
+        std::jmp_buf jump;
+        char message[JMSG_LENGTH_MAX];
+    };
+
+    void onJpegError(j_common_ptr cinfo) {
+        auto* err = reinterpret_cast<JpegError*>(cinfo->err);
+        (*cinfo->err->format_message)(cinfo, err->message);
+        std::longjmp(err->jump, 1);
+    }
+
+    // Corrupt-data warnings would otherwise go to stderr per image.
+    void onJpegMessage(j_common_ptr) {}
+
+    struct FileCloser {
+        void operator()(FILE* f) const {
+            if (f) std::fclose(f);
+        }
+    };
+    using FilePtr = std::unique_ptr<FILE, FileCloser>;
+
+    // Source columns (or rows) covered by one output column, with the share
+    // of each that falls inside it.
+    struct AreaTaps {
+        int first = 0;
+        std::vector<float> weights;
+    };
+
+    std::vector<AreaTaps> areaTaps(int source, int target) {
+        const double scale = static_cast<double>(source) / target;
+        std::vector<AreaTaps> taps(target);
+        for (int o = 0; o < target; ++o) {
+            const double begin = o * scale;
+            const double end = std::min<double>(source, (o + 1) * scale);
+            AreaTaps& t = taps[o];
+            t.first = static_cast<int>(begin);
+            const int last = std::min(source - 1, static_cast<int>(std::ceil(end)) - 1);
+            for (int i = t.first; i <= last; ++i) {
+                const double covered = std::min<double>(end, i + 1) - std::max<double>(begin, i);
+                t.weights.push_back(static_cast<float>(covered / (end - begin)));
+            }
+        }
+        return taps;
+    }
+
+    uint8_t toByte(float v) {
+        return static_cast<uint8_t>(std::clamp(v + 0.5f, 0.0f, 255.0f));
+    }
+
+    // EXIF orientation (1-8) from a saved APP1 marker, or 1 when there is
+    // none. Only IFD0 is read; the tag is always there when a camera sets it.
+    int exifOrientation(const jpeg_decompress_struct& cinfo) {
+        for (jpeg_saved_marker_ptr m = cinfo.marker_list; m; m = m->next) {
+            if (m->marker != JPEG_APP0 + 1 || m->data_length < 14) continue;
+            const uint8_t* exif = m->data;
+            if (std::memcmp(exif, "Exif\0\0", 6) != 0) continue;
+            const uint8_t* tiff = exif + 6;
+            const size_t size = m->data_length - 6;
+
+            const bool little = tiff[0] == 'I' && tiff[1] == 'I';
+            if (!little && !(tiff[0] == 'M' && tiff[1] == 'M')) return 1;
+            auto u16 = [&](size_t at) {
+                return little ? tiff[at] | tiff[at + 1] << 8 : tiff[at] << 8 | tiff[at + 1];
+            };
+            auto u32 = [&](size_t at) {
+                return little ? uint32_t(u16(at)) | uint32_t(u16(at + 2)) << 16
+                              : uint32_t(u16(at)) << 16 | uint32_t(u16(at + 2));
+            };
+
+            const size_t ifd = u32(4);
+            if (ifd + 2 > size) return 1;
+            const size_t entries = u16(ifd);
+            for (size_t i = 0; i < entries && ifd + 2 + (i + 1) * 12 <= size; ++i) {
+                const size_t entry = ifd + 2 + i * 12;
+                if (u16(entry) == 0x0112) {
+                    const int value = u16(entry + 8);
+                    return value >= 1 && value <= 8 ? value : 1;
+                }
+            }
+            return 1;
+        }
+        return 1;
+    }
+
+    // Applies an EXIF orientation to decoded pixels, so the result is the
+    // image as a viewer shows it. Orientations 5-8 swap width and height.
+    RgbImage orient(RgbImage source, int orientation) {
+        if (orientation <= 1 || orientation > 8) return source;
+        const int w = source.width, h = source.height;
+        const bool swaps = orientation >= 5;
+
+        RgbImage out;
+        out.width = swaps ? h : w;
+        out.height = swaps ? w : h;
+        out.pixels.resize(source.pixels.size());
+        for (int y = 0; y < out.height; ++y) {
+            for (int x = 0; x < out.width; ++x) {
+                int sx = x, sy = y;
+                switch (orientation) {
+                    case 2: sx = w - 1 - x; break;                 // mirrored
+                    case 3: sx = w - 1 - x; sy = h - 1 - y; break; // upside down
+                    case 4: sy = h - 1 - y; break;                 // mirrored, upside down
+                    case 5: sx = y; sy = x; break;                 // transposed
+                    case 6: sx = y; sy = h - 1 - x; break;         // turned 90 degrees clockwise
+                    case 7: sx = w - 1 - y; sy = h - 1 - x; break; // transverse
+                    case 8: sx = w - 1 - y; sy = x; break;         // turned 90 degrees anticlockwise
+                }
+                const uint8_t* src = source.pixels.data() + (static_cast<size_t>(sy) * w + sx) * 3;
+                std::copy(src, src + 3, out.pixels.data() + (static_cast<size_t>(y) * out.width + x) * 3);
+            }
+        }
+        return out;
+    }
+}
+
+std::string variantFileName(std::string_view original, int width) {
+    const size_t dot = original.find_last_of('.');
+    const std::string_view stem = original.substr(0, dot);
+    const std::string_view ext = dot == std::string_view::npos ? std::string_view(".jpg") : original.substr(dot);
+    return std::string(stem) + "_w" + std::to_string(width) + std::string(ext);
+}
+
+DecodedJpeg decodeJpegFile(const std::string& path, int minWidth) {
+    FilePtr file(std::fopen(path.c_str(), "rb"));
+    if (!file) throw std::runtime_error("cannot open " + path);
+
+    DecodedJpeg decoded;
+    jpeg_decompress_struct cinfo{};
+    JpegError err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = onJpegError;
+    err.mgr.output_message = onJpegMessage;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        throw std::runtime_error("cannot decode " + path + ": " + err.message);
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, file.get());
+    jpeg_save_markers(&cinfo, JPEG_APP0 + 1, 0xFFFF);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+
+    // Phones store portrait photos sideways with an EXIF orientation; the
+    // displayed width is the stored height for orientations 5-8.
+    const int orientation = exifOrientation(cinfo);
+    const bool swaps = orientation >= 5;
+    const JDIMENSION displayedWidth = swaps ? cinfo.image_height : cinfo.image_width;
+
+    // DCT-domain scaling skips most of the IDCT work for large photos.
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    if (minWidth > 0) {
+        for (unsigned denom : {8u, 4u, 2u}) {
+            if ((displayedWidth + denom - 1) / denom >= static_cast<unsigned>(minWidth)) {
+                cinfo.scale_denom = denom;
+                break;
+            }
+        }
+    }
+    jpeg_calc_output_dimensions(&cinfo);
+    if (static_cast<uint64_t>(cinfo.output_width) * cinfo.output_height > MAX_DECODED_PIXELS) {
+        jpeg_destroy_decompress(&cinfo);
+        throw std::runtime_error("image too large: " + path);
+    }
+
+    jpeg_start_decompress(&cinfo);
+    RgbImage& image = decoded.image;
+    image.width = static_cast<int>(cinfo.output_width);
+    image.height = static_cast<int>(cinfo.output_height);
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+    const size_t stride = static_cast<size_t>(image.width) * 3;
+
+    JSAMPROW rows[16];
+    while (cinfo.output_scanline < cinfo.output_height) {
+        const JDIMENSION start = cinfo.output_scanline;
+        const JDIMENSION count = std::min<JDIMENSION>(16, cinfo.output_height - start);
+        for (JDIMENSION i = 0; i < count; ++i) rows[i] = image.pixels.data() + (start + i) * stride;
+        jpeg_read_scanlines(&cinfo, rows, count);
+    }
+    jpeg_finish_decompress(&cinfo);
+
+    decoded.originalWidth = static_cast<int>(swaps ? cinfo.image_height : cinfo.image_width);
+    decoded.originalHeight = static_cast<int>(swaps ? cinfo.image_width : cinfo.image_height);
+    jpeg_destroy_decompress(&cinfo);
+    decoded.image = orient(std::move(decoded.image), orientation);
+    return decoded;
+}
+
+void encodeJpegFile(const std::string& path, const RgbImage& image, int quality) {
+    // A dot-prefixed temporary name: /uploads never serves those.
+    static std::atomic<unsigned> sequence{0};
+    const size_t slash = path.find_last_of('/');
+    const std::string tmp = path.substr(0, slash + 1) + "." + path.substr(slash + 1) + ".tmp" +
+                            std::to_string(sequence.fetch_add(1));
+
+    FilePtr file(std::fopen(tmp.c_str(), "wb"));
+    if (!file) throw std::runtime_error("cannot create " + tmp);
+
+    jpeg_compress_struct cinfo{};
+    JpegError err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = onJpegError;
+    if (setjmp(err.jump)) {
+        jpeg_destroy_compress(&cinfo);
+        file.reset();
+        std::remove(tmp.c_str());
+        throw std::runtime_error("cannot encode " + path + ": " + err.message);
+    }
+
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, file.get());
+    cinfo.image_width = static_cast<JDIMENSION>(image.width);
+    cinfo.image_height = static_cast<JDIMENSION>(image.height);
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    cinfo.optimize_coding = TRUE;
+
+    jpeg_start_compress(&cinfo, TRUE);
+    const size_t stride = static_cast<size_t>(image.width) * 3;
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = const_cast<uint8_t*>(image.pixels.data() + cinfo.next_scanline * stride);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    const bool written = std::fflush(file.get()) == 0 && !std::ferror(file.get());
+    file.reset();
+    if (!written || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("cannot write " + path);
+    }
+}
+
+RgbImage resizeToWidth(const RgbImage& source, int width) {
+    RgbImage out;
+    out.width = width;
+    out.height = std::max(1, static_cast<int>(std::lround(static_cast<double>(source.height) * width / source.width)));
+    out.pixels.resize(static_cast<size_t>(out.width) * out.height * 3);
+
+    const std::vector<AreaTaps> columns = areaTaps(source.width, out.width);
+    const std::vector<AreaTaps> rows = areaTaps(source.height, out.height);
+    const size_t sourceStride = static_cast<size_t>(source.width) * 3;
+
+    // Blend the source rows under each output row, then the columns of that
+    // blended row: one pass over the source and one float row of memory.
+    std::vector<float> blended(sourceStride);
+    for (int y = 0; y < out.height; ++y) {
+        std::fill(blended.begin(), blended.end(), 0.0f);
+        const AreaTaps& r = rows[y];
+        for (size_t k = 0; k < r.weights.size(); ++k) {
+            const uint8_t* src = source.pixels.data() + (r.first + k) * sourceStride;
+            const float w = r.weights[k];
+            for (size_t i = 0; i < sourceStride; ++i) blended[i] += w * src[i];
+        }
+
+        uint8_t* dst = out.pixels.data() + static_cast<size_t>(y) * out.width * 3;
+        for (int x = 0; x < out.width; ++x) {
+            const AreaTaps& c = columns[x];
+            float red = 0, green = 0, blue = 0;
+            const float* px = blended.data() + static_cast<size_t>(c.first) * 3;
+            for (size_t k = 0; k < c.weights.size(); ++k, px += 3) {
+                red += c.weights[k] * px[0];
+                green += c.weights[k] * px[1];
+                blue += c.weights[k] * px[2];
+            }
+            dst[x * 3] = toByte(red);
+            dst[x * 3 + 1] = toByte(green);
+            dst[x * 3 + 2] = toByte(blue);
+        }
+    }
+    return out;
+}
+
+ImageVariantResult generateImageVariants(const std::string& directory, const std::string& filename) {
+    // Decode just large enough for the widest variant.
+    DecodedJpeg decoded = decodeJpegFile(directory + filename, IMAGE_VARIANTS[std::size(IMAGE_VARIANTS) - 1].width);
+
+    ImageVariantResult result;
+    result.width = decoded.originalWidth;
+    result.height = decoded.originalHeight;
+
+    // Widest first, each one scaled down from the previous, so the smaller
+    // sizes read fewer pixels.
+    const RgbImage* source = &decoded.image;
+    RgbImage previous;
+    for (size_t i = std::size(IMAGE_VARIANTS); i-- > 0;) {
+        const int width = IMAGE_VARIANTS[i].width;
+        if (width >= result.width) continue;
+
+        RgbImage variant = source->width == width ? *source : resizeToWidth(*source, width);
+        encodeJpegFile(directory + variantFileName(filename, width), variant);
+        result.widths.insert(result.widths.begin(), width);
+        previous = std::move(variant);
+        source = &previous;
+    }
+    return result;
+}
+
+ImageVariantQueue::ImageVariantQueue(unsigned threads) : threadCount(std::max(1u, threads)) {}
+
+ImageVariantQueue::~ImageVariantQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ImageVariantQueue::enqueue(const std::string& imageId, const std::string& filename) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (workers.empty()) {
+            for (unsigned i = 0; i < threadCount; ++i) workers.emplace_back([this] { run(); });
+        }
+        jobs.push_back({imageId, filename});
+    }
+    cv.notify_one();
+}
+
+void ImageVariantQueue::enqueuePending() {
+    std::vector<Job> found;
+    {
+        ConnectionGuard guard(getPool());
+        pqxx::work txn(guard.get());
+        pqxx::result r = txn.exec(
+            "SELECT id, img_url FROM Images "
+            "WHERE width IS NULL AND img_url LIKE '/uploads/%' "
+            "ORDER BY id"
+        );
+        for (const auto& row : r) {
+            std::string url = row["img_url"].as<std::string>();
+            std::string filename = url.substr(url.find_last_of('/') + 1);
+            if (isSafeUploadName(filename)) found.push_back({row["id"].as<std::string>(), filename});
+        }
+    }
+    for (const Job& job : found) enqueue(job.imageId, job.filename);
+}
+
+size_t ImageVariantQueue::pending() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return jobs.size() + running;
+}
+
+void ImageVariantQueue::run() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            ++running;
+        }
+        try {
+            process(job);
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Image variants for " << job.filename << " failed: " << e.what();
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        --running;
+    }
+}
+
+void ImageVariantQueue::process(const Job& job) {
+    ImageVariantResult result;
+    try {
+        result = generateImageVariants(UPLOAD_DIR, job.filename);
+    } catch (const std::runtime_error& e) {
+        // Not a decodable JPEG (or gone): record 0x0 so it is not retried,
+        // and /uploads keeps serving the original for every width.
+        CROW_LOG_WARNING << "Image variants for " << job.filename << " skipped: " << e.what();
+    }
+
+    std::string widths = "{";
+    for (size_t i = 0; i < result.widths.size(); ++i) {
+        if (i > 0) widths += ",";
+        widths += std::to_string(result.widths[i]);
+    }
+    widths += "}";
+
+    ConnectionGuard guard(getPool());
+    guard.prepare("image_set_variants",
+                  "UPDATE Images SET width = $2, height = $3, variant_widths = $4::int[] WHERE id = $1");
+    pqxx::work txn(guard.get());
+    pqxx::result r = txn.exec_prepared("image_set_variants", job.imageId, result.width, result.height, widths);
+    txn.commit();
+
+    // The image was deleted while its variants were being written: its
+    // DELETE already removed what existed then, so remove what came after.
+    // Either way the cache may hold a recent miss for each name.
+    for (int width : result.widths) {
+        const std::string variant = variantFileName(job.filename, width);
+        if (r.affected_rows() == 0) std::remove((UPLOAD_DIR + variant).c_str());
+        uploadFiles().forget(variant);
+    }
+}
+
+ImageVariantQueue& imageVariantQueue() {
+    static ImageVariantQueue queue(VARIANT_WORKERS);
+    return queue;
+}
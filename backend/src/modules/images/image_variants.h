@@ -0,0 +1,121 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/// @file image_variants.h
+/// @brief Fixed-width JPEG variants of uploaded vehicle photos.
+///
+/// Each upload is decoded once in the background and re-encoded at the
+/// widths in IMAGE_VARIANTS, next to the original ("<stem>_w320.jpg" beside
+/// "<stem>.jpg"). Only widths below the original's are produced; the widths
+/// that exist are recorded on the Images row, and GET /uploads/<name>?w=N
+/// serves the smallest one at least N pixels wide.
+
+/// @brief One generated width.
+struct ImageVariantSpec {
+    const char* name; ///< Where the size is used in the UI.
+    int width;
+};
+
+/// @brief Variant widths, ascending.
+inline constexpr ImageVariantSpec IMAGE_VARIANTS[] = {
+    {"card", 320},
+    {"gallery", 960},
+    {"full", 1920},
+};
+
+/// @brief 8-bit RGB pixels, row-major, no padding.
+struct RgbImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels; ///< width * height * 3 bytes.
+};
+
+/// @brief File name of the `width` variant of `original`:
+/// "abc_123.jpg" -> "abc_123_w320.jpg".
+std::string variantFileName(std::string_view original, int width);
+
+/// @brief A decoded JPEG, upright, and its full-size dimensions as displayed.
+struct DecodedJpeg {
+    RgbImage image;
+    int originalWidth = 0;
+    int originalHeight = 0;
+};
+
+/// @brief Decodes a JPEG file to RGB. libjpeg scales by 1/2, 1/4 or 1/8
+/// while decoding, so the largest of those reductions that stays at least
+/// `minWidth` wide is used (0: full size). An EXIF orientation is applied to
+/// the pixels, so variants encoded from them need no orientation tag.
+/// Throws std::runtime_error when the file cannot be read, is not a JPEG or
+/// is unreasonably large.
+DecodedJpeg decodeJpegFile(const std::string& path, int minWidth = 0);
+
+/// @brief Encodes `image` as a baseline JPEG with optimized Huffman tables.
+/// Writes to a temporary name and renames, so readers never see a partial
+/// file. Throws std::runtime_error on failure.
+void encodeJpegFile(const std::string& path, const RgbImage& image, int quality = 82);
+
+/// @brief Area-averaging downscale to `width`, keeping the aspect ratio.
+/// Every source pixel contributes to exactly the output pixels it overlaps,
+/// so fine detail is averaged rather than aliased.
+RgbImage resizeToWidth(const RgbImage& source, int width);
+
+/// @brief What generateImageVariants() produced.
+struct ImageVariantResult {
+    int width = 0;           ///< Of the original.
+    int height = 0;
+    std::vector<int> widths; ///< Variants written, ascending.
+};
+
+/// @brief Writes every IMAGE_VARIANTS width narrower than the original
+/// `directory + filename` beside it. Throws std::runtime_error when the
+/// original cannot be decoded.
+ImageVariantResult generateImageVariants(const std::string& directory, const std::string& filename);
+
+/// @brief Background queue that generates the variants of new uploads and
+/// records them on their Images rows, off the request threads.
+class ImageVariantQueue {
+public:
+    explicit ImageVariantQueue(unsigned threads);
+    ~ImageVariantQueue();
+
+    ImageVariantQueue(const ImageVariantQueue&) = delete;
+    ImageVariantQueue& operator=(const ImageVariantQueue&) = delete;
+
+    /// @brief Queues the upload `filename` (inside UPLOAD_DIR) of image
+    /// `imageId`. Workers start on the first call.
+    void enqueue(const std::string& imageId, const std::string& filename);
+
+    /// @brief Queues every uploaded image whose variants were never recorded,
+    /// e.g. uploads from before the queue existed or jobs lost to a restart.
+    void enqueuePending();
+
+    /// @brief Jobs waiting or running.
+    size_t pending();
+
+private:
+    struct Job {
+        std::string imageId;
+        std::string filename;
+    };
+
+    void run();
+    void process(const Job& job);
+
+    const unsigned threadCount;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    size_t running = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+/// @brief Process-wide queue used by the image routes.
+ImageVariantQueue& imageVariantQueue();
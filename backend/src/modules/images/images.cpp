@@ -1,69 +1,154 @@
 #include "images.h"
+#include "image_variants.h"
+#include "multipart_upload.h"
+#include "upload_files.h"
 #include "../../db/db_connection.h"
-#include <fstream>
-#include <ctime>
+#include "../../db/sql_errors.h"
+#include "../../utils/http_cache.h"
+#include "../../utils/uuid.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <filesystem>
+#include <thread>
 
 namespace fs = std::filesystem;
 
+namespace {
+    // Same extension mapping Crow applies to full static-file responses.
+    std::string uploadContentType(const std::string& filename) {
+        size_t dot = filename.find_last_of('.');
+        if (dot == std::string::npos) return "application/octet-stream";
+        auto it = crow::mime_types.find(filename.substr(dot + 1));
+        return it != crow::mime_types.end() ? it->second : "application/octet-stream";
+    }
+
+    // The smallest generated variant of `filename` at least `width` pixels
+    // wide, or nullptr when none exists (the original is narrower than every
+    // larger variant, or the queue has not reached it yet).
+    std::shared_ptr<const UploadFile> lookupVariant(const std::string& filename, int width) {
+        for (const ImageVariantSpec& spec : IMAGE_VARIANTS) {
+            if (spec.width < width) continue;
+            if (auto file = uploadFiles().lookup(variantFileName(filename, spec.width))) return file;
+        }
+        return nullptr;
+    }
+
+    // Postgres int[] text form ("{320,960}") as a JSON list.
+    crow::json::wvalue::list parseIntArray(const char* text) {
+        crow::json::wvalue::list values;
+        int value = 0;
+        bool inNumber = false;
+        for (const char* c = text; *c; ++c) {
+            if (*c >= '0' && *c <= '9') {
+                value = value * 10 + (*c - '0');
+                inNumber = true;
+            } else if (inNumber) {
+                values.push_back(value);
+                value = 0;
+                inNumber = false;
+            }
+        }
+        return values;
+    }
+}
+
 void registerImagesRoutes(crow::SimpleApp& app) {
+
+    // Queue the variants of uploads that never got them (older uploads, or
+    // jobs lost to a restart) without holding up startup.
+    std::thread([] {
+        try {
+            imageVariantQueue().enqueuePending();
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Queueing pending image variants failed: " << e.what();
+        }
+    }).detach();
     
-    // Upload image for a vehicle
+    // Upload images for a vehicle. Every file part of the multipart body is
+    // streamed from the request buffer into its own temporary file (no
+    // per-part copies in memory), fsynced, and renamed into place only once
+    // all parts are recorded by one INSERT. Oversize requests and files are
+    // rejected with 413 as soon as a limit is crossed (see uploadLimits()).
     CROW_ROUTE(app, "/vehicles/<string>/images")
         .methods("POST"_method)
     ([](const crow::request& req, const std::string& vehicle_id) {
         try {
-            // Parse multipart form data
-            crow::multipart::message file_message(req);
-            
-            if (file_message.parts.empty()) {
-                return crow::response(400, "No file uploaded");
+            std::optional<std::string> boundary = multipartBoundary(req.get_header_value("Content-Type"));
+            if (!boundary) {
+                return crow::response(400, "Expected multipart/form-data");
             }
-            
-            auto& part = file_message.parts[0];
-            
-            // Generate unique filename with timestamp
-            auto now = std::chrono::system_clock::now();
-            auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
-                now.time_since_epoch()
-            ).count();
-            
-            std::string filename = vehicle_id + "_" + std::to_string(timestamp) + ".jpg";
-            std::string filepath = "/shareddocker/uploads/" + filename;
-            
+
             // Ensure uploads directory exists
-            fs::create_directories("/shareddocker/uploads");
-            
-            // Save file to disk
-            std::ofstream file(filepath, std::ios::binary);
-            if (!file) {
-                return crow::response(500, "Failed to save file");
+            fs::create_directories(UPLOAD_DIR);
+
+            UploadStaging staging(UPLOAD_DIR, uploadLimits());
+            try {
+                staging.receive(req.body, *boundary);
+            } catch (const UploadTooLarge& e) {
+                return crow::response(413, e.what());
+            } catch (const std::invalid_argument& e) {
+                return crow::response(400, e.what());
             }
-            file.write(part.body.data(), part.body.size());
-            file.close();
-            
-            // Save to database
-            std::string img_url = "/uploads/" + filename;
-            
+            if (staging.files().empty()) {
+                return crow::response(400, "No file uploaded");
+            }
+
+            // Files are named after their image ids, so names never collide.
+            std::vector<std::string> ids, filenames;
+            std::string idArray = "{", urlArray = "{";
+            for (size_t i = 0; i < staging.files().size(); ++i) {
+                ids.push_back(newUuidV7());
+                filenames.push_back(vehicle_id + "_" + ids.back() + ".jpg");
+                idArray += (i ? "," : "") + ids.back();
+                urlArray += (i ? ",/uploads/" : "/uploads/") + filenames.back();
+            }
+            idArray += "}";
+            urlArray += "}";
+
             ConnectionGuard guard(getPool());
+            guard.prepare("images_insert_batch",
+                          "INSERT INTO Images (id, vehicle_id, img_url) "
+                          "SELECT u.id, $1, u.url FROM unnest($2::uuid[], $3::text[]) AS u(id, url)");
             pqxx::work txn(guard.get());
-            
-            pqxx::result r = txn.exec_params(
-                "INSERT INTO Images (vehicle_id, img_url) VALUES ($1, $2) RETURNING id",
-                vehicle_id, img_url
-            );
-            
-            std::string image_id = r[0][0].as<std::string>();
-            txn.commit();
-            
-            // Return response
+            txn.exec_prepared("images_insert_batch", vehicle_id, idArray, urlArray);
+
+            // Publish before committing: a failed rename leaves no rows, and
+            // a failed commit takes the files back down.
+            staging.publish(filenames);
+            try {
+                txn.commit();
+            } catch (...) {
+                staging.unpublish();
+                throw;
+            }
+
+            // Card, gallery and full-width copies are made in the background;
+            // until they exist /uploads serves the original for every width.
+            crow::json::wvalue::list images;
+            for (size_t i = 0; i < ids.size(); ++i) {
+                imageVariantQueue().enqueue(ids[i], filenames[i]);
+
+                crow::json::wvalue img;
+                img["id"] = ids[i];
+                img["vehicle_id"] = vehicle_id;
+                img["img_url"] = "/uploads/" + filenames[i];
+                images.push_back(std::move(img));
+            }
+
+            // The first image stays at the top level for single-file clients.
             crow::json::wvalue response;
-            response["id"] = image_id;
+            response["id"] = ids[0];
             response["vehicle_id"] = vehicle_id;
-            response["img_url"] = img_url;
-            
+            response["img_url"] = "/uploads/" + filenames[0];
+            response["images"] = std::move(images);
+
             return crow::response(201, response);
-            
+
+        } catch (const pqxx::sql_error& e) {
+            SqlErrorStatus mapped = classifySqlState(e.sqlstate());
+            CROW_LOG_ERROR << "Image upload error: " << e.what();
+            return crow::response(mapped.status, mapped.error);
         } catch (const std::exception& e) {
             CROW_LOG_ERROR << "Image upload error: " << e.what();
             return crow::response(500, e.what());
@@ -79,7 +164,8 @@ void registerImagesRoutes(crow::SimpleApp& app) {
             pqxx::work txn(guard.get());
             
             pqxx::result r = txn.exec_params(
-                "SELECT id, vehicle_id, img_url FROM Images WHERE vehicle_id = $1 ORDER BY id",
+                "SELECT id, vehicle_id, img_url, width, height, variant_widths "
+                "FROM Images WHERE vehicle_id = $1 ORDER BY id",
                 vehicle_id
             );
             
@@ -89,6 +175,14 @@ void registerImagesRoutes(crow::SimpleApp& app) {
                 img["id"] = row["id"].as<std::string>();
                 img["vehicle_id"] = row["vehicle_id"].as<std::string>();
                 img["img_url"] = row["img_url"].as<std::string>();
+                if (row["width"].is_null()) {
+                    img["width"] = nullptr;
+                    img["height"] = nullptr;
+                } else {
+                    img["width"] = row["width"].as<int>();
+                    img["height"] = row["height"].as<int>();
+                }
+                img["variant_widths"] = parseIntArray(row["variant_widths"].c_str());
                 images.push_back(std::move(img));
             }
             
@@ -120,7 +214,8 @@ void registerImagesRoutes(crow::SimpleApp& app) {
             }
             
             std::string img_url = r[0]["img_url"].as<std::string>();
-            std::string filepath = "/shareddocker" + img_url;
+            std::string filename = img_url.substr(img_url.find_last_of('/') + 1);
+            std::string filepath = UPLOAD_DIR + filename;
             
             // Delete from database
             txn.exec_params("DELETE FROM Images WHERE id = $1", image_id);
@@ -130,6 +225,13 @@ void registerImagesRoutes(crow::SimpleApp& app) {
             if (fs::exists(filepath)) {
                 fs::remove(filepath);
             }
+            uploadFiles().forget(filename);
+            for (const ImageVariantSpec& spec : IMAGE_VARIANTS) {
+                std::string variant = variantFileName(filename, spec.width);
+                std::error_code ignored;
+                fs::remove(UPLOAD_DIR + variant, ignored);
+                uploadFiles().forget(variant);
+            }
             
             return crow::response(204);
             
@@ -139,45 +241,101 @@ void registerImagesRoutes(crow::SimpleApp& app) {
         }
     });
     
-    // Serve static image files
+    // Serve static image files. Upload names are unique and files are never
+    // rewritten, so responses are cacheable for a year as immutable and carry
+    // a strong ETag and Last-Modified from the file's identity; revalidations
+    // get a 304 and single byte ranges a 206. Full bodies go out through
+    // Crow's static-file path, which streams the file from disk in 16 KiB
+    // chunks after the handler returns, so no request holds a whole image in
+    // memory.
+    //
+    // ?w=N picks the smallest generated variant at least N pixels wide, or
+    // the original when there is none, so clients can ask for the size they
+    // display and always get an image back.
     CROW_ROUTE(app, "/uploads/<path>")
         .methods("GET"_method)
-    ([](const std::string& filename) {
-        try {
-            std::string filepath = "/shareddocker/uploads/" + filename;
-            
-            if (!fs::exists(filepath)) {
-                return crow::response(404, "Image not found");
-            }
-            
-            std::ifstream file(filepath, std::ios::binary);
-            if (!file) {
-                return crow::response(500, "Failed to read file");
+    ([](const crow::request& req, const std::string& filename) {
+        if (!isSafeUploadName(filename)) {
+            return crow::response(404, "Image not found");
+        }
+
+        std::shared_ptr<const UploadFile> file = uploadFiles().lookup(filename);
+        if (!file) {
+            return crow::response(404, "Image not found");
+        }
+
+        // A ?w= request answered with the original (variants not generated
+        // yet, or the original is the best fit) must not be pinned for a
+        // year: the client revalidates, and the ETag changes once a variant
+        // takes over.
+        bool fallback = false;
+        if (const char* w = req.url_params.get("w")) {
+            int width = 0;
+            auto [end, ec] = std::from_chars(w, w + std::strlen(w), width);
+            if (ec != std::errc{} || *end != '\0' || width <= 0) {
+                return crow::response(400, "w must be a positive integer");
             }
-            
-            std::string content(
-                (std::istreambuf_iterator<char>(file)),
-                std::istreambuf_iterator<char>()
-            );
-            
-            crow::response res(200, content);
-            
-            // Set content type based on file extension
-            if (filename.ends_with(".jpg") || filename.ends_with(".jpeg")) {
-                res.set_header("Content-Type", "image/jpeg");
-            } else if (filename.ends_with(".png")) {
-                res.set_header("Content-Type", "image/png");
-            } else if (filename.ends_with(".gif")) {
-                res.set_header("Content-Type", "image/gif");
+            if (auto variant = lookupVariant(filename, width)) {
+                file = std::move(variant);
             } else {
-                res.set_header("Content-Type", "application/octet-stream");
+                fallback = true;
             }
-            
+        }
+
+        auto setCacheHeaders = [&](crow::response& res) {
+            res.set_header("Cache-Control", fallback ? "public, no-cache" : UPLOAD_CACHE_CONTROL);
+            res.set_header("ETag", file->etag);
+            res.set_header("Last-Modified", file->lastModified);
+            res.set_header("Accept-Ranges", "bytes");
+        };
+
+        if (ifNoneMatchHits(req, file->etag) || notModifiedSince(req, file->modifiedNs / 1000000000)) {
+            crow::response res = notModified(file->etag);
+            setCacheHeaders(res);
             return res;
-            
-        } catch (const std::exception& e) {
-            CROW_LOG_ERROR << "Serve image error: " << e.what();
-            return crow::response(500, e.what());
         }
+
+        const std::string& rangeHeader = req.get_header_value("Range");
+        ByteRange range;
+        RangeStatus status = RangeStatus::Full;
+        if (!rangeHeader.empty() && ifRangeHolds(req, file->etag, file->lastModified)) {
+            status = parseRange(rangeHeader, file->size, range);
+        }
+
+        if (status == RangeStatus::Unsatisfiable) {
+            crow::response res(416);
+            setCacheHeaders(res);
+            res.set_header("Content-Range", "bytes */" + std::to_string(file->size));
+            return res;
+        }
+
+        if (status == RangeStatus::Partial) {
+            // Only the requested slice is read, and at most
+            // UPLOAD_MAX_RANGE_BYTES of it per response.
+            range.last = std::min(range.last, range.first + UPLOAD_MAX_RANGE_BYTES - 1);
+            std::string body;
+            if (!readUploadSlice(*file, range.first, range.length(), body)) {
+                uploadFiles().forget(file->name);
+                return crow::response(404, "Image not found");
+            }
+            crow::response res(206);
+            setCacheHeaders(res);
+            res.set_header("Content-Type", uploadContentType(file->name));
+            res.set_header("Content-Range", "bytes " + std::to_string(range.first) + "-" +
+                                                std::to_string(range.last) + "/" + std::to_string(file->size));
+            res.body = std::move(body);
+            return res;
+        }
+
+        // Sets Content-Length and Content-Type (from the extension); a file
+        // deleted behind the cache's back comes back as 404.
+        crow::response res;
+        res.set_static_file_info_unsafe(file->path);
+        if (res.code == 404) {
+            uploadFiles().forget(file->name);
+            return crow::response(404, "Image not found");
+        }
+        setCacheHeaders(res);
+        return res;
     });
-}
\ No newline at end of file
+}
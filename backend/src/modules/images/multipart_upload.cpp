@@ -0,0 +1,298 @@
+#include "multipart_upload.h"
+#include "../../utils/uuid.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t FEED_CHUNK = 64 * 1024;
+    constexpr size_t MAX_HEADER_BYTES = 16 * 1024;
+    constexpr size_t MAX_BOUNDARY_LENGTH = 70; // RFC 2046
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            char x = a[i], y = b[i];
+            if (x >= 'A' && x <= 'Z') x += 'a' - 'A';
+            if (y >= 'A' && y <= 'Z') y += 'a' - 'A';
+            if (x != y) return false;
+        }
+        return true;
+    }
+
+    std::string_view trim(std::string_view text) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+        return text;
+    }
+
+    // Value of parameter `key` in a header such as
+    // `form-data; name="file"; filename="a.jpg"`, quoted or not.
+    std::optional<std::string> headerParam(std::string_view header, std::string_view key) {
+        size_t i = header.find(';');
+        while (i != std::string_view::npos && i < header.size()) {
+            ++i;
+            while (i < header.size() && (header[i] == ' ' || header[i] == '\t')) ++i;
+            const size_t eq = header.find('=', i);
+            if (eq == std::string_view::npos) return std::nullopt;
+            const std::string_view name = trim(header.substr(i, eq - i));
+
+            std::string value;
+            size_t j = eq + 1;
+            if (j < header.size() && header[j] == '"') {
+                for (++j; j < header.size() && header[j] != '"'; ++j) {
+                    if (header[j] == '\\' && j + 1 < header.size()) ++j;
+                    value += header[j];
+                }
+                j = header.find(';', j);
+            } else {
+                const size_t end = header.find(';', j);
+                value = std::string(trim(header.substr(j, end == std::string_view::npos ? end : end - j)));
+                j = end;
+            }
+            if (equalsIgnoreCase(name, key)) return value;
+            i = j;
+        }
+        return std::nullopt;
+    }
+
+    void writeAll(int fd, std::string_view data) {
+        while (!data.empty()) {
+            ssize_t n = ::write(fd, data.data(), data.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+            data.remove_prefix(static_cast<size_t>(n));
+        }
+    }
+
+    uint64_t envLimit(const char* name, uint64_t fallback) {
+        const char* text = std::getenv(name);
+        if (!text || !*text) return fallback;
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(text, &end, 10);
+        return *end == '\0' && value > 0 ? value : fallback;
+    }
+}
+
+std::optional<std::string> multipartBoundary(std::string_view contentType) {
+    const size_t semi = contentType.find(';');
+    const std::string_view type = trim(contentType.substr(0, semi));
+    if (type.size() < 10 || !equalsIgnoreCase(type.substr(0, 10), "multipart/")) return std::nullopt;
+
+    std::optional<std::string> boundary = headerParam(contentType, "boundary");
+    if (!boundary || boundary->empty() || boundary->size() > MAX_BOUNDARY_LENGTH) return std::nullopt;
+    return boundary;
+}
+
+MultipartStreamParser::MultipartStreamParser(const std::string& boundary, Callbacks callbacks)
+    : delimiter("\r\n--" + boundary), callbacks(std::move(callbacks)), pending("\r\n") {
+    // The leading CRLF lets a boundary on the very first line match the same
+    // delimiter as every later one.
+}
+
+void MultipartStreamParser::feed(std::string_view chunk) {
+    if (state == State::Done) return; // epilogue
+    pending.append(chunk.data(), chunk.size());
+
+    size_t pos = 0;
+    bool more = true;
+    while (more) {
+        const std::string_view rest = std::string_view(pending).substr(pos);
+        switch (state) {
+        case State::Preamble:
+        case State::Body: {
+            const size_t hit = rest.find(delimiter);
+            if (hit == std::string_view::npos) {
+                // Everything except a tail that may begin a delimiter is
+                // part data (or preamble, which is dropped).
+                const size_t safe = rest.size() >= delimiter.size() ? rest.size() - (delimiter.size() - 1) : 0;
+                if (state == State::Body && safe > 0) callbacks.onPartData(rest.substr(0, safe));
+                pos += safe;
+                more = false;
+                break;
+            }
+            if (state == State::Body) {
+                if (hit > 0) callbacks.onPartData(rest.substr(0, hit));
+                callbacks.onPartEnd();
+            }
+            pos += hit + delimiter.size();
+            state = State::AfterBoundary;
+            break;
+        }
+        case State::AfterBoundary: {
+            size_t i = 0;
+            while (i < rest.size() && (rest[i] == ' ' || rest[i] == '\t')) ++i;
+            if (rest.size() - i < 2) {
+                more = false;
+                break;
+            }
+            if (rest.substr(i, 2) == "--") {
+                state = State::Done;
+                pos = pending.size();
+                more = false;
+                break;
+            }
+            if (rest.substr(i, 2) != "\r\n") throw std::invalid_argument("malformed multipart boundary line");
+            pos += i + 2;
+            state = State::Headers;
+            break;
+        }
+        case State::Headers: {
+            if (rest.size() < 2) {
+                more = false;
+                break;
+            }
+            size_t blockEnd = 0, consumed = 2; // a part without headers
+            if (rest.substr(0, 2) != "\r\n") {
+                blockEnd = rest.find("\r\n\r\n");
+                if (blockEnd == std::string_view::npos) {
+                    if (rest.size() > MAX_HEADER_BYTES) throw std::invalid_argument("multipart part headers too long");
+                    more = false;
+                    break;
+                }
+                consumed = blockEnd + 4;
+            }
+            parseHeaders(rest.substr(0, blockEnd));
+            pos += consumed;
+            state = State::Body;
+            callbacks.onPartBegin(part);
+            break;
+        }
+        case State::Done:
+            pos = pending.size();
+            more = false;
+            break;
+        }
+    }
+    pending.erase(0, pos);
+}
+
+void MultipartStreamParser::finish() {
+    if (state != State::Done) throw std::invalid_argument("multipart body ends before its closing boundary");
+}
+
+void MultipartStreamParser::parseHeaders(std::string_view block) {
+    part = MultipartPart{};
+    while (!block.empty()) {
+        const size_t eol = block.find("\r\n");
+        const std::string_view line = block.substr(0, eol);
+        block = eol == std::string_view::npos ? std::string_view{} : block.substr(eol + 2);
+
+        const size_t colon = line.find(':');
+        if (colon == std::string_view::npos) throw std::invalid_argument("malformed multipart part header");
+        const std::string_view name = trim(line.substr(0, colon));
+        const std::string_view value = trim(line.substr(colon + 1));
+        if (equalsIgnoreCase(name, "Content-Disposition")) {
+            part.name = headerParam(value, "name").value_or("");
+            part.filename = headerParam(value, "filename").value_or("");
+        } else if (equalsIgnoreCase(name, "Content-Type")) {
+            part.contentType = std::string(value);
+        }
+    }
+}
+
+const UploadLimits& uploadLimits() {
+    static const UploadLimits limits{
+        envLimit("UPLOAD_MAX_FILE_BYTES", 25ull << 20),
+        envLimit("UPLOAD_MAX_REQUEST_BYTES", 100ull << 20),
+        static_cast<size_t>(envLimit("UPLOAD_MAX_FILES", 20)),
+    };
+    return limits;
+}
+
+UploadStaging::UploadStaging(std::string directory, UploadLimits limits)
+    : directory(std::move(directory)), limits(limits) {}
+
+UploadStaging::~UploadStaging() {
+    closeCurrent();
+    for (const StagedUpload& file : staged) {
+        if (file.finalPath.empty() && !file.tempPath.empty()) ::unlink(file.tempPath.c_str());
+    }
+}
+
+void UploadStaging::receive(std::string_view body, const std::string& boundary) {
+    if (body.size() > limits.maxRequestBytes) {
+        throw UploadTooLarge("Upload exceeds " + std::to_string(limits.maxRequestBytes) + " bytes");
+    }
+
+    MultipartStreamParser parser(boundary, {
+        [this](const MultipartPart& part) { beginFile(part); },
+        [this](std::string_view data) { writeFile(data); },
+        [this] { endFile(); },
+    });
+    for (size_t offset = 0; offset < body.size(); offset += FEED_CHUNK) {
+        parser.feed(body.substr(offset, FEED_CHUNK));
+    }
+    parser.finish();
+}
+
+void UploadStaging::beginFile(const MultipartPart& part) {
+    skipping = part.filename.empty();
+    if (skipping) return;
+    if (staged.size() >= limits.maxFiles) {
+        throw UploadTooLarge("At most " + std::to_string(limits.maxFiles) + " files per upload");
+    }
+
+    StagedUpload file;
+    file.fieldName = part.name;
+    file.clientFilename = part.filename;
+    file.tempPath = directory + ".upload-" + newUuidV7() + ".part";
+    fd = ::open(file.tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) throw std::runtime_error("cannot create " + file.tempPath + ": " + std::strerror(errno));
+    staged.push_back(std::move(file));
+}
+
+void UploadStaging::writeFile(std::string_view data) {
+    if (skipping) return;
+    StagedUpload& file = staged.back();
+    file.size += data.size();
+    if (file.size > limits.maxFileBytes) {
+        throw UploadTooLarge("File " + file.clientFilename + " exceeds " + std::to_string(limits.maxFileBytes) +
+                             " bytes");
+    }
+    writeAll(fd, data);
+}
+
+void UploadStaging::endFile() {
+    if (skipping) {
+        skipping = false;
+        return;
+    }
+    if (::fsync(fd) != 0) throw std::runtime_error(std::string("fsync failed: ") + std::strerror(errno));
+    closeCurrent();
+}
+
+void UploadStaging::closeCurrent() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+void UploadStaging::publish(const std::vector<std::string>& names) {
+    for (size_t i = 0; i < staged.size(); ++i) {
+        const std::string target = directory + names.at(i);
+        if (::rename(staged[i].tempPath.c_str(), target.c_str()) != 0) {
+            const std::string reason = std::strerror(errno);
+            unpublish();
+            throw std::runtime_error("cannot publish " + target + ": " + reason);
+        }
+        staged[i].finalPath = target;
+    }
+
+    // Make the renames themselves durable.
+    int dir = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir >= 0) {
+        ::fsync(dir);
+        ::close(dir);
+    }
+}
+
+void UploadStaging::unpublish() {
+    for (StagedUpload& file : staged) {
+        if (file.finalPath.empty()) continue;
+        ::unlink(file.finalPath.c_str());
+        file.finalPath.clear();
+        file.tempPath.clear();
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @file multipart_upload.h
+/// @brief Incremental multipart/form-data parsing and crash-safe staging of
+/// uploaded files.
+///
+/// The parser is push-based: it takes the body in arbitrary slices and hands
+/// each part's bytes to a callback as they arrive, keeping only a
+/// boundary-sized tail between calls. UploadStaging uses it to stream every
+/// file part into its own temporary file, so a request never holds a second
+/// copy of its files in memory, and only fully written, fsynced files are
+/// renamed to their public names.
+
+/// @brief Headers of one part.
+struct MultipartPart {
+    std::string name;        ///< Content-Disposition name.
+    std::string filename;    ///< Content-Disposition filename; empty for plain fields.
+    std::string contentType; ///< Content-Type, if given.
+};
+
+/// @brief Boundary parameter of a multipart Content-Type header, or nullopt
+/// when the header is not multipart or has no usable boundary.
+std::optional<std::string> multipartBoundary(std::string_view contentType);
+
+/// @brief Push parser for one multipart body (RFC 2046 / RFC 7578).
+class MultipartStreamParser {
+public:
+    struct Callbacks {
+        std::function<void(const MultipartPart&)> onPartBegin;
+        std::function<void(std::string_view)> onPartData;
+        std::function<void()> onPartEnd;
+    };
+
+    MultipartStreamParser(const std::string& boundary, Callbacks callbacks);
+
+    /// @brief Consumes the next slice of the body. Throws
+    /// std::invalid_argument on malformed input; exceptions thrown by the
+    /// callbacks propagate unchanged.
+    void feed(std::string_view chunk);
+
+    /// @brief Call after the last slice. Throws std::invalid_argument when
+    /// the closing boundary was never seen.
+    void finish();
+
+private:
+    enum class State { Preamble, AfterBoundary, Headers, Body, Done };
+
+    void parseHeaders(std::string_view block);
+
+    const std::string delimiter; // "\r\n--" + boundary
+    Callbacks callbacks;
+    State state = State::Preamble;
+    std::string pending;         // bytes not yet consumed
+    MultipartPart part;
+};
+
+/// @brief Size limits of one upload request.
+struct UploadLimits {
+    uint64_t maxFileBytes = 0;    ///< Per file part.
+    uint64_t maxRequestBytes = 0; ///< Whole request body.
+    size_t maxFiles = 0;
+};
+
+/// @brief Limits of POST /vehicles/<id>/images: 25 MiB per file, 100 MiB per
+/// request and 20 files by default, overridable with the
+/// UPLOAD_MAX_FILE_BYTES, UPLOAD_MAX_REQUEST_BYTES and UPLOAD_MAX_FILES
+/// environment variables. Read once.
+const UploadLimits& uploadLimits();
+
+/// @brief Thrown when an upload exceeds its UploadLimits.
+class UploadTooLarge : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// @brief One file part written to disk.
+struct StagedUpload {
+    std::string fieldName;
+    std::string clientFilename;
+    std::string tempPath;
+    std::string finalPath; ///< Set by publish().
+    uint64_t size = 0;
+};
+
+/// @brief Streams the file parts of a multipart body into temporary files
+/// in `directory` and publishes them under their final names.
+///
+/// Temporary files are dot-prefixed, so /uploads never serves them. Each is
+/// fsynced when its part ends; publish() renames them and fsyncs the
+/// directory, so after a crash a file is either complete under its final
+/// name or absent. Whatever was not published is removed by the destructor.
+class UploadStaging {
+public:
+    UploadStaging(std::string directory, UploadLimits limits);
+    ~UploadStaging();
+
+    UploadStaging(const UploadStaging&) = delete;
+    UploadStaging& operator=(const UploadStaging&) = delete;
+
+    /// @brief Parses `body` in fixed-size slices and writes every part that
+    /// has a filename. Plain form fields are skipped. Throws UploadTooLarge,
+    /// std::invalid_argument (malformed body) or std::runtime_error (I/O).
+    void receive(std::string_view body, const std::string& boundary);
+
+    const std::vector<StagedUpload>& files() const { return staged; }
+
+    /// @brief Renames files()[i] to `directory + names[i]`, then fsyncs the
+    /// directory. Throws std::runtime_error on failure.
+    void publish(const std::vector<std::string>& names);
+
+    /// @brief Removes the published files again, e.g. when recording them
+    /// in the database failed.
+    void unpublish();
+
+private:
+    void beginFile(const MultipartPart& part);
+    void writeFile(std::string_view data);
+    void endFile();
+    void closeCurrent();
+
+    const std::string directory;
+    const UploadLimits limits;
+    std::vector<StagedUpload> staged;
+    int fd = -1;          // file of the part being written, or -1
+    bool skipping = false; // current part is a plain field
+};
@@ -0,0 +1,116 @@
+#include "upload_files.h"
+#include "../../utils/http_cache.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t UPLOAD_CACHE_CAPACITY = 8192;
+    constexpr std::chrono::seconds UPLOAD_MISS_TTL{10};
+    constexpr size_t MAX_NAME_LENGTH = 255;
+}
+
+bool isSafeUploadName(std::string_view name) {
+    if (name.empty() || name.size() > MAX_NAME_LENGTH || name.front() == '.') return false;
+    for (char c : name) {
+        const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                        c == '.' || c == '_' || c == '-';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool readUploadSlice(const UploadFile& file, uint64_t offset, uint64_t length, std::string& out) {
+    int fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    out.resize(length);
+    uint64_t done = 0;
+    while (done < length) {
+        ssize_t n = ::pread(fd, out.data() + done, length - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += static_cast<uint64_t>(n);
+    }
+    ::close(fd);
+    return done == length;
+}
+
+UploadFileCache::UploadFileCache(size_t capacity, std::chrono::steady_clock::duration missTtl)
+    : capacity(capacity), missTtl(missTtl) {}
+
+std::shared_ptr<const UploadFile> UploadFileCache::lookup(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = byName.find(name);
+        if (it != byName.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            return *it->second;
+        }
+        auto miss = missing.find(name);
+        if (miss != missing.end()) {
+            if (std::chrono::steady_clock::now() < miss->second) return nullptr;
+            missing.erase(miss);
+        }
+    }
+
+    // stat() outside the lock; a racing miss for the same name just stats twice.
+    auto file = std::make_shared<UploadFile>();
+    file->name = name;
+    file->path = UPLOAD_DIR + name;
+    struct stat info;
+    if (::stat(file->path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mtx);
+        if (missing.size() >= capacity) {
+            std::erase_if(missing, [now](const auto& entry) { return entry.second <= now; });
+            if (missing.size() >= capacity) missing.clear();
+        }
+        missing[name] = now + missTtl;
+        return nullptr;
+    }
+    file->size = static_cast<uint64_t>(info.st_size);
+    file->modifiedNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    file->device = static_cast<uint64_t>(info.st_dev);
+    file->inode = static_cast<uint64_t>(info.st_ino);
+
+    // A replaced file gets a new inode or mtime even at the same size, so
+    // the tag changes whenever the bytes can have.
+    char tag[64];
+    std::snprintf(tag, sizeof tag, "\"%llx-%llx-%llx\"", static_cast<unsigned long long>(file->inode),
+                  static_cast<unsigned long long>(file->size), static_cast<unsigned long long>(file->modifiedNs));
+    file->etag = tag;
+    file->lastModified = httpDate(static_cast<int64_t>(info.st_mtim.tv_sec));
+
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = byName.find(name);
+    if (it != byName.end()) return *it->second;
+    lru.push_front(file);
+    byName.emplace(name, lru.begin());
+    while (lru.size() > capacity) {
+        byName.erase(lru.back()->name);
+        lru.pop_back();
+    }
+    return file;
+}
+
+void UploadFileCache::forget(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mtx);
+    missing.erase(name);
+    auto it = byName.find(name);
+    if (it == byName.end()) return;
+    lru.erase(it->second);
+    byName.erase(it);
+}
+
+size_t UploadFileCache::size() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return byName.size();
+}
+
+UploadFileCache& uploadFiles() {
+    static UploadFileCache cache(UPLOAD_CACHE_CAPACITY, UPLOAD_MISS_TTL);
+    return cache;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/// @file upload_files.h
+/// @brief Location and metadata of the uploaded image files served by /uploads.
+///
+/// Uploaded files are never rewritten in place (every upload gets a new
+/// name), so their metadata, and the validators derived from it, can be
+/// cached until the file is deleted.
+
+/// @brief Directory holding the uploaded images, with a trailing slash.
+inline constexpr const char* UPLOAD_DIR = "/shareddocker/uploads/";
+
+/// @brief Cache-Control of /uploads responses: a name is never reused for
+/// different bytes, so clients may keep a copy for a year without revalidating.
+inline constexpr const char* UPLOAD_CACHE_CONTROL = "public, max-age=31536000, immutable";
+
+/// @brief Most bytes one 206 response carries. A longer range is answered
+/// with its first UPLOAD_MAX_RANGE_BYTES and a Content-Range saying so;
+/// clients continue from there, and no request buffers more than this.
+inline constexpr uint64_t UPLOAD_MAX_RANGE_BYTES = 1ull << 20;
+
+/// @brief True when `name` can only refer to a file directly inside
+/// UPLOAD_DIR: one path segment of letters, digits, '.', '_' or '-', not
+/// starting with a dot. Everything else (traversal, absolute paths,
+/// subdirectories, hidden files) is rejected.
+bool isSafeUploadName(std::string_view name);
+
+/// @brief stat() results of one uploaded file.
+struct UploadFile {
+    std::string name;       ///< File name inside UPLOAD_DIR.
+    std::string path;       ///< Full path.
+    uint64_t size = 0;
+    int64_t modifiedNs = 0; ///< st_mtim in nanoseconds since the epoch.
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    std::string etag;         ///< Strong ETag: quoted hex of inode, size and mtime.
+    std::string lastModified; ///< mtime as an HTTP date.
+};
+
+/// @brief Reads `length` bytes at `offset` of `file` into `out` with pread(),
+/// without touching the rest of the file. False if the file is gone or
+/// shorter than expected.
+bool readUploadSlice(const UploadFile& file, uint64_t offset, uint64_t length, std::string& out);
+
+/// @brief LRU of upload metadata keyed by file name, bounded by entry count.
+///
+/// A miss stats the file. A name that does not exist is remembered for
+/// `missTtl`, so repeated requests for it (e.g. ?w= probing variants that
+/// were never generated) cost no stat(); forget() ends that early when the
+/// file is written.
+class UploadFileCache {
+public:
+    UploadFileCache(size_t capacity, std::chrono::steady_clock::duration missTtl);
+
+    /// @brief Metadata of a regular file in UPLOAD_DIR, or nullptr if there is
+    /// none. `name` must already have passed isSafeUploadName().
+    std::shared_ptr<const UploadFile> lookup(const std::string& name);
+
+    /// @brief Drops the entry of a deleted, replaced or newly written file.
+    void forget(const std::string& name);
+
+    size_t size();
+
+private:
+    using Lru = std::list<std::shared_ptr<const UploadFile>>;
+
+    const size_t capacity;
+    const std::chrono::steady_clock::duration missTtl;
+    std::mutex mtx;
+    Lru lru;    // most recently used first
+    std::unordered_map<std::string, Lru::iterator> byName;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> missing; // name -> expiry
+};
+
+/// @brief Process-wide cache used by the image routes.
+UploadFileCache& uploadFiles();
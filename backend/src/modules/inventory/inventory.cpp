@@ -1,8 +1,209 @@
 #include "inventory.h"
+#include "inventory_model.h"
+#include "similar_vehicles.h"
+#include "../analytics/analytics.h"
+#include "../sales/invoice.h"
 #include <iostream>
+#include <array>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <vector>
 #include "../../db/db_connection.h"
+#include "../../utils/http_cache.h"
+#include "../../utils/idempotency.h"
+#include "../../utils/uuid.h"
+#include "../../utils/validators.h"
 #include <pqxx/pqxx>
 
+namespace {
+    // Columns PATCH /vehicles/<id> may change. The order is fixed so that every
+    // combination of supplied fields maps to exactly one prepared statement.
+    const std::array<const char*, 10> PATCHABLE_COLUMNS = {
+        "vin", "make", "model", "year", "odometer",
+        "fuel_type", "transmission", "trim", "market_price", "status"
+    };
+
+    const char* VEHICLE_COLUMNS =
+        "id, vin, make, model, year, odometer, fuel_type, transmission, "
+        "trim, market_price, status, version";
+
+    // Builds the UPDATE for one field-set; bit i of mask selects PATCHABLE_COLUMNS[i].
+    // Only the supplied columns are written, the id is compared as a UUID so the
+    // primary key index is used, and the version guard is skipped when its
+    // parameter is NULL (If-Match: *).
+    std::string buildPatchSql(unsigned mask) {
+        std::string sql = "UPDATE Vehicles SET ";
+        int param = 1;
+        for (size_t i = 0; i < PATCHABLE_COLUMNS.size(); ++i) {
+            if (!(mask & (1u << i))) continue;
+            sql += PATCHABLE_COLUMNS[i];
+            sql += " = $" + std::to_string(param++) + ", ";
+        }
+        std::string idParam = "$" + std::to_string(param++);
+        std::string versionParam = "$" + std::to_string(param);
+        sql += "version = version + 1 "
+               "WHERE id = " + idParam + "::uuid "
+               "AND (" + versionParam + "::int IS NULL OR version = " + versionParam + "::int) "
+               "RETURNING " + VEHICLE_COLUMNS;
+        return sql;
+    }
+
+    // Reads the version out of an If-Match value such as "3", W/"3" or 3.
+    std::optional<int> parseVersionTag(std::string tag) {
+        if (tag.rfind("W/", 0) == 0) tag = tag.substr(2);
+        if (tag.size() >= 2 && tag.front() == '"' && tag.back() == '"')
+            tag = tag.substr(1, tag.size() - 2);
+        if (tag.empty() || tag.size() > 9) return std::nullopt;
+        for (char c : tag) {
+            if (c < '0' || c > '9') return std::nullopt;
+        }
+        return std::stoi(tag);
+    }
+
+    std::string versionETag(int version) {
+        return "\"" + std::to_string(version) + "\"";
+    }
+
+    // Reprices every vehicle matching the filter in one statement. Filter
+    // parameters left NULL match everything; the new price is rounded to cents,
+    // clamped to the optional floor/ceiling and never drops below 0.01.
+    // Unchanged prices are not rewritten. The single result row carries the
+    // match count even when nothing was updated.
+    const char* REPRICE_SQL = R"(
+        WITH target AS (
+            SELECT id, market_price AS old_price
+            FROM Vehicles
+            WHERE ($1::text IS NULL OR make = $1)
+              AND ($2::text IS NULL OR model = $2)
+              AND ($3::int IS NULL OR year = $3)
+              AND ($4::status_enum IS NULL OR status = $4::status_enum)
+              AND ($5::int IS NULL OR created_at <= now() - make_interval(days => $5::int))
+            FOR UPDATE
+        ),
+        priced AS (
+            SELECT t.id, t.old_price, c.new_price
+            FROM target t
+            CROSS JOIN LATERAL (
+                SELECT ROUND(CASE WHEN $6 = 'percent'
+                                  THEN t.old_price * (1 + $7::numeric / 100)
+                                  ELSE t.old_price + $7::numeric END, 2) AS raw
+            ) r
+            CROSS JOIN LATERAL (
+                SELECT GREATEST(r.raw, COALESCE($8::numeric, r.raw), 0.01) AS floored
+            ) f
+            CROSS JOIN LATERAL (
+                SELECT LEAST(f.floored, COALESCE($9::numeric, f.floored)) AS new_price
+            ) c
+        ),
+        updated AS (
+            UPDATE Vehicles v
+            SET market_price = p.new_price, version = v.version + 1
+            FROM priced p
+            WHERE v.id = p.id AND p.new_price <> p.old_price
+            RETURNING v.id, v.vin, v.make, v.model, v.year, v.odometer, v.fuel_type,
+                      v.transmission, v.status, p.old_price, v.market_price AS new_price, v.market_price
+        )
+        SELECT m.matched, u.*
+        FROM (SELECT count(*) AS matched FROM target) m
+        LEFT JOIN updated u ON true
+        ORDER BY u.make, u.model, u.year
+    )";
+
+    VehicleFeatures featuresFromRow(const pqxx::row& row) {
+        VehicleFeatures v;
+        v.id = row["id"].c_str();
+        v.make = row["make"].c_str();
+        v.model = row["model"].c_str();
+        v.year = row["year"].as<int>();
+        v.odometer = row["odometer"].as<int>();
+        v.marketPrice = row["market_price"].as<double>();
+        v.fuelType = row["fuel_type"].c_str();
+        v.transmission = row["transmission"].c_str();
+        v.available = std::string(row["status"].c_str()) == "Available";
+        return v;
+    }
+
+    // Fills the similarity index from the Vehicles table on first use. Writes
+    // made while the table is read are replayed on top of the snapshot.
+    void ensureSimilarIndexLoaded() {
+        static std::once_flag loaded;
+        std::call_once(loaded, [] {
+            auto& index = similarVehicleIndex();
+            index.reload([] {
+                pqxx::result res;
+                {
+                    ConnectionGuard guard(getPool());
+                    pqxx::work txn(guard.get());
+                    res = txn.exec(
+                        "SELECT id, make, model, year, odometer, fuel_type, transmission, market_price, status "
+                        "FROM Vehicles");
+                    txn.commit();
+                }
+
+                std::vector<VehicleFeatures> vehicles;
+                vehicles.reserve(res.size());
+                for (const auto& row : res) vehicles.push_back(featuresFromRow(row));
+                return vehicles;
+            });
+            CROW_LOG_INFO << "Similar-vehicle index loaded with " << index.size() << " vehicles";
+        });
+    }
+
+    // Everything the vehicle page shows, assembled by Postgres into one JSON
+    // document: the vehicle, its images, its sales and test-drive stats.
+    const char* VEHICLE_DETAIL_SQL = R"(
+        SELECT json_build_object(
+            'vehicle', json_build_object(
+                'id', v.id, 'vin', v.vin, 'make', v.make, 'model', v.model,
+                'year', v.year, 'odometer', v.odometer, 'fuel_type', v.fuel_type,
+                'transmission', v.transmission, 'trim', v.trim,
+                'market_price', v.market_price, 'status', v.status, 'version', v.version),
+            'images', COALESCE((
+                SELECT json_agg(json_build_object(
+                           'id', i.id, 'vehicle_id', i.vehicle_id, 'img_url', i.img_url)
+                       ORDER BY i.id)
+                FROM Images i WHERE i.vehicle_id = v.id), '[]'::json),
+            'sales', COALESCE((
+                SELECT json_agg(json_build_object(
+                           'sale_id', s.id, 'date', s.date, 'price', s.sale_price,
+                           'customer_id', c.id,
+                           'customer', c.first_name || ' ' || c.last_name)
+                       ORDER BY s.date DESC)
+                FROM Sales s JOIN Customers c ON s.customer_id = c.id
+                WHERE s.vehicle_id = v.id), '[]'::json),
+            'test_drives', (
+                SELECT json_build_object(
+                           'count', count(*),
+                           'last_date', max(t.date) FILTER (WHERE t.date <= CURRENT_DATE),
+                           'next_date', min(t.date) FILTER (WHERE t.date > CURRENT_DATE))
+                FROM Test_Drive_Record t WHERE t.vehicle_id = v.id)
+        )::text AS detail
+        FROM Vehicles v
+        WHERE v.id = $1::uuid
+    )";
+
+    crow::json::wvalue vehicleRowToJson(const pqxx::row& row) {
+        crow::json::wvalue vehicle;
+        vehicle["id"] = row["id"].c_str();
+        vehicle["vin"] = row["vin"].c_str();
+        vehicle["make"] = row["make"].c_str();
+        vehicle["model"] = row["model"].c_str();
+        vehicle["year"] = row["year"].as<int>();
+        vehicle["odometer"] = row["odometer"].as<int>();
+        vehicle["fuel_type"] = row["fuel_type"].c_str();
+        vehicle["transmission"] = row["transmission"].c_str();
+
+        if (row["trim"].is_null()) vehicle["trim"] = nullptr;
+        else vehicle["trim"] = row["trim"].c_str();
+
+        vehicle["market_price"] = row["market_price"].as<double>();
+        vehicle["status"] = row["status"].c_str();
+        vehicle["version"] = row["version"].as<int>();
+        return vehicle;
+    }
+}
+
 void registerInventoryRoutes(crow::SimpleApp& app) {
     std::cout << "[DEBUG] Inventory routes registered!" << std::endl;
 
@@ -137,8 +338,11 @@ void registerInventoryRoutes(crow::SimpleApp& app) {
             vehicle["trim"] = row["trim"].c_str();
             vehicle["market_price"] = row["market_price"].as<double>();
             vehicle["status"] = row["status"].c_str();
+            vehicle["version"] = row["version"].as<int>();
 
-            return crow::response{vehicle};
+            crow::response response{vehicle};
+            response.set_header("ETag", versionETag(row["version"].as<int>()));
+            return response;
         } catch (const std::exception& e) {
             return crow::response(500, std::string("Database error: ") + e.what());
         }
@@ -148,73 +352,310 @@ void registerInventoryRoutes(crow::SimpleApp& app) {
     CROW_ROUTE(app, "/vehicles")
     .methods(crow::HTTPMethod::POST)
     ([](const crow::request& req) {
-         std::cout << "[DEBUG] POST /vehicles hit" << std::endl;
+        return withIdempotency(req, "POST /vehicles", [&req](IdempotentWrite& idempotency) {
+             std::cout << "[DEBUG] POST /vehicles hit" << std::endl;
+            auto body = crow::json::load(req.body);
+            if (!body) return crow::response(400, "Invalid JSON");
+            if (!body.has("vin") || body["vin"].t() != crow::json::type::String ||
+                !isVinFormat(std::string(body["vin"].s()))) {
+                return crow::response(400, "Invalid VIN (17 characters, no I, O or Q)");
+            }
+
+            try {
+                ConnectionGuard guard(getPool());
+                pqxx::work txn(guard.get());
+
+                // Convert crow::json::r_string to std::string
+                pqxx::row row = txn.exec_params(
+                    "INSERT INTO Vehicles (id, vin, make, model, year, odometer, fuel_type, transmission, trim, market_price, status) "
+                    "VALUES ($1,$2,$3,$4,$5,$6,$7,$8,$9,$10,$11) "
+                    "RETURNING id, make, model, year, odometer, fuel_type, transmission, market_price, status",
+                    newUuidV7(),
+                    std::string(body["vin"].s()),
+                    std::string(body["make"].s()),
+                    std::string(body["model"].s()),
+                    body["year"].i(),
+                    body["odometer"].i(),
+                    std::string(body["fuel_type"].s()),
+                    std::string(body["transmission"].s()),
+                    std::string(body["trim"].s()),
+                    body["market_price"].d(),
+                    std::string(body["status"].s())
+                )[0];
+
+                crow::json::wvalue res;
+                res["id"] = row["id"].c_str();
+                crow::response created(201, res);
+                idempotency.record(txn, created);
+
+                txn.commit();
+                similarVehicleIndex().upsert(featuresFromRow(row));
+                return created;
+            } catch (const std::exception& e) {
+                return crow::response(500, std::string("Database error: ") + e.what());
+            }
+        });
+    });
+
+
+    // Aggregated vehicle page payload in one round trip, with an ETag so an
+    // unchanged vehicle costs the client a 304 instead of a download.
+    CROW_ROUTE(app, "/vehicles/<string>/detail")
+    .methods(crow::HTTPMethod::GET)
+    ([](const crow::request& req, std::string vehicleId) {
+        if (vehicleId.length() != 36) {
+            return crow::response(400, "Invalid UUID format");
+        }
+
+        try {
+            std::string detail;
+            {
+                ConnectionGuard guard(getPool());
+                guard.prepare("vehicle_detail", VEHICLE_DETAIL_SQL);
+                pqxx::read_transaction txn(guard.get());
+                pqxx::result res = txn.exec_prepared("vehicle_detail", vehicleId);
+                if (res.empty()) {
+                    return crow::response(404, "Vehicle not found");
+                }
+                detail = res[0]["detail"].c_str();
+            }
+
+            const std::string etag = contentETag(detail);
+            if (ifNoneMatchHits(req, etag)) {
+                return notModified(etag);
+            }
+
+            crow::response response(200, std::move(detail));
+            response.set_header("Content-Type", "application/json");
+            response.set_header("ETag", etag);
+            response.set_header("Cache-Control", "no-cache");
+            return response;
+
+        } catch (const std::exception& e) {
+            return crow::response(500, std::string("Database error: ") + e.what());
+        }
+    });
+
+    // Vehicles most similar to the given one (available stock only), served from
+    // the in-memory feature index without touching the database.
+    CROW_ROUTE(app, "/vehicles/<string>/similar")
+    .methods(crow::HTTPMethod::GET)
+    ([](const crow::request& req, std::string vehicleId) {
+        size_t k = 8;
+        if (const char* kParam = req.url_params.get("k")) {
+            int requested = std::atoi(kParam);
+            if (requested < 1 || requested > 50) {
+                return crow::response(400, "k must be between 1 and 50");
+            }
+            k = static_cast<size_t>(requested);
+        }
+
+        try {
+            ensureSimilarIndexLoaded();
+
+            bool found = false;
+            auto matches = similarVehicleIndex().nearest(vehicleId, k, found);
+            if (!found) {
+                return crow::response(404, "Vehicle not found");
+            }
+
+            crow::json::wvalue::list result;
+            result.reserve(matches.size());
+            for (const auto& match : matches) {
+                crow::json::wvalue item;
+                item["id"] = match.vehicle.id;
+                item["make"] = match.vehicle.make;
+                item["model"] = match.vehicle.model;
+                item["year"] = match.vehicle.year;
+                item["odometer"] = match.vehicle.odometer;
+                item["market_price"] = match.vehicle.marketPrice;
+                item["fuel_type"] = match.vehicle.fuelType;
+                item["transmission"] = match.vehicle.transmission;
+                item["distance"] = match.distance;
+                result.push_back(std::move(item));
+            }
+            crow::json::wvalue out;
+            out = std::move(result);
+            return crow::response(200, out);
+
+        } catch (const std::exception& e) {
+            return crow::response(500, std::string("Database error: ") + e.what());
+        }
+    });
+
+    // Bulk reprice: one set-based UPDATE over every vehicle matching the filter.
+    // Body: {"filter": {"make", "model", "year", "status", "min_days_in_stock"},
+    //        "rule": {"type": "percent"|"absolute", "value", "floor", "ceiling"},
+    //        "dry_run": bool}
+    // A dry run executes the same statement and rolls it back, so the diff it
+    // reports is exactly what a real run would apply.
+    CROW_ROUTE(app, "/vehicles/reprice")
+    .methods(crow::HTTPMethod::POST)
+    ([](const crow::request& req) {
         auto body = crow::json::load(req.body);
-        if (!body) return crow::response(400, "Invalid JSON");
+        if (!body || !body.has("filter") || !body.has("rule")) {
+            return crow::response(400, "Body must contain filter and rule");
+        }
+        const auto& filter = body["filter"];
+        const auto& rule = body["rule"];
+        if (filter.t() != crow::json::type::Object || rule.t() != crow::json::type::Object) {
+            return crow::response(400, "filter and rule must be objects");
+        }
+
+        auto optString = [](const crow::json::rvalue& obj, const char* key) -> std::optional<std::string> {
+            if (!obj.has(key) || obj[key].t() != crow::json::type::String) return std::nullopt;
+            return std::string(obj[key].s());
+        };
+        auto optNumber = [](const crow::json::rvalue& obj, const char* key) -> std::optional<double> {
+            if (!obj.has(key) || obj[key].t() != crow::json::type::Number) return std::nullopt;
+            return obj[key].d();
+        };
+
+        std::optional<std::string> make = optString(filter, "make");
+        std::optional<std::string> model = optString(filter, "model");
+        std::optional<std::string> status = optString(filter, "status");
+        std::optional<int> year;
+        if (auto y = optNumber(filter, "year")) year = static_cast<int>(*y);
+        std::optional<int> minDays;
+        if (auto d = optNumber(filter, "min_days_in_stock")) minDays = static_cast<int>(*d);
+
+        if (!make && !model && !status && !year && !minDays) {
+            return crow::response(400, "filter must contain at least one of make, model, year, status, min_days_in_stock");
+        }
+        if (minDays && *minDays < 0) {
+            return crow::response(400, "min_days_in_stock must not be negative");
+        }
+
+        std::optional<std::string> type = optString(rule, "type");
+        std::optional<double> value = optNumber(rule, "value");
+        std::optional<double> floor = optNumber(rule, "floor");
+        std::optional<double> ceiling = optNumber(rule, "ceiling");
+
+        if (!type || (*type != "percent" && *type != "absolute") || !value) {
+            return crow::response(400, "rule needs type 'percent' or 'absolute' and a numeric value");
+        }
+        if (*type == "percent" && *value <= -100) {
+            return crow::response(400, "percent must be greater than -100");
+        }
+        if ((floor && *floor <= 0) || (ceiling && *ceiling <= 0) ||
+            (floor && ceiling && *floor > *ceiling)) {
+            return crow::response(400, "floor and ceiling must be positive and floor <= ceiling");
+        }
+
+        bool dryRun = body.has("dry_run") && body["dry_run"].t() == crow::json::type::True;
 
         try {
             ConnectionGuard guard(getPool());
+            guard.prepare("vehicle_reprice", REPRICE_SQL);
             pqxx::work txn(guard.get());
 
-            // Convert crow::json::r_string to std::string
-            pqxx::row row = txn.exec_params(
-                "INSERT INTO Vehicles (vin, make, model, year, odometer, fuel_type, transmission, trim, market_price, status) "
-                "VALUES ($1,$2,$3,$4,$5,$6,$7,$8,$9,$10) RETURNING id",
-                std::string(body["vin"].s()),
-                std::string(body["make"].s()),
-                std::string(body["model"].s()),
-                body["year"].i(),
-                body["odometer"].i(),
-                std::string(body["fuel_type"].s()),
-                std::string(body["transmission"].s()),
-                std::string(body["trim"].s()),
-                body["market_price"].d(),
-                std::string(body["status"].s())
-            )[0];
-
-            
-            txn.commit();
-            crow::json::wvalue res;
-            res["id"] = row["id"].c_str();
-            return crow::response(201, res);
+            pqxx::result res = txn.exec_prepared("vehicle_reprice",
+                make, model, year, status, minDays, *type, *value, floor, ceiling);
+
+            crow::json::wvalue summary;
+            crow::json::wvalue::list vehicles;
+            double totalBefore = 0, totalAfter = 0;
+
+            for (const auto& row : res) {
+                if (row["id"].is_null()) continue;
+                double oldPrice = row["old_price"].as<double>();
+                double newPrice = row["new_price"].as<double>();
+                totalBefore += oldPrice;
+                totalAfter += newPrice;
+
+                crow::json::wvalue item;
+                item["id"] = row["id"].c_str();
+                item["vin"] = row["vin"].c_str();
+                item["make"] = row["make"].c_str();
+                item["model"] = row["model"].c_str();
+                item["year"] = row["year"].as<int>();
+                item["old_price"] = oldPrice;
+                item["new_price"] = newPrice;
+                vehicles.push_back(std::move(item));
+            }
+
+            summary["dry_run"] = dryRun;
+            summary["matched"] = res.empty() ? 0 : res[0]["matched"].as<int>();
+            summary["changed"] = static_cast<int>(vehicles.size());
+            summary["total_before"] = totalBefore;
+            summary["total_after"] = totalAfter;
+            summary["delta"] = totalAfter - totalBefore;
+            summary["vehicles"] = std::move(vehicles);
+
+            if (dryRun) {
+                txn.abort();
+            } else {
+                txn.commit();
+                std::vector<VehicleFeatures> repriced;
+                std::vector<std::string> repricedIds;
+                repriced.reserve(res.size());
+                repricedIds.reserve(res.size());
+                for (const auto& row : res) {
+                    if (row["id"].is_null()) continue;
+                    repriced.push_back(featuresFromRow(row));
+                    repricedIds.push_back(repriced.back().id);
+                }
+                similarVehicleIndex().upsertMany(repriced);
+                invoiceCache().invalidateVehicles(repricedIds);
+            }
+
+            return crow::response(200, summary);
+
+        } catch (const pqxx::data_exception& e) {
+            return crow::response(400, std::string("Invalid value: ") + e.what());
         } catch (const std::exception& e) {
             return crow::response(500, std::string("Database error: ") + e.what());
         }
     });
 
-
     CROW_ROUTE(app, "/vehicles/<string>")
     .methods(crow::HTTPMethod::PUT)
     ([](const crow::request& req, std::string vehicleId) {
         auto body = crow::json::load(req.body);
         if (!body) return crow::response(400, "Invalid JSON");
+        if (!body.has("vin") || body["vin"].t() != crow::json::type::String ||
+            !isVinFormat(std::string(body["vin"].s()))) {
+            return crow::response(400, "Invalid VIN (17 characters, no I, O or Q)");
+        }
 
         try {
-            ConnectionGuard guard(getPool());   
-            pqxx::work txn(guard.get());
+            // The connection goes back to the pool before the in-memory
+            // stores are touched.
+            pqxx::result res;
+            std::vector<SaleFact> soldFacts;
+            {
+                ConnectionGuard guard(getPool());
+                pqxx::work txn(guard.get());
+
+                res = txn.exec_params(
+                    "UPDATE Vehicles SET vin=$1, make=$2, model=$3, year=$4, odometer=$5, "
+                    "fuel_type=$6, transmission=$7, trim=$8, market_price=$9, status=$10, "
+                    "version = version + 1 "
+                    "WHERE id = $11::uuid "
+                    "RETURNING id, make, model, year, odometer, fuel_type, transmission, market_price, status",
+                    std::string(body["vin"].s()),
+                    std::string(body["make"].s()),
+                    std::string(body["model"].s()),
+                    body["year"].i(),
+                    body["odometer"].i(),
+                    std::string(body["fuel_type"].s()),
+                    std::string(body["transmission"].s()),
+                    std::string(body["trim"].s()),
+                    body["market_price"].d(),
+                    std::string(body["status"].s()),
+                    vehicleId
+                );
 
-            pqxx::result res = txn.exec_params(
-                "UPDATE Vehicles SET vin=$1, make=$2, model=$3, year=$4, odometer=$5, "
-                "fuel_type=$6, transmission=$7, trim=$8, market_price=$9, status=$10 "
-                "WHERE id::text = $11",
-                std::string(body["vin"].s()),
-                std::string(body["make"].s()),
-                std::string(body["model"].s()),
-                body["year"].i(),
-                body["odometer"].i(),
-                std::string(body["fuel_type"].s()),
-                std::string(body["transmission"].s()),
-                std::string(body["trim"].s()),
-                body["market_price"].d(),
-                std::string(body["status"].s()),
-                vehicleId
-            );
+                if (res.empty()) {
+                    return crow::response(404, "Vehicle not found or UUID mismatch");
+                }
+                soldFacts = fetchVehicleSaleFacts(txn, vehicleId);
 
-            if (res.affected_rows() == 0) {
-                return crow::response(404, "Vehicle not found or UUID mismatch");
+                txn.commit();
             }
-
-            txn.commit();
+            similarVehicleIndex().upsert(featuresFromRow(res[0]));
+            invoiceCache().invalidateVehicle(vehicleId);
+            for (const SaleFact& fact : soldFacts) salesFactTable().upsert(fact);
             std::cout << "[DEBUG] PUT /vehicles/" << vehicleId << " updated successfully" << std::endl;
             return crow::response(200, "Vehicle updated successfully");
 
@@ -223,6 +664,127 @@ void registerInventoryRoutes(crow::SimpleApp& app) {
         }
     });
 
+    // Partially update a vehicle. Only the supplied fields are written, and the
+    // If-Match header must carry the version the client last read ("*" skips
+    // the check) so concurrent editors cannot silently overwrite each other.
+    CROW_ROUTE(app, "/vehicles/<string>")
+    .methods(crow::HTTPMethod::PATCH)
+    ([](const crow::request& req, std::string vehicleId) {
+        if (vehicleId.length() != 36) {
+            return crow::response(400, "Invalid UUID format");
+        }
+
+        auto body = crow::json::load(req.body);
+        if (!body || body.t() != crow::json::type::Object) {
+            return crow::response(400, "Invalid JSON");
+        }
+
+        const std::string ifMatch = req.get_header_value("If-Match");
+        if (ifMatch.empty()) {
+            return crow::response(428, "If-Match header with the vehicle version is required");
+        }
+        std::optional<int> expectedVersion;
+        if (ifMatch != "*") {
+            expectedVersion = parseVersionTag(ifMatch);
+            if (!expectedVersion) {
+                return crow::response(400, "Invalid If-Match version");
+            }
+        }
+
+        // Collect the supplied fields in PATCHABLE_COLUMNS order, as text
+        // parameters; Postgres casts them to the column types.
+        Vehicle rules;
+        unsigned mask = 0;
+        std::vector<std::optional<std::string>> params;
+        for (size_t i = 0; i < PATCHABLE_COLUMNS.size(); ++i) {
+            const std::string column = PATCHABLE_COLUMNS[i];
+            if (!body.has(column)) continue;
+            const auto& value = body[column];
+
+            if (column == "year" || column == "odometer") {
+                if (value.t() != crow::json::type::Number) {
+                    return crow::response(400, column + " must be an integer");
+                }
+                int number = static_cast<int>(value.i());
+                if (column == "year" && !rules.isValidYear(number)) {
+                    return crow::response(400, "Invalid year");
+                }
+                if (column == "odometer" && !rules.isValidOdometer(number)) {
+                    return crow::response(400, "Invalid odometer");
+                }
+                params.emplace_back(std::to_string(number));
+            } else if (column == "market_price") {
+                if (value.t() != crow::json::type::Number || !rules.isValidMarketPrice(value.d())) {
+                    return crow::response(400, "market_price must be a positive number");
+                }
+                params.emplace_back(std::to_string(value.d()));
+            } else if (column == "trim" && value.t() == crow::json::type::Null) {
+                params.emplace_back(std::nullopt);
+            } else {
+                if (value.t() != crow::json::type::String) {
+                    return crow::response(400, column + " must be a string");
+                }
+                if (column == "vin" && !isVinFormat(std::string(value.s()))) {
+                    return crow::response(400, "Invalid VIN (17 characters, no I, O or Q)");
+                }
+                params.emplace_back(std::string(value.s()));
+            }
+            mask |= 1u << i;
+        }
+
+        if (mask == 0) {
+            return crow::response(400, "No updatable fields provided");
+        }
+
+        params.emplace_back(vehicleId);
+        if (expectedVersion) params.emplace_back(std::to_string(*expectedVersion));
+        else params.emplace_back(std::nullopt);
+
+        try {
+            // The connection goes back to the pool before the in-memory
+            // stores are touched.
+            pqxx::result res;
+            std::vector<SaleFact> soldFacts;
+            {
+                ConnectionGuard guard(getPool());
+                const std::string statement = "vehicle_patch_" + std::to_string(mask);
+                guard.prepare(statement, buildPatchSql(mask));
+
+                pqxx::work txn(guard.get());
+                res = txn.exec_prepared(statement, pqxx::prepare::make_dynamic_params(params));
+
+                if (res.empty()) {
+                    // Either the vehicle does not exist or someone else updated it first.
+                    pqxx::result current = txn.exec_params(
+                        "SELECT version FROM Vehicles WHERE id = $1::uuid", vehicleId);
+                    if (current.empty()) {
+                        return crow::response(404, "Vehicle not found");
+                    }
+                    crow::response conflict(412, "Vehicle was modified by another request");
+                    conflict.set_header("ETag", versionETag(current[0]["version"].as<int>()));
+                    return conflict;
+                }
+                soldFacts = fetchVehicleSaleFacts(txn, vehicleId);
+
+                txn.commit();
+            }
+            similarVehicleIndex().upsert(featuresFromRow(res[0]));
+            invoiceCache().invalidateVehicle(vehicleId);
+            for (const SaleFact& fact : soldFacts) salesFactTable().upsert(fact);
+
+            crow::response response(200, vehicleRowToJson(res[0]));
+            response.set_header("ETag", versionETag(res[0]["version"].as<int>()));
+            return response;
+
+        } catch (const pqxx::unique_violation&) {
+            return crow::response(409, "A vehicle with this VIN already exists");
+        } catch (const pqxx::data_exception& e) {
+            return crow::response(400, std::string("Invalid value: ") + e.what());
+        } catch (const std::exception& e) {
+            return crow::response(500, std::string("Database error: ") + e.what());
+        }
+    });
+
     CROW_ROUTE(app, "/test_post").methods(crow::HTTPMethod::POST)
     ([](const crow::request& req){
         std::cout << "[DEBUG] /test_post received POST!" << std::endl;
@@ -0,0 +1,180 @@
+#include "similar_vehicles.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+namespace {
+    // Eight packed floats; GCC/Clang lower arithmetic on this type to SSE/AVX.
+    typedef float Vec8 __attribute__((vector_size(32)));
+
+    // Relative weights of each feature group in the distance.
+    constexpr float YEAR_WEIGHT = 1.0f;
+    constexpr float ODOMETER_WEIGHT = 1.0f;
+    constexpr float PRICE_WEIGHT = 1.5f;
+    constexpr float CATEGORY_WEIGHT = 0.5f;
+    constexpr float MAKE_WEIGHT = 0.6f;
+    constexpr float MODEL_WEIGHT = 0.8f;
+
+    uint64_t fnv1a(const std::string& s) {
+        uint64_t h = 1469598103934665603ull;
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Spreads a string over three coordinates in [-1, 1]; equal strings land on
+    // the same point, different ones are (pseudo-randomly) far apart.
+    void embed(const std::string& s, float weight, float* out) {
+        uint64_t h = fnv1a(s);
+        for (int i = 0; i < 3; ++i) {
+            out[i] = weight * (static_cast<float>((h >> (i * 21)) & 0x1FFFFF) / 1048575.5f - 1.0f);
+        }
+    }
+
+    float squaredDistance(const float* a, const float* b) {
+        Vec8 a0, a1, b0, b1;
+        std::memcpy(&a0, a, sizeof(Vec8));
+        std::memcpy(&a1, a + 8, sizeof(Vec8));
+        std::memcpy(&b0, b, sizeof(Vec8));
+        std::memcpy(&b1, b + 8, sizeof(Vec8));
+        Vec8 d0 = a0 - b0;
+        Vec8 d1 = a1 - b1;
+        Vec8 s = d0 * d0 + d1 * d1;
+        return (s[0] + s[1]) + (s[2] + s[3]) + (s[4] + s[5]) + (s[6] + s[7]);
+    }
+}
+
+void SimilarVehicleIndex::encode(const VehicleFeatures& v, float* out) {
+    std::fill(out, out + DIMENSIONS, 0.0f);
+
+    out[0] = YEAR_WEIGHT * static_cast<float>(v.year - 2000) / 25.0f;
+    out[1] = ODOMETER_WEIGHT * static_cast<float>(std::max(v.odometer, 0)) / 200000.0f;
+
+    // Log scale so a $2k gap matters more on a $15k car than on a $90k one.
+    const double lo = std::log(5000.0), hi = std::log(200000.0);
+    double price = std::clamp(v.marketPrice, 5000.0, 200000.0);
+    out[2] = PRICE_WEIGHT * static_cast<float>((std::log(price) - lo) / (hi - lo));
+
+    static const char* FUELS[] = {"Gasoline", "Diesel", "Electric", "Hybrid"};
+    for (int i = 0; i < 4; ++i) {
+        if (v.fuelType == FUELS[i]) out[3 + i] = CATEGORY_WEIGHT;
+    }
+    static const char* TRANSMISSIONS[] = {"Manual", "Automatic", "CVT"};
+    for (int i = 0; i < 3; ++i) {
+        if (v.transmission == TRANSMISSIONS[i]) out[7 + i] = CATEGORY_WEIGHT;
+    }
+
+    embed(v.make, MAKE_WEIGHT, out + 10);
+    embed(v.make + "/" + v.model, MODEL_WEIGHT, out + 13);
+}
+
+void SimilarVehicleIndex::upsert(const VehicleFeatures& vehicle) {
+    upsertMany(std::span<const VehicleFeatures>(&vehicle, 1));
+}
+
+void SimilarVehicleIndex::upsertMany(std::span<const VehicleFeatures> batch) {
+    std::vector<Row> encoded(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) encode(batch[i], encoded[i].f);
+
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    if (reloading) pendingUpserts.insert(pendingUpserts.end(), batch.begin(), batch.end());
+    for (size_t i = 0; i < batch.size(); ++i) upsertLocked(batch[i], encoded[i]);
+}
+
+void SimilarVehicleIndex::upsertLocked(const VehicleFeatures& vehicle, const Row& row) {
+    auto it = slots.find(vehicle.id);
+    if (it != slots.end()) {
+        rows[it->second] = row;
+        vehicles[it->second] = vehicle;
+        available[it->second] = vehicle.available;
+        return;
+    }
+    slots.emplace(vehicle.id, rows.size());
+    rows.push_back(row);
+    vehicles.push_back(vehicle);
+    available.push_back(vehicle.available);
+}
+
+void SimilarVehicleIndex::reload(const std::function<std::vector<VehicleFeatures>()>& source) {
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        reloading = true;
+        pendingUpserts.clear();
+    }
+
+    SimilarVehicleIndex fresh;
+    try {
+        fresh.upsertMany(source());
+    } catch (...) {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        reloading = false;
+        pendingUpserts.clear();
+        throw;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mtx);
+    for (const VehicleFeatures& vehicle : pendingUpserts) {
+        Row row;
+        encode(vehicle, row.f);
+        fresh.upsertLocked(vehicle, row);
+    }
+    pendingUpserts.clear();
+    reloading = false;
+    rows.swap(fresh.rows);
+    vehicles.swap(fresh.vehicles);
+    available.swap(fresh.available);
+    slots.swap(fresh.slots);
+}
+
+size_t SimilarVehicleIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    return rows.size();
+}
+
+std::vector<SimilarVehicleIndex::Match>
+SimilarVehicleIndex::nearest(const std::string& id, size_t k, bool& found) const {
+    std::shared_lock<std::shared_mutex> lock(mtx);
+    auto it = slots.find(id);
+    found = it != slots.end();
+    if (!found || k == 0) return {};
+
+    const size_t self = it->second;
+    const Row query = rows[self];
+
+    // Max-heap on distance holding the best k seen so far.
+    std::vector<std::pair<float, size_t>> heap;
+    heap.reserve(k + 1);
+    float worst = INFINITY;
+
+    const size_t n = rows.size();
+    for (size_t i = 0; i < n; ++i) {
+        float d = squaredDistance(query.f, rows[i].f);
+        if (d >= worst || i == self || !available[i]) continue;
+
+        heap.emplace_back(d, i);
+        std::push_heap(heap.begin(), heap.end());
+        if (heap.size() > k) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+        }
+        if (heap.size() == k) worst = heap.front().first;
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+
+    std::vector<Match> matches;
+    matches.reserve(heap.size());
+    for (const auto& [distance, slot] : heap) {
+        matches.push_back({vehicles[slot], distance});
+    }
+    return matches;
+}
+
+SimilarVehicleIndex& similarVehicleIndex() {
+    static SimilarVehicleIndex index;
+    return index;
+}
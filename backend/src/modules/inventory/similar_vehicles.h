@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// @struct VehicleFeatures
+/// @brief The vehicle attributes the similarity index is built from.
+struct VehicleFeatures {
+    std::string id;
+    std::string make;
+    std::string model;
+    int year = 0;
+    int odometer = 0;
+    double marketPrice = 0;
+    std::string fuelType;
+    std::string transmission;
+    bool available = true;
+};
+
+/// @class SimilarVehicleIndex
+/// @brief In-memory feature matrix answering "vehicles like this one" queries.
+///
+/// Every vehicle becomes one 16-float row (one cache line): normalized year,
+/// odometer and log price, one-hot fuel type and transmission, and small hashed
+/// embeddings of make and model. The normalization constants are fixed, so a
+/// write only touches its own row and the index never needs a full rebuild.
+/// Queries are a brute-force SIMD scan keeping a bounded max-heap of the k
+/// closest available vehicles.
+class SimilarVehicleIndex {
+public:
+    static constexpr size_t DIMENSIONS = 16;
+
+    /// @brief A query hit: the stored vehicle and its squared distance.
+    struct Match {
+        VehicleFeatures vehicle;
+        float distance;
+    };
+
+    /// @brief Inserts a vehicle or replaces the row of an existing one.
+    /// @param vehicle The vehicle attributes.
+    void upsert(const VehicleFeatures& vehicle);
+
+    /// @brief Upserts many vehicles under one write lock, e.g. after a bulk
+    /// reprice or the initial load. Rows are encoded before the lock is taken.
+    /// @param vehicles The vehicle attributes.
+    void upsertMany(std::span<const VehicleFeatures> vehicles);
+
+    /// @brief Replaces the contents with the vehicles `source` returns.
+    ///
+    /// The new matrix is built without the lock and swapped in under a short
+    /// write lock. Upserts issued while `source` runs are queued and applied
+    /// on top of it, so a vehicle written after the snapshot was read keeps
+    /// its newer row. Reloads must not run concurrently.
+    /// @param source Reads the current vehicles.
+    void reload(const std::function<std::vector<VehicleFeatures>()>& source);
+
+    /// @brief Finds the k available vehicles closest to the given one.
+    /// @param id The vehicle to compare against (itself excluded).
+    /// @param k Maximum number of matches.
+    /// @param found Set to false when the id is not indexed.
+    /// @return Matches ordered from most to least similar.
+    std::vector<Match> nearest(const std::string& id, size_t k, bool& found) const;
+
+    /// @brief Number of indexed vehicles.
+    size_t size() const;
+
+    /// @brief Computes the feature row for a vehicle.
+    /// @param vehicle The vehicle attributes.
+    /// @param out Receives DIMENSIONS floats.
+    static void encode(const VehicleFeatures& vehicle, float* out);
+
+private:
+    struct alignas(64) Row {
+        float f[DIMENSIONS];
+    };
+
+    void upsertLocked(const VehicleFeatures& vehicle, const Row& row);
+
+    mutable std::shared_mutex mtx;
+    bool reloading = false;
+    std::vector<VehicleFeatures> pendingUpserts; // upserts made while reload() runs
+    std::vector<Row> rows;
+    std::vector<VehicleFeatures> vehicles;
+    std::vector<unsigned char> available; // kept apart so the scan stays in the matrix
+    std::unordered_map<std::string, size_t> slots;
+};
+
+/// @brief Process-wide similarity index shared by the inventory routes.
+SimilarVehicleIndex& similarVehicleIndex();
@@ -0,0 +1,286 @@
+#include "invoice.h"
+#include "../../external/crow/crow_all.h"
+#include "../../utils/http_cache.h"
+#include <cmath>
+
+namespace {
+    // Sized for the working set of recent sales: an invoice renders to roughly
+    // 2 KB, so a full cache holds about 16 MB.
+    constexpr size_t INVOICE_CACHE_CAPACITY = 8192;
+
+    const char* INVOICE_SQL =
+        "SELECT "
+        "  s.id AS sale_id, "
+        "  s.date AS sale_date, "
+        "  s.sale_price, "
+        "  s.version, "
+        "  v.id AS vehicle_id, "
+        "  v.make, "
+        "  v.model, "
+        "  v.year, "
+        "  v.vin, "
+        "  v.odometer, "
+        "  v.fuel_type, "
+        "  v.transmission, "
+        "  v.trim, "
+        "  s.market_price, "
+        "  v.status, "
+        "  c.id AS customer_id, "
+        "  c.first_name, "
+        "  c.last_name, "
+        "  c.email, "
+        "  c.ph_number, "
+        "  c.address, "
+        "  c.driving_licence "
+        "FROM Sales s "
+        "JOIN Vehicles v ON s.vehicle_id = v.id "
+        "JOIN Customers c ON s.customer_id = c.id "
+        "WHERE s.id = $1";
+
+    std::string renderInvoiceBody(const pqxx::row& row) {
+        // ========================================
+        // BUILDING STRINGS FIRST
+        // ========================================
+
+        std::string customer_name = std::string(row["first_name"].c_str()) + " " +
+                                    row["last_name"].c_str();
+
+        std::string vehicle_description = std::string(row["year"].c_str()) + " " +
+                                          row["make"].c_str() + " " +
+                                          row["model"].c_str();
+
+        // Add trim if exists
+        if (!row["trim"].is_null()) {
+            vehicle_description += " " + std::string(row["trim"].c_str());
+        }
+
+        // ========================================
+        // CALCULATIONS
+        // ========================================
+
+        double base_price = row["sale_price"].as<double>();
+        double sales_tax_rate = 0.13;
+        double sales_tax = base_price * sales_tax_rate;
+        double documentation_fee = 500.00;
+        double registration_fee = 120.00;
+        double delivery_fee = 0.00;
+
+        double subtotal = base_price;
+        double total_fees = documentation_fee + registration_fee + delivery_fee;
+        double total_before_tax = subtotal + total_fees;
+        double total_amount = total_before_tax + sales_tax;
+
+        // Profit analysis is just for backend crunching - not shown to customers
+        double market_price = row["market_price"].as<double>();
+        double profit = base_price - market_price;
+        double profit_percentage = (profit / market_price) * 100;
+
+        // ========================================
+        // BUILD JSON RESPONSE
+        // ========================================
+
+        crow::json::wvalue invoice;
+
+        // Invoice metadata
+        invoice["invoice_number"] = row["sale_id"].c_str();
+        invoice["invoice_date"] = row["sale_date"].c_str();
+        invoice["invoice_type"] = "Vehicle Sale";
+
+        // Customer information
+        invoice["customer"]["customer_id"] = row["customer_id"].c_str();
+        invoice["customer"]["name"] = customer_name;
+        invoice["customer"]["email"] = row["email"].c_str();
+        invoice["customer"]["phone"] = row["ph_number"].c_str();
+        invoice["customer"]["address"] = row["address"].is_null() ? "" : row["address"].c_str();
+        invoice["customer"]["driving_licence"] = row["driving_licence"].c_str();
+
+        // Vehicle information
+        invoice["vehicle"]["vehicle_id"] = row["vehicle_id"].c_str();
+        invoice["vehicle"]["description"] = vehicle_description;
+        invoice["vehicle"]["vin"] = row["vin"].c_str();
+        invoice["vehicle"]["year"] = row["year"].as<int>();
+        invoice["vehicle"]["make"] = row["make"].c_str();
+        invoice["vehicle"]["model"] = row["model"].c_str();
+        invoice["vehicle"]["trim"] = row["trim"].is_null() ? "" : row["trim"].c_str();
+        invoice["vehicle"]["odometer"] = row["odometer"].as<int>();
+        invoice["vehicle"]["fuel_type"] = row["fuel_type"].c_str();
+        invoice["vehicle"]["transmission"] = row["transmission"].c_str();
+
+        // Line items
+        invoice["line_items"] = crow::json::wvalue::list();
+
+        invoice["line_items"][0]["description"] = vehicle_description;
+        invoice["line_items"][0]["quantity"] = 1;
+        invoice["line_items"][0]["unit_price"] = base_price;
+        invoice["line_items"][0]["amount"] = base_price;
+
+        invoice["line_items"][1]["description"] = "Documentation Fee";
+        invoice["line_items"][1]["quantity"] = 1;
+        invoice["line_items"][1]["unit_price"] = documentation_fee;
+        invoice["line_items"][1]["amount"] = documentation_fee;
+
+        invoice["line_items"][2]["description"] = "Registration Fee";
+        invoice["line_items"][2]["quantity"] = 1;
+        invoice["line_items"][2]["unit_price"] = registration_fee;
+        invoice["line_items"][2]["amount"] = registration_fee;
+
+        // Pricing breakdown
+        invoice["pricing"]["subtotal"] = subtotal;
+        invoice["pricing"]["documentation_fee"] = documentation_fee;
+        invoice["pricing"]["registration_fee"] = registration_fee;
+        invoice["pricing"]["delivery_fee"] = delivery_fee;
+        invoice["pricing"]["total_fees"] = total_fees;
+        invoice["pricing"]["total_before_tax"] = total_before_tax;
+        invoice["pricing"]["sales_tax_rate"] = sales_tax_rate;
+        invoice["pricing"]["sales_tax"] = sales_tax;
+        invoice["pricing"]["total_amount"] = total_amount;
+
+        // Tax breakdown
+        invoice["taxes"] = crow::json::wvalue::list();
+        invoice["taxes"][0]["name"] = "HST (Harmonized Sales Tax)";
+        invoice["taxes"][0]["rate"] = sales_tax_rate;
+        invoice["taxes"][0]["amount"] = sales_tax;
+
+        // Payment information
+        invoice["payment"]["status"] = "Paid";
+        invoice["payment"]["method"] = "Not specified";
+        invoice["payment"]["amount_paid"] = total_amount;
+        invoice["payment"]["balance_due"] = 0.00;
+
+        // Internal analytics
+        invoice["analytics"]["market_price"] = market_price;
+        invoice["analytics"]["profit"] = profit;
+        invoice["analytics"]["profit_percentage"] = std::round(profit_percentage * 100) / 100.0;
+
+        // Dealer information
+        invoice["dealer"]["name"] = "DealerDrive Auto Sales";
+        invoice["dealer"]["address"] = "123 Main Street, Toronto, ON M5V 3A8";
+        invoice["dealer"]["phone"] = "(416) 555-0100";
+        invoice["dealer"]["email"] = "sales@dealerdrive.com";
+        invoice["dealer"]["website"] = "www.dealerdrive.com";
+
+        // Terms and conditions
+        invoice["terms"] = crow::json::wvalue::list();
+        invoice["terms"][0] = "Vehicle sold 'as is' with no warranty";
+        invoice["terms"][1] = "All sales are final";
+        invoice["terms"][2] = "Buyer is responsible for vehicle inspection";
+        invoice["terms"][3] = "Payment due upon signing";
+
+        // Notes
+        invoice["notes"] = "Thank you for your business!";
+
+        return invoice.dump();
+    }
+}
+
+InvoiceCache::InvoiceCache(size_t capacity) : capacity(capacity) {}
+
+std::shared_ptr<const RenderedInvoice> InvoiceCache::get(const std::string& saleId) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = bySale.find(saleId);
+    if (it == bySale.end()) return nullptr;
+    lru.splice(lru.begin(), lru, it->second);
+    return *it->second;
+}
+
+bool InvoiceCache::put(std::shared_ptr<const RenderedInvoice> invoice, uint64_t seenEpoch) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = bySale.find(invoice->saleId);
+    if (it != bySale.end()) {
+        if ((*it->second)->version > invoice->version) return false;
+        eraseLocked(it);
+    }
+    if (seenEpoch != currentEpoch.load(std::memory_order_relaxed)) return false;
+
+    lru.push_front(invoice);
+    bySale.emplace(invoice->saleId, lru.begin());
+    byVehicle[invoice->vehicleId].insert(invoice->saleId);
+    byCustomer[invoice->customerId].insert(invoice->saleId);
+
+    while (bySale.size() > capacity) {
+        eraseLocked(bySale.find(lru.back()->saleId));
+    }
+    return true;
+}
+
+void InvoiceCache::eraseLocked(std::unordered_map<std::string, Lru::iterator>::iterator it) {
+    const RenderedInvoice& invoice = **it->second;
+    auto unlink = [&](auto& index, const std::string& key) {
+        auto entry = index.find(key);
+        if (entry == index.end()) return;
+        entry->second.erase(invoice.saleId);
+        if (entry->second.empty()) index.erase(entry);
+    };
+    unlink(byVehicle, invoice.vehicleId);
+    unlink(byCustomer, invoice.customerId);
+
+    Lru::iterator node = it->second;
+    bySale.erase(it);
+    lru.erase(node);
+}
+
+void InvoiceCache::invalidateSale(const std::string& saleId) {
+    std::lock_guard<std::mutex> lock(mtx);
+    currentEpoch.fetch_add(1, std::memory_order_release);
+    auto it = bySale.find(saleId);
+    if (it != bySale.end()) eraseLocked(it);
+}
+
+void InvoiceCache::invalidateIndexed(std::unordered_map<std::string, std::unordered_set<std::string>>& index,
+                                     std::span<const std::string> keys) {
+    std::lock_guard<std::mutex> lock(mtx);
+    currentEpoch.fetch_add(1, std::memory_order_release);
+    for (const std::string& key : keys) {
+        auto entry = index.find(key);
+        if (entry == index.end()) continue;
+        // eraseLocked() edits the set being walked, so work from a copy.
+        const std::unordered_set<std::string> saleIds = entry->second;
+        for (const auto& saleId : saleIds) {
+            auto it = bySale.find(saleId);
+            if (it != bySale.end()) eraseLocked(it);
+        }
+    }
+}
+
+void InvoiceCache::invalidateVehicle(const std::string& vehicleId) {
+    invalidateIndexed(byVehicle, std::span<const std::string>(&vehicleId, 1));
+}
+
+void InvoiceCache::invalidateVehicles(std::span<const std::string> vehicleIds) {
+    invalidateIndexed(byVehicle, vehicleIds);
+}
+
+void InvoiceCache::invalidateCustomer(const std::string& customerId) {
+    invalidateIndexed(byCustomer, std::span<const std::string>(&customerId, 1));
+}
+
+size_t InvoiceCache::size() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return bySale.size();
+}
+
+InvoiceCache& invoiceCache() {
+    static InvoiceCache cache(INVOICE_CACHE_CAPACITY);
+    return cache;
+}
+
+void prepareInvoice(ConnectionGuard& guard) {
+    guard.prepare("sale_invoice", INVOICE_SQL);
+}
+
+std::optional<RenderedInvoice> loadInvoice(pqxx::transaction_base& txn, const std::string& saleId) {
+    pqxx::result r = txn.exec_prepared("sale_invoice", saleId);
+    if (r.empty()) return std::nullopt;
+    return invoiceFromRow(r[0]);
+}
+
+RenderedInvoice invoiceFromRow(const pqxx::row& row) {
+    RenderedInvoice invoice;
+    invoice.saleId = row["sale_id"].c_str();
+    invoice.vehicleId = row["vehicle_id"].c_str();
+    invoice.customerId = row["customer_id"].c_str();
+    invoice.version = row["version"].as<int>();
+    invoice.body = renderInvoiceBody(row);
+    invoice.etag = contentETag(invoice.body);
+    return invoice;
+}
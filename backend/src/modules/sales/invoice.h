@@ -0,0 +1,103 @@
+#pragma once
+#include "../../db/db_connection.h"
+#include <pqxx/pqxx>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+/// @file invoice.h
+/// @brief Pre-rendered sale invoices and the bounded cache that serves them.
+///
+/// An invoice is rendered to JSON once, when its sale is created or updated or
+/// on the first read after an eviction, and then served as stored bytes with a
+/// strong ETag. The rendering depends on the sale, its vehicle and its
+/// customer, so each entry remembers the vehicle and customer it was built
+/// from and an edit to either drops it.
+
+/// @brief One rendered invoice.
+struct RenderedInvoice {
+    std::string saleId;
+    std::string vehicleId;
+    std::string customerId;
+    int version = 0;        ///< Sales.version the body was rendered from.
+    std::string body;       ///< Serialized JSON document.
+    std::string etag;       ///< contentETag(body).
+};
+
+/// @brief LRU of rendered invoices keyed by sale id, bounded by entry count.
+///
+/// Readers that miss render from the database outside the cache lock. To keep
+/// such a render from reinstalling data an edit has just invalidated, every
+/// invalidation advances an epoch: a loader reads epoch() before querying and
+/// put() refuses the entry if the epoch has moved since.
+class InvoiceCache {
+public:
+    explicit InvoiceCache(size_t capacity);
+
+    /// @brief Cached invoice of a sale, or nullptr. Marks it recently used.
+    std::shared_ptr<const RenderedInvoice> get(const std::string& saleId);
+
+    /// @brief Current invalidation epoch; read it before loading an invoice.
+    uint64_t epoch() const { return currentEpoch.load(std::memory_order_acquire); }
+
+    /// @brief Stores an invoice loaded while the epoch was `seenEpoch`.
+    /// Any cached older version of the sale is dropped either way, so a writer
+    /// whose fresh render is refused still evicts the stale one.
+    /// @return false if an invalidation happened since, or the cache already
+    ///         holds a newer version of the sale.
+    bool put(std::shared_ptr<const RenderedInvoice> invoice, uint64_t seenEpoch);
+
+    /// @brief Drops the invoice of one sale.
+    void invalidateSale(const std::string& saleId);
+
+    /// @brief Drops every invoice rendered from this vehicle.
+    void invalidateVehicle(const std::string& vehicleId);
+
+    /// @brief Drops every invoice rendered from any of these vehicles, under
+    /// one lock and one epoch step (e.g. after a bulk reprice).
+    void invalidateVehicles(std::span<const std::string> vehicleIds);
+
+    /// @brief Drops every invoice rendered from this customer.
+    void invalidateCustomer(const std::string& customerId);
+
+    size_t size();
+
+private:
+    using Lru = std::list<std::shared_ptr<const RenderedInvoice>>;
+
+    void eraseLocked(std::unordered_map<std::string, Lru::iterator>::iterator it);
+    void invalidateIndexed(std::unordered_map<std::string, std::unordered_set<std::string>>& index,
+                           std::span<const std::string> keys);
+
+    const size_t capacity;
+    std::mutex mtx;
+    std::atomic<uint64_t> currentEpoch{0};
+    Lru lru;    // most recently used first
+    std::unordered_map<std::string, Lru::iterator> bySale;
+    std::unordered_map<std::string, std::unordered_set<std::string>> byVehicle;
+    std::unordered_map<std::string, std::unordered_set<std::string>> byCustomer;
+};
+
+/// @brief Process-wide invoice cache used by the sales routes and invalidated
+/// by the vehicle and customer routes.
+InvoiceCache& invoiceCache();
+
+/// @brief Prepares the invoice query on the guarded connection.
+/// Call before opening the transaction passed to loadInvoice().
+void prepareInvoice(ConnectionGuard& guard);
+
+/// @brief Reads a sale with its vehicle and customer and renders its invoice.
+/// @return std::nullopt when the sale does not exist.
+std::optional<RenderedInvoice> loadInvoice(pqxx::transaction_base& txn, const std::string& saleId);
+
+/// @brief Renders an invoice from a row carrying the columns of the invoice
+/// query: sale_id, sale_date, sale_price, version, the vehicle columns with
+/// vehicle_id, and the customer columns with customer_id.
+RenderedInvoice invoiceFromRow(const pqxx::row& row);
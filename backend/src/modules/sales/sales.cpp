@@ -1,51 +1,501 @@
 #include "sales.h"
+#include "sales_rollup.h"
+#include "sales_distribution.h"
+#include "invoice.h"
+#include "sales_import.h"
+#include "../analytics/analytics.h"
+#include "../inventory/similar_vehicles.h"
 #include "../../db/db_connection.h"
+#include "../../db/sql_errors.h"
+#include "../../utils/civil_date.h"
+#include "../../utils/http_cache.h"
+#include "../../utils/idempotency.h"
+#include "../../utils/uuid.h"
 #include <pqxx/pqxx>
-#include <ctime>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <iomanip>
+#include <vector>
 /// @file sales.cpp
 /// @brief Implements sales-related HTTP endpoints and helper functions for the application.
 
-/// @brief Validates if a date string is in YYYY-MM-DD format and is a valid calendar date.
-/// @param date The date string to validate.
-/// @return true if the date is valid, false otherwise.
-bool isValidDate(const std::string& date) {
-    std::tm tm = {};
-    std::istringstream ss(date);
-    ss >> std::get_time(&tm, "%Y-%m-%d");
+namespace {
+    // Columns GET /sales/export/csv can emit, in default output order. Only
+    // keys from this list reach the SQL, so the select list is never built
+    // from client text.
+    struct ExportColumn {
+        const char* key;
+        const char* header;
+        const char* expr;
+        bool byDefault;
+    };
+
+    const std::array<ExportColumn, 20> EXPORT_COLUMNS = {{
+        {"date",         "Date",                   "s.date",                      true},
+        {"sale_price",   "Sale Price",             "s.sale_price",                true},
+        {"market_price", "Market Price",           "s.market_price",              true},
+        {"profit",       "Profit compare to MRP",  "(s.sale_price - s.market_price)", true},
+        {"profit_pct",   "Profit %",               "ROUND(((s.sale_price - s.market_price) / s.market_price * 100), 2)", true},
+        {"vin",          "VIN",                    "v.vin",                       true},
+        {"make",         "Make",                   "s.make",                      true},
+        {"model",        "Model",                  "s.model",                     true},
+        {"year",         "Year",                   "v.year",                      true},
+        {"trim",         "Trim",                   "v.trim",                      true},
+        {"odometer",     "Odometer",               "v.odometer",                  true},
+        {"fuel_type",    "Fuel Type",              "v.fuel_type",                 true},
+        {"transmission", "Transmission",           "v.transmission",              true},
+        {"first_name",   "First Name",             "c.first_name",                true},
+        {"last_name",    "Last Name",              "c.last_name",                 true},
+        {"email",        "Email",                  "c.email",                     true},
+        {"phone",        "Phone",                  "c.ph_number",                 true},
+        {"sale_id",      "Sale ID",                "s.id",                        false},
+        {"vehicle_id",   "Vehicle ID",             "v.id",                        false},
+        {"customer_id",  "Customer ID",            "c.id",                        false},
+    }};
+
+    // Rows fetched per cursor round trip; bounds the memory held per export.
+    constexpr int EXPORT_BATCH_ROWS = 2000;
+    // Spooled exports are left for Crow to send and swept on a later export.
+    constexpr auto EXPORT_MAX_AGE = std::chrono::minutes(15);
+
+    std::filesystem::path exportDir() {
+        return std::filesystem::temp_directory_path() / "sales_exports";
+    }
+
+    // Resolves a comma-separated "columns" parameter. Returns false and names the
+    // offending key in `bad` when an unknown column is requested.
+    bool resolveExportColumns(const char* param, std::vector<const ExportColumn*>& out, std::string& bad) {
+        if (!param || !*param) {
+            for (const auto& c : EXPORT_COLUMNS) {
+                if (c.byDefault) out.push_back(&c);
+            }
+            return true;
+        }
+        std::string list(param);
+        size_t start = 0;
+        while (start <= list.size()) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) end = list.size();
+            std::string key = list.substr(start, end - start);
+            start = end + 1;
+            if (key.empty()) continue;
+
+            const ExportColumn* match = nullptr;
+            for (const auto& c : EXPORT_COLUMNS) {
+                if (key == c.key) match = &c;
+            }
+            if (!match) {
+                bad = key;
+                return false;
+            }
+            out.push_back(match);
+        }
+        if (out.empty()) {
+            bad = list;
+            return false;
+        }
+        return true;
+    }
+
+    // Appends one RFC 4180 field, quoting only when the value needs it.
+    void appendCsvField(std::string& line, const char* value, size_t len) {
+        bool quote = false;
+        for (size_t i = 0; i < len && !quote; ++i) {
+            char ch = value[i];
+            quote = ch == ',' || ch == '"' || ch == '\n' || ch == '\r';
+        }
+        if (!quote) {
+            line.append(value, len);
+            return;
+        }
+        line.push_back('"');
+        for (size_t i = 0; i < len; ++i) {
+            if (value[i] == '"') line.push_back('"');
+            line.push_back(value[i]);
+        }
+        line.push_back('"');
+    }
+
+    // Deletes spooled exports old enough that Crow has finished sending them.
+    void sweepOldExports(const std::filesystem::path& dir) {
+        std::error_code ec;
+        auto cutoff = std::filesystem::file_time_type::clock::now() - EXPORT_MAX_AGE;
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+            if (entry.is_regular_file(ec) && entry.last_write_time(ec) < cutoff) {
+                std::filesystem::remove(entry.path(), ec);
+            }
+        }
+    }
+
+    // Loads the price/profit sketches for every sale once. A failed load
+    // leaves the flag unset, so the next request tries again.
+    void ensureDistributionLoaded() {
+        static std::once_flag loaded;
+        std::call_once(loaded, [] {
+            salesDistribution().reload([](const SalesDistributionStore::Sink& sink) {
+                ConnectionGuard guard(getPool());
+                pqxx::work txn(guard.get());
+                pqxx::icursorstream cursor(txn,
+                    "SELECT s.make, s.model, s.date, s.sale_price, s.market_price FROM Sales s",
+                    "sales_distribution", 10000);
+                pqxx::result batch;
+                while (cursor >> batch) {
+                    for (const auto& row : batch) {
+                        sink(row["make"].c_str(), row["model"].c_str(), row["date"].c_str(),
+                             row["sale_price"].as<double>(), row["market_price"].as<double>());
+                    }
+                }
+                txn.commit();
+            });
+        });
+    }
+
+    // Rebuilds the dirty sketch buckets a distribution query is about to read.
+    void rebuildDirtyBuckets(const std::string& make, const std::string& model, int fromMonth, int toMonth) {
+        auto& store = salesDistribution();
+        std::vector<SalesDistributionStore::BucketKey> keys = store.beginRebuild(make, model, fromMonth, toMonth);
+        if (keys.empty()) return;
+
+        size_t done = 0;
+        try {
+            ConnectionGuard guard(getPool());
+            pqxx::work txn(guard.get());
+            for (; done < keys.size(); ++done) {
+                const auto& [bMake, bModel, month] = keys[done];
+                const std::string monthStart = toDateString(monthFromIndex(month));
 
-    if (ss.fail()) return false;
+                pqxx::result r = txn.exec_params(
+                    "SELECT s.sale_price, s.market_price FROM Sales s "
+                    "WHERE s.make = $1 AND s.model = $2 "
+                    "AND s.date >= $3::date AND s.date < $3::date + INTERVAL '1 month'",
+                    bMake, bModel, monthStart);
+
+                SalesDistributionStore::Summary summary;
+                for (const auto& row : r) {
+                    double price = row["sale_price"].as<double>();
+                    summary.salePrice.add(price);
+                    summary.profit.add(price - row["market_price"].as<double>());
+                }
+                store.finishRebuild(keys[done], std::move(summary));
+            }
+            txn.commit();
+        } catch (...) {
+            store.abortRebuild({keys.begin() + done, keys.end()});
+            throw;
+        }
+    }
+
+    // "p50", "p99.9": the response key for a quantile.
+    std::string quantileLabel(double q) {
+        std::ostringstream label;
+        label << 'p' << std::setprecision(6) << q * 100;
+        return label.str();
+    }
+
+    // Records a sale in one statement: locks the vehicle, inserts the sale
+    // only if the vehicle is still Available and the customer exists, marks
+    // the vehicle Sold, adds the sale to its daily rollup (the same increment
+    // applySaleToRollup makes) and returns the invoice columns. The sale keeps
+    // a copy of the vehicle's make, model and market price, which is what
+    // the rollup and every later report count it with. The single
+    // result row always carries the vehicle's status before the sale (NULL if
+    // unknown) and whether the customer exists; the sale columns are NULL when
+    // nothing was inserted. A concurrent sale of the same vehicle waits on the
+    // row lock and then sees it Sold.
+    const char* CREATE_SALE_SQL = R"(
+        WITH vehicle AS (
+            SELECT id, status, make, model, market_price FROM Vehicles WHERE id = $1::uuid FOR UPDATE
+        ),
+        customer AS (
+            SELECT id FROM Customers WHERE id = $2::uuid
+        ),
+        sale AS (
+            INSERT INTO Sales (id, vehicle_id, customer_id, date, sale_price, make, model, market_price)
+            SELECT $5::uuid, vehicle.id, customer.id, $3::date, $4::numeric,
+                   vehicle.make, vehicle.model, vehicle.market_price
+            FROM vehicle, customer
+            WHERE vehicle.status = 'Available'
+            RETURNING id, vehicle_id, customer_id, date, sale_price, version, make, model, market_price
+        ),
+        sold AS (
+            UPDATE Vehicles v SET status = 'Sold', version = v.version + 1
+            FROM sale
+            WHERE v.id = sale.vehicle_id
+            RETURNING v.id, v.vin, v.make, v.model, v.year, v.odometer, v.fuel_type,
+                      v.transmission, v.trim, v.market_price, v.status
+        ),
+        buyer AS (
+            UPDATE Customers c SET version = c.version + 1
+            FROM sale
+            WHERE c.id = sale.customer_id
+        ),
+        rollup AS (
+            INSERT INTO Sales_Daily_Rollup AS r
+                (day, make, model, sales_count, revenue, market_value, profit, min_sale_price, max_sale_price)
+            SELECT sale.date, sale.make, sale.model, 1, sale.sale_price, sale.market_price,
+                   sale.sale_price - sale.market_price, sale.sale_price, sale.sale_price
+            FROM sale
+            ON CONFLICT (day, make, model) DO UPDATE SET
+                sales_count = r.sales_count + 1,
+                revenue = r.revenue + EXCLUDED.revenue,
+                market_value = r.market_value + EXCLUDED.market_value,
+                profit = r.profit + EXCLUDED.profit,
+                min_sale_price = LEAST(r.min_sale_price, EXCLUDED.min_sale_price),
+                max_sale_price = GREATEST(r.max_sale_price, EXCLUDED.max_sale_price)
+        )
+        SELECT (SELECT status FROM vehicle) AS prior_status,
+               EXISTS (SELECT 1 FROM customer) AS customer_exists,
+               sale.id AS sale_id, sale.date AS sale_date, sale.sale_price, sale.version,
+               sold.id AS vehicle_id, sold.vin, sold.make, sold.model, sold.year, sold.odometer,
+               sold.fuel_type, sold.transmission, sold.trim, sold.market_price, sold.status,
+               c.id AS customer_id, c.first_name, c.last_name, c.email, c.ph_number,
+               c.address, c.driving_licence
+        FROM (SELECT 1) one
+        LEFT JOIN sale ON true
+        LEFT JOIN sold ON sold.id = sale.vehicle_id
+        LEFT JOIN Customers c ON c.id = sale.customer_id
+    )";
+
+    // JSON error for a failed statement, with the status its SQLSTATE maps to.
+    crow::response sqlErrorResponse(const pqxx::sql_error& e) {
+        const SqlErrorStatus mapped = classifySqlState(e.sqlstate());
+        crow::json::wvalue error;
+        error["error"] = mapped.error;
+        error["message"] = e.what();
+        crow::response res(mapped.status, error);
+        if (mapped.status == 503) res.set_header("Retry-After", "1");
+        return res;
+    }
+
+    // Page size limits for the sales lists.
+    constexpr int SALES_PAGE_DEFAULT = 50;
+    constexpr int SALES_PAGE_MAX = 500;
+
+    // Lines accepted by one POST /sales/batch request.
+    constexpr size_t MAX_BATCH_LINES = 100000;
+
+    // Which sales a list route is restricted to before any query filter.
+    enum class SalesScope { All, Vehicle, Customer };
+
+    // Parsed query of GET /sales, /sales/vehicles/<id> and /sales/customers/<id>.
+    // The cursor is the (date, id) of the last row of the previous page; rows
+    // are ordered by date, then id, both descending, so the next page starts
+    // strictly below it and costs the same as the first.
+    struct SalesPageQuery {
+        std::optional<std::string> from, to, make;
+        std::optional<std::string> minPrice, maxPrice;
+        std::optional<std::string> afterDate, afterId;
+        int limit = SALES_PAGE_DEFAULT;
+        std::string count;  // "", "estimate" or "exact"
+    };
+
+    std::string encodeSalesCursor(const std::string& date, const std::string& id) {
+        const std::string raw = date + "|" + id;
+        std::string cursor = crow::utility::base64encode_urlsafe(raw, raw.size());
+        while (!cursor.empty() && cursor.back() == '=') cursor.pop_back();
+        return cursor;
+    }
+
+    // True when `id` has the 8-4-4-4-12 hex layout Postgres accepts as a uuid.
+    bool isUuidText(const std::string& id) {
+        if (id.size() != 36) return false;
+        for (size_t i = 0; i < id.size(); ++i) {
+            const bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+            if (dash ? id[i] != '-' : !std::isxdigit(static_cast<unsigned char>(id[i]))) return false;
+        }
+        return true;
+    }
+
+    bool decodeSalesCursor(const std::string& cursor, std::string& date, std::string& id) {
+        // "YYYY-MM-DD|" plus a 36-character UUID is 47 bytes, 63 unpadded characters.
+        if (cursor.size() != 63) return false;
+        for (char c : cursor) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') return false;
+        }
+        const std::string raw = crow::utility::base64decode(cursor, cursor.size());
+        if (raw.size() != 47 || raw[10] != '|') return false;
+        date = raw.substr(0, 10);
+        id = raw.substr(11);
+        return isValidDate(date) && isUuidText(id);
+    }
+
+    // Validates a non-negative decimal price parameter.
+    bool isPriceParam(const char* text) {
+        char* end = nullptr;
+        const double value = std::strtod(text, &end);
+        return end != text && *end == '\0' && std::isfinite(value) && value >= 0;
+    }
+
+    // Fills `q` from the query string; returns an error message on bad input.
+    std::optional<std::string> parseSalesPageQuery(const crow::request& req, SalesPageQuery& q) {
+        const auto& params = req.url_params;
+        if (const char* from = params.get("from")) {
+            if (!isValidDate(from)) return "from must be a date (YYYY-MM-DD)";
+            q.from = from;
+        }
+        if (const char* to = params.get("to")) {
+            if (!isValidDate(to)) return "to must be a date (YYYY-MM-DD)";
+            q.to = to;
+        }
+        if (const char* make = params.get("make")) {
+            if (*make == '\0') return "make must not be empty";
+            q.make = make;
+        }
+        if (const char* minPrice = params.get("min_price")) {
+            if (!isPriceParam(minPrice)) return "min_price must be a non-negative number";
+            q.minPrice = minPrice;
+        }
+        if (const char* maxPrice = params.get("max_price")) {
+            if (!isPriceParam(maxPrice)) return "max_price must be a non-negative number";
+            q.maxPrice = maxPrice;
+        }
+        if (const char* limit = params.get("limit")) {
+            char* end = nullptr;
+            const long value = std::strtol(limit, &end, 10);
+            if (end == limit || *end != '\0' || value < 1 || value > SALES_PAGE_MAX) {
+                return "limit must be between 1 and " + std::to_string(SALES_PAGE_MAX);
+            }
+            q.limit = static_cast<int>(value);
+        }
+        if (const char* cursor = params.get("cursor")) {
+            std::string date, id;
+            if (!decodeSalesCursor(cursor, date, id)) return "Invalid cursor";
+            q.afterDate = date;
+            q.afterId = id;
+        }
+        if (const char* count = params.get("count")) {
+            q.count = count;
+            if (q.count != "estimate" && q.count != "exact") return "count must be 'estimate' or 'exact'";
+        }
+        return std::nullopt;
+    }
+
+    // Bit i is set when optional filter i is present; every combination maps to
+    // one prepared statement per scope.
+    unsigned salesPageMask(const SalesPageQuery& q) {
+        return (q.from ? 1u : 0u) | (q.to ? 2u : 0u) | (q.make ? 4u : 0u) |
+               (q.minPrice ? 8u : 0u) | (q.maxPrice ? 16u : 0u) | (q.afterDate ? 32u : 0u);
+    }
+
+    // FROM/WHERE shared by the page, count and estimate queries. `bind` turns a
+    // value into SQL: a numbered placeholder for prepared statements, or a
+    // quoted literal for EXPLAIN. The cursor bound is left out of counts.
+    std::string salesPageFilter(const SalesPageQuery& q, SalesScope scope, const std::string& scopeId,
+                                bool withCursor, const std::function<std::string(const std::string&)>& bind) {
+        std::string sql =
+            " FROM Sales s "
+            "JOIN Vehicles v ON s.vehicle_id = v.id "
+            "JOIN Customers c ON s.customer_id = c.id "
+            "WHERE TRUE";
+        if (scope == SalesScope::Vehicle) sql += " AND s.vehicle_id = " + bind(scopeId) + "::uuid";
+        if (scope == SalesScope::Customer) sql += " AND s.customer_id = " + bind(scopeId) + "::uuid";
+        if (q.from) sql += " AND s.date >= " + bind(*q.from) + "::date";
+        if (q.to) sql += " AND s.date <= " + bind(*q.to) + "::date";
+        if (q.make) sql += " AND s.make = " + bind(*q.make);
+        if (q.minPrice) sql += " AND s.sale_price >= " + bind(*q.minPrice) + "::numeric";
+        if (q.maxPrice) sql += " AND s.sale_price <= " + bind(*q.maxPrice) + "::numeric";
+        if (withCursor && q.afterDate) {
+            sql += " AND (s.date, s.id) < (" + bind(*q.afterDate) + "::date, " + bind(*q.afterId) + "::uuid)";
+        }
+        return sql;
+    }
+
+    // Runs one page of a sales list and renders it as the JSON array the route
+    // has always returned. Paging state travels in headers: X-Next-Cursor
+    // while more rows follow, and X-Total-Count (count=exact) or
+    // X-Estimated-Total-Count (count=estimate, the planner's row estimate).
+    crow::response salesPage(const crow::request& req, SalesScope scope, const std::string& scopeId) {
+        SalesPageQuery q;
+        if (auto message = parseSalesPageQuery(req, q)) {
+            crow::json::wvalue error;
+            error["error"] = *message;
+            return crow::response(400, error);
+        }
+        if (scope != SalesScope::All && !isUuidText(scopeId)) {
+            crow::json::wvalue error;
+            error["error"] = "Invalid UUID format";
+            return crow::response(400, error);
+        }
 
-    tm.tm_isdst = -1;
-    std::time_t t = std::mktime(&tm);
-    if (t == -1) return false;
+        static const char* SCOPE_NAMES[] = {"all", "vehicle", "customer"};
+        const std::string scopeName = SCOPE_NAMES[static_cast<int>(scope)];
 
-    std::tm check = *std::gmtime(&t);
+        std::vector<std::optional<std::string>> params;
+        auto placeholder = [&params](const std::string& value) {
+            params.emplace_back(value);
+            return "$" + std::to_string(params.size());
+        };
+        std::string sql =
+            "SELECT s.id AS sale_id, s.date, s.sale_price, "
+            "v.id AS vehicle_id, s.make, s.model, "
+            "c.id AS customer_id, c.first_name, c.last_name" +
+            salesPageFilter(q, scope, scopeId, true, placeholder) +
+            " ORDER BY s.date DESC, s.id DESC LIMIT " + placeholder(std::to_string(q.limit + 1)) + "::int";
 
-    return check.tm_year == tm.tm_year &&
-           check.tm_mon  == tm.tm_mon &&
-           check.tm_mday == tm.tm_mday;
-}
-/// @brief Converts a date string in YYYY-MM-DD format to std::time_t.
-/// @param date The date string to convert.
-/// @return The corresponding std::time_t value.
-std::time_t toTimeT(const std::string& date) {
-    std::tm tm = {};
-    std::istringstream ss(date);
-    ss >> std::get_time(&tm, "%Y-%m-%d");
-    tm.tm_isdst = -1;
-    return std::mktime(&tm);
-}
-/// @brief Converts a std::time_t value to a date string in YYYY-MM-DD format.
-/// @param t The std::time_t value to convert.
-/// @return The formatted date string.
-std::string toDateString(std::time_t t) {
-    std::tm tm = *std::gmtime(&t);
-    char buf[11];
-    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
-    return std::string(buf);
+        ConnectionGuard guard(getPool());
+        const std::string statement = "sales_page_" + scopeName + "_" + std::to_string(salesPageMask(q));
+        guard.prepare(statement, sql);
+        pqxx::read_transaction txn(guard.get());
+        pqxx::result r = txn.exec_prepared(statement, pqxx::prepare::make_dynamic_params(params));
+
+        std::optional<long long> total;
+        if (q.count == "exact") {
+            params.clear();
+            const std::string countSql = "SELECT count(*)" + salesPageFilter(q, scope, scopeId, false, placeholder);
+            const std::string countStatement = "sales_count_" + scopeName + "_" + std::to_string(salesPageMask(q) & 31u);
+            guard.prepare(countStatement, countSql);
+            total = txn.exec_prepared(countStatement, pqxx::prepare::make_dynamic_params(params))[0][0].as<long long>();
+        } else if (q.count == "estimate") {
+            auto literal = [&txn](const std::string& value) { return txn.quote(value); };
+            pqxx::result plan = txn.exec("EXPLAIN (FORMAT JSON) SELECT 1" +
+                                         salesPageFilter(q, scope, scopeId, false, literal));
+            auto parsed = crow::json::load(plan[0][0].c_str());
+            if (parsed && parsed.t() == crow::json::type::List && parsed.size() > 0) {
+                total = static_cast<long long>(parsed[0]["Plan"]["Plan Rows"].d());
+            }
+        }
+        txn.commit();
+
+        const bool includeIds = scope != SalesScope::All;
+        const size_t shown = std::min<size_t>(r.size(), static_cast<size_t>(q.limit));
+        crow::json::wvalue result = crow::json::wvalue::list();
+        for (size_t i = 0; i < shown; ++i) {
+            const auto& row = r[i];
+            result[i]["sale_id"] = row["sale_id"].c_str();
+            result[i]["date"] = row["date"].c_str();
+            result[i]["price"] = row["sale_price"].as<double>();
+            if (includeIds) result[i]["vehicle_id"] = row["vehicle_id"].c_str();
+            result[i]["vehicle"] = std::string(row["make"].c_str()) + " " + row["model"].c_str();
+            if (includeIds) result[i]["customer_id"] = row["customer_id"].c_str();
+            result[i]["customer"] = std::string(row["first_name"].c_str()) + " " + row["last_name"].c_str();
+        }
+
+        crow::response res(200, result);
+        if (r.size() > shown) {
+            const auto& last = r[shown - 1];
+            res.set_header("X-Next-Cursor", encodeSalesCursor(last["date"].c_str(), last["sale_id"].c_str()));
+        }
+        if (total) {
+            res.set_header(q.count == "exact" ? "X-Total-Count" : "X-Estimated-Total-Count",
+                           std::to_string(*total));
+        }
+        return res;
+    }
 }
+
 /// @brief Registers all sales-related HTTP routes to the Crow application.
 /// @param app The Crow application instance to register routes on.
 void registerSalesRoutes(crow::SimpleApp& app) {
@@ -53,42 +503,22 @@ void registerSalesRoutes(crow::SimpleApp& app) {
     //------------------------------------------------------------------
     // GET /sales
     //------------------------------------------------------------------
-    /// @brief Retrieves a list of all sales.
+    /// @brief Retrieves one page of sales, newest first.
     /// @route GET /sales
+    /// Query: from, to, make, min_price, max_price, limit (default 50, max 500),
+    /// cursor (from the previous page's X-Next-Cursor) and count=estimate|exact.
     CROW_ROUTE(app, "/sales")
     .methods("GET"_method)
-    ([]() {
-
-        ConnectionGuard guard(getPool());
-        pqxx::work txn(guard.get());
-
-        pqxx::result r = txn.exec(
-            "SELECT s.id AS sale_id, s.date, s.sale_price, "
-            "v.make, v.model, "
-            "c.first_name, c.last_name "
-            "FROM Sales s "
-            "JOIN Vehicles v ON s.vehicle_id = v.id "
-            "JOIN Customers c ON s.customer_id = c.id "
-            "ORDER BY s.date DESC"
-        );
-
-        crow::json::wvalue result = crow::json::wvalue::list();
-        int i = 0;
-
-        for (const auto& row : r) {
-            result[i]["sale_id"] = row["sale_id"].c_str();
-            result[i]["date"] = row["date"].c_str();
-            result[i]["price"] = row["sale_price"].as<double>();
-            result[i]["vehicle"] =
-                std::string(row["make"].c_str()) + " " +
-                row["model"].c_str();
-            result[i]["customer"] =
-                std::string(row["first_name"].c_str()) + " " +
-                row["last_name"].c_str();
-            ++i;
+    ([](const crow::request& req) {
+        try {
+            return salesPage(req, SalesScope::All, "");
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Error in GET /sales: " << e.what();
+            crow::json::wvalue error;
+            error["error"] = "Database error";
+            error["message"] = e.what();
+            return crow::response(500, error);
         }
-
-        return result;
     });
 
     //------------------------------------------------------------------
@@ -116,85 +546,86 @@ void registerSalesRoutes(crow::SimpleApp& app) {
             std::string endDate   = endParam;
 
             // Validate date format + calendar validity
-            if (!isValidDate(startDate) || !isValidDate(endDate)) {
+            const auto start = parseDate(startDate);
+            const auto end = parseDate(endDate);
+            if (!start || !end) {
                 return crow::response(
                     400,
                     "Invalid date format or invalid calendar date (YYYY-MM-DD)"
                 );
             }
 
-            std::time_t startTime = toTimeT(startDate);
-            std::time_t endTime   = toTimeT(endDate);
+            const int startDay = daysFromCivil(*start);
+            const int endDay   = daysFromCivil(*end);
 
             // Logical validation
-            if (startTime >= endTime) {
+            if (startDay >= endDay) {
                 return crow::response(400, "start date must be before end date");
             }
 
             // Safety limit (10 years max)
             const int MAX_WEEKS = 520;
-            int weekCounter = 0;
+            const long weeks = (endDay - startDay + 6) / 7;
+            if (weeks > MAX_WEEKS) {
+                return crow::response(400, "Date range too large");
+            }
 
+            // Every week is folded from the daily rollups in one grouped query,
+            // so the cost depends on the range, not on the size of the history.
             ConnectionGuard guard(getPool());
             pqxx::work txn(guard.get());
 
+            pqxx::result r = txn.exec_params(
+                R"(
+                    SELECT
+                        (day - $1::date) / 7 AS week,
+                        SUM(sales_count) AS total_sales_count,
+                        SUM(revenue) AS total_revenue,
+                        MIN(min_sale_price) AS min_sale_price,
+                        MAX(max_sale_price) AS max_sale_price,
+                        SUM(market_value) AS total_market_value,
+                        SUM(profit) AS total_profit
+                    FROM Sales_Daily_Rollup
+                    WHERE day >= $1::date AND day < $1::date + $2::int
+                    GROUP BY 1
+                    ORDER BY 1
+                )",
+                startDate,
+                weeks * 7
+            );
+
+            txn.commit();
+
             std::ostringstream csv;
             csv << "week_start,week_end,total_sales_count,total_revenue,"
                 << "avg_sale_price,min_sale_price,max_sale_price,"
                 << "total_market_value,total_profit,avg_profit_per_sale\n";
 
-            std::time_t currentWeekStart = startTime;
-
-            while (currentWeekStart < endTime) {
-
-                if (++weekCounter > MAX_WEEKS) {
-                    return crow::response(400, "Date range too large");
+            auto row = r.begin();
+            for (long week = 0; week < weeks; ++week) {
+                const int weekStartDay = startDay + static_cast<int>(week) * 7;
+
+                csv << toDateString(weekStartDay) << ","
+                    << toDateString(weekStartDay + 6) << ",";
+
+                if (row != r.end() && row["week"].as<long>() == week) {
+                    int count = row["total_sales_count"].as<int>();
+                    double revenue = row["total_revenue"].as<double>();
+                    double profit = row["total_profit"].as<double>();
+                    csv << count << ","
+                        << revenue << ","
+                        << revenue / count << ","
+                        << row["min_sale_price"].as<double>() << ","
+                        << row["max_sale_price"].as<double>() << ","
+                        << row["total_market_value"].as<double>() << ","
+                        << profit << ","
+                        << profit / count << "\n";
+                    ++row;
+                } else {
+                    csv << "0,0,0,0,0,0,0,0\n";
                 }
-
-                std::time_t currentWeekEnd =
-                    currentWeekStart + 7 * 24 * 60 * 60;
-
-                std::string weekStartStr = toDateString(currentWeekStart);
-                std::string weekEndStr   = toDateString(currentWeekEnd);
-
-                pqxx::result r = txn.exec_params(
-                    R"(
-                        SELECT
-                            COUNT(*) AS total_sales_count,
-                            COALESCE(SUM(s.sale_price), 0) AS total_revenue,
-                            COALESCE(AVG(s.sale_price), 0) AS avg_sale_price,
-                            COALESCE(MIN(s.sale_price), 0) AS min_sale_price,
-                            COALESCE(MAX(s.sale_price), 0) AS max_sale_price,
-                            COALESCE(SUM(v.market_price), 0) AS total_market_value,
-                            COALESCE(SUM(s.sale_price - v.market_price), 0) AS total_profit,
-                            COALESCE(AVG(s.sale_price - v.market_price), 0) AS avg_profit_per_sale
-                        FROM Sales s
-                        JOIN Vehicles v ON s.vehicle_id = v.id
-                        WHERE s.date >= $1 AND s.date < $2
-                    )",
-                    weekStartStr,
-                    weekEndStr
-                );
-
-                const auto& row = r[0];
-
-                csv
-                    << weekStartStr << ","
-                    << toDateString(currentWeekStart + 6 * 24 * 60 * 60) << ","
-                    << row["total_sales_count"].as<int>() << ","
-                    << row["total_revenue"].as<double>() << ","
-                    << row["avg_sale_price"].as<double>() << ","
-                    << row["min_sale_price"].as<double>() << ","
-                    << row["max_sale_price"].as<double>() << ","
-                    << row["total_market_value"].as<double>() << ","
-                    << row["total_profit"].as<double>() << ","
-                    << row["avg_profit_per_sale"].as<double>() << "\n";
-
-                currentWeekStart = currentWeekEnd;
             }
 
-            txn.commit();
-
             crow::response res;
             res.code = 200;
             res.set_header("Content-Type", "text/csv");
@@ -211,85 +642,193 @@ void registerSalesRoutes(crow::SimpleApp& app) {
     });
 
     //------------------------------------------------------------------
-    // GET /sales/export/csv - Export all sales to CSV
+    // GET /sales/distribution
     //------------------------------------------------------------------
-     /// @brief Exports all sales data to a CSV file.
+    /// @brief Sale-price and profit quantiles for a make/model over a period.
+    ///
+    /// Served from per (make, model, month) t-digests merged at query time;
+    /// see sales_distribution.h for how they are kept current and
+    /// utils/tdigest.h for accuracy and memory bounds.
+    /// @route GET /sales/distribution
+    /// @param make Optional make; all makes when omitted.
+    /// @param model Optional model; all models when omitted.
+    /// @param from Optional first month (YYYY-MM or YYYY-MM-DD, inclusive).
+    /// @param to Optional last month (YYYY-MM or YYYY-MM-DD, inclusive).
+    /// @param quantiles Optional comma-separated quantiles in [0, 1]; default 0.1,0.5,0.9.
+    CROW_ROUTE(app, "/sales/distribution")
+    .methods("GET"_method)
+    ([](const crow::request& req) {
+        std::string make = req.url_params.get("make") ? req.url_params.get("make") : "";
+        std::string model = req.url_params.get("model") ? req.url_params.get("model") : "";
+
+        int fromMonth = INT_MIN, toMonth = INT_MAX;
+        const char* fromParam = req.url_params.get("from");
+        const char* toParam = req.url_params.get("to");
+        if ((fromParam && !SalesDistributionStore::monthNumber(fromParam, fromMonth)) ||
+            (toParam && !SalesDistributionStore::monthNumber(toParam, toMonth))) {
+            return crow::response(400, "Invalid month. Use YYYY-MM");
+        }
+        if (fromMonth > toMonth) {
+            return crow::response(400, "from must not be after to");
+        }
+
+        std::vector<double> quantiles = {0.1, 0.5, 0.9};
+        if (const char* qParam = req.url_params.get("quantiles")) {
+            quantiles.clear();
+            std::istringstream list(qParam);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                char* end = nullptr;
+                double q = std::strtod(item.c_str(), &end);
+                if (item.empty() || *end != '\0' || !(q >= 0.0 && q <= 1.0)) {
+                    return crow::response(400, "quantiles must be numbers between 0 and 1");
+                }
+                quantiles.push_back(q);
+            }
+            if (quantiles.empty() || quantiles.size() > 20) {
+                return crow::response(400, "Provide between 1 and 20 quantiles");
+            }
+        }
+
+        try {
+            ensureDistributionLoaded();
+            rebuildDirtyBuckets(make, model, fromMonth, toMonth);
+            SalesDistributionStore::Summary summary = salesDistribution().merged(make, model, fromMonth, toMonth);
+
+            auto describe = [&](const TDigest& digest) {
+                crow::json::wvalue out;
+                for (double q : quantiles) out[quantileLabel(q)] = digest.quantile(q);
+                out["min"] = digest.min();
+                out["max"] = digest.max();
+                return out;
+            };
+
+            crow::json::wvalue result;
+            result["make"] = make;
+            result["model"] = model;
+            result["from"] = fromParam ? fromParam : "";
+            result["to"] = toParam ? toParam : "";
+            result["count"] = static_cast<int64_t>(summary.salePrice.count());
+            result["buckets"] = summary.buckets;
+            if (summary.salePrice.count() > 0) {
+                result["sale_price"] = describe(summary.salePrice);
+                result["profit"] = describe(summary.profit);
+            }
+            return crow::response(200, result);
+
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Error in GET /sales/distribution: " << e.what();
+            crow::json::wvalue error;
+            error["error"] = "Internal server error";
+            return crow::response(500, error);
+        }
+    });
+
+    //------------------------------------------------------------------
+    // GET /sales/export/csv - Export sales to CSV
+    //------------------------------------------------------------------
+    /// @brief Exports sales data to a CSV file.
+    ///
+    /// Rows are pulled through a server-side cursor in fixed-size batches and
+    /// written straight to a spool file, which Crow then sends from disk in
+    /// chunks. Memory use stays flat regardless of how much history is exported.
     /// @route GET /sales/export/csv
+    /// @param from Optional first sale date (YYYY-MM-DD, inclusive).
+    /// @param to Optional last sale date (YYYY-MM-DD, inclusive).
+    /// @param columns Optional comma-separated column keys, e.g. "date,vin,sale_price".
     CROW_ROUTE(app, "/sales/export/csv")
     .methods("GET"_method)
-    ([]() {
+    ([](const crow::request& req) {
+        const char* fromParam = req.url_params.get("from");
+        const char* toParam = req.url_params.get("to");
+        if ((fromParam && !isValidDate(fromParam)) || (toParam && !isValidDate(toParam))) {
+            return crow::response(400, "Invalid date format. Use YYYY-MM-DD");
+        }
+        if (fromParam && toParam && std::string(fromParam) > std::string(toParam)) {
+            return crow::response(400, "from must not be after to");
+        }
+
+        std::vector<const ExportColumn*> columns;
+        std::string badColumn;
+        if (!resolveExportColumns(req.url_params.get("columns"), columns, badColumn)) {
+            return crow::response(400, "Unknown export column: " + badColumn);
+        }
+
+        std::filesystem::path path;
         try {
-            ConnectionGuard guard(getPool());
-            pqxx::work txn(guard.get());
+            std::filesystem::path dir = exportDir();
+            std::filesystem::create_directories(dir);
+            sweepOldExports(dir);
+            path = dir / ("sales_export_" + newUuidV7() + ".csv");
+
+            std::unique_ptr<std::FILE, int (*)(std::FILE*)> out(std::fopen(path.c_str(), "wb"), &std::fclose);
+            if (!out) {
+                throw std::runtime_error("cannot create " + path.string());
+            }
 
-            pqxx::result r = txn.exec(
-                "SELECT "
-                "s.id AS sale_id, "
-                "s.date, "
-                "s.sale_price, "
-                "v.id AS vehicle_id, "
-                "v.vin, "
-                "v.make, "
-                "v.model, "
-                "v.year, "
-                "v.trim, "
-                "v.odometer, "
-                "v.fuel_type, "
-                "v.transmission, "
-                "v.market_price, "
-                "c.id AS customer_id, "
-                "c.first_name, "
-                "c.last_name, "
-                "c.email, "
-                "c.ph_number, "
-                // Calculate profit
-                "(s.sale_price - v.market_price) AS profit, "
-                "ROUND(((s.sale_price - v.market_price) / v.market_price * 100), 2) AS profit_percentage "
-                "FROM Sales s "
-                "JOIN Vehicles v ON s.vehicle_id = v.id "
-                "JOIN Customers c ON s.customer_id = c.id "
-                "ORDER BY s.date DESC"
-            );
+            std::string line;
+            line.reserve(1 << 16);
+            for (size_t i = 0; i < columns.size(); ++i) {
+                if (i) line.push_back(',');
+                line += columns[i]->header;
+            }
+            line.push_back('\n');
+
+            {
+                ConnectionGuard guard(getPool());
+                pqxx::work txn(guard.get());
+
+                std::string sql = "SELECT ";
+                for (size_t i = 0; i < columns.size(); ++i) {
+                    if (i) sql += ", ";
+                    sql += columns[i]->expr;
+                }
+                sql += " FROM Sales s "
+                       "JOIN Vehicles v ON s.vehicle_id = v.id "
+                       "JOIN Customers c ON s.customer_id = c.id "
+                       "WHERE TRUE";
+                if (fromParam) sql += " AND s.date >= " + txn.quote(fromParam);
+                if (toParam) sql += " AND s.date <= " + txn.quote(toParam);
+                sql += " ORDER BY s.date DESC, s.id DESC";
+
+                pqxx::icursorstream cursor(txn, sql, "sales_export", EXPORT_BATCH_ROWS);
+                pqxx::result batch;
+                while (cursor >> batch) {
+                    for (const auto& row : batch) {
+                        for (size_t i = 0; i < columns.size(); ++i) {
+                            if (i) line.push_back(',');
+                            if (!row[i].is_null()) appendCsvField(line, row[i].c_str(), row[i].size());
+                        }
+                        line.push_back('\n');
+                    }
+                    if (std::fwrite(line.data(), 1, line.size(), out.get()) != line.size()) {
+                        throw std::runtime_error("short write to " + path.string());
+                    }
+                    line.clear();
+                }
+                txn.commit();
+            }
 
-            // Build CSV content
-            std::stringstream csv;
-
-            // CSV Header
-            csv << "Date,Sale Price,Market Price,Profit compare to MRP,Profit %,"
-                << "VIN,Make,Model,Year,Trim,Odometer,Fuel Type,Transmission,"
-                << "First Name,Last Name,Email,Phone\n";
-
-            // CSV Rows
-            for (const auto& row : r) {
-                csv << row["date"].c_str() << ","
-                    << row["sale_price"].as<double>() << ","
-                    << row["market_price"].as<double>() << ","
-                    << row["profit"].as<double>() << ","
-                    << row["profit_percentage"].as<double>() << ","
-                    << row["vin"].c_str() << ","
-                    << row["make"].c_str() << ","
-                    << row["model"].c_str() << ","
-                    << row["year"].c_str() << ","
-                    << (row["trim"].is_null() ? "" : row["trim"].c_str()) << ","
-                    << row["odometer"].as<int>() << ","
-                    << row["fuel_type"].c_str() << ","
-                    << row["transmission"].c_str() << ","
-                    << row["first_name"].c_str() << ","
-                    << row["last_name"].c_str() << ","
-                    << row["email"].c_str() << ","
-                    << row["ph_number"].c_str() << "\n";
-            }
-
-            // Create response with proper headers
-            crow::response res(csv.str());
+            if (!line.empty() && std::fwrite(line.data(), 1, line.size(), out.get()) != line.size()) {
+                throw std::runtime_error("short write to " + path.string());
+            }
+            if (std::fclose(out.release()) != 0) {
+                throw std::runtime_error("cannot close " + path.string());
+            }
+
+            crow::response res;
+            res.set_static_file_info_unsafe(path.string());
             res.set_header("Content-Type", "text/csv");
             res.set_header("Content-Disposition", "attachment; filename=sales_export.csv");
-            
             return res;
 
         } catch (const std::exception& e) {
             CROW_LOG_ERROR << "Error in CSV export: " << e.what();
-            
+            if (!path.empty()) {
+                std::error_code ec;
+                std::filesystem::remove(path, ec);
+            }
+
             crow::json::wvalue error;
             error["error"] = "Export failed";
             error["message"] = e.what();
@@ -302,11 +841,13 @@ void registerSalesRoutes(crow::SimpleApp& app) {
     // GET /sales/<id> - Get invoice for a sale
     //------------------------------------------------------------------
      /// @brief Retrieves the invoice for a specific sale by ID.
+    /// Served as pre-rendered JSON from the invoice cache with a strong ETag;
+    /// a matching If-None-Match gets a 304.
     /// @route GET /sales/id/<id>
     /// @param id The sale ID (UUID).
     CROW_ROUTE(app, "/sales/id/<string>")
     .methods("GET"_method)
-    ([](const std::string& id) {
+    ([](const crow::request& req, const std::string& id) {
         try {
             // Validate UUID format
             if (id.length() != 36) {
@@ -315,180 +856,34 @@ void registerSalesRoutes(crow::SimpleApp& app) {
                 return crow::response(400, error);
             }
 
-            ConnectionGuard guard(getPool());
-            pqxx::work txn(guard.get());
+            std::shared_ptr<const RenderedInvoice> invoice = invoiceCache().get(id);
+            if (!invoice) {
+                const uint64_t epoch = invoiceCache().epoch();
+                std::optional<RenderedInvoice> loaded;
+                {
+                    ConnectionGuard guard(getPool());
+                    prepareInvoice(guard);
+                    pqxx::read_transaction txn(guard.get());
+                    loaded = loadInvoice(txn, id);
+                }
+                if (!loaded) {
+                    crow::json::wvalue error;
+                    error["error"] = "Sale not found";
+                    return crow::response(404, error);
+                }
+                invoice = std::make_shared<const RenderedInvoice>(std::move(*loaded));
+                invoiceCache().put(invoice, epoch);
+            }
 
-            pqxx::result r = txn.exec_params(
-                "SELECT "
-                "  s.id AS sale_id, "
-                "  s.date AS sale_date, "
-                "  s.sale_price, "
-                "  v.id AS vehicle_id, "
-                "  v.make, "
-                "  v.model, "
-                "  v.year, "
-                "  v.vin, "
-                "  v.odometer, "
-                "  v.fuel_type, "
-                "  v.transmission, "
-                "  v.trim, "
-                "  v.market_price, "
-                "  v.status, "
-                "  c.id AS customer_id, "
-                "  c.first_name, "
-                "  c.last_name, "
-                "  c.email, "
-                "  c.ph_number, "
-                "  c.address, "
-                "  c.driving_licence "
-                "FROM Sales s "
-                "JOIN Vehicles v ON s.vehicle_id = v.id "
-                "JOIN Customers c ON s.customer_id = c.id "
-                "WHERE s.id = $1",
-                id
-            );
+            if (ifNoneMatchHits(req, invoice->etag)) {
+                return notModified(invoice->etag);
+            }
 
-            if (r.empty()) {
-                crow::json::wvalue error;
-                error["error"] = "Sale not found";
-                return crow::response(404, error);
-            }
-
-            auto row = r[0];
-
-            // ========================================
-            // BUILDING STRINGS FIRST 
-            // ========================================
-            
-            std::string customer_name = std::string(row["first_name"].c_str()) + " " + 
-                                    row["last_name"].c_str();
-            
-            std::string vehicle_description = std::string(row["year"].c_str()) + " " +
-                                            row["make"].c_str() + " " +
-                                            row["model"].c_str();
-            
-            // Add trim if exists
-            if (!row["trim"].is_null()) {
-                vehicle_description += " " + std::string(row["trim"].c_str());
-            }
-
-            // ========================================
-            // CALCULATIONS
-            // ========================================
-            
-            double base_price = row["sale_price"].as<double>();
-            double sales_tax_rate = 0.13;
-            double sales_tax = base_price * sales_tax_rate;
-            double documentation_fee = 500.00;
-            double registration_fee = 120.00;
-            double delivery_fee = 0.00;
-            
-            double subtotal = base_price;
-            double total_fees = documentation_fee + registration_fee + delivery_fee;
-            double total_before_tax = subtotal + total_fees;
-            double total_amount = total_before_tax + sales_tax;
-
-
-            // Profit analysis is just for backend crunching - not shown to customers
-            double market_price = row["market_price"].as<double>();
-            double profit = base_price - market_price;
-            double profit_percentage = (profit / market_price) * 100;
-
-            // ========================================
-            // BUILD JSON RESPONSE
-            // ========================================
-            
-            crow::json::wvalue invoice;
-
-            // Invoice metadata
-            invoice["invoice_number"] = row["sale_id"].c_str();
-            invoice["invoice_date"] = row["sale_date"].c_str();
-            invoice["invoice_type"] = "Vehicle Sale";
-
-            // Customer information
-            invoice["customer"]["customer_id"] = row["customer_id"].c_str();
-            invoice["customer"]["name"] = customer_name;  // Use the string variable
-            invoice["customer"]["email"] = row["email"].c_str();
-            invoice["customer"]["phone"] = row["ph_number"].c_str();
-            invoice["customer"]["address"] = row["address"].is_null() ? "" : row["address"].c_str();
-            invoice["customer"]["driving_licence"] = row["driving_licence"].c_str();
-
-            // Vehicle information
-            invoice["vehicle"]["vehicle_id"] = row["vehicle_id"].c_str();
-            invoice["vehicle"]["description"] = vehicle_description;  // ✅ Use the string variable
-            invoice["vehicle"]["vin"] = row["vin"].c_str();
-            invoice["vehicle"]["year"] = row["year"].as<int>();
-            invoice["vehicle"]["make"] = row["make"].c_str();
-            invoice["vehicle"]["model"] = row["model"].c_str();
-            invoice["vehicle"]["trim"] = row["trim"].is_null() ? "" : row["trim"].c_str();
-            invoice["vehicle"]["odometer"] = row["odometer"].as<int>();
-            invoice["vehicle"]["fuel_type"] = row["fuel_type"].c_str();
-            invoice["vehicle"]["transmission"] = row["transmission"].c_str();
-
-            // Line items
-            invoice["line_items"] = crow::json::wvalue::list();
-            
-            invoice["line_items"][0]["description"] = vehicle_description;  // ✅ Use string variable
-            invoice["line_items"][0]["quantity"] = 1;
-            invoice["line_items"][0]["unit_price"] = base_price;
-            invoice["line_items"][0]["amount"] = base_price;
-
-            invoice["line_items"][1]["description"] = "Documentation Fee";
-            invoice["line_items"][1]["quantity"] = 1;
-            invoice["line_items"][1]["unit_price"] = documentation_fee;
-            invoice["line_items"][1]["amount"] = documentation_fee;
-
-            invoice["line_items"][2]["description"] = "Registration Fee";
-            invoice["line_items"][2]["quantity"] = 1;
-            invoice["line_items"][2]["unit_price"] = registration_fee;
-            invoice["line_items"][2]["amount"] = registration_fee;
-
-            // Pricing breakdown
-            invoice["pricing"]["subtotal"] = subtotal;
-            invoice["pricing"]["documentation_fee"] = documentation_fee;
-            invoice["pricing"]["registration_fee"] = registration_fee;
-            invoice["pricing"]["delivery_fee"] = delivery_fee;
-            invoice["pricing"]["total_fees"] = total_fees;
-            invoice["pricing"]["total_before_tax"] = total_before_tax;
-            invoice["pricing"]["sales_tax_rate"] = sales_tax_rate;
-            invoice["pricing"]["sales_tax"] = sales_tax;
-            invoice["pricing"]["total_amount"] = total_amount;
-
-            // Tax breakdown
-            invoice["taxes"] = crow::json::wvalue::list();
-            invoice["taxes"][0]["name"] = "HST (Harmonized Sales Tax)";
-            invoice["taxes"][0]["rate"] = sales_tax_rate;
-            invoice["taxes"][0]["amount"] = sales_tax;
-
-            // Payment information
-            invoice["payment"]["status"] = "Paid";
-            invoice["payment"]["method"] = "Not specified";
-            invoice["payment"]["amount_paid"] = total_amount;
-            invoice["payment"]["balance_due"] = 0.00;
-
-            // Internal analytics
-            invoice["analytics"]["market_price"] = market_price;
-            invoice["analytics"]["profit"] = profit;
-            invoice["analytics"]["profit_percentage"] = std::round(profit_percentage * 100) / 100.0;
-
-            // Dealer information
-            invoice["dealer"]["name"] = "DealerDrive Auto Sales";
-            invoice["dealer"]["address"] = "123 Main Street, Toronto, ON M5V 3A8";
-            invoice["dealer"]["phone"] = "(416) 555-0100";
-            invoice["dealer"]["email"] = "sales@dealerdrive.com";
-            invoice["dealer"]["website"] = "www.dealerdrive.com";
-
-            // Terms and conditions
-            invoice["terms"] = crow::json::wvalue::list();
-            invoice["terms"][0] = "Vehicle sold 'as is' with no warranty";
-            invoice["terms"][1] = "All sales are final";
-            invoice["terms"][2] = "Buyer is responsible for vehicle inspection";
-            invoice["terms"][3] = "Payment due upon signing";
-
-            // Notes
-            invoice["notes"] = "Thank you for your business!";
-
-            return crow::response(200, invoice);
+            crow::response response(200, invoice->body);
+            response.set_header("Content-Type", "application/json");
+            response.set_header("ETag", invoice->etag);
+            response.set_header("Cache-Control", "no-cache");
+            return response;
 
         } catch (const pqxx::sql_error& e) {
             CROW_LOG_ERROR << "SQL Error in GET /sales/" << id << ": " << e.what();
@@ -515,176 +910,292 @@ void registerSalesRoutes(crow::SimpleApp& app) {
     CROW_ROUTE(app, "/sales")
     .methods("POST"_method)
     ([](const crow::request& req) {
+        return withIdempotency(req, "POST /sales", [&req](IdempotentWrite& idempotency) {
 
-        try{
-            // Parse JSON body
-            auto body = crow::json::load(req.body);
-            if (!body){
-                crow::json::wvalue error;
-                error["error"] = "Invalid JSON";
-                error["message"] = "Request body must be valid JSON.";
-                return crow::response(400, error);
-            }
+            try{
+                // Parse JSON body
+                auto body = crow::json::load(req.body);
+                if (!body){
+                    crow::json::wvalue error;
+                    error["error"] = "Invalid JSON";
+                    error["message"] = "Request body must be valid JSON.";
+                    return crow::response(400, error);
+                }
              
-            // Validate required fields
-            if(!body.has("vehicle_id") || !body.has("customer_id") || !body.has("sale_price") || !body.has("date")){
-                crow::json::wvalue error;
-                error["error"] = "Missing fields";
-                error["message"] = "Required fields: vehicle_id, customer_id, sale_price, date.";
-                return crow::response(400, error);
-            }
+                // Validate required fields
+                if(!body.has("vehicle_id") || !body.has("customer_id") || !body.has("sale_price") || !body.has("date")){
+                    crow::json::wvalue error;
+                    error["error"] = "Missing fields";
+                    error["message"] = "Required fields: vehicle_id, customer_id, sale_price, date.";
+                    return crow::response(400, error);
+                }
 
-            // Extract values
-            std::string vehicle_id = body["vehicle_id"].s();
-            std::string customer_id = body["customer_id"].s();
-            double sale_price = body["sale_price"].d();
-            std::string date = body["date"].s();
+                // Extract values
+                std::string vehicle_id = body["vehicle_id"].s();
+                std::string customer_id = body["customer_id"].s();
+                double sale_price = body["sale_price"].d();
+                std::string date = body["date"].s();
 
-             // Validate format 
-            if (vehicle_id.length() != 36 || customer_id.length() != 36) {
+                 // Validate format 
+                if (vehicle_id.length() != 36 || customer_id.length() != 36) {
+                    crow::json::wvalue error;
+                    error["error"] = "Invalid UUID format";
+                    return crow::response(400, error);
+                }
+
+                // Validate sale price
+                if (sale_price <= 0) {
+                    crow::json::wvalue error;
+                    error["error"] = "Sale price must be positive";
+                    return crow::response(400, error);
+                }
+                if (sale_price > 1000000) {
+                    crow::json::wvalue error;
+                    error["error"] = "Sale price is too high";
+                    return crow::response(400, error);
+                }
+
+                // The in-memory stores are updated after the connection is
+                // back in the pool, so a slow store never holds one.
+                crow::response created;
+                SaleFact fact;
+                VehicleFeatures sold;
+                std::shared_ptr<const RenderedInvoice> invoice;
+                uint64_t invoiceEpoch = 0;
+                const uint64_t distributionEpoch = salesDistribution().epoch();
+                {
+                    ConnectionGuard guard(getPool());
+                    guard.prepare("sale_create", CREATE_SALE_SQL);
+                    invoiceEpoch = invoiceCache().epoch();
+                    pqxx::work txn(guard.get());
+
+                    pqxx::result r = txn.exec_prepared("sale_create",
+                        vehicle_id, customer_id, date, sale_price, newUuidV7());
+                    const auto row = r[0];
+
+                    if (row["prior_status"].is_null()) {
+                        crow::json::wvalue error;
+                        error["error"] = "Vehicle not found";
+                        return crow::response(404, error);
+                    }
+                    if (!row["customer_exists"].as<bool>()) {
+                        crow::json::wvalue error;
+                        error["error"] = "Customer not found";
+                        return crow::response(404, error);
+                    }
+                    if (row["sale_id"].is_null()) {
+                        crow::json::wvalue error;
+                        error["error"] = "Vehicle is not available";
+                        error["status"] = row["prior_status"].c_str();
+                        return crow::response(409, error);
+                    }
+
+                    invoice = std::make_shared<const RenderedInvoice>(invoiceFromRow(row));
+
+                    // response with created sale and its invoice
+                    crow::json::wvalue result;
+                    result["sale_id"] = row["sale_id"].c_str();
+                    result["vehicle_id"] = row["vehicle_id"].c_str();
+                    result["customer_id"] = row["customer_id"].c_str();
+                    result["date"] = row["sale_date"].c_str();
+                    result["sale_price"] = row["sale_price"].as<double>();
+                    result["vehicle_status"] = row["status"].c_str();
+                    result["invoice"] = crow::json::load(invoice->body);
+                    created = crow::response(201, result);
+                    idempotency.record(txn, created);
+
+                    txn.commit();
+
+                    fact.saleId = row["sale_id"].c_str();
+                    fact.date = row["sale_date"].c_str();
+                    fact.salePrice = row["sale_price"].as<double>();
+                    fact.marketPrice = row["market_price"].as<double>();
+                    fact.make = row["make"].c_str();
+                    fact.model = row["model"].c_str();
+                    fact.fuelType = row["fuel_type"].c_str();
+                    fact.transmission = row["transmission"].c_str();
+                    fact.vehicleYear = row["year"].as<int>();
+
+                    sold.id = row["vehicle_id"].c_str();
+                    sold.make = fact.make;
+                    sold.model = fact.model;
+                    sold.year = fact.vehicleYear;
+                    sold.odometer = row["odometer"].as<int>();
+                    sold.marketPrice = fact.marketPrice;
+                    sold.fuelType = fact.fuelType;
+                    sold.transmission = fact.transmission;
+                    sold.available = false;
+                }
+
+                salesFactTable().upsert(fact);
+                salesDistribution().add(fact.saleId, fact.make, fact.model, fact.date, fact.salePrice,
+                                        fact.marketPrice, distributionEpoch);
+                similarVehicleIndex().upsert(sold);
+                invoiceCache().put(std::move(invoice), invoiceEpoch);
+                return created;
+
+            } catch (const pqxx::sql_error& e) {
+                CROW_LOG_ERROR << "SQL error in POST /sales [" << e.sqlstate() << "]: " << e.what();
+                return sqlErrorResponse(e);
+
+            } catch (const std::exception& e) {
                 crow::json::wvalue error;
-                error["error"] = "Invalid UUID format";
-                return crow::response(400, error);
+                error["error"] = "Internal server error";
+                return crow::response(500, error);
             }
+        });
+    });
 
-            // Validate sale price
-            if (sale_price <= 0) {
+    //------------------------------------------------------------------
+    // POST /sales/batch
+    //------------------------------------------------------------------
+    /// @brief Imports many sales at once, e.g. the nightly DMS backfill.
+    /// @route POST /sales/batch
+    /// @param req NDJSON body: one {"vehicle_id", "customer_id", "sale_price", "date"}
+    ///            object per line, at most 100,000 lines.
+    /// Valid lines are imported in one transaction; every line gets an outcome
+    /// (created, duplicate, unknown_vehicle, unknown_customer, vehicle_sold or
+    /// invalid) in the response, so a rerun of the same file creates nothing.
+    CROW_ROUTE(app, "/sales/batch")
+    .methods("POST"_method)
+    ([](const crow::request& req) {
+        try {
+            const size_t lineCount = countNdjsonLines(req.body);
+            if (lineCount == 0) {
                 crow::json::wvalue error;
-                error["error"] = "Sale price must be positive";
+                error["error"] = "Empty batch";
+                error["message"] = "Send one JSON sale per line.";
                 return crow::response(400, error);
             }
-            if (sale_price > 1000000) {
+            if (lineCount > MAX_BATCH_LINES) {
                 crow::json::wvalue error;
-                error["error"] = "Sale price is too high";
-                return crow::response(400, error);
+                error["error"] = "Batch too large";
+                error["message"] = "At most " + std::to_string(MAX_BATCH_LINES) + " sales per request.";
+                return crow::response(413, error);
+            }
+            std::vector<ImportRow> rows = parseSalesNdjson(req.body);
+
+            std::vector<ImportOutcome> outcomes;
+            std::vector<ImportedSale> created;
+            const uint64_t distributionEpoch = salesDistribution().epoch();
+            {
+                ConnectionGuard guard(getPool());
+                pqxx::work txn(guard.get());
+                outcomes = importSales(txn, rows, created);
+                txn.commit();
             }
 
-            ConnectionGuard guard(getPool());
-            pqxx::work txn(guard.get());
-
-            // insert and return new sale
-            pqxx::result r = txn.exec_params(
-                "INSERT INTO Sales (vehicle_id, customer_id, date, sale_price) "
-                "VALUES ($1, $2, $3, $4) "
-                "RETURNING id, vehicle_id, customer_id, date, sale_price",
-                vehicle_id, customer_id, date, sale_price
-            );
+            for (const auto& sale : created) {
+                SaleFact fact;
+                fact.saleId = sale.saleId;
+                fact.date = sale.date;
+                fact.salePrice = sale.salePrice;
+                fact.marketPrice = sale.marketPrice;
+                fact.make = sale.make;
+                fact.model = sale.model;
+                fact.fuelType = sale.fuelType;
+                fact.transmission = sale.transmission;
+                fact.vehicleYear = sale.year;
+                salesFactTable().upsert(fact);
+                salesDistribution().add(sale.saleId, sale.make, sale.model, sale.date, sale.salePrice,
+                                        sale.marketPrice, distributionEpoch);
+
+                VehicleFeatures sold;
+                sold.id = sale.vehicleId;
+                sold.make = sale.make;
+                sold.model = sale.model;
+                sold.year = sale.year;
+                sold.odometer = sale.odometer;
+                sold.marketPrice = sale.marketPrice;
+                sold.fuelType = sale.fuelType;
+                sold.transmission = sale.transmission;
+                sold.available = false;
+                similarVehicleIndex().upsert(sold);
+            }
 
-            txn.commit();
+            std::map<std::string, int> counts = {
+                {"created", 0}, {"duplicate", 0}, {"unknown_vehicle", 0},
+                {"unknown_customer", 0}, {"vehicle_sold", 0}, {"invalid", 0},
+            };
+            crow::json::wvalue::list results;
+            results.reserve(outcomes.size());
+            for (const auto& outcome : outcomes) {
+                ++counts[outcome.outcome];
+                crow::json::wvalue item;
+                item["line"] = outcome.line;
+                item["outcome"] = outcome.outcome;
+                if (!outcome.saleId.empty()) item["sale_id"] = outcome.saleId;
+                if (!outcome.message.empty()) item["message"] = outcome.message;
+                results.push_back(std::move(item));
+            }
 
-            // response with created sale
             crow::json::wvalue result;
-            result["sale_id"] = r[0]["id"].c_str();
-            result["vehicle_id"] = r[0]["vehicle_id"].c_str();
-            result["customer_id"] = r[0]["customer_id"].c_str();
-            result["date"] = r[0]["date"].c_str();
-            result["sale_price"] = r[0]["sale_price"].as<double>();
-
-            return crow::response(201, result);
+            result["received"] = static_cast<int>(rows.size());
+            for (const auto& [outcome, count] : counts) result["counts"][outcome] = count;
+            result["results"] = std::move(results);
+            return crow::response(200, result);
 
         } catch (const pqxx::sql_error& e) {
-            std::string error_msg = e.what();
-            crow::json::wvalue error;
-            
-            // Handle database constraint violations
-            if (error_msg.find("foreign key constraint") != std::string::npos) {
-                if (error_msg.find("vehicle_id") != std::string::npos) {
-                    error["error"] = "Vehicle not found";
-                } else {
-                    error["error"] = "Customer not found";
-                }
-                return crow::response(404, error);
-                
-            } else if (error_msg.find("unique constraint") != std::string::npos || 
-                    error_msg.find("duplicate key") != std::string::npos) {
-                error["error"] = "Vehicle already sold";
-                return crow::response(409, error);
-                
-            } else {
-                error["error"] = "Database error";
-                error["message"] = e.what();
-                return crow::response(500, error);
-            }
-            
+            CROW_LOG_ERROR << "SQL error in POST /sales/batch [" << e.sqlstate() << "]: " << e.what();
+            return sqlErrorResponse(e);
+
         } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Error in POST /sales/batch: " << e.what();
             crow::json::wvalue error;
             error["error"] = "Internal server error";
+            error["message"] = e.what();
             return crow::response(500, error);
         }
-    }) ;
+    });
 
     //------------------------------------------------------------------
     // GET /sales/vehicles/<id>
     //------------------------------------------------------------------
-    /// @brief Retrieves all sales for a specific vehicle.
+    /// @brief Retrieves one page of sales for a specific vehicle.
+    /// Accepts the same query parameters as GET /sales.
     /// @route GET /sales/vehicles/<vehicle_id>
     /// @param vehicle_id The vehicle ID (UUID).
     CROW_ROUTE(app, "/sales/vehicles/<string>")
     .methods("GET"_method)
-    ([](const std::string& vehicle_id) {
-        ConnectionGuard guard(getPool());
-        pqxx::work txn(guard.get());
-        pqxx::result r = txn.exec_params(
-            "SELECT s.id AS sale_id, s.date, s.sale_price, "
-            "v.id AS vehicle_id, v.make, v.model, "
-            "c.id AS customer_id, c.first_name, c.last_name "
-            "FROM Sales s "
-            "JOIN Vehicles v ON s.vehicle_id = v.id "
-            "JOIN Customers c ON s.customer_id = c.id "
-            "WHERE v.id = $1 "
-            "ORDER BY s.date DESC",
-            vehicle_id
-        );
-        crow::json::wvalue result = crow::json::wvalue::list();
-        int i = 0;
-        for (const auto& row : r) {
-            result[i]["sale_id"]     = row["sale_id"].c_str();
-            result[i]["date"]        = row["date"].c_str();
-            result[i]["price"]       = row["sale_price"].as<double>();
-            result[i]["vehicle_id"]  = row["vehicle_id"].c_str();
-            result[i]["vehicle"]     = std::string(row["make"].c_str()) + " " + row["model"].c_str();
-            result[i]["customer_id"] = row["customer_id"].c_str();
-            result[i]["customer"]    = std::string(row["first_name"].c_str()) + " " + row["last_name"].c_str();
-            ++i;
-        }
-        return result;
+    ([](const crow::request& req, const std::string& vehicle_id) {
+        try {
+            return salesPage(req, SalesScope::Vehicle, vehicle_id);
+        } catch (const pqxx::data_exception&) {
+            crow::json::wvalue error;
+            error["error"] = "Invalid UUID format";
+            return crow::response(400, error);
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Error in GET /sales/vehicles/" << vehicle_id << ": " << e.what();
+            crow::json::wvalue error;
+            error["error"] = "Database error";
+            error["message"] = e.what();
+            return crow::response(500, error);
+        }
     });
 
     //------------------------------------------------------------------
     // GET /sales/customers/<id>
     //------------------------------------------------------------------
-    /// @brief Retrieves all sales for a specific customer.
+    /// @brief Retrieves one page of sales for a specific customer.
+    /// Accepts the same query parameters as GET /sales.
     /// @route GET /sales/customers/<customer_id>
     /// @param customer_id The customer ID (UUID).
     CROW_ROUTE(app, "/sales/customers/<string>")
     .methods("GET"_method)
-    ([](const std::string& customer_id) {
-        ConnectionGuard guard(getPool());
-        pqxx::work txn(guard.get());
-        pqxx::result r = txn.exec_params(
-            "SELECT s.id AS sale_id, s.date, s.sale_price, "
-            "v.id AS vehicle_id, v.make, v.model, "
-            "c.id AS customer_id, c.first_name, c.last_name "
-            "FROM Sales s "
-            "JOIN Vehicles v ON s.vehicle_id = v.id "
-            "JOIN Customers c ON s.customer_id = c.id "
-            "WHERE c.id = $1 "
-            "ORDER BY s.date DESC",
-            customer_id
-        );
-        crow::json::wvalue result = crow::json::wvalue::list();
-        int i = 0;
-        for (const auto& row : r) {
-            result[i]["sale_id"]     = row["sale_id"].c_str();
-            result[i]["date"]        = row["date"].c_str();
-            result[i]["price"]       = row["sale_price"].as<double>();
-            result[i]["vehicle_id"]  = row["vehicle_id"].c_str();
-            result[i]["vehicle"]     = std::string(row["make"].c_str()) + " " + row["model"].c_str();
-            result[i]["customer_id"] = row["customer_id"].c_str();
-            result[i]["customer"]    = std::string(row["first_name"].c_str()) + " " + row["last_name"].c_str();
-            ++i;
-        }
-        return result;
+    ([](const crow::request& req, const std::string& customer_id) {
+        try {
+            return salesPage(req, SalesScope::Customer, customer_id);
+        } catch (const pqxx::data_exception&) {
+            crow::json::wvalue error;
+            error["error"] = "Invalid UUID format";
+            return crow::response(400, error);
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Error in GET /sales/customers/" << customer_id << ": " << e.what();
+            crow::json::wvalue error;
+            error["error"] = "Database error";
+            error["message"] = e.what();
+            return crow::response(500, error);
+        }
     });
 
     //------------------------------------------------------------------
@@ -754,44 +1265,94 @@ void registerSalesRoutes(crow::SimpleApp& app) {
             // ----------------------------
             // Database update
             // ----------------------------
-            ConnectionGuard guard(getPool());
-            pqxx::work txn(guard.get());
+            // The connection goes back to the pool before the in-memory
+            // stores are touched.
+            pqxx::result before, r;
+            std::string oldDate, oldPrice, newDate, newPrice;
+            std::optional<SaleFact> fact;
+            std::optional<RenderedInvoice> invoice;
+            uint64_t invoiceEpoch = 0;
+            {
+                ConnectionGuard guard(getPool());
+                prepareSalesRollup(guard);
+                prepareInvoice(guard);
+                invoiceEpoch = invoiceCache().epoch();
+                pqxx::work txn(guard.get());
+
+                // Lock the sale and remember what its rollup currently counts.
+                before = txn.exec_params(
+                    "SELECT date, sale_price, vehicle_id FROM Sales WHERE id = $1 FOR UPDATE",
+                    id
+                );
+                if (before.empty()) {
+                    crow::json::wvalue error;
+                    error["error"] = "Sale not found";
+                    return crow::response(404, error);
+                }
 
-            pqxx::result r;
+                if (has_price && has_date) {
+                    r = txn.exec_params(
+                        "UPDATE Sales "
+                        "SET sale_price = $1, date = $2, version = version + 1 "
+                        "WHERE id = $3 "
+                        "RETURNING id, vehicle_id, customer_id, date, sale_price",
+                        sale_price, date, id
+                    );
+                } else if (has_price) {
+                    r = txn.exec_params(
+                        "UPDATE Sales "
+                        "SET sale_price = $1, version = version + 1 "
+                        "WHERE id = $2 "
+                        "RETURNING id, vehicle_id, customer_id, date, sale_price",
+                        sale_price, id
+                    );
+                } else {
+                    r = txn.exec_params(
+                        "UPDATE Sales "
+                        "SET date = $1, version = version + 1 "
+                        "WHERE id = $2 "
+                        "RETURNING id, vehicle_id, customer_id, date, sale_price",
+                        date, id
+                    );
+                }
 
-            if (has_price && has_date) {
-                r = txn.exec_params(
-                    "UPDATE Sales "
-                    "SET sale_price = $1, date = $2 "
-                    "WHERE id = $3 "
-                    "RETURNING id, vehicle_id, customer_id, date, sale_price",
-                    sale_price, date, id
-                );
-            } else if (has_price) {
-                r = txn.exec_params(
-                    "UPDATE Sales "
-                    "SET sale_price = $1 "
-                    "WHERE id = $2 "
-                    "RETURNING id, vehicle_id, customer_id, date, sale_price",
-                    sale_price, id
-                );
-            } else {
-                r = txn.exec_params(
-                    "UPDATE Sales "
-                    "SET date = $1 "
-                    "WHERE id = $2 "
-                    "RETURNING id, vehicle_id, customer_id, date, sale_price",
-                    date, id
-                );
-            }
+                if (r.empty()) {
+                    crow::json::wvalue error;
+                    error["error"] = "Sale not found";
+                    return crow::response(404, error);
+                }
 
-            if (r.empty()) {
-                crow::json::wvalue error;
-                error["error"] = "Sale not found";
-                return crow::response(404, error);
+                // Move the sale between rollups if its price or day changed.
+                oldDate = before[0]["date"].c_str();
+                oldPrice = before[0]["sale_price"].c_str();
+                newDate = r[0]["date"].c_str();
+                newPrice = r[0]["sale_price"].c_str();
+                if (oldDate != newDate || oldPrice != newPrice) {
+                    retractSaleFromRollup(txn, oldDate, id, oldPrice);
+                    applySaleToRollup(txn, newDate, id, newPrice);
+                }
+                // The buyer's overview shows the sale, so its ETag must move too.
+                txn.exec_params("UPDATE Customers SET version = version + 1 WHERE id = $1",
+                                r[0]["customer_id"].c_str());
+                fact = fetchSaleFact(txn, id);
+                invoice = loadInvoice(txn, id);
+
+                txn.commit();
             }
 
-            txn.commit();
+            if (invoice) {
+                // Replaces the previous version; if refused, the stale entry is gone anyway.
+                invoiceCache().put(std::make_shared<const RenderedInvoice>(std::move(*invoice)), invoiceEpoch);
+            } else {
+                invoiceCache().invalidateSale(id);
+            }
+            if (fact) {
+                salesFactTable().upsert(*fact);
+                if (oldDate != newDate || oldPrice != newPrice) {
+                    salesDistribution().markDirty(fact->make, fact->model, oldDate);
+                    salesDistribution().markDirty(fact->make, fact->model, newDate);
+                }
+            }
 
             // ----------------------------
             // Build response
@@ -806,12 +1367,8 @@ void registerSalesRoutes(crow::SimpleApp& app) {
             return crow::response(200, result);
 
         } catch (const pqxx::sql_error& e) {
-            CROW_LOG_ERROR << "SQL error in PUT /sales/" << id << ": " << e.what();
-
-            crow::json::wvalue error;
-            error["error"] = "Database error";
-            error["message"] = e.what();
-            return crow::response(500, error);
+            CROW_LOG_ERROR << "SQL error in PUT /sales/" << id << " [" << e.sqlstate() << "]: " << e.what();
+            return sqlErrorResponse(e);
 
         } catch (const std::exception& e) {
             CROW_LOG_ERROR << "Error in PUT /sales/" << id << ": " << e.what();
@@ -0,0 +1,159 @@
+#include "sales_distribution.h"
+#include "../../utils/civil_date.h"
+#include <climits>
+
+bool SalesDistributionStore::monthNumber(std::string_view text, int& month) {
+    const auto date = parseYearMonth(text);
+    if (!date) return false;
+    month = monthIndex(*date);
+    return true;
+}
+
+void SalesDistributionStore::reload(const std::function<void(const Sink&)>& source) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        reloading = true;
+        pendingAdds.clear();
+    }
+
+    // Read and sketch outside the lock; queries keep using the old buckets.
+    std::map<BucketKey, Bucket> fresh;
+    try {
+        source([&fresh](const std::string& make, const std::string& model, const std::string& date,
+                        double salePrice, double marketPrice) {
+            int month;
+            if (!monthNumber(date, month)) return;
+            Bucket& b = fresh[{make, model, month}];
+            b.salePrice.add(salePrice);
+            b.profit.add(salePrice - marketPrice);
+        });
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mtx);
+        reloading = false;
+        pendingAdds.clear();
+        throw;
+    }
+    for (auto& [key, b] : fresh) {
+        b.salePrice.compress();
+        b.profit.compress();
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    const uint64_t readAt = ++currentEpoch;
+    for (auto& [key, b] : fresh) b.readAt = readAt;
+    // The load may or may not have seen these sales.
+    for (const auto& [saleId, key] : pendingAdds) fresh[key].state = State::Dirty;
+    pendingAdds.clear();
+    reloading = false;
+    buckets.swap(fresh);
+    isLoaded = true;
+}
+
+uint64_t SalesDistributionStore::epoch() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return currentEpoch;
+}
+
+void SalesDistributionStore::add(const std::string& saleId, const std::string& make, const std::string& model,
+                                 const std::string& date, double salePrice, double marketPrice,
+                                 uint64_t seenEpoch) {
+    int month;
+    if (!monthNumber(date, month)) return;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (reloading) pendingAdds.insert_or_assign(saleId, BucketKey{make, model, month});
+    if (!isLoaded) return;
+    Bucket& b = buckets[{make, model, month}];
+    switch (b.state) {
+        case State::Clean:
+            if (b.readAt <= seenEpoch) {
+                b.salePrice.add(salePrice);
+                b.profit.add(salePrice - marketPrice);
+            } else {
+                b.state = State::Dirty; // read after the sale began: it may be in already
+            }
+            break;
+        case State::Dirty:
+            break; // the rebuild will read it from the database
+        case State::Rebuilding:
+        case State::RebuildingDirty:
+            b.state = State::RebuildingDirty; // the rebuild may have missed it
+            break;
+    }
+}
+
+void SalesDistributionStore::markDirty(const std::string& make, const std::string& model,
+                                       const std::string& date) {
+    int month;
+    if (!monthNumber(date, month)) return;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!isLoaded) return;
+    Bucket& b = buckets[{make, model, month}];
+    b.state = (b.state == State::Rebuilding || b.state == State::RebuildingDirty)
+                  ? State::RebuildingDirty
+                  : State::Dirty;
+}
+
+template <typename F>
+void SalesDistributionStore::forEachMatching(const std::string& make, const std::string& model,
+                                             int fromMonth, int toMonth, F&& visit) {
+    auto it = make.empty() ? buckets.begin() : buckets.lower_bound({make, model, INT_MIN});
+    for (; it != buckets.end(); ++it) {
+        const auto& [bMake, bModel, bMonth] = it->first;
+        if (!make.empty() && bMake != make) break;
+        if (!model.empty() && bModel != model) {
+            if (!make.empty()) break; // keys are sorted by make, then model
+            continue;
+        }
+        if (bMonth < fromMonth || bMonth > toMonth) continue;
+        visit(it->first, it->second);
+    }
+}
+
+std::vector<SalesDistributionStore::BucketKey>
+SalesDistributionStore::beginRebuild(const std::string& make, const std::string& model,
+                                     int fromMonth, int toMonth) {
+    std::vector<BucketKey> claimed;
+    std::lock_guard<std::mutex> lock(mtx);
+    forEachMatching(make, model, fromMonth, toMonth, [&](const BucketKey& key, Bucket& b) {
+        if (b.state == State::Dirty) {
+            b.state = State::Rebuilding;
+            claimed.push_back(key);
+        }
+    });
+    return claimed;
+}
+
+void SalesDistributionStore::finishRebuild(const BucketKey& key, Summary summary) {
+    std::lock_guard<std::mutex> lock(mtx);
+    Bucket& b = buckets[key];
+    summary.salePrice.compress();
+    summary.profit.compress();
+    b.salePrice = std::move(summary.salePrice);
+    b.profit = std::move(summary.profit);
+    b.state = b.state == State::RebuildingDirty ? State::Dirty : State::Clean;
+    b.readAt = ++currentEpoch;
+}
+
+void SalesDistributionStore::abortRebuild(const std::vector<BucketKey>& keys) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto& key : keys) buckets[key].state = State::Dirty;
+}
+
+SalesDistributionStore::Summary
+SalesDistributionStore::merged(const std::string& make, const std::string& model, int fromMonth, int toMonth) {
+    Summary out;
+    std::lock_guard<std::mutex> lock(mtx);
+    forEachMatching(make, model, fromMonth, toMonth, [&](const BucketKey&, Bucket& b) {
+        out.salePrice.merge(b.salePrice);
+        out.profit.merge(b.profit);
+        ++out.buckets;
+    });
+    return out;
+}
+
+SalesDistributionStore& salesDistribution() {
+    static SalesDistributionStore store;
+    return store;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "../../utils/tdigest.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/// @file sales_distribution.h
+/// @brief Per (make, model, month) quantile sketches of sale price and profit.
+///
+/// Each bucket holds one t-digest of sale prices and one of profit against
+/// market_price. A query merges the buckets of the requested make/model and
+/// month range, so its cost depends on the number of buckets, not on the
+/// number of sales.
+///
+/// Sketches cannot forget a value, so a changed sale marks its buckets dirty
+/// instead. A dirty bucket is rebuilt from Postgres the next time a query
+/// touches it. Buckets use the make, model and market price stored on the
+/// sale, so editing or repricing a sold vehicle leaves them valid; only
+/// PUT /sales changes what a bucket holds.
+///
+/// Sketches cannot tell whether they already hold a value either. Every
+/// load or rebuild of a bucket is stamped with the store's epoch once its
+/// database read is done. A new sale is added only if its bucket was read
+/// before the sale's transaction began, i.e. before its epoch() ticket. If
+/// the read may already have seen the sale, the bucket is marked dirty
+/// instead, so no sale is ever counted twice.
+class SalesDistributionStore {
+public:
+    /// @brief Bucket identity: make, model and months since 1970-01.
+    using BucketKey = std::tuple<std::string, std::string, int>;
+
+    /// @brief Sketches of one bucket, or of several merged together.
+    struct Summary {
+        TDigest salePrice;
+        TDigest profit;
+        size_t buckets = 0;
+    };
+
+    using Sink = std::function<void(const std::string& make, const std::string& model,
+                                    const std::string& date, double salePrice, double marketPrice)>;
+
+    /// @brief Replaces every bucket with the sales `source` feeds to its sink.
+    /// The sketches are built without the lock and swapped in; buckets of
+    /// sales added meanwhile come out dirty. Reloads must not run concurrently.
+    void reload(const std::function<void(const Sink&)>& source);
+
+    /// @brief Ticket to take before the transaction that inserts a sale and
+    /// to pass to add() once it has committed.
+    uint64_t epoch();
+
+    /// @brief Adds one committed sale (ignored before the first reload unless
+    /// one is running: that load includes it).
+    void add(const std::string& saleId, const std::string& make, const std::string& model,
+             const std::string& date, double salePrice, double marketPrice, uint64_t seenEpoch);
+
+    /// @brief Marks the bucket a sale was counted in as needing a rebuild.
+    void markDirty(const std::string& make, const std::string& model, const std::string& date);
+
+    /// @brief Claims the dirty buckets matching a filter for rebuilding.
+    /// Empty make/model match everything.
+    std::vector<BucketKey> beginRebuild(const std::string& make, const std::string& model,
+                                        int fromMonth, int toMonth);
+
+    /// @brief Installs a rebuilt bucket. If it was dirtied again meanwhile it
+    /// stays dirty and is rebuilt on a later query.
+    void finishRebuild(const BucketKey& key, Summary summary);
+
+    /// @brief Returns claimed buckets to the dirty state after a failed rebuild.
+    void abortRebuild(const std::vector<BucketKey>& keys);
+
+    /// @brief Merges every bucket matching the filter.
+    Summary merged(const std::string& make, const std::string& model, int fromMonth, int toMonth);
+
+    /// @brief Months since 1970-01 for "YYYY-MM" or "YYYY-MM-DD".
+    static bool monthNumber(std::string_view text, int& month);
+
+private:
+    enum class State { Clean, Dirty, Rebuilding, RebuildingDirty };
+
+    struct Bucket {
+        TDigest salePrice;
+        TDigest profit;
+        State state = State::Clean;
+        uint64_t readAt = 0; ///< Epoch stamped after the last load or rebuild read it.
+    };
+
+    template <typename F>
+    void forEachMatching(const std::string& make, const std::string& model,
+                         int fromMonth, int toMonth, F&& visit);
+
+    std::mutex mtx;
+    bool isLoaded = false;
+    bool reloading = false;
+    uint64_t currentEpoch = 1;
+    std::map<BucketKey, Bucket> buckets;
+    std::unordered_map<std::string, BucketKey> pendingAdds; ///< Sale id -> bucket, while reload() runs.
+};
+
+/// @brief Process-wide store used by the sales routes.
+SalesDistributionStore& salesDistribution();
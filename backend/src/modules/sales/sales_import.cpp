@@ -0,0 +1,267 @@
+#include "sales_import.h"
+#include "../../external/crow/crow_all.h"
+#include "../../utils/civil_date.h"
+#include "../../utils/uuid.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <thread>
+
+namespace {
+    // Lines one validation thread should have to itself to be worth starting.
+    constexpr size_t MIN_LINES_PER_THREAD = 4096;
+
+    bool isUuid(const std::string& text) {
+        if (text.size() != 36) return false;
+        for (size_t i = 0; i < text.size(); ++i) {
+            const bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+            if (dash ? text[i] != '-' : !std::isxdigit(static_cast<unsigned char>(text[i]))) return false;
+        }
+        return true;
+    }
+
+    void validateLine(std::string_view text, ImportRow& row) {
+        auto json = crow::json::load(text.data(), text.size());
+        if (!json || json.t() != crow::json::type::Object) {
+            row.error = "Invalid JSON";
+            return;
+        }
+        for (const char* key : {"vehicle_id", "customer_id", "date"}) {
+            if (!json.has(key) || json[key].t() != crow::json::type::String) {
+                row.error = std::string("Missing or non-string field: ") + key;
+                return;
+            }
+        }
+        if (!json.has("sale_price") || json["sale_price"].t() != crow::json::type::Number) {
+            row.error = "Missing or non-numeric field: sale_price";
+            return;
+        }
+
+        row.vehicleId = json["vehicle_id"].s();
+        row.customerId = json["customer_id"].s();
+        row.date = json["date"].s();
+        row.salePrice = json["sale_price"].d();
+
+        if (!isUuid(row.vehicleId) || !isUuid(row.customerId)) {
+            row.error = "Invalid UUID format";
+        } else if (!isValidDate(row.date)) {
+            row.error = "Invalid date";
+        } else if (!std::isfinite(row.salePrice) || row.salePrice <= 0) {
+            row.error = "Sale price must be positive";
+        } else if (row.salePrice > 1000000) {
+            row.error = "Sale price is too high";
+        } else {
+            row.saleId = newUuidV7();
+        }
+    }
+
+    // Lowercases UUIDs so staged rows compare equal to what Postgres returns.
+    void normalize(ImportRow& row) {
+        for (char& c : row.vehicleId) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        for (char& c : row.customerId) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    const char* STAGING_SQL =
+        "CREATE TEMP TABLE sales_import ("
+        "  line INTEGER PRIMARY KEY, id UUID NOT NULL, vehicle_id UUID NOT NULL, "
+        "  customer_id UUID NOT NULL, date DATE NOT NULL, sale_price NUMERIC(10,2) NOT NULL"
+        ") ON COMMIT DROP";
+
+    // Fixed lock order across concurrent imports and single sales: vehicles
+    // by id, then customers by id (POST /sales also locks its vehicle before
+    // touching the buyer).
+    const char* LOCK_VEHICLES_SQL =
+        "SELECT 1 FROM Vehicles WHERE id IN (SELECT vehicle_id FROM sales_import) "
+        "ORDER BY id FOR UPDATE";
+    const char* LOCK_CUSTOMERS_SQL =
+        "SELECT 1 FROM Customers WHERE id IN (SELECT customer_id FROM sales_import) "
+        "ORDER BY id FOR UPDATE";
+
+    // Runs after the lock statements, so in READ COMMITTED it sees every sale
+    // committed by transactions that held those locks before us. The rollup
+    // deltas are summed per (day, make, model) and upserted in key order, so
+    // two imports touching the same rollup rows take their locks in the same
+    // order.
+    const char* MERGE_SQL = R"(
+        WITH staged AS (
+            SELECT i.*, v.id IS NOT NULL AS vehicle_known, c.id IS NOT NULL AS customer_known,
+                   v.status AS vehicle_status, v.make, v.model, v.market_price,
+                   EXISTS (SELECT 1 FROM Sales s
+                           WHERE s.vehicle_id = i.vehicle_id AND s.customer_id = i.customer_id
+                             AND s.date = i.date AND s.sale_price = i.sale_price) AS recorded
+            FROM sales_import i
+            LEFT JOIN Vehicles v ON v.id = i.vehicle_id
+            LEFT JOIN Customers c ON c.id = i.customer_id
+        ),
+        ranked AS (
+            SELECT s.*,
+                   row_number() OVER (PARTITION BY vehicle_id, customer_id, date, sale_price
+                                      ORDER BY line) AS copy_rank,
+                   row_number() OVER (PARTITION BY vehicle_id, (vehicle_known AND customer_known AND NOT recorded)
+                                      ORDER BY line) AS vehicle_rank
+            FROM staged s
+        ),
+        classified AS (
+            SELECT line, id, vehicle_id, customer_id, date, sale_price, make, model, market_price,
+                   CASE
+                       WHEN NOT vehicle_known THEN 'unknown_vehicle'
+                       WHEN NOT customer_known THEN 'unknown_customer'
+                       WHEN recorded OR copy_rank > 1 THEN 'duplicate'
+                       WHEN vehicle_rank > 1 OR vehicle_status <> 'Available' THEN 'vehicle_sold'
+                       ELSE 'created'
+                   END AS outcome
+            FROM ranked
+        ),
+        inserted AS (
+            INSERT INTO Sales (id, vehicle_id, customer_id, date, sale_price, make, model, market_price)
+            SELECT id, vehicle_id, customer_id, date, sale_price, make, model, market_price
+            FROM classified WHERE outcome = 'created'
+            RETURNING id, vehicle_id, date, sale_price, make, model, market_price
+        ),
+        sold AS (
+            UPDATE Vehicles v SET status = 'Sold', version = v.version + 1
+            FROM inserted
+            WHERE v.id = inserted.vehicle_id
+            RETURNING v.id
+        ),
+        buyers AS (
+            UPDATE Customers c SET version = c.version + 1
+            WHERE c.id IN (SELECT customer_id FROM classified WHERE outcome = 'created')
+        ),
+        rollup AS (
+            INSERT INTO Sales_Daily_Rollup AS r
+                (day, make, model, sales_count, revenue, market_value, profit, min_sale_price, max_sale_price)
+            SELECT n.date, n.make, n.model, count(*), sum(n.sale_price), sum(n.market_price),
+                   sum(n.sale_price - n.market_price), min(n.sale_price), max(n.sale_price)
+            FROM inserted n
+            GROUP BY n.date, n.make, n.model
+            ORDER BY n.date, n.make, n.model
+            ON CONFLICT (day, make, model) DO UPDATE SET
+                sales_count = r.sales_count + EXCLUDED.sales_count,
+                revenue = r.revenue + EXCLUDED.revenue,
+                market_value = r.market_value + EXCLUDED.market_value,
+                profit = r.profit + EXCLUDED.profit,
+                min_sale_price = LEAST(r.min_sale_price, EXCLUDED.min_sale_price),
+                max_sale_price = GREATEST(r.max_sale_price, EXCLUDED.max_sale_price)
+        )
+        SELECT c.line, c.outcome, c.id, c.vehicle_id, c.date, c.sale_price,
+               v.market_price, v.make, v.model, v.fuel_type, v.transmission, v.year, v.odometer
+        FROM classified c
+        LEFT JOIN Vehicles v ON v.id = c.vehicle_id AND c.outcome = 'created'
+        ORDER BY c.line
+    )";
+}
+
+size_t countNdjsonLines(std::string_view body) {
+    size_t count = 0;
+    size_t start = 0;
+    while (start < body.size()) {
+        size_t end = body.find('\n', start);
+        if (end == std::string_view::npos) end = body.size();
+        std::string_view text = body.substr(start, end - start);
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        if (text.find_first_not_of(" \t") != std::string_view::npos) ++count;
+        start = end + 1;
+    }
+    return count;
+}
+
+std::vector<ImportRow> parseSalesNdjson(std::string_view body, unsigned threads) {
+    std::vector<std::string_view> lines;
+    std::vector<ImportRow> rows;
+    int lineNumber = 0;
+    size_t start = 0;
+    while (start < body.size()) {
+        size_t end = body.find('\n', start);
+        if (end == std::string_view::npos) end = body.size();
+        ++lineNumber;
+        std::string_view text = body.substr(start, end - start);
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        if (text.find_first_not_of(" \t") != std::string_view::npos) {
+            lines.push_back(text);
+            rows.emplace_back().line = lineNumber;
+        }
+        start = end + 1;
+    }
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::clamp<size_t>(lines.size() / MIN_LINES_PER_THREAD, 1, threads));
+
+    auto validateRange = [&](size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            validateLine(lines[i], rows[i]);
+            normalize(rows[i]);
+        }
+    };
+
+    const size_t chunk = (lines.size() + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t) {
+        const size_t from = std::min(lines.size(), t * chunk);
+        const size_t to = std::min(lines.size(), from + chunk);
+        workers.emplace_back(validateRange, from, to);
+    }
+    validateRange(0, std::min(lines.size(), chunk));
+    for (auto& worker : workers) worker.join();
+
+    return rows;
+}
+
+std::vector<ImportOutcome> importSales(pqxx::work& txn, const std::vector<ImportRow>& rows,
+                                       std::vector<ImportedSale>& created) {
+    std::vector<ImportOutcome> outcomes;
+    outcomes.reserve(rows.size());
+
+    txn.exec(STAGING_SQL);
+    {
+        pqxx::stream_to stream(txn, "sales_import",
+            std::vector<std::string>{"line", "id", "vehicle_id", "customer_id", "date", "sale_price"});
+        for (const auto& row : rows) {
+            if (!row.error.empty()) continue;
+            stream << std::make_tuple(row.line, row.saleId, row.vehicleId, row.customerId,
+                                      row.date, row.salePrice);
+        }
+        stream.complete();
+    }
+    txn.exec("ANALYZE sales_import");
+    txn.exec(LOCK_VEHICLES_SQL);
+    txn.exec(LOCK_CUSTOMERS_SQL);
+    pqxx::result merged = txn.exec(MERGE_SQL);
+
+    // Interleave the database outcomes with the rows rejected up front; both
+    // are in line order.
+    auto result = merged.begin();
+    for (const auto& row : rows) {
+        ImportOutcome outcome;
+        outcome.line = row.line;
+        if (!row.error.empty()) {
+            outcome.outcome = "invalid";
+            outcome.message = row.error;
+            outcomes.push_back(std::move(outcome));
+            continue;
+        }
+
+        const auto& r = *result;
+        ++result;
+        outcome.outcome = r["outcome"].c_str();
+        if (outcome.outcome == "created") {
+            outcome.saleId = r["id"].c_str();
+
+            ImportedSale sale;
+            sale.saleId = outcome.saleId;
+            sale.vehicleId = r["vehicle_id"].c_str();
+            sale.date = r["date"].c_str();
+            sale.salePrice = r["sale_price"].as<double>();
+            sale.marketPrice = r["market_price"].as<double>();
+            sale.make = r["make"].c_str();
+            sale.model = r["model"].c_str();
+            sale.fuelType = r["fuel_type"].c_str();
+            sale.transmission = r["transmission"].c_str();
+            sale.year = r["year"].as<int>();
+            sale.odometer = r["odometer"].as<int>();
+            created.push_back(std::move(sale));
+        }
+        outcomes.push_back(std::move(outcome));
+    }
+    return outcomes;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <pqxx/pqxx>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @file sales_import.h
+/// @brief Bulk sale ingestion for POST /sales/batch (NDJSON from the DMS).
+///
+/// Lines are validated in parallel without touching the database. The valid
+/// ones are COPYed into a temporary staging table and merged into Sales by one
+/// set-based statement that decides every row's outcome, so the cost is a few
+/// round trips per batch rather than several per sale.
+
+/// @brief One NDJSON line after validation.
+struct ImportRow {
+    int line = 0;               ///< 1-based line number in the request body.
+    std::string saleId;         ///< UUIDv7 assigned to the row if it is created.
+    std::string vehicleId;
+    std::string customerId;
+    std::string date;           ///< YYYY-MM-DD
+    double salePrice = 0;
+    std::string error;          ///< Non-empty when the line is invalid.
+};
+
+/// @brief Final result of one line.
+struct ImportOutcome {
+    int line = 0;
+    /// created, duplicate, unknown_vehicle, unknown_customer, vehicle_sold or invalid.
+    std::string outcome;
+    std::string saleId;         ///< Set for created rows.
+    std::string message;        ///< Set for invalid rows.
+};
+
+/// @brief What a created sale needs to update the in-memory stores after commit.
+struct ImportedSale {
+    std::string saleId;
+    std::string vehicleId;
+    std::string date;
+    double salePrice = 0;
+    double marketPrice = 0;
+    std::string make;
+    std::string model;
+    std::string fuelType;
+    std::string transmission;
+    int year = 0;
+    int odometer = 0;
+};
+
+/// @brief Number of non-blank lines in an NDJSON body, without parsing them,
+/// so oversized batches are rejected before any validation work.
+size_t countNdjsonLines(std::string_view body);
+
+/// @brief Splits an NDJSON body into lines and validates them.
+///
+/// Each non-blank line must be an object with vehicle_id and customer_id
+/// (UUIDs), sale_price (0 < price <= 1,000,000) and date (YYYY-MM-DD).
+/// Work is split across up to `threads` threads (0: one per core), each
+/// validating a contiguous range of lines.
+/// @return One row per non-blank line, in input order.
+std::vector<ImportRow> parseSalesNdjson(std::string_view body, unsigned threads = 0);
+
+/// @brief Stages the valid rows and merges them into Sales.
+///
+/// Vehicles and then customers are locked in id order first, and the rollup
+/// rows are upserted in key order, so concurrent batches cannot deadlock and
+/// each sees the other's sales. A row is then
+///   - unknown_vehicle / unknown_customer when a reference does not exist,
+///   - duplicate when an identical sale (vehicle, customer, date, price) is
+///     already recorded or appeared earlier in the batch,
+///   - vehicle_sold when the vehicle is no longer Available or an earlier
+///     line of the batch sold it,
+///   - created otherwise: the sale is inserted, the vehicle marked Sold and
+///     the daily rollups incremented.
+/// @param txn The transaction to import in; the caller commits.
+/// @param rows Output of parseSalesNdjson(); invalid rows are reported as such.
+/// @param created Receives the sales that were inserted.
+/// @return One outcome per row, in line order.
+std::vector<ImportOutcome> importSales(pqxx::work& txn, const std::vector<ImportRow>& rows,
+                                       std::vector<ImportedSale>& created);
@@ -0,0 +1,69 @@
+#include "sales_rollup.h"
+
+namespace {
+    const char* APPLY_SQL =
+        "INSERT INTO Sales_Daily_Rollup AS r "
+        "(day, make, model, sales_count, revenue, market_value, profit, min_sale_price, max_sale_price) "
+        "SELECT $1::date, s.make, s.model, 1, $3::numeric, s.market_price, "
+        "$3::numeric - s.market_price, $3::numeric, $3::numeric "
+        "FROM Sales s WHERE s.id = $2::uuid "
+        "ON CONFLICT (day, make, model) DO UPDATE SET "
+        "sales_count = r.sales_count + 1, "
+        "revenue = r.revenue + EXCLUDED.revenue, "
+        "market_value = r.market_value + EXCLUDED.market_value, "
+        "profit = r.profit + EXCLUDED.profit, "
+        "min_sale_price = LEAST(r.min_sale_price, EXCLUDED.min_sale_price), "
+        "max_sale_price = GREATEST(r.max_sale_price, EXCLUDED.max_sale_price)";
+
+    // Returns the group key, the remaining count and whether the retracted
+    // price sat on a bound. The bounds are not touched by this statement, so
+    // RETURNING still sees the values the price was compared against.
+    const char* RETRACT_SQL =
+        "UPDATE Sales_Daily_Rollup r SET "
+        "sales_count = r.sales_count - 1, "
+        "revenue = r.revenue - $3::numeric, "
+        "market_value = r.market_value - s.market_price, "
+        "profit = r.profit - ($3::numeric - s.market_price) "
+        "FROM Sales s "
+        "WHERE s.id = $2::uuid AND r.day = $1::date AND r.make = s.make AND r.model = s.model "
+        "RETURNING r.make, r.model, r.sales_count, "
+        "($3::numeric <= r.min_sale_price OR $3::numeric >= r.max_sale_price) AS on_bound";
+
+    const char* DELETE_EMPTY_SQL =
+        "DELETE FROM Sales_Daily_Rollup "
+        "WHERE day = $1::date AND make = $2 AND model = $3 AND sales_count <= 0";
+
+    const char* RECOMPUTE_BOUNDS_SQL =
+        "UPDATE Sales_Daily_Rollup r SET min_sale_price = b.lo, max_sale_price = b.hi "
+        "FROM (SELECT MIN(s.sale_price) AS lo, MAX(s.sale_price) AS hi "
+        "      FROM Sales s "
+        "      WHERE s.date = $1::date AND s.make = $2 AND s.model = $3) b "
+        "WHERE r.day = $1::date AND r.make = $2 AND r.model = $3 AND b.lo IS NOT NULL";
+}
+
+void prepareSalesRollup(ConnectionGuard& guard) {
+    guard.prepare("sales_rollup_apply", APPLY_SQL);
+    guard.prepare("sales_rollup_retract", RETRACT_SQL);
+    guard.prepare("sales_rollup_delete_empty", DELETE_EMPTY_SQL);
+    guard.prepare("sales_rollup_recompute_bounds", RECOMPUTE_BOUNDS_SQL);
+}
+
+void applySaleToRollup(pqxx::transaction_base& txn, const std::string& day,
+                       const std::string& saleId, const std::string& salePrice) {
+    txn.exec_prepared("sales_rollup_apply", day, saleId, salePrice);
+}
+
+void retractSaleFromRollup(pqxx::transaction_base& txn, const std::string& day,
+                           const std::string& saleId, const std::string& salePrice) {
+    pqxx::result r = txn.exec_prepared("sales_rollup_retract", day, saleId, salePrice);
+    if (r.empty()) return; // never rolled up (e.g. recorded before the backfill)
+
+    std::string make = r[0]["make"].c_str();
+    std::string model = r[0]["model"].c_str();
+
+    if (r[0]["sales_count"].as<int>() <= 0) {
+        txn.exec_prepared("sales_rollup_delete_empty", day, make, model);
+    } else if (r[0]["on_bound"].as<bool>()) {
+        txn.exec_prepared("sales_rollup_recompute_bounds", day, make, model);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "../../db/db_connection.h"
+#include <pqxx/pqxx>
+#include <string>
+
+/// @file sales_rollup.h
+/// @brief Transactional maintenance of the Sales_Daily_Rollup table.
+///
+/// Every sale contributes to exactly one (day, make, model) rollup row. Writers
+/// call these helpers inside the transaction that changes the sale, so rollups
+/// and raw sales always commit together. A sale is counted with the make,
+/// model and market price copied onto it when it was recorded, so edits to
+/// the vehicle afterwards never shift it between rollups. Increments go through
+/// INSERT ... ON CONFLICT, whose row lock serializes concurrent sales of the
+/// same model on the same day without losing counts. POST /sales makes the
+/// same increment inside its single create statement; keep the two in step.
+
+/// @brief Prepares the rollup statements on the guarded connection.
+/// Call before opening the transaction passed to the other helpers.
+/// @param guard The connection the transaction will run on.
+void prepareSalesRollup(ConnectionGuard& guard);
+
+/// @brief Adds one sale to the rollup of its day and vehicle model.
+/// @param txn The transaction recording the sale.
+/// @param day The sale date (YYYY-MM-DD).
+/// @param saleId The sale; supplies its make, model and market price.
+/// @param salePrice The sale price as returned by Postgres (exact decimal).
+void applySaleToRollup(pqxx::transaction_base& txn, const std::string& day,
+                       const std::string& saleId, const std::string& salePrice);
+
+/// @brief Removes one sale from the rollup it was previously added to.
+///
+/// Sums are decremented in place. MIN/MAX cannot be decremented, so they are
+/// recomputed from that day's sales of the model, but only when the retracted
+/// price sat on a bound. A row whose count drops to zero is deleted.
+/// @param txn The transaction changing the sale; the sale row must already
+///            hold its new values.
+/// @param day The sale date the sale was counted under.
+/// @param saleId The sale.
+/// @param salePrice The sale price the sale was counted with.
+void retractSaleFromRollup(pqxx::transaction_base& txn, const std::string& day,
+                           const std::string& saleId, const std::string& salePrice);
@@ -1,4 +1,5 @@
 #include "test_drive.h"
+#include "../../utils/civil_date.h"
 
 
 //getters and setters
@@ -21,24 +22,8 @@ string TestDrive::getVehicleId() const{
 	return vehicleId;
 }
 bool TestDrive::isDateValid(const string& date) {
-	//implement date validation logic here (YYYY-MM-DD)
-	static const std::regex pattern(R"(^\d{4}-\d{2}-\d{2}$)");
-	if (!std::regex_match(date, pattern))
-		return false;
-
-	int y, m, d;
-	if (sscanf(date.c_str(), "%d-%d-%d", &y, &m, &d) != 3)
-		return false;
-
-	if (m < 1 || m > 12)
-		return false;
-
-	if (d < 1 || d > 31)
-		return false;
-
-	return true;
-
-	return true;
+	// YYYY-MM-DD and a real calendar day (no 2024-02-30)
+	return isValidDate(date);
 }
 void TestDrive::setDate(std::string date) {
 	//if time is not past today return error
@@ -2,7 +2,6 @@
 #pragma once
 #include <chrono>
 #include <string>
-#include <regex>
 #include <iostream>
 #include "../../external/crow/crow_all.h"
 using namespace std;
@@ -1,8 +1,17 @@
 ﻿#include "test_drive_service.h"
 #include "../../db/db_connection.h"
+#include "../../utils/uuid.h"
 
 TestDriveService::TestDriveService(ConnectionGuard& g) : guard(g) {}
 
+namespace {
+    // Test drives appear in GET /customers/<id>/overview, whose ETag follows
+    // the customer's version.
+    void bumpCustomerVersion(pqxx::work& txn, const std::string& customerId) {
+        txn.exec_params("UPDATE customers SET version = version + 1 WHERE id = $1", customerId);
+    }
+}
+
 crow::json::wvalue TestDriveService::getAllTestDrives() {
     pqxx::work txn(guard.get());
     pqxx::result r = txn.exec(
@@ -29,13 +38,15 @@ crow::json::wvalue TestDriveService::getAllTestDrives() {
 crow::json::wvalue TestDriveService::addTestDrive(const TestDrive& testDrive) {
     pqxx::work txn(guard.get());
     pqxx::result r = txn.exec_params(
-        "INSERT INTO test_drive_record (customer_id, vehicle_id, date, comments) "
-        "VALUES ($1, $2, $3, $4) RETURNING id, customer_id, vehicle_id, date",
+        "INSERT INTO test_drive_record (id, customer_id, vehicle_id, date, comments) "
+        "VALUES ($1, $2, $3, $4, $5) RETURNING id, customer_id, vehicle_id, date",
+        newUuidV7(),
         testDrive.getCustomerId(),
         testDrive.getVehicleId(),
         testDrive.getDate(),
         testDrive.getComment()
     );
+    bumpCustomerVersion(txn, r[0]["customer_id"].c_str());
     txn.commit();
     return getTestDriveByTestId(r[0]["id"].c_str());
 }
@@ -61,6 +72,7 @@ crow::json::wvalue TestDriveService::updateTestDrive(const TestDrive& testDrive)
             "RETURNING id, customer_id, vehicle_id, date, comments",
             testDrive.getComment(), testDrive.getTestDriveId());
     }
+    if (!r.empty()) bumpCustomerVersion(txn, r[0]["customer_id"].c_str());
     txn.commit();
 
     if (r.empty()) return result;
@@ -0,0 +1,19 @@
+#include "civil_date.h"
+
+// Compile-time checks of the conversions against known dates.
+static_assert(daysFromCivil({1970, 1, 1}) == 0);
+static_assert(daysFromCivil({2000, 3, 1}) == 11017);
+static_assert(civilFromDays(-1) == CivilDate{1969, 12, 31});
+static_assert(civilFromDays(daysFromCivil({2024, 2, 29})) == CivilDate{2024, 2, 29});
+static_assert(isoWeekday(0) == 4);
+static_assert(isValidDate("2024-02-29") && !isValidDate("2023-02-29"));
+
+std::string toDateString(const CivilDate& date) {
+    std::string out(10, '\0');
+    formatDate(date, out.data());
+    return out;
+}
+
+std::string toDateString(int days) {
+    return toDateString(civilFromDays(days));
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Proleptic Gregorian calendar dates without time zones.
+//
+// Sale and test-drive dates are plain calendar days, so they are handled as
+// day counts (days since 1970-01-01) rather than through std::tm, mktime and
+// gmtime. That keeps every function here pure integer arithmetic: no locale,
+// no shared static buffers (safe on any thread), and no local-time or DST
+// shift moving a date across a day or week boundary.
+//
+// Conversions use Howard Hinnant's days_from_civil / civil_from_days
+// algorithms, valid for every year this module accepts (0000-9999).
+//
+// Everything is constexpr, so the same code validates literals at compile
+// time and runs allocation-free at request time; only toDateString()
+// allocates, for the std::string it returns.
+
+struct CivilDate {
+    int year = 1970;
+    int month = 1;  // 1-12
+    int day = 1;    // 1-31
+
+    friend constexpr bool operator==(const CivilDate&, const CivilDate&) = default;
+};
+
+constexpr bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+// Days in `month` (1-12) of `year`.
+constexpr int daysInMonth(int year, int month) {
+    constexpr int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return DAYS[month - 1] + (month == 2 && isLeapYear(year) ? 1 : 0);
+}
+
+namespace civil_detail {
+    constexpr bool digits(std::string_view text, size_t from, size_t count, int& value) {
+        value = 0;
+        for (size_t i = from; i < from + count; ++i) {
+            if (text[i] < '0' || text[i] > '9') return false;
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    }
+
+    constexpr void writeDigits(char* out, int value, int width) {
+        for (int i = width - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+}
+
+// Parses a strict "YYYY-MM-DD" calendar date (exactly ten characters, real
+// day of the month, leap years honoured).
+constexpr std::optional<CivilDate> parseDate(std::string_view text) {
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-') return std::nullopt;
+    CivilDate date;
+    if (!civil_detail::digits(text, 0, 4, date.year) ||
+        !civil_detail::digits(text, 5, 2, date.month) ||
+        !civil_detail::digits(text, 8, 2, date.day)) {
+        return std::nullopt;
+    }
+    if (date.month < 1 || date.month > 12) return std::nullopt;
+    if (date.day < 1 || date.day > daysInMonth(date.year, date.month)) return std::nullopt;
+    return date;
+}
+
+// Parses "YYYY-MM", or the year and month of a "YYYY-MM-DD" date, into a
+// CivilDate on the first of that month.
+constexpr std::optional<CivilDate> parseYearMonth(std::string_view text) {
+    if (text.size() == 10) {
+        auto date = parseDate(text);
+        if (!date) return std::nullopt;
+        return CivilDate{date->year, date->month, 1};
+    }
+    if (text.size() != 7 || text[4] != '-') return std::nullopt;
+    CivilDate date;
+    if (!civil_detail::digits(text, 0, 4, date.year) ||
+        !civil_detail::digits(text, 5, 2, date.month) ||
+        date.month < 1 || date.month > 12) {
+        return std::nullopt;
+    }
+    return date;
+}
+
+constexpr bool isValidDate(std::string_view text) {
+    return parseDate(text).has_value();
+}
+
+// Days since 1970-01-01 (negative before it).
+constexpr int daysFromCivil(const CivilDate& date) {
+    const int y = date.year - (date.month <= 2 ? 1 : 0);
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;                                              // [0, 399]
+    const int doy = (153 * (date.month + (date.month > 2 ? -3 : 9)) + 2) / 5 + date.day - 1;  // [0, 365]
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                      // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+// Inverse of daysFromCivil().
+constexpr CivilDate civilFromDays(int days) {
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const int doe = days - era * 146097;                                        // [0, 146096]
+    const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;      // [0, 399]
+    const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                    // [0, 365]
+    const int mp = (5 * doy + 2) / 153;                                         // [0, 11]
+    const int day = doy - (153 * mp + 2) / 5 + 1;
+    const int month = mp < 10 ? mp + 3 : mp - 9;
+    return CivilDate{yoe + era * 400 + (month <= 2 ? 1 : 0), month, day};
+}
+
+// ISO weekday: 1 = Monday ... 7 = Sunday.
+constexpr int isoWeekday(int days) {
+    // 1970-01-01 was a Thursday.
+    const int fromMonday = ((days % 7) + 7 + 3) % 7;
+    return fromMonday + 1;
+}
+
+// Day count of the Monday starting the ISO week that contains `days`.
+constexpr int weekStart(int days) {
+    return days - (isoWeekday(days) - 1);
+}
+
+// Months since 1970-01, the bucket key of monthly aggregates.
+constexpr int monthIndex(const CivilDate& date) {
+    return (date.year - 1970) * 12 + (date.month - 1);
+}
+
+// First day of the month `index` months after 1970-01.
+constexpr CivilDate monthFromIndex(int index) {
+    const int year = 1970 + (index >= 0 ? index / 12 : (index - 11) / 12);
+    return CivilDate{year, index - (year - 1970) * 12 + 1, 1};
+}
+
+// Writes "YYYY-MM-DD" into out[0..9] (no terminator).
+constexpr void formatDate(const CivilDate& date, char* out) {
+    civil_detail::writeDigits(out, date.year, 4);
+    out[4] = '-';
+    civil_detail::writeDigits(out + 5, date.month, 2);
+    out[7] = '-';
+    civil_detail::writeDigits(out + 8, date.day, 2);
+}
+
+std::string toDateString(const CivilDate& date);
+
+// "YYYY-MM-DD" of a day count.
+std::string toDateString(int days);
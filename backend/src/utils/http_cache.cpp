@@ -0,0 +1,163 @@
+#include "http_cache.h"
+#include "civil_date.h"
+#include <charconv>
+#include <cstdio>
+#include <cstdint>
+
+std::string contentETag(std::string_view body) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : body) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+
+    static const char HEX[] = "0123456789abcdef";
+    std::string tag(18, '"');
+    for (int i = 0; i < 16; ++i) {
+        tag[16 - i] = HEX[(h >> (i * 4)) & 0xF];
+    }
+    return tag;
+}
+
+namespace {
+    std::string_view stripWeak(std::string_view tag) {
+        if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+        return tag;
+    }
+}
+
+bool ifNoneMatchHits(const crow::request& req, const std::string& etag) {
+    const std::string& header = req.get_header_value("If-None-Match");
+    if (header.empty()) return false;
+
+    std::string_view wanted = stripWeak(etag);
+    std::string_view rest = header;
+    while (!rest.empty()) {
+        size_t comma = rest.find(',');
+        std::string_view item = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+
+        if (item == "*" || stripWeak(item) == wanted) return true;
+    }
+    return false;
+}
+
+crow::response notModified(const std::string& etag) {
+    crow::response res(304);
+    res.set_header("ETag", etag);
+    return res;
+}
+
+namespace {
+    const char* const WEEKDAYS[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+    const char* const MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    bool parseNumber(std::string_view text, uint64_t& value) {
+        if (text.empty()) return false;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc{} && end == text.data() + text.size();
+    }
+
+    std::string_view trim(std::string_view text) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) text.remove_suffix(1);
+        return text;
+    }
+}
+
+std::string httpDate(int64_t epochSeconds) {
+    int64_t days = epochSeconds / 86400;
+    int64_t secs = epochSeconds % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        --days;
+    }
+    const CivilDate date = civilFromDays(static_cast<int>(days));
+
+    char buf[64];
+    std::snprintf(buf, sizeof buf, "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                  WEEKDAYS[isoWeekday(static_cast<int>(days)) - 1], date.day, MONTHS[date.month - 1], date.year,
+                  static_cast<int>(secs / 3600), static_cast<int>(secs / 60 % 60), static_cast<int>(secs % 60));
+    return buf;
+}
+
+std::optional<int64_t> parseHttpDate(std::string_view text) {
+    // "Sun, 06 Nov 1994 08:49:37 GMT"
+    //  0123456789012345678901234567890
+    if (text.size() != 29 || text.substr(3, 2) != ", " || text[7] != ' ' || text[11] != ' ' ||
+        text[16] != ' ' || text[19] != ':' || text[22] != ':' || text.substr(25) != " GMT") {
+        return std::nullopt;
+    }
+
+    int month = 0;
+    for (int m = 0; m < 12; ++m) {
+        if (text.substr(8, 3) == MONTHS[m]) month = m + 1;
+    }
+    uint64_t day, year, hour, minute, second;
+    if (month == 0 || !parseNumber(text.substr(5, 2), day) || !parseNumber(text.substr(12, 4), year) ||
+        !parseNumber(text.substr(17, 2), hour) || !parseNumber(text.substr(20, 2), minute) ||
+        !parseNumber(text.substr(23, 2), second)) {
+        return std::nullopt;
+    }
+    if (day < 1 || static_cast<int>(day) > daysInMonth(static_cast<int>(year), month) || hour > 23 ||
+        minute > 59 || second > 60) {
+        return std::nullopt;
+    }
+
+    const int64_t days = daysFromCivil(CivilDate{static_cast<int>(year), month, static_cast<int>(day)});
+    return days * 86400 + static_cast<int64_t>(hour * 3600 + minute * 60 + second);
+}
+
+bool notModifiedSince(const crow::request& req, int64_t lastModified) {
+    // If-None-Match takes precedence; a client that sent one and missed
+    // must get the full response.
+    if (!req.get_header_value("If-None-Match").empty()) return false;
+    const std::string& header = req.get_header_value("If-Modified-Since");
+    if (header.empty()) return false;
+    std::optional<int64_t> since = parseHttpDate(trim(header));
+    return since.has_value() && lastModified <= *since;
+}
+
+RangeStatus parseRange(std::string_view header, uint64_t size, ByteRange& range) {
+    header = trim(header);
+    if (header.substr(0, 6) != "bytes=") return RangeStatus::Full;
+    std::string_view spec = trim(header.substr(6));
+    if (spec.find(',') != std::string_view::npos) return RangeStatus::Full;
+
+    const size_t dash = spec.find('-');
+    if (dash == std::string_view::npos) return RangeStatus::Full;
+    std::string_view firstText = spec.substr(0, dash);
+    std::string_view lastText = spec.substr(dash + 1);
+
+    uint64_t first = 0, last = 0;
+    if (firstText.empty()) {
+        // Suffix range: the final `last` bytes.
+        if (!parseNumber(lastText, last)) return RangeStatus::Full;
+        if (last == 0 || size == 0) return RangeStatus::Unsatisfiable;
+        range.first = last >= size ? 0 : size - last;
+        range.last = size - 1;
+        return RangeStatus::Partial;
+    }
+
+    if (!parseNumber(firstText, first)) return RangeStatus::Full;
+    if (lastText.empty()) {
+        last = UINT64_MAX;
+    } else if (!parseNumber(lastText, last) || last < first) {
+        return RangeStatus::Full;
+    }
+    if (first >= size) return RangeStatus::Unsatisfiable;
+    range.first = first;
+    range.last = last >= size ? size - 1 : last;
+    return RangeStatus::Partial;
+}
+
+bool ifRangeHolds(const crow::request& req, const std::string& etag, const std::string& lastModified) {
+    std::string_view header = trim(req.get_header_value("If-Range"));
+    if (header.empty()) return true;
+    if (header.front() == '"' || header.substr(0, 2) == "W/") return header == etag;
+    return header == lastModified;
+}
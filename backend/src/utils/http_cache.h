@@ -0,0 +1,57 @@
+#pragma once
+#include "../external/crow/crow_all.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Helpers for HTTP validators (ETag / If-None-Match, Last-Modified /
+// If-Modified-Since) and byte ranges shared by the modules.
+
+// Strong ETag derived from the response bytes (64-bit FNV-1a, quoted hex).
+std::string contentETag(std::string_view body);
+
+// True when the request's If-None-Match lists `etag` (or "*"), i.e. the
+// client's copy is current and a 304 can be returned. Weak comparison, as
+// RFC 9110 requires for If-None-Match.
+bool ifNoneMatchHits(const crow::request& req, const std::string& etag);
+
+// Builds a 304 Not Modified carrying the validator.
+crow::response notModified(const std::string& etag);
+
+// IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT") for Last-Modified.
+std::string httpDate(int64_t epochSeconds);
+
+// Seconds since the epoch of an IMF-fixdate, or nullopt. The obsolete
+// RFC 850 and asctime forms are not accepted; a client sending them just
+// gets a full response.
+std::optional<int64_t> parseHttpDate(std::string_view text);
+
+// True when the request has no If-None-Match and its If-Modified-Since is
+// not older than `lastModified` (RFC 9110 13.1.3).
+bool notModifiedSince(const crow::request& req, int64_t lastModified);
+
+// Inclusive byte range of a representation.
+struct ByteRange {
+    uint64_t first = 0;
+    uint64_t last = 0;
+
+    uint64_t length() const { return last - first + 1; }
+};
+
+enum class RangeStatus {
+    Full,           // no usable Range: send the whole representation (200)
+    Partial,        // send `range` (206)
+    Unsatisfiable,  // the range lies past the end (416)
+};
+
+// Interprets a Range header against a representation of `size` bytes.
+// Handles one "bytes=first-last", "bytes=first-" or "bytes=-suffix" range;
+// anything else (other units, several ranges, malformed values) is ignored
+// and yields Full, which RFC 9110 permits.
+RangeStatus parseRange(std::string_view header, uint64_t size, ByteRange& range);
+
+// True when the request's If-Range (if any) still matches the current
+// representation, i.e. its Range may be honoured. An entity tag must match
+// `etag` exactly (strong comparison); a date must equal `lastModified`.
+bool ifRangeHolds(const crow::request& req, const std::string& etag, const std::string& lastModified);
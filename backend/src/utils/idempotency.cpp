@@ -0,0 +1,360 @@
+#include "idempotency.h"
+#include "http_cache.h"
+#include "../db/db_connection.h"
+#include <algorithm>
+#include <atomic>
+
+IdempotencyCache::IdempotencyCache(std::chrono::seconds ttl, size_t maxEntriesPerShard)
+    : ttl(ttl), maxEntriesPerShard(maxEntriesPerShard) {}
+
+IdempotencyCache::Shard& IdempotencyCache::shardFor(const std::string& key) {
+    return shards[std::hash<std::string>{}(key) % SHARDS];
+}
+
+void IdempotencyCache::expire(Shard& shard, Clock::time_point now) {
+    while (!shard.expiry.empty() &&
+           (shard.expiry.front().first <= now || shard.entries.size() > maxEntriesPerShard)) {
+        auto [at, key] = std::move(shard.expiry.front());
+        shard.expiry.pop_front();
+        auto it = shard.entries.find(key);
+        // A completed or re-claimed key was queued again with a later time.
+        if (it != shard.entries.end() && it->second.expiresAt <= at) shard.entries.erase(it);
+    }
+}
+
+void IdempotencyCache::store(Shard& shard, const std::string& key, Entry entry) {
+    shard.expiry.emplace_back(entry.expiresAt, key);
+    shard.entries[key] = std::move(entry);
+}
+
+// Drops the queued expiry of `key` at `at`, so released and re-stored keys
+// leave nothing behind in the queue. The queue is in time order, so the
+// record is found by binary search, and it is recent, so the erase is short.
+void IdempotencyCache::unqueue(Shard& shard, const std::string& key, Clock::time_point at) {
+    auto it = std::lower_bound(shard.expiry.begin(), shard.expiry.end(), at,
+                               [](const auto& queued, Clock::time_point t) { return queued.first < t; });
+    for (; it != shard.expiry.end() && it->first == at; ++it) {
+        if (it->second == key) {
+            shard.expiry.erase(it);
+            return;
+        }
+    }
+}
+
+IdempotencyCache::Lookup IdempotencyCache::claim(const std::string& key, const std::string& fingerprint,
+                                                 Clock::time_point now) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    expire(shard, now);
+
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+        if (it->second.fingerprint != fingerprint) return {State::Mismatch, {}};
+        if (!it->second.completed) return {State::InFlight, {}};
+        return {State::Completed, it->second.response};
+    }
+
+    Entry entry;
+    entry.fingerprint = fingerprint;
+    entry.expiresAt = now + ttl;
+    store(shard, key, std::move(entry));
+    return {State::Claimed, {}};
+}
+
+void IdempotencyCache::complete(const std::string& key, StoredResponse response, Clock::time_point now) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) return;
+
+    unqueue(shard, key, it->second.expiresAt);
+    Entry entry = std::move(it->second);
+    entry.completed = true;
+    entry.response = std::move(response);
+    entry.expiresAt = now + ttl;
+    store(shard, key, std::move(entry));
+}
+
+void IdempotencyCache::remember(const std::string& key, const std::string& fingerprint,
+                                StoredResponse response, Clock::time_point now) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) unqueue(shard, key, it->second.expiresAt);
+
+    Entry entry;
+    entry.fingerprint = fingerprint;
+    entry.completed = true;
+    entry.response = std::move(response);
+    entry.expiresAt = now + ttl;
+    store(shard, key, std::move(entry));
+}
+
+void IdempotencyCache::release(const std::string& key) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) return;
+    unqueue(shard, key, it->second.expiresAt);
+    shard.entries.erase(it);
+}
+
+size_t IdempotencyCache::size() {
+    size_t total = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+namespace {
+    // How long a completed key is replayed.
+    constexpr std::chrono::hours IDEMPOTENCY_TTL{24};
+    // How long a claim whose request never finished (crashed instance) blocks the key.
+    constexpr int IDEMPOTENCY_LEASE_SECONDS = 300;
+    // In-process keys per shard before the oldest are dropped (the table still has them).
+    constexpr size_t IDEMPOTENCY_SHARD_CAPACITY = 8192;
+    // One database claim in this many also purges every expired key.
+    constexpr unsigned PURGE_EVERY = 1000;
+
+    const char* EXPIRE_KEY_SQL =
+        "DELETE FROM Idempotency_Keys WHERE scope = $1 AND key = $2 AND expires_at < now()";
+
+    const char* CLAIM_SQL =
+        "INSERT INTO Idempotency_Keys (scope, key, request_hash, expires_at) "
+        "VALUES ($1, $2, $3, now() + make_interval(secs => $4)) "
+        "ON CONFLICT (scope, key) DO NOTHING RETURNING 1";
+
+    const char* EXISTING_SQL =
+        "SELECT request_hash, status_code, response_body, content_type, response_headers "
+        "FROM Idempotency_Keys WHERE scope = $1 AND key = $2";
+
+    const char* COMPLETE_SQL =
+        "UPDATE Idempotency_Keys SET status_code = $3, response_body = $4, content_type = $5, "
+        "response_headers = $6, expires_at = now() + make_interval(secs => $7) "
+        "WHERE scope = $1 AND key = $2";
+
+    const char* RELEASE_SQL =
+        "DELETE FROM Idempotency_Keys WHERE scope = $1 AND key = $2 AND status_code IS NULL";
+
+    IdempotencyCache& idempotencyCache() {
+        static IdempotencyCache cache(IDEMPOTENCY_TTL, IDEMPOTENCY_SHARD_CAPACITY);
+        return cache;
+    }
+
+    bool isValidKey(const std::string& key) {
+        if (key.empty() || key.size() > 255) return false;
+        for (unsigned char c : key) {
+            if (c < 0x21 || c > 0x7e) return false;
+        }
+        return true;
+    }
+
+    crow::response jsonError(int status, const std::string& message) {
+        crow::json::wvalue error;
+        error["error"] = message;
+        return crow::response(status, error);
+    }
+
+    StoredResponse storedFrom(const crow::response& res) {
+        StoredResponse stored;
+        stored.status = res.code;
+        stored.body = res.body;
+        stored.headers.assign(res.headers.begin(), res.headers.end());
+        return stored;
+    }
+
+    std::string headerOf(const StoredResponse& stored, const std::string& name) {
+        for (const auto& [header, value] : stored.headers) {
+            if (crow::ci_key_eq{}(header, name)) return value;
+        }
+        return "";
+    }
+
+    // Headers are stored one "Name: value" per line.
+    std::string encodeHeaders(const StoredResponse& stored) {
+        std::string text;
+        for (const auto& [name, value] : stored.headers) text += name + ": " + value + "\n";
+        return text;
+    }
+
+    void decodeHeaders(const std::string& text, StoredResponse& stored) {
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos) end = text.size();
+            const size_t colon = text.find(": ", start);
+            if (colon != std::string::npos && colon < end) {
+                stored.headers.emplace_back(text.substr(start, colon - start), text.substr(colon + 2, end - colon - 2));
+            }
+            start = end + 1;
+        }
+    }
+
+    int ttlSeconds() {
+        return static_cast<int>(std::chrono::seconds(IDEMPOTENCY_TTL).count());
+    }
+
+    crow::response replay(const StoredResponse& stored) {
+        crow::response res(stored.status, stored.body);
+        for (const auto& [name, value] : stored.headers) res.add_header(name, value);
+        res.set_header("Idempotent-Replayed", "true");
+        return res;
+    }
+
+    enum class DbClaim { Claimed, InFlight, Mismatch, Completed };
+
+    // Claims the key in the table, or reports what an earlier request left there.
+    DbClaim claimInDatabase(const std::string& scope, const std::string& key,
+                            const std::string& fingerprint, StoredResponse& stored) {
+        static std::atomic<unsigned> claims{0};
+
+        ConnectionGuard guard(getPool());
+        guard.prepare("idempotency_expire", EXPIRE_KEY_SQL);
+        guard.prepare("idempotency_claim", CLAIM_SQL);
+        guard.prepare("idempotency_existing", EXISTING_SQL);
+        pqxx::work txn(guard.get());
+
+        if (++claims % PURGE_EVERY == 0) {
+            txn.exec("DELETE FROM Idempotency_Keys WHERE expires_at < now()");
+        } else {
+            txn.exec_prepared("idempotency_expire", scope, key);
+        }
+
+        DbClaim outcome = DbClaim::Claimed;
+        if (txn.exec_prepared("idempotency_claim", scope, key, fingerprint, IDEMPOTENCY_LEASE_SECONDS).empty()) {
+            pqxx::result existing = txn.exec_prepared("idempotency_existing", scope, key);
+            if (existing.empty()) {
+                outcome = DbClaim::InFlight;  // removed between our statements; let the client retry
+            } else if (existing[0]["request_hash"].c_str() != fingerprint) {
+                outcome = DbClaim::Mismatch;
+            } else if (existing[0]["status_code"].is_null()) {
+                outcome = DbClaim::InFlight;
+            } else {
+                stored.status = existing[0]["status_code"].as<int>();
+                stored.body = existing[0]["response_body"].c_str();
+                if (!existing[0]["response_headers"].is_null()) {
+                    decodeHeaders(existing[0]["response_headers"].c_str(), stored);
+                } else if (!existing[0]["content_type"].is_null()) {
+                    stored.headers.emplace_back("Content-Type", existing[0]["content_type"].c_str());  // row from before 013
+                }
+                outcome = DbClaim::Completed;
+            }
+        }
+        txn.commit();
+        return outcome;
+    }
+
+    void finishInDatabase(const std::string& scope, const std::string& key, const StoredResponse* stored) {
+        ConnectionGuard guard(getPool());
+        pqxx::work txn(guard.get());
+        if (stored) {
+            guard.prepare("idempotency_complete", COMPLETE_SQL);
+            txn.exec_prepared("idempotency_complete", scope, key, stored->status, stored->body,
+                              headerOf(*stored, "Content-Type"), encodeHeaders(*stored), ttlSeconds());
+        } else {
+            guard.prepare("idempotency_release", RELEASE_SQL);
+            txn.exec_prepared("idempotency_release", scope, key);
+        }
+        txn.commit();
+    }
+}
+
+void IdempotentWrite::record(pqxx::transaction_base& txn, const crow::response& res) {
+    if (key.empty()) return;
+    response = storedFrom(res);
+    txn.exec_params(COMPLETE_SQL, scope, key, response.status, response.body,
+                    headerOf(response, "Content-Type"), encodeHeaders(response), ttlSeconds());
+    recorded = true;
+}
+
+crow::response withIdempotency(const crow::request& req, const std::string& scope,
+                               const std::function<crow::response(IdempotentWrite&)>& handler) {
+    const std::string& key = req.get_header_value("Idempotency-Key");
+    if (key.empty()) {
+        IdempotentWrite untracked;
+        return handler(untracked);
+    }
+    if (!isValidKey(key)) {
+        return jsonError(400, "Idempotency-Key must be 1-255 visible ASCII characters");
+    }
+
+    const std::string cacheKey = scope + '\n' + key;
+    const std::string fingerprint = contentETag(req.body);
+    IdempotencyCache& cache = idempotencyCache();
+
+    // Hot path: answered from memory without a connection.
+    IdempotencyCache::Lookup local = cache.claim(cacheKey, fingerprint);
+    switch (local.state) {
+        case IdempotencyCache::State::Completed:
+            return replay(local.response);
+        case IdempotencyCache::State::InFlight: {
+            crow::response busy = jsonError(409, "A request with this Idempotency-Key is still in progress");
+            busy.set_header("Retry-After", "1");
+            return busy;
+        }
+        case IdempotencyCache::State::Mismatch:
+            return jsonError(422, "Idempotency-Key was already used with a different request body");
+        case IdempotencyCache::State::Claimed:
+            break;
+    }
+
+    StoredResponse stored;
+    try {
+        switch (claimInDatabase(scope, key, fingerprint, stored)) {
+            case DbClaim::Completed:
+                cache.remember(cacheKey, fingerprint, stored);
+                return replay(stored);
+            case DbClaim::InFlight: {
+                cache.release(cacheKey);
+                crow::response busy = jsonError(409, "A request with this Idempotency-Key is still in progress");
+                busy.set_header("Retry-After", "1");
+                return busy;
+            }
+            case DbClaim::Mismatch:
+                cache.release(cacheKey);
+                return jsonError(422, "Idempotency-Key was already used with a different request body");
+            case DbClaim::Claimed:
+                break;
+        }
+    } catch (const std::exception& e) {
+        cache.release(cacheKey);
+        CROW_LOG_ERROR << "Idempotency claim failed for " << scope << ": " << e.what();
+        return jsonError(503, "Idempotency store unavailable");
+    }
+
+    IdempotentWrite write(scope, key);
+    crow::response res = [&] {
+        try {
+            return handler(write);
+        } catch (...) {
+            cache.release(cacheKey);
+            try { finishInDatabase(scope, key, nullptr); } catch (...) {}
+            throw;
+        }
+    }();
+
+    if (res.code < 500 && write.recorded) {
+        // Stored by the handler's own transaction, which has committed.
+        cache.complete(cacheKey, std::move(write.response));
+        return res;
+    }
+
+    try {
+        if (res.code >= 500) {
+            cache.release(cacheKey);
+            finishInDatabase(scope, key, nullptr);
+        } else {
+            stored = storedFrom(res);
+            finishInDatabase(scope, key, &stored);
+            cache.complete(cacheKey, std::move(stored));
+        }
+    } catch (const std::exception& e) {
+        // Keep the key blocked here rather than free to run again: the
+        // response stands, and this instance replays it until the TTL ends.
+        CROW_LOG_ERROR << "Idempotency completion failed for " << scope << ": " << e.what();
+        if (res.code < 500) cache.complete(cacheKey, storedFrom(res));
+    }
+    return res;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "../external/crow/crow_all.h"
+#include <pqxx/pqxx>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Idempotency-Key support for create routes.
+//
+// A client that retries a POST with the same Idempotency-Key gets the first
+// attempt's response back instead of a second write. Keys live in two places:
+//   - IdempotencyCache, a sharded in-process map that answers hot repeats
+//     without touching the connection pool, and
+//   - the Idempotency_Keys table, which makes a key visible to other backend
+//     instances and survives restarts.
+// A key is bound to its route and to a hash of the request body; reusing it
+// for a different body is rejected with 422.
+
+struct StoredResponse {
+    int status = 0;
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers;  // Content-Type, ETag, Location, ...
+};
+
+// Sharded TTL map of keys in flight or completed.
+//
+// Every key is claimed before its request runs, so a concurrent duplicate in
+// the same process sees it in flight. Completed entries expire after the TTL;
+// each shard keeps its keys in expiry order (the TTL is fixed), so expiring
+// is a pop from the front rather than a scan.
+class IdempotencyCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class State { Claimed, InFlight, Completed, Mismatch };
+
+    struct Lookup {
+        State state;
+        StoredResponse response;    // set when Completed
+    };
+
+    IdempotencyCache(std::chrono::seconds ttl, size_t maxEntriesPerShard);
+
+    // Claims `key` for a request with body hash `fingerprint`, unless it is
+    // already in flight or completed.
+    Lookup claim(const std::string& key, const std::string& fingerprint, Clock::time_point now = Clock::now());
+
+    // Stores the response of a claimed key; it is replayed until the TTL ends.
+    void complete(const std::string& key, StoredResponse response, Clock::time_point now = Clock::now());
+
+    // Records a response found elsewhere (the database) for `key`.
+    void remember(const std::string& key, const std::string& fingerprint, StoredResponse response,
+                  Clock::time_point now = Clock::now());
+
+    // Drops a claim whose request failed, so a retry runs again.
+    void release(const std::string& key);
+
+    size_t size();
+
+private:
+    static constexpr size_t SHARDS = 16;
+
+    struct Entry {
+        std::string fingerprint;
+        bool completed = false;
+        StoredResponse response;
+        Clock::time_point expiresAt;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, Entry> entries;
+        std::deque<std::pair<Clock::time_point, std::string>> expiry;  // oldest first
+    };
+
+    Shard& shardFor(const std::string& key);
+    void expire(Shard& shard, Clock::time_point now);
+    void store(Shard& shard, const std::string& key, Entry entry);
+    void unqueue(Shard& shard, const std::string& key, Clock::time_point at);
+
+    const std::chrono::seconds ttl;
+    const size_t maxEntriesPerShard;
+    std::array<Shard, SHARDS> shards;
+};
+
+// Handed to a withIdempotency handler so it can store its response in the
+// same transaction as the write it reports. If that transaction commits, the
+// key is complete; if it rolls back, so does the stored response. Either way
+// a committed write can never be left behind a key that is free to run again.
+class IdempotentWrite {
+public:
+    // Stores `res` as the key's response inside `txn`. Call after building
+    // the response and right before committing. Does nothing when the
+    // request carries no Idempotency-Key.
+    void record(pqxx::transaction_base& txn, const crow::response& res);
+
+private:
+    friend crow::response withIdempotency(const crow::request&, const std::string&,
+                                          const std::function<crow::response(IdempotentWrite&)>&);
+
+    IdempotentWrite() = default;
+    IdempotentWrite(std::string scope, std::string key) : scope(std::move(scope)), key(std::move(key)) {}
+
+    std::string scope;
+    std::string key;                 // empty: no Idempotency-Key
+    bool recorded = false;
+    StoredResponse response;
+};
+
+// Runs `handler` at most once per Idempotency-Key within `scope` (e.g.
+// "POST /sales"). Without the header the handler simply runs. Replays carry
+// the stored status, body and headers plus "Idempotent-Replayed: true"; a
+// key still being processed gets 409, and a key reused with a different body
+// 422. 5xx results are not stored, so the client can retry them.
+crow::response withIdempotency(const crow::request& req, const std::string& scope,
+                               const std::function<crow::response(IdempotentWrite&)>& handler);
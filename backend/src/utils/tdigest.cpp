@@ -0,0 +1,147 @@
+#include "tdigest.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    // k1 scale: k(q) = compression / (2 pi) * asin(2q - 1). A centroid may
+    // span at most one unit of k.
+    double scaleK(double q, double compression) {
+        return compression / (2 * PI) * std::asin(2 * q - 1);
+    }
+
+    double inverseK(double k, double compression) {
+        return (std::sin(k * 2 * PI / compression) + 1) / 2;
+    }
+
+    // Most weight the centroids up to the next one may hold, given the weight
+    // before it. Past k = compression / 4 (q = 1) asin has no inverse, and
+    // the last centroid may take everything that is left.
+    double weightLimit(double weightSoFar, double totalWeight, double compression) {
+        const double q = std::clamp(weightSoFar / totalWeight, 0.0, 1.0);
+        const double k = scaleK(q, compression) + 1;
+        if (k >= compression / 4) return totalWeight;
+        return totalWeight * inverseK(k, compression);
+    }
+}
+
+TDigest::TDigest(double compression) : compression(compression) {}
+
+void TDigest::add(double value, double weight) {
+    if (std::isnan(value) || weight <= 0) return;
+    if (count() == 0) {
+        minValue = maxValue = value;
+    } else {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+    buffer.push_back({value, weight});
+    bufferWeight += weight;
+    if (buffer.size() >= static_cast<size_t>(5 * compression)) mergeBuffer();
+}
+
+void TDigest::merge(const TDigest& other) {
+    if (other.count() == 0) return;
+    if (count() == 0) {
+        minValue = other.minValue;
+        maxValue = other.maxValue;
+    } else {
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+    for (const auto& c : other.centroids) buffer.push_back(c);
+    for (const auto& c : other.buffer) buffer.push_back(c);
+    bufferWeight += other.count();
+    mergeBuffer();
+}
+
+void TDigest::mergeBuffer() const {
+    if (buffer.empty()) return;
+
+    buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+    std::sort(buffer.begin(), buffer.end(),
+              [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    totalWeight += bufferWeight;
+    bufferWeight = 0;
+
+    std::vector<Centroid> merged;
+    merged.reserve(std::min(buffer.size(), static_cast<size_t>(compression * PI / 2) + 2));
+
+    double weightSoFar = 0;
+    double limit = weightLimit(0, totalWeight, compression);
+    Centroid current = buffer.front();
+    for (size_t i = 1; i < buffer.size(); ++i) {
+        const Centroid& next = buffer[i];
+        if (weightSoFar + current.weight + next.weight <= limit) {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        } else {
+            weightSoFar += current.weight;
+            merged.push_back(current);
+            limit = weightLimit(weightSoFar, totalWeight, compression);
+            current = next;
+        }
+    }
+    merged.push_back(current);
+
+    centroids.swap(merged);
+    buffer.clear();
+}
+
+void TDigest::compress() {
+    mergeBuffer();
+    buffer.shrink_to_fit();
+}
+
+size_t TDigest::centroidCount() const {
+    mergeBuffer();
+    return centroids.size();
+}
+
+size_t TDigest::memoryBytes() const {
+    return sizeof(*this) + (centroids.capacity() + buffer.capacity()) * sizeof(Centroid);
+}
+
+double TDigest::quantile(double q) const {
+    mergeBuffer();
+    if (centroids.empty()) return 0;
+    if (centroids.size() == 1) return centroids.front().mean;
+
+    q = std::clamp(q, 0.0, 1.0);
+
+    // Nothing merged yet: every centroid is one value, so answer exactly the
+    // way percentile_cont does.
+    if (static_cast<double>(centroids.size()) == totalWeight) {
+        const double rank = q * (totalWeight - 1);
+        const size_t lo = static_cast<size_t>(rank);
+        if (lo + 1 >= centroids.size()) return centroids.back().mean;
+        return centroids[lo].mean + (centroids[lo + 1].mean - centroids[lo].mean) * (rank - lo);
+    }
+
+    const double index = q * totalWeight;
+
+    // Each centroid's mean is taken to sit at the middle of its weight; the
+    // sample minimum and maximum anchor both ends.
+    const Centroid& first = centroids.front();
+    if (index <= first.weight / 2) {
+        return minValue + (first.mean - minValue) * (index / (first.weight / 2));
+    }
+
+    double position = first.weight / 2;
+    for (size_t i = 0; i + 1 < centroids.size(); ++i) {
+        const Centroid& a = centroids[i];
+        const Centroid& b = centroids[i + 1];
+        const double gap = (a.weight + b.weight) / 2;
+        if (index <= position + gap) {
+            return a.mean + (b.mean - a.mean) * ((index - position) / gap);
+        }
+        position += gap;
+    }
+
+    const Centroid& last = centroids.back();
+    const double tail = last.weight / 2;
+    return last.mean + (maxValue - last.mean) * std::min(1.0, (index - position) / tail);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Mergeable quantile sketch (Dunning's merging t-digest, k1 scale function).
+//
+// Values are summarized as weighted centroids. The scale function allows big
+// centroids near the median and forces small ones at the tails, so extreme
+// quantiles stay accurate while the sketch size stays bounded. Digests built
+// separately (per month, per model) can be merged into one digest of the union.
+//
+// Accuracy at compression 100 (the default), measured by TDigestBench against
+// exact quantiles of 1M uniform, normal and log-normal prices:
+//   - up to about 50 values every value is its own centroid and the result
+//     equals the exact percentile_cont interpolation,
+//   - rank error at p50 is under 0.25% of n, and under 0.1% at p01/p10/p90/p99
+//     (the scale function makes tail centroids small),
+//   - digests merged from parts stay within the same bounds.
+// Errors are in rank, not value: across a gap in the data a quantile is
+// interpolated between neighbouring centroids.
+//
+// Memory: about compression * pi / 2 centroids at most (~160 x 16 bytes, so
+// 2.5 KB) however many values were added; small digests hold one 16-byte
+// centroid per value. Adds are staged in a buffer of up to 5 * compression
+// entries (8 KB) that compress() releases.
+class TDigest {
+public:
+    explicit TDigest(double compression = 100.0);
+
+    // Adds a value with the given weight.
+    void add(double value, double weight = 1.0);
+
+    // Adds every centroid of `other`; the result summarizes both inputs.
+    void merge(const TDigest& other);
+
+    // Estimated value at quantile q in [0, 1] (0 when empty). Linear
+    // interpolation between centroid centres, like percentile_cont.
+    double quantile(double q) const;
+
+    // Total weight added.
+    double count() const { return totalWeight + bufferWeight; }
+    double min() const { return minValue; }
+    double max() const { return maxValue; }
+
+    // Number of centroids after compression.
+    size_t centroidCount() const;
+
+    // Folds the unmerged buffer into the centroids and frees the buffer.
+    void compress();
+
+    // Approximate heap bytes held by the sketch.
+    size_t memoryBytes() const;
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    void mergeBuffer() const;
+
+    double compression;
+    mutable std::vector<Centroid> centroids;
+    mutable std::vector<Centroid> buffer;
+    mutable double totalWeight = 0;
+    mutable double bufferWeight = 0;
+    double minValue = 0;
+    double maxValue = 0;
+};
@@ -0,0 +1,85 @@
+#include "uuid.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace {
+    // (unix_ms << 12) | sequence of the last issued ID.
+    std::atomic<uint64_t> lastStamp{0};
+
+    uint64_t nextStamp() {
+        const uint64_t nowMs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        const uint64_t now = nowMs << 12;
+
+        uint64_t prev = lastStamp.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            next = now > prev ? now : prev + 1;
+        } while (!lastStamp.compare_exchange_weak(prev, next, std::memory_order_relaxed));
+        return next;
+    }
+
+    // splitmix64, seeded once per thread from the OS entropy source.
+    uint64_t randomBits() {
+        thread_local uint64_t state = [] {
+            std::random_device rd;
+            uint64_t seed = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+            return seed ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+        }();
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+}
+
+void newUuidV7(char* out) {
+    const uint64_t stamp = nextStamp();
+    const uint64_t millis = stamp >> 12;
+    const uint64_t sequence = stamp & 0xFFF;
+    const uint64_t random = randomBits();
+
+    uint8_t bytes[16];
+    for (int i = 0; i < 6; ++i) {
+        bytes[i] = static_cast<uint8_t>(millis >> (40 - 8 * i));
+    }
+    bytes[6] = static_cast<uint8_t>(0x70 | (sequence >> 8));
+    bytes[7] = static_cast<uint8_t>(sequence);
+    bytes[8] = static_cast<uint8_t>(0x80 | ((random >> 56) & 0x3F));
+    for (int i = 9; i < 16; ++i) {
+        bytes[i] = static_cast<uint8_t>(random >> (8 * (15 - i)));
+    }
+
+    static const char HEX[] = "0123456789abcdef";
+    int pos = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) out[pos++] = '-';
+        out[pos++] = HEX[bytes[i] >> 4];
+        out[pos++] = HEX[bytes[i] & 0xF];
+    }
+}
+
+std::string newUuidV7() {
+    std::string id(36, '\0');
+    newUuidV7(id.data());
+    return id;
+}
+
+uint64_t uuidV7Millis(const std::string& uuid) {
+    if (uuid.size() != 36 || uuid[8] != '-' || uuid[14] != '7') return 0;
+    uint64_t millis = 0;
+    for (size_t i = 0; i < 13; ++i) {
+        if (i == 8) continue;
+        char c = uuid[i];
+        int v = (c >= '0' && c <= '9') ? c - '0'
+              : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+              : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (v < 0) return 0;
+        millis = (millis << 4) | static_cast<uint64_t>(v);
+    }
+    return millis;
+}
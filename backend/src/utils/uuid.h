@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Time-ordered UUIDv7 identifiers (RFC 9562) generated in-process.
+//
+// Layout: 48-bit Unix milliseconds | version 7 | 12-bit sequence | variant |
+// 62 random bits. The millisecond+sequence prefix comes from one atomic
+// counter, so IDs are strictly increasing across all threads of the process
+// (if more than 4096 IDs are requested within a millisecond the prefix runs
+// ahead of the clock until it catches up). Random bits come from a per-thread
+// generator, so no lock is taken.
+//
+// Ascending keys make B-tree inserts append to the right-most leaf instead of
+// splitting random pages, which keeps primary-key indexes dense and hot.
+
+// Returns a new UUIDv7 in canonical 36-character form.
+std::string newUuidV7();
+
+// Writes a new UUIDv7 in canonical form into out[0..35] (no terminator).
+void newUuidV7(char* out);
+
+// Unix milliseconds embedded in a canonical UUIDv7 string (0 if malformed).
+uint64_t uuidV7Millis(const std::string& uuid);
@@ -0,0 +1,103 @@
+#pragma once
+#include <string_view>
+
+// Format validators for customer and vehicle fields.
+//
+// Each check is a single pass over the input with no allocation, and all of
+// them are constexpr, so formats can be pinned down with static_assert and
+// bulk paths can validate millions of values per second. They accept exactly
+// what the std::regex patterns they replace accepted (the same patterns the
+// frontend forms use), so moving a check between client and server never
+// changes its answer.
+
+namespace validator_detail {
+    constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    // ECMAScript \s for ASCII input: space, \t, \n, \v, \f, \r.
+    constexpr bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+    // Value of a VIN character in the check-digit sum (ISO 3779 / 49 CFR
+    // 565), or -1 for characters a VIN may not contain (I, O, Q, lowercase).
+    constexpr int vinValue(char c) {
+        if (isDigit(c)) return c - '0';
+        switch (c) {
+            case 'A': case 'J':           return 1;
+            case 'B': case 'K': case 'S': return 2;
+            case 'C': case 'L': case 'T': return 3;
+            case 'D': case 'M': case 'U': return 4;
+            case 'E': case 'N': case 'V': return 5;
+            case 'F': case 'W':           return 6;
+            case 'G': case 'P': case 'X': return 7;
+            case 'H': case 'Y':           return 8;
+            case 'R': case 'Z':           return 9;
+            default:                      return -1;
+        }
+    }
+}
+
+// Phone number: exactly 10 digits, no separators (^\d{10}$).
+constexpr bool isValidPhone(std::string_view phone) {
+    if (phone.size() != 10) return false;
+    for (char c : phone) {
+        if (!validator_detail::isDigit(c)) return false;
+    }
+    return true;
+}
+
+// Ontario driving licence: "ON-" and 8 digits (^ON-\d{8}$). Callers
+// uppercase the input first.
+constexpr bool isValidLicence(std::string_view licence) {
+    if (licence.size() != 11 || licence.substr(0, 3) != "ON-") return false;
+    for (char c : licence.substr(3)) {
+        if (!validator_detail::isDigit(c)) return false;
+    }
+    return true;
+}
+
+// Basic email shape (^[^\s@]+@[^\s@]+\.[^\s@]+$): one '@' with text before
+// it, and a '.' after it that has text on both sides; no whitespace.
+constexpr bool isValidEmail(std::string_view email) {
+    size_t at = std::string_view::npos;
+    size_t lastDot = std::string_view::npos;
+    bool earlierDot = false;  // a usable '.' was seen before lastDot
+    for (size_t i = 0; i < email.size(); ++i) {
+        const char c = email[i];
+        if (validator_detail::isSpace(c)) return false;
+        if (c == '@') {
+            if (at != std::string_view::npos) return false;
+            at = i;
+        } else if (c == '.' && at != std::string_view::npos && i > at + 1) {
+            if (lastDot != std::string_view::npos) earlierDot = true;
+            lastDot = i;
+        }
+    }
+    if (at == std::string_view::npos || at == 0) return false;
+    // The last dot may end the address; an earlier one then serves.
+    return lastDot != std::string_view::npos && (lastDot + 1 < email.size() || earlierDot);
+}
+
+// 17 characters from the VIN alphabet (digits and A-Z without I, O, Q).
+// The vehicle routes check this shape alone on create and update: stored
+// and seeded VINs do not all carry a valid check digit.
+constexpr bool isVinFormat(std::string_view vin) {
+    if (vin.size() != 17) return false;
+    for (char c : vin) {
+        if (validator_detail::vinValue(c) < 0) return false;
+    }
+    return true;
+}
+
+// Full VIN check: format plus the North American check digit in position 9
+// (weighted sum of the transliterated characters mod 11, 10 written as 'X').
+constexpr bool isValidVin(std::string_view vin) {
+    constexpr int WEIGHTS[17] = {8, 7, 6, 5, 4, 3, 2, 10, 0, 9, 8, 7, 6, 5, 4, 3, 2};
+    if (vin.size() != 17) return false;
+    int sum = 0;
+    for (size_t i = 0; i < 17; ++i) {
+        const int value = validator_detail::vinValue(vin[i]);
+        if (value < 0) return false;
+        sum += value * WEIGHTS[i];
+    }
+    const int check = sum % 11;
+    return vin[8] == (check == 10 ? 'X' : static_cast<char>('0' + check));
+}
@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include "../../src/modules/analytics/sales_facts.h"
+#include <cstdio>
+#include <vector>
+
+namespace {
+    SaleFact makeFact(const std::string& id, const std::string& date, const std::string& make,
+                      const std::string& fuel, double price, double market) {
+        SaleFact f;
+        f.saleId = id;
+        f.date = date;
+        f.make = make;
+        f.model = make + " Base";
+        f.fuelType = fuel;
+        f.transmission = "Automatic";
+        f.vehicleYear = 2020;
+        f.salePrice = price;
+        f.marketPrice = market;
+        return f;
+    }
+
+    void load(SalesFactTable& table, const std::vector<SaleFact>& facts) {
+        table.reload([&](const SalesFactTable::Sink& sink) {
+            for (const auto& f : facts) sink(f);
+        });
+    }
+
+    const std::string ID1 = "01890a5d-ac96-774b-bcce-b302099a8057";
+    const std::string ID2 = "01890a5d-ac96-774b-bcce-b302099a8058";
+    const std::string ID3 = "01890a5d-ac96-774b-bcce-b302099a8059";
+}
+
+// ===== Dates =====
+TEST(AnalyticsTests, DayNumberKnownDates) {
+    int32_t day = -1;
+    ASSERT_TRUE(SalesFactTable::dayNumber("1970-01-01", day));
+    ASSERT_EQ(day, 0);
+    ASSERT_TRUE(SalesFactTable::dayNumber("2024-02-29", day));
+    ASSERT_EQ(day, 19782);
+    ASSERT_FALSE(SalesFactTable::dayNumber("2023-02-29", day));
+    ASSERT_FALSE(SalesFactTable::dayNumber("2024-1-05", day));
+}
+
+// ===== Aggregation =====
+TEST(AnalyticsTests, GroupsByMakeAndMonth) {
+    SalesFactTable table;
+    load(table, {
+        makeFact(ID1, "2024-01-10", "Honda", "Gasoline", 20000, 18000),
+        makeFact(ID2, "2024-01-20", "Honda", "Hybrid", 30000, 29000),
+        makeFact(ID3, "2024-02-01", "Ford", "Gasoline", 40000, 41000),
+    });
+
+    SalesFactTable::Query q;
+    q.groupBy = {SalesFactTable::Dimension::Make, SalesFactTable::Dimension::Month};
+    auto result = table.aggregate(q);
+
+    ASSERT_EQ(result.groups.size(), 2u);
+    ASSERT_EQ(result.groups[0].key, (std::vector<std::string>{"Ford", "2024-02"}));
+    ASSERT_EQ(result.groups[1].key, (std::vector<std::string>{"Honda", "2024-01"}));
+    ASSERT_EQ(result.groups[1].count, 2);
+    ASSERT_DOUBLE_EQ(result.groups[1].value(SalesFactTable::Metric::Revenue), 50000.0);
+    ASSERT_DOUBLE_EQ(result.groups[1].value(SalesFactTable::Metric::Profit), 3000.0);
+    ASSERT_DOUBLE_EQ(result.groups[1].value(SalesFactTable::Metric::MinPrice), 20000.0);
+    ASSERT_DOUBLE_EQ(result.groups[0].value(SalesFactTable::Metric::Profit), -1000.0);
+}
+
+TEST(AnalyticsTests, DateFilterAndUpsert) {
+    SalesFactTable table;
+    load(table, {
+        makeFact(ID1, "2024-01-10", "Honda", "Gasoline", 20000, 18000),
+        makeFact(ID2, "2024-03-05", "Honda", "Gasoline", 25000, 24000),
+    });
+
+    // Moving a sale out of the range must drop it from the filtered total.
+    ASSERT_TRUE(table.upsert(makeFact(ID1, "2023-12-31", "Honda", "Gasoline", 21000, 18000)));
+    ASSERT_EQ(table.size(), 2u);
+
+    SalesFactTable::Query q;
+    SalesFactTable::dayNumber("2024-01-01", q.fromDay);
+    auto result = table.aggregate(q);
+    ASSERT_EQ(result.groups.size(), 1u);
+    ASSERT_EQ(result.groups[0].count, 1);
+    ASSERT_DOUBLE_EQ(result.groups[0].value(SalesFactTable::Metric::Revenue), 25000.0);
+}
+
+TEST(AnalyticsTests, UpsertFindsRowsByIdInAnyOrder) {
+    SalesFactTable table;
+    load(table, {makeFact(ID2, "2024-01-10", "Honda", "Gasoline", 20000, 18000)});
+
+    // An id below the largest loaded one is still new, and re-sending any
+    // sale updates its row rather than adding another.
+    ASSERT_TRUE(table.upsert(makeFact(ID1, "2024-01-11", "Ford", "Gasoline", 30000, 28000)));
+    ASSERT_TRUE(table.upsert(makeFact(ID3, "2024-01-12", "Kia", "Gasoline", 10000, 9000)));
+    ASSERT_TRUE(table.upsert(makeFact(ID1, "2024-01-11", "Ford", "Diesel", 31000, 28000)));
+    ASSERT_TRUE(table.upsert(makeFact(ID2, "2024-01-10", "Honda", "Hybrid", 21000, 18000)));
+    ASSERT_EQ(table.size(), 3u);
+
+    SalesFactTable::Query q;
+    q.groupBy = {SalesFactTable::Dimension::FuelType};
+    auto result = table.aggregate(q);
+    ASSERT_EQ(result.groups.size(), 3u);
+    ASSERT_EQ(result.groups[0].key, (std::vector<std::string>{"Diesel"}));
+    ASSERT_DOUBLE_EQ(result.groups[0].value(SalesFactTable::Metric::Revenue), 31000.0);
+    ASSERT_EQ(result.groups[2].key, (std::vector<std::string>{"Hybrid"}));
+    ASSERT_DOUBLE_EQ(result.groups[2].value(SalesFactTable::Metric::Revenue), 21000.0);
+}
+
+TEST(AnalyticsTests, ReloadKeepsUpsertsMadeDuringTheLoad) {
+    SalesFactTable table;
+    load(table, {makeFact(ID1, "2024-01-10", "Honda", "Gasoline", 20000, 18000)});
+
+    table.reload([&](const SalesFactTable::Sink& sink) {
+        sink(makeFact(ID1, "2024-01-10", "Honda", "Gasoline", 20000, 18000));
+        // Writers do not wait for the load, and readers still see the old contents.
+        ASSERT_TRUE(table.upsert(makeFact(ID1, "2024-01-10", "Honda", "Gasoline", 22000, 18000)));
+        ASSERT_TRUE(table.upsert(makeFact(ID2, "2024-01-11", "Ford", "Gasoline", 30000, 28000)));
+        ASSERT_EQ(table.size(), 2u);
+    });
+
+    ASSERT_EQ(table.size(), 2u);
+    SalesFactTable::Query q;
+    q.groupBy = {SalesFactTable::Dimension::Make};
+    auto result = table.aggregate(q);
+    ASSERT_EQ(result.groups.size(), 2u);
+    ASSERT_DOUBLE_EQ(result.groups[0].value(SalesFactTable::Metric::Revenue), 30000.0);
+    ASSERT_DOUBLE_EQ(result.groups[1].value(SalesFactTable::Metric::Revenue), 22000.0);
+}
+
+TEST(AnalyticsTests, ThreadedMatchesSingleThreaded) {
+    SalesFactTable table;
+    table.reload([](const SalesFactTable::Sink& sink) {
+        char id[37];
+        for (int i = 0; i < 200000; ++i) {
+            std::snprintf(id, sizeof(id), "00000000-0000-7000-8000-%012d", i);
+            sink(makeFact(id, i % 2 ? "2024-05-01" : "2023-05-01",
+                          i % 3 ? "Kia" : "Mazda", i % 5 ? "Gasoline" : "Electric",
+                          10000 + i % 1000, 9000));
+        }
+    });
+
+    SalesFactTable::Query q;
+    q.groupBy = {SalesFactTable::Dimension::Make, SalesFactTable::Dimension::FuelType,
+                 SalesFactTable::Dimension::SaleYear};
+    q.threads = 1;
+    auto single = table.aggregate(q);
+    q.threads = 4;
+    auto threaded = table.aggregate(q);
+
+    ASSERT_EQ(single.groups.size(), threaded.groups.size());
+    for (size_t i = 0; i < single.groups.size(); ++i) {
+        ASSERT_EQ(single.groups[i].key, threaded.groups[i].key);
+        ASSERT_EQ(single.groups[i].count, threaded.groups[i].count);
+        ASSERT_EQ(single.groups[i].revenueCents, threaded.groups[i].revenueCents);
+        ASSERT_EQ(single.groups[i].maxCents, threaded.groups[i].maxCents);
+    }
+    ASSERT_EQ(threaded.scannedRows, 200000u);
+}
@@ -5,6 +5,8 @@
 
 #include "db/db_connection.h"
 #include "modules/customer/customer.h"
+#include "modules/customer/customer_import.h"
+#include "modules/customer/customer_search.h"
 #include <pqxx/pqxx>
 #include <chrono>
 #include <optional>
@@ -25,7 +27,7 @@ namespace
     }
 
     // Deletes a customer by id (used in TearDown so tests don’t leave junk in the DB).
-    void deleteCustomerById(pqxx::connection &conn, const std::string &id)
+    void deleteCustomerById(ConnectionGuard &guard, const std::string &id)
     {
         pqxx::work txn(guard.get());
         txn.exec_params("DELETE FROM Customers WHERE id = $1", id);
@@ -46,7 +48,7 @@ namespace
 
         void TearDown() override
         {
-            if (!conn_)
+            if (!guard_)
                 return;
 
             // Best-effort cleanup of created customers
@@ -61,6 +63,7 @@ namespace
         }
 
         ConnectionGuard& guard() { return *guard_; }
+        CustomerRepository repo() { return CustomerRepository(*guard_); }
 
         // Helper so each test can quickly create a valid customer.
         Customer makeCustomer(const std::string &first = "TestFirst",
@@ -68,8 +71,8 @@ namespace
                               const std::string &phone = "5190000000",
                               const std::optional<std::string> &address = std::optional<std::string>("123 Test St"))
         {
-            Customer c = createCustomer(
-                guard(), first, last, phone,
+            Customer c = repo().createCustomer(
+                first, last, phone,
                 "test" + suffix_ + "@example.com",
                 "DL-" + suffix_,
                 address);
@@ -99,7 +102,7 @@ TEST_F(CustomerDbFixture, CreateCustomer_HappyPath)
 TEST_F(CustomerDbFixture, GetCustomerById_ReturnsCreatedCustomer)
 {
     Customer created = makeCustomer();
-    auto fetched = getCustomerById(conn(), created.id);
+    auto fetched = repo().getCustomerById(created.id);
 
     ASSERT_TRUE(fetched.has_value());
     EXPECT_EQ(fetched->email, created.email);
@@ -110,7 +113,7 @@ TEST_F(CustomerDbFixture, GetCustomerById_ReturnsCreatedCustomer)
 TEST_F(CustomerDbFixture, GetAllCustomers_IncludesCreatedCustomer)
 {
     Customer created = makeCustomer();
-    auto all = getAllCustomers(conn());
+    auto all = repo().getAllCustomers();
 
     bool found = false;
     for (const auto &c : all)
@@ -128,7 +131,7 @@ TEST_F(CustomerDbFixture, GetAllCustomers_IncludesCreatedCustomer)
 TEST_F(CustomerDbFixture, CreateCustomer_MissingRequiredFields_Throws)
 {
     EXPECT_THROW(
-        (void)createCustomer(guard(), "", "Last", "123", "x" + suffix_ + "@example.com", "DL-X" + suffix_, std::nullopt),
+        (void)repo().createCustomer("", "Last", "123", "x" + suffix_ + "@example.com", "DL-X" + suffix_, std::nullopt),
         std::invalid_argument);
 }
 
@@ -136,7 +139,7 @@ TEST_F(CustomerDbFixture, CreateCustomer_MissingRequiredFields_Throws)
 TEST_F(CustomerDbFixture, CreateCustomer_InvalidEmail_Throws)
 {
     EXPECT_THROW(
-        (void)createCustomer(guard(), "A", "B", "123", "not-an-email", "DL-Y" + suffix_, std::nullopt),
+        (void)repo().createCustomer("A", "B", "123", "not-an-email", "DL-Y" + suffix_, std::nullopt),
         std::invalid_argument);
 }
 
@@ -146,7 +149,7 @@ TEST_F(CustomerDbFixture, CreateCustomer_DuplicateEmail_ThrowsUniqueViolation)
     Customer created = makeCustomer();
 
     EXPECT_THROW(
-        (void)createCustomer(guard(), "Dup", "Email", "123", created.email, "DL-DUP-" + suffix_, std::nullopt),
+        (void)repo().createCustomer("Dup", "Email", "123", created.email, "DL-DUP-" + suffix_, std::nullopt),
         pqxx::unique_violation);
 }
 
@@ -156,7 +159,7 @@ TEST_F(CustomerDbFixture, CreateCustomer_DuplicateDrivingLicence_ThrowsUniqueVio
     Customer created = makeCustomer();
 
     EXPECT_THROW(
-        (void)createCustomer(guard(), "Dup", "DL", "123", "other" + suffix_ + "@example.com", created.driving_licence, std::nullopt),
+        (void)repo().createCustomer("Dup", "DL", "123", "other" + suffix_ + "@example.com", created.driving_licence, std::nullopt),
         pqxx::unique_violation);
 }
 
@@ -165,8 +168,7 @@ TEST_F(CustomerDbFixture, PatchCustomer_UpdatesPhoneAndAddress)
 {
     Customer created = makeCustomer();
 
-    Customer updated = patchCustomer(
-        guard(),
+    auto updated = repo().patchCustomer(
         created.id,
         std::nullopt,
         std::nullopt,
@@ -175,8 +177,9 @@ TEST_F(CustomerDbFixture, PatchCustomer_UpdatesPhoneAndAddress)
         std::nullopt,
         std::optional<std::string>("999 Updated Ave"));
 
-    EXPECT_EQ(updated.ph_number, "5191111111");
-    EXPECT_EQ(updated.address, "999 Updated Ave");
+    ASSERT_TRUE(updated.has_value());
+    EXPECT_EQ(updated->ph_number, "5191111111");
+    EXPECT_EQ(updated->address, "999 Updated Ave");
 }
 
 // Patch should reject invalid email if provided.
@@ -185,8 +188,7 @@ TEST_F(CustomerDbFixture, PatchCustomer_InvalidEmail_Throws)
     Customer created = makeCustomer();
 
     EXPECT_THROW(
-        (void)patchCustomer(
-            guard(),
+        (void)repo().patchCustomer(
             created.id,
             std::nullopt,
             std::nullopt,
@@ -203,7 +205,7 @@ TEST_F(CustomerDbFixture, PatchCustomer_NoFieldsProvided_Throws)
     Customer created = makeCustomer();
 
     EXPECT_THROW(
-        (void)patchCustomer(guard(), created.id, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt),
+        (void)repo().patchCustomer(created.id, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt),
         std::invalid_argument);
 }
 
@@ -214,8 +216,7 @@ TEST_F(CustomerDbFixture, PatchCustomer_UniquenessConflictOnEmail_ThrowsUniqueVi
 
     // Creates a second customer with a different unique email/licence.
     std::string other_suffix = uniqueSuffix();
-    Customer c2 = createCustomer(
-        guard(),
+    Customer c2 = repo().createCustomer(
         "Other",
         "Customer",
         "5192222222",
@@ -227,8 +228,7 @@ TEST_F(CustomerDbFixture, PatchCustomer_UniquenessConflictOnEmail_ThrowsUniqueVi
 
     // Attempt to patch c2’s email to c1’s email, which should violate the UNIQUE constraint.
     EXPECT_THROW(
-        (void)patchCustomer(
-            guard(),
+        (void)repo().patchCustomer(
             c2.id,
             std::nullopt,
             std::nullopt,
@@ -237,4 +237,178 @@ TEST_F(CustomerDbFixture, PatchCustomer_UniquenessConflictOnEmail_ThrowsUniqueVi
             std::nullopt,
             std::nullopt),
         pqxx::unique_violation);
-}
\ No newline at end of file
+}
+// Cursors round-trip names with any characters and reject tampering.
+TEST(CustomerCursorTests, RoundTripsAndRejectsGarbage)
+{
+    CustomerCursor cursor{"Zoë", "O'Brien|\"x\"", "0190a6d2-7c4e-7b1a-9d3f-2a4b6c8d0e1f"};
+    auto decoded = decodeCustomerCursor(encodeCustomerCursor(cursor));
+
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->first_name, cursor.first_name);
+    EXPECT_EQ(decoded->last_name, cursor.last_name);
+    EXPECT_EQ(decoded->id, cursor.id);
+
+    EXPECT_FALSE(decodeCustomerCursor("").has_value());
+    EXPECT_FALSE(decodeCustomerCursor("not a cursor").has_value());
+    EXPECT_FALSE(decodeCustomerCursor(encodeCustomerCursor({"A", "B", "not-a-uuid"})).has_value());
+}
+
+// Walking pages of one row visits the created customer exactly once.
+TEST_F(CustomerDbFixture, ListCustomers_PagesFollowTheCursor)
+{
+    Customer created = makeCustomer("AaaPagingFirst", "AaaPagingLast");
+
+    std::optional<CustomerCursor> after;
+    int seen = 0;
+    for (int page = 0; page < 5; ++page)
+    {
+        CustomerPage result = repo().listCustomers(1, after);
+        ASSERT_LE(result.customers.size(), 1u);
+        for (const auto &c : result.customers)
+            seen += c.id == created.id;
+        if (!result.next)
+            break;
+        after = result.next;
+    }
+    EXPECT_EQ(seen, 1);
+}
+
+// The overview carries the customer and empty histories; its ETag matches the
+// cheap validator and moves when the customer is patched.
+TEST_F(CustomerDbFixture, Overview_ETagFollowsCustomerVersion)
+{
+    Customer created = makeCustomer("OverviewFirst", "OverviewLast");
+
+    auto overview = repo().getOverview(created.id);
+    ASSERT_TRUE(overview.has_value());
+    EXPECT_NE(overview->body.find("\"first_name\" : \"OverviewFirst\""), std::string::npos);
+    EXPECT_NE(overview->body.find("\"purchase_count\" : 0"), std::string::npos);
+    EXPECT_EQ(repo().getOverviewETag(created.id), overview->etag);
+
+    repo().patchCustomer(created.id, std::nullopt, std::nullopt, std::optional<std::string>("5192222222"),
+                         std::nullopt, std::nullopt, std::nullopt);
+    EXPECT_NE(repo().getOverviewETag(created.id), overview->etag);
+
+    EXPECT_FALSE(repo().getOverview("00000000-0000-7000-8000-000000000000").has_value());
+}
+
+namespace
+{
+    Customer searchCustomer(const std::string &id, const std::string &first, const std::string &last,
+                            const std::string &phone, const std::string &email)
+    {
+        return Customer{id, first, last, "", phone, email, "ON-" + phone.substr(2)};
+    }
+
+    std::vector<std::string> hitIds(const std::vector<CustomerSearchIndex::Hit> &hits)
+    {
+        std::vector<std::string> ids;
+        for (const auto &h : hits)
+            ids.push_back(h.customer.id);
+        return ids;
+    }
+}
+
+// Prefixes of names, email and phone digits find the customer; a misspelt
+// surname is a fuzzy hit ranked after the prefix hits.
+TEST(CustomerSearchTests, PrefixAndFuzzyMatches)
+{
+    CustomerSearchIndex index;
+    index.reload([](const CustomerSearchIndex::Sink &sink)
+                 {
+        sink(searchCustomer("1", "Alice", "Johnson", "5195550101", "alice@example.com"));
+        sink(searchCustomer("2", "Bob", "Jones", "5195550202", "bob@example.com"));
+        sink(searchCustomer("3", "Carol", "Smith", "4165550303", "carol.smith@example.com")); });
+
+    EXPECT_EQ(hitIds(index.search("JOHN", 10)), std::vector<std::string>({"1"}));
+    EXPECT_EQ(hitIds(index.search("alice j", 10)), std::vector<std::string>({"1"}));
+    EXPECT_EQ(hitIds(index.search("carol.s", 10)), std::vector<std::string>({"3"}));
+    EXPECT_EQ(hitIds(index.search("(416) 555", 10)), std::vector<std::string>({"3"}));
+    EXPECT_EQ(hitIds(index.search("on-955502", 10)), std::vector<std::string>({"2"}));
+
+    auto hits = index.search("jonson", 10);
+    ASSERT_FALSE(hits.empty());
+    EXPECT_EQ(hits[0].customer.id, "1");
+    EXPECT_TRUE(hits[0].fuzzy);
+    EXPECT_GE(hits[0].score, CustomerSearchIndex::FUZZY_THRESHOLD);
+
+    EXPECT_TRUE(index.search("zzzz", 10).empty());
+}
+
+// An upsert replaces a customer's old keys and adds new customers.
+TEST(CustomerSearchTests, UpsertReplacesOldKeys)
+{
+    CustomerSearchIndex index;
+    index.upsert(searchCustomer("0", "Early", "Bird", "5195550000", "early@example.com"));
+    EXPECT_FALSE(index.loaded());
+
+    index.reload([](const CustomerSearchIndex::Sink &sink)
+                 { sink(searchCustomer("1", "Alice", "Johnson", "5195550101", "alice@example.com")); });
+    EXPECT_EQ(index.size(), 1u);
+
+    index.upsert(searchCustomer("1", "Alice", "Walker", "5195550101", "alice@example.com"));
+    index.upsert(searchCustomer("2", "Dan", "Johnston", "5195550404", "dan@example.com"));
+
+    EXPECT_EQ(index.size(), 2u);
+    EXPECT_EQ(hitIds(index.search("walk", 10)), std::vector<std::string>({"1"}));
+    EXPECT_EQ(hitIds(index.search("johnst", 10)), std::vector<std::string>({"2"}));
+    for (const auto &h : index.search("johnson", 10))
+        EXPECT_NE(h.customer.id, "1");
+}
+
+// NDJSON records are validated with the createCustomer rules, keeping line
+// numbers and skipping blank lines.
+TEST(CustomerImportTests, ValidatesNdjsonLines)
+{
+    const std::string body =
+        "{\"first_name\":\" Ann \",\"last_name\":\"Lee\",\"ph_number\":\"5195550101\","
+        "\"email\":\"ann@example.com\",\"driving_licence\":\"on-12345678\",\"address\":\"  \"}\n"
+        "\n"
+        "not json\r\n"
+        "{\"first_name\":\"Bo\",\"last_name\":\"Lee\",\"ph_number\":\"555\","
+        "\"email\":\"bo@example.com\",\"driving_licence\":\"ON-12345679\"}\n"
+        "{\"first_name\":\"Cy\",\"last_name\":\"Lee\",\"ph_number\":\"5195550103\","
+        "\"email\":\"cy@example.com\"}";
+
+    EXPECT_EQ(countCustomerRecords(body, false), 4u);
+    auto rows = parseCustomerNdjson(body, 1);
+    ASSERT_EQ(rows.size(), 4u);
+    EXPECT_EQ(rows[0].line, 1);
+    EXPECT_TRUE(rows[0].error.empty());
+    EXPECT_EQ(rows[0].id.size(), 36u);
+    EXPECT_EQ(rows[0].customer.first_name, "Ann");
+    EXPECT_EQ(rows[0].customer.driving_licence, "ON-12345678");
+    EXPECT_FALSE(rows[0].customer.address.has_value());
+    EXPECT_EQ(rows[1].line, 3);
+    EXPECT_EQ(rows[1].error, "Invalid JSON");
+    EXPECT_EQ(rows[2].error, "Invalid phone number (must be 10 digits).");
+    EXPECT_EQ(rows[3].line, 5);
+    EXPECT_EQ(rows[3].error, "Missing or non-string field: driving_licence");
+}
+
+// CSV columns are found by header name; quoted fields keep commas, quotes and
+// line breaks, and a record's line is where it starts.
+TEST(CustomerImportTests, ParsesCsvWithQuotedFields)
+{
+    const std::string body =
+        "\xEF\xBB\xBF" "Email,First_Name,last_name,ph_number,driving_licence,address,notes\r\n"
+        "ann@example.com,Ann,Lee,5195550101,ON-12345678,\"12 King St, Unit \"\"B\"\"\",vip\r\n"
+        "bo@example.com,Bo,Lee,5195550102,ON-12345679,\"line one\nline two\",\n"
+        "\n"
+        "cy@example,Cy,Lee,5195550103,ON-12345670,,\n";
+
+    EXPECT_EQ(countCustomerRecords(body, true), 3u);
+    auto rows = parseCustomerCsv(body, 1);
+    ASSERT_EQ(rows.size(), 3u);
+    EXPECT_EQ(rows[0].line, 2);
+    EXPECT_TRUE(rows[0].error.empty());
+    EXPECT_EQ(rows[0].customer.email, "ann@example.com");
+    EXPECT_EQ(rows[0].customer.address, std::optional<std::string>("12 King St, Unit \"B\""));
+    EXPECT_EQ(rows[1].line, 3);
+    EXPECT_EQ(rows[1].customer.address, std::optional<std::string>("line one\nline two"));
+    EXPECT_EQ(rows[2].line, 6);
+    EXPECT_EQ(rows[2].error, "Invalid email format.");
+
+    EXPECT_THROW(parseCustomerCsv("first_name,last_name,email\nA,B,c@d.ef\n"), std::invalid_argument);
+}
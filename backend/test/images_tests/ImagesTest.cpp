@@ -5,6 +5,8 @@
 #include <fstream>
 #include <filesystem>
 #include "../../src/db/db_connection.h"
+#include "../../src/modules/images/image_variants.h"
+#include "../../src/modules/images/multipart_upload.h"
 
 namespace fs = std::filesystem;
 
@@ -482,6 +484,196 @@ TEST_F(ImagesTest, GetTotalImageCount) {
     EXPECT_EQ(r2[0]["total"].as<int>(), initial_count + 1);
 }
 
+// ========================================
+// VARIANT GENERATION TESTS
+// ========================================
+
+TEST(ImageVariantTest, ResizeKeepsAspectAndColour) {
+    RgbImage image;
+    image.width = 1000;
+    image.height = 750;
+    image.pixels.assign(1000 * 750 * 3, 0);
+    for (size_t i = 0; i < image.pixels.size(); i += 3) {
+        image.pixels[i] = 200;
+        image.pixels[i + 1] = 100;
+        image.pixels[i + 2] = 50;
+    }
+
+    RgbImage small = resizeToWidth(image, 320);
+    EXPECT_EQ(small.width, 320);
+    EXPECT_EQ(small.height, 240);
+    EXPECT_EQ(small.pixels[0], 200);
+    EXPECT_EQ(small.pixels[1], 100);
+    EXPECT_EQ(small.pixels[small.pixels.size() - 1], 50);
+    EXPECT_EQ(variantFileName("abc_123.jpg", 320), "abc_123_w320.jpg");
+}
+
+TEST(ImageVariantTest, GeneratesOnlyNarrowerVariants) {
+    std::string dir = "/tmp/";
+    std::string name = "variant_test_1000.jpg";
+    RgbImage image;
+    image.width = 1000;
+    image.height = 500;
+    image.pixels.assign(1000 * 500 * 3, 128);
+    encodeJpegFile(dir + name, image);
+
+    ImageVariantResult result = generateImageVariants(dir, name);
+    EXPECT_EQ(result.width, 1000);
+    EXPECT_EQ(result.height, 500);
+    EXPECT_EQ(result.widths, (std::vector<int>{320, 960}));
+
+    DecodedJpeg card = decodeJpegFile(dir + variantFileName(name, 320));
+    EXPECT_EQ(card.image.width, 320);
+    EXPECT_EQ(card.image.height, 160);
+    EXPECT_FALSE(fs::exists(dir + variantFileName(name, 1920)));
+
+    ImagesTestHelper::deleteTestImageFile(dir + name);
+    ImagesTestHelper::deleteTestImageFile(dir + variantFileName(name, 320));
+    ImagesTestHelper::deleteTestImageFile(dir + variantFileName(name, 960));
+}
+
+// Inserts a big-endian EXIF APP1 segment carrying `orientation` right after
+// the SOI marker of a JPEG file, the way phone cameras write it.
+static void addExifOrientation(const std::string& path, int orientation) {
+    std::ifstream in(path, std::ios::binary);
+    std::string jpeg((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    const unsigned char app1[] = {
+        0xFF, 0xE1, 0x00, 0x22,                         // APP1, 34 bytes
+        'E', 'x', 'i', 'f', 0x00, 0x00,
+        'M', 'M', 0x00, 0x2A, 0x00, 0x00, 0x00, 0x08,   // TIFF header, IFD0 at 8
+        0x00, 0x01,                                     // one entry
+        0x01, 0x12, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, // Orientation, SHORT, 1 value
+        0x00, static_cast<unsigned char>(orientation), 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,                         // no next IFD
+    };
+    jpeg.insert(2, reinterpret_cast<const char*>(app1), sizeof(app1));
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << jpeg;
+}
+
+TEST(ImageVariantTest, AppliesExifOrientation) {
+    std::string dir = "/tmp/";
+    std::string name = "variant_test_portrait.jpg";
+    // Stored sideways: red on the left, blue on the right. Orientation 6
+    // turns it 90 degrees clockwise, so it shows red on top, blue below.
+    RgbImage image;
+    image.width = 1200;
+    image.height = 400;
+    image.pixels.assign(1200 * 400 * 3, 0);
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x) {
+            image.pixels[(static_cast<size_t>(y) * image.width + x) * 3 + (x < 600 ? 0 : 2)] = 255;
+        }
+    }
+    encodeJpegFile(dir + name, image);
+    addExifOrientation(dir + name, 6);
+
+    ImageVariantResult result = generateImageVariants(dir, name);
+    EXPECT_EQ(result.width, 400);
+    EXPECT_EQ(result.height, 1200);
+    EXPECT_EQ(result.widths, (std::vector<int>{320}));
+
+    DecodedJpeg card = decodeJpegFile(dir + variantFileName(name, 320));
+    ASSERT_EQ(card.image.width, 320);
+    ASSERT_EQ(card.image.height, 960);
+    auto pixel = [&](int x, int y) { return card.image.pixels.data() + (static_cast<size_t>(y) * 320 + x) * 3; };
+    EXPECT_GT(pixel(160, 100)[0], 200);
+    EXPECT_LT(pixel(160, 100)[2], 60);
+    EXPECT_LT(pixel(160, 860)[0], 60);
+    EXPECT_GT(pixel(160, 860)[2], 200);
+
+    ImagesTestHelper::deleteTestImageFile(dir + name);
+    ImagesTestHelper::deleteTestImageFile(dir + variantFileName(name, 320));
+}
+
+TEST(ImageVariantTest, RejectsNonJpeg) {
+    std::string path = "/tmp/variant_test_not_a_jpeg.jpg";
+    std::ofstream(path) << "GIF89a";
+    EXPECT_THROW(decodeJpegFile(path), std::runtime_error);
+    ImagesTestHelper::deleteTestImageFile(path);
+}
+
+// ========================================
+// MULTIPART UPLOAD TESTS
+// ========================================
+
+namespace {
+    const std::string MULTIPART_BODY =
+        "preamble\r\n"
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"note\"\r\n"
+        "\r\n"
+        "hello\r\n"
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"file\"; filename=\"a.jpg\"\r\n"
+        "Content-Type: image/jpeg\r\n"
+        "\r\n"
+        "\xFF\xD8\r\n--XyQ-near-miss\xFF\xD9\r\n"
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"file\"; filename=\"b.jpg\"\r\n"
+        "\r\n"
+        "second\r\n"
+        "--XyZ--\r\n";
+
+    std::vector<std::pair<MultipartPart, std::string>> parseInSlices(const std::string& body, size_t slice) {
+        std::vector<std::pair<MultipartPart, std::string>> parts;
+        MultipartStreamParser parser("XyZ", {
+            [&](const MultipartPart& part) { parts.push_back({part, ""}); },
+            [&](std::string_view data) { parts.back().second.append(data); },
+            [] {},
+        });
+        for (size_t i = 0; i < body.size(); i += slice) parser.feed(std::string_view(body).substr(i, slice));
+        parser.finish();
+        return parts;
+    }
+}
+
+TEST(MultipartUploadTest, ParsesPartsAcrossAnySliceSize) {
+    EXPECT_EQ(multipartBoundary("multipart/form-data; boundary=\"XyZ\""), std::optional<std::string>("XyZ"));
+    EXPECT_FALSE(multipartBoundary("application/json").has_value());
+
+    for (size_t slice : {1, 2, 7, 4096}) {
+        auto parts = parseInSlices(MULTIPART_BODY, slice);
+        ASSERT_EQ(parts.size(), 3u);
+        EXPECT_EQ(parts[0].first.name, "note");
+        EXPECT_EQ(parts[0].second, "hello");
+        EXPECT_EQ(parts[1].first.filename, "a.jpg");
+        EXPECT_EQ(parts[1].first.contentType, "image/jpeg");
+        EXPECT_EQ(parts[1].second, "\xFF\xD8\r\n--XyQ-near-miss\xFF\xD9");
+        EXPECT_EQ(parts[2].second, "second");
+    }
+
+    EXPECT_THROW(parseInSlices(MULTIPART_BODY.substr(0, MULTIPART_BODY.size() - 8), 4096), std::invalid_argument);
+}
+
+TEST(MultipartUploadTest, StagesFilePartsAndEnforcesLimits) {
+    std::string dir = "/tmp/multipart_upload_test/";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    {
+        UploadStaging staging(dir, UploadLimits{1024, 4096, 5});
+        staging.receive(MULTIPART_BODY, "XyZ");
+        ASSERT_EQ(staging.files().size(), 2u);
+        EXPECT_EQ(staging.files()[1].size, 6u);
+
+        staging.publish({"one.jpg", "two.jpg"});
+        EXPECT_EQ(fs::file_size(dir + "two.jpg"), 6u);
+    }
+    EXPECT_TRUE(fs::exists(dir + "one.jpg"));
+
+    {
+        UploadStaging staging(dir, UploadLimits{4, 4096, 5});
+        EXPECT_THROW(staging.receive(MULTIPART_BODY, "XyZ"), UploadTooLarge);
+    }
+    {
+        UploadStaging staging(dir, UploadLimits{1024, 4096, 1});
+        EXPECT_THROW(staging.receive(MULTIPART_BODY, "XyZ"), UploadTooLarge);
+    }
+    // Nothing but the two published files is left behind.
+    EXPECT_EQ(std::distance(fs::directory_iterator(dir), fs::directory_iterator()), 2);
+    fs::remove_all(dir);
+}
+
 // ========================================
 // MAIN (REQUIRED BY GTEST)
 // ========================================
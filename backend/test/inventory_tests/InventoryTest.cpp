@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "../../src/modules/inventory/inventory_model.h"
+#include "../../src/modules/inventory/similar_vehicles.h"
 
 // ===== Basic Set/Get =====
 TEST(InventoryTests, SetAndGetVin) {
@@ -110,3 +111,87 @@ TEST(InventoryTests, InvalidStatus) {
     Vehicle v;
     ASSERT_FALSE(v.isValidStatus("IN_REPAIR"));
 }
+
+// ===== Similar Vehicles Index =====
+static VehicleFeatures makeFeatures(const std::string& id, const std::string& make,
+                                    const std::string& model, int year, double price) {
+    VehicleFeatures v;
+    v.id = id;
+    v.make = make;
+    v.model = model;
+    v.year = year;
+    v.odometer = 40000;
+    v.marketPrice = price;
+    v.fuelType = "Gasoline";
+    v.transmission = "Automatic";
+    return v;
+}
+
+TEST(InventoryTests, SimilarIndexPrefersSameModel) {
+    SimilarVehicleIndex index;
+    index.upsert(makeFeatures("a", "Honda", "Civic", 2019, 20000));
+    index.upsert(makeFeatures("b", "Honda", "Civic", 2020, 21000));
+    index.upsert(makeFeatures("c", "Ford", "F-150", 2012, 45000));
+
+    bool found = false;
+    auto matches = index.nearest("a", 1, found);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(matches.size(), 1u);
+    ASSERT_EQ(matches[0].vehicle.id, "b");
+}
+
+TEST(InventoryTests, SimilarIndexSkipsSoldAndSelf) {
+    SimilarVehicleIndex index;
+    index.upsert(makeFeatures("a", "Honda", "Civic", 2019, 20000));
+    VehicleFeatures sold = makeFeatures("b", "Honda", "Civic", 2019, 20000);
+    sold.available = false;
+    index.upsert(sold);
+
+    bool found = false;
+    auto matches = index.nearest("a", 5, found);
+    ASSERT_TRUE(found);
+    ASSERT_TRUE(matches.empty());
+}
+
+TEST(InventoryTests, SimilarIndexReloadKeepsWritesMadeDuringTheLoad) {
+    SimilarVehicleIndex index;
+    index.upsert(makeFeatures("a", "Honda", "Civic", 2019, 20000));
+    index.reload([&index] {
+        // The snapshot still shows "b" for sale; it is sold before the swap.
+        std::vector<VehicleFeatures> snapshot = {
+            makeFeatures("b", "Honda", "Civic", 2019, 21000),
+            makeFeatures("c", "Toyota", "Camry", 2020, 24000),
+        };
+        VehicleFeatures sold = snapshot[0];
+        sold.available = false;
+        index.upsert(sold);
+        return snapshot;
+    });
+
+    bool found = true;
+    index.nearest("a", 1, found);
+    ASSERT_FALSE(found);
+    ASSERT_EQ(index.size(), 2u);
+
+    auto matches = index.nearest("c", 5, found);
+    ASSERT_TRUE(found);
+    ASSERT_TRUE(matches.empty());
+}
+
+TEST(InventoryTests, SimilarIndexUpsertManyMatchesSingleUpserts) {
+    SimilarVehicleIndex index;
+    index.upsert(makeFeatures("a", "Honda", "Civic", 2019, 20000));
+    const std::vector<VehicleFeatures> batch = {
+        makeFeatures("a", "Honda", "Civic", 2019, 18000),  // repriced in place
+        makeFeatures("b", "Honda", "Civic", 2019, 18500),
+        makeFeatures("c", "Ford", "F-150", 2012, 45000),
+    };
+    index.upsertMany(batch);
+    ASSERT_EQ(index.size(), 3u);
+
+    bool found = false;
+    auto matches = index.nearest("b", 1, found);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(matches[0].vehicle.id, "a");
+    ASSERT_EQ(matches[0].vehicle.marketPrice, 18000);
+}
@@ -2,7 +2,13 @@
 #include <pqxx/pqxx>
 #include <string>
 #include <memory>
+#include <climits>
 #include "../../src/db/db_connection.h"
+#include "../../src/modules/sales/sales_distribution.h"
+#include "../../src/modules/sales/invoice.h"
+#include "../../src/modules/sales/sales_import.h"
+#include "../../src/modules/sales/sales_rollup.h"
+#include "../../src/db/sql_errors.h"
 
 // ========================================
 // TEST HELPERS
@@ -328,6 +334,67 @@ TEST_F(SalesTest, UpdateSale_NonExistentId) {
     EXPECT_EQ(r.size(), 0);
 }
 
+// ========================================
+// SALES ROLLUP TESTS (GET /sales/weekly-report)
+// ========================================
+
+// Sums the weekly report reads for the test vehicle's model in the week of 2031-06-02.
+static pqxx::row weeklyTotals(pqxx::connection& conn, const std::string& model) {
+    pqxx::work txn(conn);
+    pqxx::result r = txn.exec_params(
+        "SELECT COALESCE(SUM(sales_count), 0) AS sales_count, COALESCE(SUM(market_value), 0) AS market_value, "
+        "COALESCE(SUM(profit), 0) AS profit FROM Sales_Daily_Rollup "
+        "WHERE day >= '2031-06-02' AND day < '2031-06-09' AND make = 'Toyota' AND model = $1",
+        model);
+    txn.commit();
+    return r[0];
+}
+
+TEST_F(SalesTest, WeeklyReport_UnchangedByRepricingSoldVehicle) {
+    const std::string model = "Snapshot-" + test_vehicle_id.substr(0, 8);
+    prepareSalesRollup(*guard_);
+    {
+        pqxx::work txn(conn());
+        txn.exec_params("UPDATE Vehicles SET model = $1, status = 'Sold' WHERE id = $2", model, test_vehicle_id);
+        pqxx::result r = txn.exec_params(
+            "INSERT INTO Sales (vehicle_id, customer_id, date, sale_price) "
+            "VALUES ($1, $2, '2031-06-03', 26000.00) RETURNING id, market_price",
+            test_vehicle_id, test_customer_id);
+        test_sale_id = r[0]["id"].c_str();
+        EXPECT_DOUBLE_EQ(r[0]["market_price"].as<double>(), 25000.00);
+        applySaleToRollup(txn, "2031-06-03", test_sale_id, "26000.00");
+        txn.commit();
+    }
+
+    // POST /vehicles/reprice and PUT /vehicles change the vehicle, not the sale.
+    {
+        pqxx::work txn(conn());
+        txn.exec_params("UPDATE Vehicles SET market_price = 31000.00 WHERE id = $1", test_vehicle_id);
+        txn.commit();
+    }
+    pqxx::row totals = weeklyTotals(conn(), model);
+    EXPECT_EQ(totals["sales_count"].as<int>(), 1);
+    EXPECT_DOUBLE_EQ(totals["market_value"].as<double>(), 25000.00);
+    EXPECT_DOUBLE_EQ(totals["profit"].as<double>(), 1000.00);
+
+    // PUT /sales retracts exactly what the sale was counted with.
+    {
+        pqxx::work txn(conn());
+        txn.exec_params("UPDATE Sales SET sale_price = 27000.00 WHERE id = $1", test_sale_id);
+        retractSaleFromRollup(txn, "2031-06-03", test_sale_id, "26000.00");
+        applySaleToRollup(txn, "2031-06-03", test_sale_id, "27000.00");
+        txn.commit();
+    }
+    totals = weeklyTotals(conn(), model);
+    EXPECT_EQ(totals["sales_count"].as<int>(), 1);
+    EXPECT_DOUBLE_EQ(totals["market_value"].as<double>(), 25000.00);
+    EXPECT_DOUBLE_EQ(totals["profit"].as<double>(), 2000.00);
+
+    pqxx::work cleanup(conn());
+    cleanup.exec_params("DELETE FROM Sales_Daily_Rollup WHERE make = 'Toyota' AND model = $1", model);
+    cleanup.commit();
+}
+
 // ========================================
 // GET SALES BY VEHICLE (GET /sales/vehicles/<id>)
 // ========================================
@@ -484,6 +551,203 @@ TEST_F(SalesTest, Validation_UUIDFormat) {
     EXPECT_EQ(test_vehicle_id[23], '-');
 }
 
+// ========================================
+// DISTRIBUTION SKETCH TESTS
+// ========================================
+
+TEST(SalesDistributionTest, MergesMonthsOfOneModel) {
+    SalesDistributionStore store;
+    store.reload([](const SalesDistributionStore::Sink& sink) {
+        for (int i = 1; i <= 30; ++i) {
+            sink("Toyota", "Camry", i <= 15 ? "2024-01-10" : "2024-02-10", 20000 + i * 100, 20000);
+            sink("Honda", "Civic", "2024-01-10", 90000, 20000);
+        }
+    });
+
+    int from = 0, to = 0;
+    ASSERT_TRUE(SalesDistributionStore::monthNumber("2024-01", from));
+    ASSERT_TRUE(SalesDistributionStore::monthNumber("2024-02-29", to));
+
+    auto summary = store.merged("Toyota", "Camry", from, to);
+    EXPECT_EQ(summary.buckets, 2u);
+    EXPECT_DOUBLE_EQ(summary.salePrice.count(), 30.0);
+    EXPECT_DOUBLE_EQ(summary.salePrice.quantile(0.5), 21550.0);
+    EXPECT_DOUBLE_EQ(summary.profit.quantile(0.0), 100.0);
+
+    auto january = store.merged("Toyota", "Camry", from, from);
+    EXPECT_DOUBLE_EQ(january.salePrice.count(), 15.0);
+}
+
+TEST(SalesDistributionTest, DirtyBucketIsClaimedOnce) {
+    SalesDistributionStore store;
+    store.reload([](const SalesDistributionStore::Sink& sink) {
+        sink("Kia", "Rio", "2024-03-01", 15000, 14000);
+    });
+    store.markDirty("Kia", "Rio", "2024-03-20");
+
+    auto keys = store.beginRebuild("Kia", "", INT_MIN, INT_MAX);
+    ASSERT_EQ(keys.size(), 1u);
+    EXPECT_TRUE(store.beginRebuild("Kia", "", INT_MIN, INT_MAX).empty());
+
+    SalesDistributionStore::Summary rebuilt;
+    rebuilt.salePrice.add(16000);
+    rebuilt.profit.add(2000);
+    store.finishRebuild(keys[0], std::move(rebuilt));
+
+    auto summary = store.merged("Kia", "Rio", INT_MIN, INT_MAX);
+    EXPECT_DOUBLE_EQ(summary.salePrice.quantile(0.5), 16000.0);
+}
+
+TEST(SalesDistributionTest, SaleSeenByALoadIsNotCountedTwice) {
+    SalesDistributionStore store;
+    int march = 0, april = 0;
+    ASSERT_TRUE(SalesDistributionStore::monthNumber("2024-03", march));
+    ASSERT_TRUE(SalesDistributionStore::monthNumber("2024-04", april));
+
+    // The sale's transaction begins, commits, and the load reads it before
+    // add() runs: the bucket must be rebuilt, not added to.
+    const uint64_t early = store.epoch();
+    store.reload([&](const SalesDistributionStore::Sink& sink) {
+        sink("Kia", "Rio", "2024-03-01", 15000, 14000);
+        // A sale added while the load runs may or may not be in it either.
+        store.add("s2", "Kia", "Rio", "2024-04-02", 16000, 14000, store.epoch());
+    });
+    store.add("s1", "Kia", "Rio", "2024-03-01", 15000, 14000, early);
+    EXPECT_DOUBLE_EQ(store.merged("Kia", "Rio", march, march).salePrice.count(), 1.0);
+    EXPECT_EQ(store.beginRebuild("Kia", "Rio", march, april).size(), 2u);
+
+    // A sale begun after the last read is added directly.
+    const uint64_t late = store.epoch();
+    store.add("s3", "Kia", "Rio", "2024-05-03", 17000, 14000, late);
+    auto may = store.merged("Kia", "Rio", april + 1, april + 1);
+    EXPECT_DOUBLE_EQ(may.salePrice.count(), 1.0);
+    EXPECT_TRUE(store.beginRebuild("Kia", "Rio", april + 1, april + 1).empty());
+}
+
+// ========================================
+// INVOICE CACHE TESTS
+// ========================================
+
+static std::shared_ptr<const RenderedInvoice> cachedInvoice(const std::string& saleId, const std::string& vehicleId,
+                                                            const std::string& customerId, int version) {
+    auto invoice = std::make_shared<RenderedInvoice>();
+    invoice->saleId = saleId;
+    invoice->vehicleId = vehicleId;
+    invoice->customerId = customerId;
+    invoice->version = version;
+    invoice->body = "{\"invoice_number\":\"" + saleId + "\"}";
+    return invoice;
+}
+
+TEST(InvoiceCacheTest, EvictsLeastRecentlyUsed) {
+    InvoiceCache cache(2);
+    EXPECT_TRUE(cache.put(cachedInvoice("s1", "v1", "c1", 1), cache.epoch()));
+    EXPECT_TRUE(cache.put(cachedInvoice("s2", "v2", "c1", 1), cache.epoch()));
+    ASSERT_NE(cache.get("s1"), nullptr);
+
+    EXPECT_TRUE(cache.put(cachedInvoice("s3", "v3", "c2", 1), cache.epoch()));
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_NE(cache.get("s1"), nullptr);
+    EXPECT_EQ(cache.get("s2"), nullptr);
+
+    // An older revision never replaces a newer one.
+    EXPECT_TRUE(cache.put(cachedInvoice("s1", "v1", "c1", 3), cache.epoch()));
+    EXPECT_FALSE(cache.put(cachedInvoice("s1", "v1", "c1", 2), cache.epoch()));
+    EXPECT_EQ(cache.get("s1")->version, 3);
+}
+
+TEST(InvoiceCacheTest, EditsDropInvoicesAndRefuseStaleLoads) {
+    InvoiceCache cache(16);
+    cache.put(cachedInvoice("s1", "v1", "c1", 1), cache.epoch());
+    cache.put(cachedInvoice("s2", "v2", "c1", 1), cache.epoch());
+    cache.put(cachedInvoice("s3", "v3", "c2", 1), cache.epoch());
+
+    cache.invalidateCustomer("c1");
+    EXPECT_EQ(cache.get("s1"), nullptr);
+    EXPECT_EQ(cache.get("s2"), nullptr);
+    EXPECT_NE(cache.get("s3"), nullptr);
+
+    // A render that started before the vehicle edit must not be installed.
+    const uint64_t seen = cache.epoch();
+    cache.invalidateVehicle("v3");
+    EXPECT_EQ(cache.get("s3"), nullptr);
+    EXPECT_FALSE(cache.put(cachedInvoice("s3", "v3", "c2", 1), seen));
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(InvoiceCacheTest, InvalidatesManyVehiclesInOneStep) {
+    InvoiceCache cache(16);
+    cache.put(cachedInvoice("s1", "v1", "c1", 1), cache.epoch());
+    cache.put(cachedInvoice("s2", "v2", "c1", 1), cache.epoch());
+    cache.put(cachedInvoice("s3", "v3", "c2", 1), cache.epoch());
+
+    const uint64_t seen = cache.epoch();
+    const std::vector<std::string> repriced = {"v1", "v3", "v9"};
+    cache.invalidateVehicles(repriced);
+    EXPECT_EQ(cache.epoch(), seen + 1);
+    EXPECT_EQ(cache.get("s1"), nullptr);
+    EXPECT_NE(cache.get("s2"), nullptr);
+    EXPECT_EQ(cache.get("s3"), nullptr);
+}
+
+// ========================================
+// BATCH IMPORT VALIDATION TESTS
+// ========================================
+
+TEST(SalesImportTest, ValidatesEachLine) {
+    const std::string vehicle = "0190f3a2-7c41-7d2e-9a51-3b6f0c8e2d17";
+    const std::string customer = "0190F3A2-7C41-7D2E-9A51-3B6F0C8E2D18";
+    const std::string body =
+        "{\"vehicle_id\":\"" + vehicle + "\",\"customer_id\":\"" + customer + "\",\"sale_price\":25000,\"date\":\"2024-02-29\"}\n"
+        "\n"
+        "not json\r\n"
+        "{\"vehicle_id\":\"" + vehicle + "\",\"customer_id\":\"" + customer + "\",\"sale_price\":0,\"date\":\"2024-03-01\"}\n"
+        "{\"vehicle_id\":\"" + vehicle + "\",\"customer_id\":\"" + customer + "\",\"sale_price\":100,\"date\":\"2023-02-29\"}";
+
+    EXPECT_EQ(countNdjsonLines(body), 4u);
+    auto rows = parseSalesNdjson(body, 1);
+    ASSERT_EQ(rows.size(), 4u);
+    EXPECT_EQ(rows[0].line, 1);
+    EXPECT_TRUE(rows[0].error.empty());
+    EXPECT_EQ(rows[0].saleId.size(), 36u);
+    EXPECT_EQ(rows[0].customerId, "0190f3a2-7c41-7d2e-9a51-3b6f0c8e2d18");
+    EXPECT_EQ(rows[1].line, 3);
+    EXPECT_EQ(rows[1].error, "Invalid JSON");
+    EXPECT_EQ(rows[2].error, "Sale price must be positive");
+    EXPECT_EQ(rows[3].line, 5);
+    EXPECT_EQ(rows[3].error, "Invalid date");
+}
+
+TEST(SalesImportTest, ParallelValidationKeepsLineOrder) {
+    std::string body;
+    for (int i = 0; i < 20000; ++i) {
+        body += "{\"vehicle_id\":\"0190f3a2-7c41-7d2e-9a51-3b6f0c8e2d17\","
+                "\"customer_id\":\"0190f3a2-7c41-7d2e-9a51-3b6f0c8e2d18\","
+                "\"sale_price\":" + std::to_string(i + 1) + ",\"date\":\"2024-01-01\"}\n";
+    }
+    auto rows = parseSalesNdjson(body, 4);
+    ASSERT_EQ(rows.size(), 20000u);
+    for (int i = 0; i < 20000; ++i) {
+        ASSERT_EQ(rows[i].line, i + 1);
+        ASSERT_TRUE(rows[i].error.empty());
+        ASSERT_EQ(rows[i].salePrice, i + 1.0);
+    }
+}
+
+// ========================================
+// SQLSTATE MAPPING TESTS
+// ========================================
+
+TEST(SqlStateTest, MapsClassesToHttpStatus) {
+    EXPECT_EQ(classifySqlState("22007").status, 400);  // invalid datetime format
+    EXPECT_EQ(classifySqlState("22003").status, 400);  // numeric out of range
+    EXPECT_EQ(classifySqlState("23503").status, 409);
+    EXPECT_EQ(classifySqlState("23505").status, 409);
+    EXPECT_EQ(classifySqlState("40P01").status, 503);
+    EXPECT_EQ(classifySqlState("42P01").status, 500);  // undefined table is our bug
+    EXPECT_EQ(classifySqlState("").status, 500);
+}
+
 // ========================================
 // MAIN (REQUIRED BY GTEST)
 // ========================================
@@ -0,0 +1,250 @@
+#include "gtest/gtest.h"
+#include "../../src/utils/civil_date.h"
+#include "../../src/utils/http_cache.h"
+#include "../../src/utils/idempotency.h"
+#include "../../src/utils/uuid.h"
+#include "../../src/utils/validators.h"
+#include "../../src/utils/tdigest.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+// ===== ETags =====
+TEST(UtilsTests, ContentETagIsQuotedAndStable) {
+    std::string tag = contentETag("{\"id\":1}");
+    ASSERT_EQ(tag.size(), 18u);
+    ASSERT_EQ(tag.front(), '"');
+    ASSERT_EQ(tag.back(), '"');
+    ASSERT_EQ(tag, contentETag("{\"id\":1}"));
+    ASSERT_NE(tag, contentETag("{\"id\":2}"));
+}
+
+TEST(UtilsTests, IfNoneMatchFindsTagInList) {
+    crow::request req;
+    req.add_header("If-None-Match", "\"aaa\", W/\"bbb\"");
+    ASSERT_TRUE(ifNoneMatchHits(req, "\"bbb\""));
+    ASSERT_TRUE(ifNoneMatchHits(req, "\"aaa\""));
+    ASSERT_FALSE(ifNoneMatchHits(req, "\"ccc\""));
+}
+
+TEST(UtilsTests, IfNoneMatchMissingHeader) {
+    crow::request req;
+    ASSERT_FALSE(ifNoneMatchHits(req, "\"aaa\""));
+}
+
+TEST(UtilsTests, HttpDateRoundTrips) {
+    ASSERT_EQ(httpDate(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+    ASSERT_EQ(parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"), std::optional<int64_t>(784111777));
+    ASSERT_EQ(parseHttpDate(httpDate(1709251199)), std::optional<int64_t>(1709251199));
+    ASSERT_FALSE(parseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT").has_value());
+    ASSERT_FALSE(parseHttpDate("Sun, 31 Feb 1994 08:49:37 GMT").has_value());
+
+    crow::request req;
+    req.add_header("If-Modified-Since", "Sun, 06 Nov 1994 08:49:37 GMT");
+    ASSERT_TRUE(notModifiedSince(req, 784111777));
+    ASSERT_FALSE(notModifiedSince(req, 784111778));
+    req.add_header("If-None-Match", "\"other\"");
+    ASSERT_FALSE(notModifiedSince(req, 784111777));
+}
+
+TEST(UtilsTests, ParseRangeForms) {
+    ByteRange r;
+    ASSERT_EQ(parseRange("bytes=0-99", 1000, r), RangeStatus::Partial);
+    ASSERT_EQ(r.first, 0u);
+    ASSERT_EQ(r.last, 99u);
+    ASSERT_EQ(parseRange("bytes=900-", 1000, r), RangeStatus::Partial);
+    ASSERT_EQ(r.length(), 100u);
+    ASSERT_EQ(parseRange("bytes=-300", 1000, r), RangeStatus::Partial);
+    ASSERT_EQ(r.first, 700u);
+    ASSERT_EQ(parseRange("bytes=990-5000", 1000, r), RangeStatus::Partial);
+    ASSERT_EQ(r.last, 999u);
+
+    ASSERT_EQ(parseRange("bytes=1000-", 1000, r), RangeStatus::Unsatisfiable);
+    ASSERT_EQ(parseRange("bytes=0-1,5-9", 1000, r), RangeStatus::Full);
+    ASSERT_EQ(parseRange("items=0-1", 1000, r), RangeStatus::Full);
+    ASSERT_EQ(parseRange("bytes=9-2", 1000, r), RangeStatus::Full);
+}
+
+TEST(UtilsTests, IfRangeNeedsExactValidator) {
+    crow::request req;
+    ASSERT_TRUE(ifRangeHolds(req, "\"a\"", "Sun, 06 Nov 1994 08:49:37 GMT"));
+    req.add_header("If-Range", "\"a\"");
+    ASSERT_TRUE(ifRangeHolds(req, "\"a\"", "Sun, 06 Nov 1994 08:49:37 GMT"));
+    ASSERT_FALSE(ifRangeHolds(req, "\"b\"", "Sun, 06 Nov 1994 08:49:37 GMT"));
+}
+
+// ===== UUIDv7 =====
+TEST(UtilsTests, UuidV7HasCanonicalLayout) {
+    std::string id = newUuidV7();
+    ASSERT_EQ(id.size(), 36u);
+    ASSERT_EQ(id[8], '-');
+    ASSERT_EQ(id[13], '-');
+    ASSERT_EQ(id[14], '7');
+    ASSERT_EQ(id[18], '-');
+    ASSERT_TRUE(id[19] == '8' || id[19] == '9' || id[19] == 'a' || id[19] == 'b');
+    ASSERT_EQ(id[23], '-');
+}
+
+TEST(UtilsTests, UuidV7IsStrictlyIncreasing) {
+    std::string previous = newUuidV7();
+    for (int i = 0; i < 10000; ++i) {
+        std::string next = newUuidV7();
+        ASSERT_LT(previous, next);
+        previous = next;
+    }
+}
+
+TEST(UtilsTests, UuidV7CarriesCurrentTime) {
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t millis = uuidV7Millis(newUuidV7());
+    ASSERT_GE(millis + 1000, static_cast<uint64_t>(nowMs));
+    ASSERT_LE(millis, static_cast<uint64_t>(nowMs) + 1000);
+}
+
+// ===== t-digest =====
+TEST(UtilsTests, TDigestSmallInputIsExact) {
+    TDigest digest;
+    for (int i = 1; i <= 11; ++i) digest.add(i * 10.0);
+    ASSERT_DOUBLE_EQ(digest.quantile(0.5), 60.0);
+    ASSERT_DOUBLE_EQ(digest.quantile(0.25), 35.0);
+    ASSERT_DOUBLE_EQ(digest.quantile(0.0), 10.0);
+    ASSERT_DOUBLE_EQ(digest.quantile(1.0), 110.0);
+}
+
+TEST(UtilsTests, TDigestRankErrorIsSmall) {
+    std::mt19937 rng(3);
+    std::normal_distribution<double> prices(30000, 8000);
+    std::vector<double> values(200000);
+    TDigest whole, left, right;
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = prices(rng);
+        whole.add(values[i]);
+        (i % 2 ? left : right).add(values[i]);
+    }
+    left.merge(right);
+    std::sort(values.begin(), values.end());
+
+    for (double q : {0.01, 0.1, 0.5, 0.9, 0.99}) {
+        for (const TDigest* d : {&whole, &left}) {
+            double rank = std::lower_bound(values.begin(), values.end(), d->quantile(q)) - values.begin();
+            ASSERT_NEAR(rank / values.size(), q, 0.005);
+        }
+    }
+    ASSERT_LE(whole.centroidCount(), 160u);
+}
+
+TEST(UtilsTests, TDigestSizeStaysBoundedForLargeInputs) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> prices(5000, 95000);
+    TDigest digest;
+    // The tail centroids used to stop merging somewhere past a few million
+    // values, so check the size all along the way.
+    for (int i = 1; i <= 12000000; ++i) {
+        digest.add(prices(rng));
+        if (i % 500000 == 0) ASSERT_LE(digest.centroidCount(), 160u);
+    }
+    ASSERT_NEAR(digest.quantile(0.999), 94910.0, 100.0);
+}
+
+TEST(UtilsTests, IdempotencyCacheReplaysCompletedKey) {
+    IdempotencyCache cache(std::chrono::seconds(60), 100);
+    ASSERT_TRUE(cache.claim("k", "\"a\"").state == IdempotencyCache::State::Claimed);
+    ASSERT_TRUE(cache.claim("k", "\"a\"").state == IdempotencyCache::State::InFlight);
+
+    cache.complete("k", {201, "{\"id\":\"1\"}", {{"Content-Type", "application/json"}, {"ETag", "W/\"3\""}}});
+    auto again = cache.claim("k", "\"a\"");
+    ASSERT_TRUE(again.state == IdempotencyCache::State::Completed);
+    ASSERT_EQ(again.response.status, 201);
+    ASSERT_EQ(again.response.body, "{\"id\":\"1\"}");
+    ASSERT_EQ(again.response.headers.size(), 2u);
+    ASSERT_EQ(again.response.headers[1].second, "W/\"3\"");
+
+    ASSERT_TRUE(cache.claim("k", "\"b\"").state == IdempotencyCache::State::Mismatch);
+    cache.release("k");
+    ASSERT_TRUE(cache.claim("k", "\"b\"").state == IdempotencyCache::State::Claimed);
+}
+
+TEST(UtilsTests, IdempotencyCacheExpiresKeys) {
+    using Clock = IdempotencyCache::Clock;
+    IdempotencyCache cache(std::chrono::seconds(60), 2);
+    const Clock::time_point start = Clock::now();
+    cache.claim("k", "\"a\"", start);
+    cache.complete("k", {201, "{}", {{"Content-Type", "application/json"}}}, start);
+
+    ASSERT_TRUE(cache.claim("k", "\"a\"", start + std::chrono::seconds(59)).state ==
+                IdempotencyCache::State::Completed);
+    ASSERT_TRUE(cache.claim("k", "\"a\"", start + std::chrono::seconds(61)).state ==
+                IdempotencyCache::State::Claimed);
+
+    for (int i = 0; i < 100; ++i) cache.claim("other" + std::to_string(i), "\"a\"", start);
+    ASSERT_LE(cache.size(), 16u * 3);
+}
+
+TEST(UtilsTests, CivilDateValidatesCalendarDays) {
+    ASSERT_TRUE(isValidDate("2024-02-29"));
+    ASSERT_TRUE(isValidDate("2000-02-29"));
+    ASSERT_FALSE(isValidDate("1900-02-29"));
+    ASSERT_FALSE(isValidDate("2023-02-29"));
+    ASSERT_FALSE(isValidDate("2024-04-31"));
+    ASSERT_FALSE(isValidDate("2024-4-01"));
+    ASSERT_FALSE(isValidDate("2024/04/01"));
+    ASSERT_FALSE(isValidDate("2024-04-01 "));
+    ASSERT_FALSE(isValidDate(""));
+}
+
+TEST(UtilsTests, CivilDateRoundTripsAndBuckets) {
+    for (int days = -800000; days <= 800000; days += 97) {
+        ASSERT_EQ(daysFromCivil(civilFromDays(days)), days);
+    }
+    ASSERT_EQ(toDateString(daysFromCivil({2024, 3, 10}) + 1), "2024-03-11");
+    ASSERT_EQ(toDateString(-1), "1969-12-31");
+
+    // 2024-03-10 was a Sunday, in the ISO week starting Monday 2024-03-04.
+    const int sunday = daysFromCivil({2024, 3, 10});
+    ASSERT_EQ(isoWeekday(sunday), 7);
+    ASSERT_EQ(toDateString(weekStart(sunday)), "2024-03-04");
+
+    ASSERT_EQ(monthIndex(*parseYearMonth("2024-03")), 54 * 12 + 2);
+    ASSERT_TRUE(monthFromIndex(monthIndex({2024, 3, 17})) == (CivilDate{2024, 3, 1}));
+    ASSERT_TRUE(monthFromIndex(-1) == (CivilDate{1969, 12, 1}));
+    ASSERT_FALSE(parseYearMonth("2024-13").has_value());
+}
+
+// The validators are constexpr, so the formats are pinned at compile time too.
+static_assert(isValidPhone("5195551234") && !isValidPhone("519-555-1234"));
+static_assert(isValidLicence("ON-12345678") && !isValidLicence("ON-1234567X"));
+static_assert(isValidVin("1M8GDM9AXKP042788") && !isValidVin("1M8GDM9A1KP042788"));
+
+TEST(UtilsTests, ValidatorsMatchTheFormerPatterns) {
+    ASSERT_TRUE(isValidPhone("0000000000"));
+    ASSERT_FALSE(isValidPhone("519555123"));
+    ASSERT_FALSE(isValidPhone("51955512345"));
+
+    ASSERT_FALSE(isValidLicence("on-12345678"));
+    ASSERT_FALSE(isValidLicence("ON-123456789"));
+
+    ASSERT_TRUE(isValidEmail("a@b.c"));
+    ASSERT_TRUE(isValidEmail("first.last@mail.example.com"));
+    ASSERT_TRUE(isValidEmail("a@b.c."));
+    ASSERT_FALSE(isValidEmail("a@.c"));
+    ASSERT_FALSE(isValidEmail("a@b."));
+    ASSERT_FALSE(isValidEmail("@b.c"));
+    ASSERT_FALSE(isValidEmail("a@b@c.d"));
+    ASSERT_FALSE(isValidEmail("a b@c.d"));
+    ASSERT_FALSE(isValidEmail("ab.c"));
+}
+
+TEST(UtilsTests, VinCheckDigit) {
+    ASSERT_TRUE(isValidVin("11111111111111111"));
+    ASSERT_TRUE(isValidVin("1HGCM82633A004352"));
+    ASSERT_FALSE(isValidVin("1HGCM82643A004352"));   // wrong check digit
+    ASSERT_FALSE(isValidVin("1HGCM82633A00435"));    // 16 characters
+    ASSERT_FALSE(isValidVin("1HGCM82633A00I352"));   // I is not a VIN character
+
+    // Seed data uses zero-padded counters: right shape, no check digit.
+    ASSERT_TRUE(isVinFormat("00000000000000001"));
+    ASSERT_FALSE(isValidVin("00000000000000001"));
+    ASSERT_FALSE(isVinFormat("1hgcm82633a004352"));
+}
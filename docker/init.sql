@@ -4,6 +4,19 @@
 CREATE EXTENSION IF NOT EXISTS "uuid-ossp";
 CREATE EXTENSION IF NOT EXISTS "pgcrypto";
 
+-- Time-ordered UUIDv7 (RFC 9562): 48-bit Unix milliseconds in front of a
+-- random v4 body, with the version nibble switched from 4 to 7. The backend
+-- generates its own IDs; this default covers inserts made directly in SQL.
+CREATE OR REPLACE FUNCTION uuid_generate_v7() RETURNS uuid AS $$
+    SELECT encode(
+        set_bit(set_bit(
+            overlay(uuid_send(gen_random_uuid())
+                    PLACING substring(int8send(floor(extract(epoch FROM clock_timestamp()) * 1000)::bigint) FROM 3)
+                    FROM 1 FOR 6),
+            52, 1), 53, 1),
+        'hex')::uuid;
+$$ LANGUAGE sql VOLATILE;
+
 -- =========================================================
 -- ENUM TYPES
 -- =========================================================
@@ -15,7 +28,7 @@ CREATE TYPE status_enum AS ENUM ('Available', 'Sold');
 -- TABLES
 -- =========================================================
 CREATE TABLE Vehicles (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     vin VARCHAR(17) NOT NULL UNIQUE,
     make VARCHAR(50) NOT NULL,
     model VARCHAR(50) NOT NULL,
@@ -25,41 +38,94 @@ CREATE TABLE Vehicles (
     transmission transmission_enum NOT NULL,
     trim VARCHAR(50),
     market_price NUMERIC(10,2) NOT NULL,
-    status status_enum NOT NULL DEFAULT 'Available'
+    status status_enum NOT NULL DEFAULT 'Available',
+    version INTEGER NOT NULL DEFAULT 1,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now()
 );
 
 CREATE TABLE Customers (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     first_name VARCHAR(50) NOT NULL,
     last_name VARCHAR(50) NOT NULL,
     address TEXT,
     ph_number VARCHAR(20) NOT NULL,
     email VARCHAR(100) NOT NULL UNIQUE,
-    driving_licence VARCHAR(50) NOT NULL UNIQUE
+    driving_licence VARCHAR(50) NOT NULL UNIQUE,
+    version INTEGER NOT NULL DEFAULT 1
 );
 
 CREATE TABLE Images (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     vehicle_id UUID NOT NULL REFERENCES Vehicles(id) ON DELETE CASCADE,
-    img_url TEXT NOT NULL
+    img_url TEXT NOT NULL,
+    width INTEGER,
+    height INTEGER,
+    variant_widths INTEGER[] NOT NULL DEFAULT '{}'
 );
 
 CREATE TABLE Sales (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     vehicle_id UUID NOT NULL REFERENCES Vehicles(id) UNIQUE,
     customer_id UUID NOT NULL REFERENCES Customers(id),
     date DATE NOT NULL,
-    sale_price NUMERIC(10,2) NOT NULL
+    sale_price NUMERIC(10,2) NOT NULL,
+    version INTEGER NOT NULL DEFAULT 1,
+    -- The vehicle as sold; rollups and reports read these, not Vehicles.
+    make VARCHAR(50) NOT NULL,
+    model VARCHAR(50) NOT NULL,
+    market_price NUMERIC(10,2) NOT NULL
 );
 
+-- Fills the vehicle snapshot for inserts that leave it out (seeds, ad-hoc SQL).
+CREATE OR REPLACE FUNCTION sales_snapshot_vehicle() RETURNS trigger AS $$
+BEGIN
+    IF NEW.make IS NULL OR NEW.model IS NULL OR NEW.market_price IS NULL THEN
+        SELECT COALESCE(NEW.make, v.make), COALESCE(NEW.model, v.model),
+               COALESCE(NEW.market_price, v.market_price)
+        INTO NEW.make, NEW.model, NEW.market_price
+        FROM Vehicles v WHERE v.id = NEW.vehicle_id;
+    END IF;
+    RETURN NEW;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER sales_snapshot_vehicle BEFORE INSERT ON Sales
+    FOR EACH ROW EXECUTE FUNCTION sales_snapshot_vehicle();
+
 CREATE TABLE Test_Drive_Record (
-    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v7(),
     vehicle_id UUID NOT NULL REFERENCES Vehicles(id),
     customer_id UUID NOT NULL REFERENCES Customers(id),
     date DATE NOT NULL,
     comments TEXT
 );
 
+CREATE TABLE Sales_Daily_Rollup (
+    day DATE NOT NULL,
+    make VARCHAR(50) NOT NULL,
+    model VARCHAR(50) NOT NULL,
+    sales_count INTEGER NOT NULL,
+    revenue NUMERIC(14,2) NOT NULL,
+    market_value NUMERIC(14,2) NOT NULL,
+    profit NUMERIC(14,2) NOT NULL,
+    min_sale_price NUMERIC(10,2) NOT NULL,
+    max_sale_price NUMERIC(10,2) NOT NULL,
+    PRIMARY KEY (day, make, model)
+);
+
+CREATE TABLE Idempotency_Keys (
+    scope VARCHAR(32) NOT NULL,
+    key VARCHAR(255) NOT NULL,
+    request_hash VARCHAR(20) NOT NULL,
+    status_code INTEGER,
+    response_body TEXT,
+    content_type VARCHAR(100),
+    response_headers TEXT,
+    created_at TIMESTAMPTZ NOT NULL DEFAULT now(),
+    expires_at TIMESTAMPTZ NOT NULL,
+    PRIMARY KEY (scope, key)
+);
+
 -- =========================================================
 -- INDEXES
 -- =========================================================
@@ -67,16 +133,21 @@ CREATE INDEX idx_vehicles_status ON vehicles(status);
 CREATE INDEX idx_vehicles_make ON vehicles(make);
 CREATE INDEX idx_vehicles_year ON vehicles(year);
 CREATE INDEX idx_vehicles_make_model ON vehicles(make, model);
-CREATE INDEX idx_sales_customer_id ON sales(customer_id);
-CREATE INDEX idx_sales_date ON sales(date);
+CREATE INDEX idx_sales_vehicle_date_id ON sales(vehicle_id, date DESC, id DESC);
+CREATE INDEX idx_sales_customer_date_id ON sales(customer_id, date DESC, id DESC);
+CREATE INDEX idx_sales_date_id ON sales(date DESC, id DESC);
 CREATE INDEX idx_images_vehicle_id ON images(vehicle_id);
 CREATE INDEX idx_test_drive_vehicle_id ON test_drive_record(vehicle_id);
 CREATE INDEX idx_test_drive_customer_id ON test_drive_record(customer_id);
+CREATE INDEX idx_customers_name_id ON customers(first_name, last_name, id);
+CREATE INDEX idx_idempotency_keys_expires ON idempotency_keys(expires_at);
 
 -- =========================================================
 -- CLEAN EXISTING DATA (SAFE)
 -- =========================================================
 TRUNCATE TABLE
+    Idempotency_Keys,
+    Sales_Daily_Rollup,
     Test_Drive_Record,
     Sales,
     Images,
@@ -149,6 +220,16 @@ FROM sold_vehicles sv
 JOIN random_customers rc ON sv.rn = rc.rn
 LIMIT 2000;
 
+-- =========================================================
+-- SALES ROLLUPS (same query as sql/tools/backfill_sales_rollup.sql)
+-- =========================================================
+INSERT INTO Sales_Daily_Rollup
+    (day, make, model, sales_count, revenue, market_value, profit, min_sale_price, max_sale_price)
+SELECT s.date, s.make, s.model, COUNT(*), SUM(s.sale_price), SUM(s.market_price),
+       SUM(s.sale_price - s.market_price), MIN(s.sale_price), MAX(s.sale_price)
+FROM Sales s
+GROUP BY s.date, s.make, s.model;
+
 -- =========================================================
 -- SEED TEST DRIVES (5000)
 -- =========================================================
@@ -212,6 +293,10 @@ INSERT INTO Images (vehicle_id, img_url)
             'https://images.unsplash.com/photo-1605559424843-9e4c228bf1c2?w=800'
         ] AS image_urls) urls;
 
+-- Refresh planner statistics so row estimates (X-Estimated-Total-Count)
+-- are available before autovacuum first runs.
+ANALYZE;
+
 -- =========================================================
 -- SUMMARY
 -- =========================================================
@@ -1,5 +1,5 @@
 import { useState } from "react";
-import { imageService, type VehicleImage } from "../services/imageService";
+import { imageService, IMAGE_WIDTHS, type VehicleImage } from "../services/imageService";
 import "./ImageManager.css";
 
 interface Props {
@@ -13,16 +13,16 @@ const ImageManager = ({ vehicleId, images, onImagesUpdated, onClose }: Props) =>
   const [uploading, setUploading] = useState(false);
 
   const handleUpload = async (e: React.ChangeEvent<HTMLInputElement>) => {
-    const file = e.target.files?.[0];
-    if (!file) return;
+    const files = Array.from(e.target.files ?? []);
+    if (files.length === 0) return;
 
     try {
       setUploading(true);
-      await imageService.upload(vehicleId, file);
+      await imageService.upload(vehicleId, files);
       onImagesUpdated(); // Refresh parent component
     } catch (error) {
       console.error("Upload failed:", error);
-      alert("Failed to upload image");
+      alert("Failed to upload images");
     } finally {
       setUploading(false);
     }
@@ -52,12 +52,13 @@ const ImageManager = ({ vehicleId, images, onImagesUpdated, onClose }: Props) =>
           {/* Upload Section */}
           <div className="uploadSection">
             <label htmlFor="imageUpload" className="uploadButton">
-              {uploading ? "Uploading..." : "Upload New Image"}
+              {uploading ? "Uploading..." : "Upload New Images"}
             </label>
             <input
               id="imageUpload"
               type="file"
               accept="image/*"
+              multiple
               onChange={handleUpload}
               disabled={uploading}
               style={{ display: "none" }}
@@ -72,7 +73,7 @@ const ImageManager = ({ vehicleId, images, onImagesUpdated, onClose }: Props) =>
               images.map((img) => (
                 <div key={img.id} className="imageItem">
                   <img
-                    src={imageService.getUrl(img.img_url)}
+                    src={imageService.getUrl(img.img_url, IMAGE_WIDTHS.card)}
                     alt="Vehicle"
                   />
                   <button
@@ -1,6 +1,6 @@
 import { useNavigate } from "react-router-dom";
 import type { Vehicle } from "../types/vehicle";
-import { imageService } from "../services/imageService";
+import { imageService, IMAGE_WIDTHS } from "../services/imageService";
 import "./VehicleInfoCard.css";
 
 interface Props {
@@ -11,7 +11,7 @@ const VehicleInfoCard = ({ vehicle }: Props) => {
   const navigate = useNavigate();
   
   const thumbnailUrl = vehicle.first_image 
-    ? imageService.getUrl(vehicle.first_image)
+    ? imageService.getUrl(vehicle.first_image, IMAGE_WIDTHS.card)
     : "";
 
   return (
@@ -1,6 +1,6 @@
 import { useState, useEffect } from "react";
 import type { Vehicle } from "../types/vehicle";
-import { imageService, type VehicleImage } from "../services/imageService";
+import { imageService, IMAGE_WIDTHS, type VehicleImage } from "../services/imageService";
 import ImageManager from "./ImageManager";
 import "./VehicleViewInfo.css";
 
@@ -21,7 +21,7 @@ const VehicleViewInfo = ({ vehicle }: Props) => {
       setImages(vehicleImages);
       
       if (vehicleImages.length > 0) {
-        setSelectedImage(imageService.getUrl(vehicleImages[0].img_url));
+        setSelectedImage(imageService.getUrl(vehicleImages[0].img_url, IMAGE_WIDTHS.gallery));
       } else {
         setSelectedImage("");
       }
@@ -61,11 +61,11 @@ const VehicleViewInfo = ({ vehicle }: Props) => {
             {images.slice(0, 4).map((img) => (
               <div 
                 key={img.id} 
-                className={`thumb ${selectedImage === imageService.getUrl(img.img_url) ? 'active' : ''}`}
-                onClick={() => setSelectedImage(imageService.getUrl(img.img_url))}
+                className={`thumb ${selectedImage === imageService.getUrl(img.img_url, IMAGE_WIDTHS.gallery) ? 'active' : ''}`}
+                onClick={() => setSelectedImage(imageService.getUrl(img.img_url, IMAGE_WIDTHS.gallery))}
               >
                 <img 
-                  src={imageService.getUrl(img.img_url)} 
+                  src={imageService.getUrl(img.img_url, IMAGE_WIDTHS.card)} 
                   alt="thumbnail"
                   style={{ width: '100%', height: '100%', objectFit: 'cover', cursor: 'pointer' }}
                 />
@@ -3,7 +3,7 @@
 import React, { useEffect, useState } from "react";
 import { useNavigate, useParams } from "react-router-dom";
 import { customerService } from "../../services/customerService";
-import type { Customer } from "../../types/customer";
+import type { CustomerOverview } from "../../types/customer";
 import "./CustomersPage.css";
 
 // The component fetches the customer details using the ID from the URL params and displays them.
@@ -12,8 +12,8 @@ export default function CustomerDetailsPage() {
   const { id } = useParams<{ id: string }>();
   const navigate = useNavigate();
 
-  // State to hold the customer details, loading status, and any error message.
-  const [customer, setCustomer] = useState<Customer | null>(null);
+  // State to hold the customer overview, loading status, and any error message.
+  const [overview, setOverview] = useState<CustomerOverview | null>(null);
   const [loading, setLoading] = useState(true);
   const [error, setError] = useState<string | null>(null);
 
@@ -24,10 +24,10 @@ export default function CustomerDetailsPage() {
     setLoading(true);
     setError(null);
 
-    // Fetch the customer details from the service using the ID.
+    // Fetch the customer, their purchases and test drives in one request.
     customerService
-      .getById(id)
-      .then((data) => setCustomer(data))
+      .getOverview(id)
+      .then((data) => setOverview(data))
       .catch(() => setError("Failed to load customer details."))
       .finally(() => setLoading(false));
   }, [id]);
@@ -44,7 +44,7 @@ export default function CustomerDetailsPage() {
   }
 
   // If there was an error fetching the customer details or if the customer was not found, show an error message and a back button.
-  if (error || !customer) {
+  if (error || !overview) {
     return (
       <div className="custDetailsPage">
         <h2>{error ?? "Customer not found."}</h2>
@@ -55,6 +55,8 @@ export default function CustomerDetailsPage() {
     );
   }
 
+  const { customer, sales, test_drives: testDrives, stats } = overview;
+
   return (
     <div className="custDetailsPage">
       <div className="custDetailsHeader">
@@ -81,6 +83,70 @@ export default function CustomerDetailsPage() {
           <Detail label="Address" value={customer.address ? customer.address : "—"} />
         </div>
       </div>
+
+      <div className="custDetailsCard">
+        <div className="custDetailsGrid">
+          <Detail label="Lifetime value" value={`$${Number(stats.lifetime_value).toLocaleString()}`} />
+          <Detail label="Purchases" value={String(stats.purchase_count)} />
+          <Detail label="Test drives" value={String(stats.test_drive_count)} />
+          <Detail label="Last activity" value={stats.last_activity ?? "—"} />
+          <Detail label="Next test drive" value={stats.next_test_drive ?? "—"} />
+        </div>
+      </div>
+
+      <div className="custDetailsCard">
+        <h2 className="custDetailsSection">Purchases</h2>
+        {sales.length === 0 ? (
+          <p>No purchases yet.</p>
+        ) : (
+          <table className="custTable custDetailsTable">
+            <thead className="custTableHead">
+              <tr>
+                <th>Date</th>
+                <th>Vehicle</th>
+                <th>VIN</th>
+                <th>Price</th>
+              </tr>
+            </thead>
+            <tbody>
+              {sales.map((s) => (
+                <tr key={s.sale_id}>
+                  <td>{s.date}</td>
+                  <td>{s.year} {s.vehicle}</td>
+                  <td>{s.vin}</td>
+                  <td>${Number(s.price).toLocaleString()}</td>
+                </tr>
+              ))}
+            </tbody>
+          </table>
+        )}
+      </div>
+
+      <div className="custDetailsCard">
+        <h2 className="custDetailsSection">Test drives</h2>
+        {testDrives.length === 0 ? (
+          <p>No test drives yet.</p>
+        ) : (
+          <table className="custTable custDetailsTable">
+            <thead className="custTableHead">
+              <tr>
+                <th>Date</th>
+                <th>Vehicle</th>
+                <th>Comment</th>
+              </tr>
+            </thead>
+            <tbody>
+              {testDrives.map((t) => (
+                <tr key={t.id}>
+                  <td>{t.date}</td>
+                  <td>{t.year} {t.vehicle}</td>
+                  <td>{t.comment || "—"}</td>
+                </tr>
+              ))}
+            </tbody>
+          </table>
+        )}
+      </div>
     </div>
   );
 }
@@ -14,21 +14,41 @@ export default function CustomersPage() {
   const [customers, setCustomers] = useState<Customer[]>([]);
   const [loading, setLoading] = useState(true);
   const [error, setError] = useState<string | null>(null);
+  const [nextCursor, setNextCursor] = useState<string | null>(null);
+  const [total, setTotal] = useState<number | null>(null);
+  const [loadingMore, setLoadingMore] = useState(false);
   const navigate = useNavigate();
 
-  // Fetch customers on component mount
+  // Fetch the first page on component mount
   useEffect(() => {
     setLoading(true);
     setError(null);
 
-    // Fetch all customers from the backend
     customerService
-      .getAll()
-      .then((data) => setCustomers(data))
+      .getPage()
+      .then((page) => {
+        setCustomers(page.items);
+        setNextCursor(page.nextCursor);
+        setTotal(page.total);
+      })
       .catch(() => setError("Failed to load customers."))
       .finally(() => setLoading(false));
   }, []);
 
+  // Append the next page after the last row shown
+  const loadMore = () => {
+    if (!nextCursor) return;
+    setLoadingMore(true);
+    customerService
+      .getPage({ cursor: nextCursor })
+      .then((page) => {
+        setCustomers((prev) => [...prev, ...page.items]);
+        setNextCursor(page.nextCursor);
+      })
+      .catch(() => setError("Failed to load customers."))
+      .finally(() => setLoadingMore(false));
+  };
+
   return (
     <div className="custPage">
       <div className="custHeaderRow">
@@ -71,6 +91,19 @@ export default function CustomersPage() {
               ))}
             </tbody>
           </table>
+
+          {nextCursor && (
+            <div className="custMore">
+              <button className="custBtnSecondary" onClick={loadMore} disabled={loadingMore}>
+                {loadingMore ? "Loading..." : "Load more"}
+              </button>
+              {total !== null && (
+                <span className="custCount">
+                  Showing {customers.length} of about {total}
+                </span>
+              )}
+            </div>
+          )}
         </div>
       )}
     </div>
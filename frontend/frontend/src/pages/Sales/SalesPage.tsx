@@ -46,7 +46,10 @@ const buildTableCsv = (rows: SaleSummary[]) => {
 const SalesPage = () => {
   const navigate = useNavigate();
   const [sales, setSales] = useState<SaleSummary[]>([]);
+  const [nextCursor, setNextCursor] = useState<string | null>(null);
+  const [total, setTotal] = useState<number | null>(null);
   const [loading, setLoading] = useState(true);
+  const [loadingMore, setLoadingMore] = useState(false);
   const [error, setError] = useState<string | null>(null);
 
   // Weekly report UI
@@ -58,16 +61,33 @@ const SalesPage = () => {
     setLoading(true);
     setError(null);
     try {
-      const data = await salesService.getAll();
-      setSales(Array.isArray(data) ? data : []);
+      const page = await salesService.getPage({ count: "estimate" });
+      setSales(Array.isArray(page.items) ? page.items : []);
+      setNextCursor(page.nextCursor);
+      setTotal(page.total);
     } catch (e: any) {
       setError(e?.response?.data?.error || "Failed to load sales");
       setSales([]);
+      setNextCursor(null);
     } finally {
       setLoading(false);
     }
   };
 
+  const loadMore = async () => {
+    if (!nextCursor) return;
+    setLoadingMore(true);
+    try {
+      const page = await salesService.getPage({ cursor: nextCursor });
+      setSales((prev) => [...prev, ...page.items]);
+      setNextCursor(page.nextCursor);
+    } catch (e: any) {
+      alert(e?.response?.data?.error || "Failed to load more sales");
+    } finally {
+      setLoadingMore(false);
+    }
+  };
+
   useEffect(() => {
     fetchSales();
   }, []);
@@ -185,6 +205,19 @@ const SalesPage = () => {
               )}
             </tbody>
           </table>
+
+          {nextCursor && (
+            <div className="salesMore">
+              <button className="salesBtn" onClick={loadMore} disabled={loadingMore}>
+                {loadingMore ? "Loading..." : "Load more"}
+              </button>
+              {total !== null && (
+                <span className="salesCount">
+                  Showing {rows.length} of about {total}
+                </span>
+              )}
+            </div>
+          )}
         </div>
       )}
     </div>
@@ -1,13 +1,45 @@
 // This service module provides functions to interact with the backend API for customer-related operations.
 import api from "./api";
-import type { Customer, CustomerCreate, CustomerUpdate } from "../types/customer";
+import type {
+  Customer,
+  CustomerCreate,
+  CustomerOverview,
+  CustomerPage,
+  CustomerPageParams,
+  CustomerSearchHit,
+  CustomerUpdate,
+} from "../types/customer";
 
 export const customerService = {
-  // Fetches all customers from the backend.
-  // GET /customers
+  // Fetches one page of customers, ordered by first then last name.
+  // GET /customers?limit=&cursor=
+  getPage: async (params: CustomerPageParams = {}): Promise<CustomerPage> => {
+    const res = await api.get<Customer[]>("/customers", { params });
+    const total = res.headers["x-estimated-total-count"];
+    return {
+      items: res.data,
+      nextCursor: res.headers["x-next-cursor"] ?? null,
+      total: total !== undefined ? Number(total) : null,
+    };
+  },
+
+  // Fetches all customers by walking every page (for pickers that need the full list).
   getAll: async (): Promise<Customer[]> => {
-    const res = await api.get<Customer[]>("/customers");
-    // We return only the data, not the full axios response object.
+    const all: Customer[] = [];
+    let cursor: string | undefined;
+    do {
+      const page = await customerService.getPage({ limit: 500, cursor });
+      all.push(...page.items);
+      cursor = page.nextCursor ?? undefined;
+    } while (cursor);
+    return all;
+  },
+
+  // Looks customers up by name, email, phone or licence prefix, with fuzzy
+  // name matches after the prefix ones.
+  // GET /customers/search?q=&limit=
+  search: async (q: string, limit = 20): Promise<CustomerSearchHit[]> => {
+    const res = await api.get<CustomerSearchHit[]>("/customers/search", { params: { q, limit } });
     return res.data;
   },
 
@@ -18,6 +50,13 @@ export const customerService = {
     return res.data;
   },
 
+  // Fetches a customer with their purchases, test drives and lifetime stats.
+  // GET /customers/:id/overview
+  getOverview: async (id: string): Promise<CustomerOverview> => {
+    const res = await api.get<CustomerOverview>(`/customers/${id}/overview`);
+    return res.data;
+  },
+
   // Creates a new customer.
   // POST /customers
   // The backend generates the id and returns the full created object.
@@ -4,8 +4,16 @@ export interface VehicleImage {
   id: string;
   vehicle_id: string;
   img_url: string;
+  // Original size in pixels; null until the backend has processed the upload.
+  width: number | null;
+  height: number | null;
+  // Widths of the resized copies the backend generated (e.g. [320, 960]).
+  variant_widths: number[];
 }
 
+// Sizes the backend generates for uploads: cards, the detail gallery, full view.
+export const IMAGE_WIDTHS = { card: 320, gallery: 960, full: 1920 } as const;
+
 export const imageService = {
   // Get all images for a vehicle
   getByVehicle: async (vehicleId: string): Promise<VehicleImage[]> => {
@@ -13,10 +21,10 @@ export const imageService = {
     return res.data;
   },
 
-  // Upload image for a vehicle
-  upload: async (vehicleId: string, file: File) => {
+  // Upload one or more images for a vehicle in a single request
+  upload: async (vehicleId: string, files: File[]) => {
     const formData = new FormData();
-    formData.append("file", file);
+    files.forEach((file) => formData.append("file", file));
     
     const res = await api.post(`/vehicles/${vehicleId}/images`, formData, {
       headers: { "Content-Type": "multipart/form-data" }
@@ -29,13 +37,15 @@ export const imageService = {
     await api.delete(`/images/${imageId}`);
   },
 
-  // Get full image URL
-  getUrl: (imgUrl: string): string => {
+  // Get full image URL. With a width, local uploads are served as the
+  // smallest resized copy at least that wide (or the original).
+  getUrl: (imgUrl: string, width?: number): string => {
     // If it's an external URL (Unsplash), return as-is
     if (imgUrl.startsWith('http')) {
       return imgUrl;
     }
     // If it's a local upload, use the API endpoint
-    return `/api${imgUrl}`;  // Goes through Vite proxy
+    const url = `/api${imgUrl}`;  // Goes through Vite proxy
+    return width ? `${url}?w=${width}` : url;
   }
 };
\ No newline at end of file
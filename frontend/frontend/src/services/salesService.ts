@@ -45,16 +45,23 @@
 import api from "./api";
 import type {
   SaleSummary,
+  SalesPage,
+  SalesPageParams,
   SaleCreatePayload,
   SaleCreateResponse,
   SaleUpdatePayload,
 } from "../types/sales";
 
 export const salesService = {
-  // For the table
-  getAll: async (): Promise<SaleSummary[]> => {
-    const res = await api.get<SaleSummary[]>("/sales");
-    return res.data;
+  // For the table: one page, newest first. Pass nextCursor back for the next one.
+  getPage: async (params: SalesPageParams = {}): Promise<SalesPage> => {
+    const res = await api.get<SaleSummary[]>("/sales", { params });
+    const total = res.headers["x-total-count"] ?? res.headers["x-estimated-total-count"];
+    return {
+      items: res.data,
+      nextCursor: res.headers["x-next-cursor"] ?? null,
+      total: total !== undefined ? Number(total) : null,
+    };
   },
 
   // Create sale (for your Add Sale page later)
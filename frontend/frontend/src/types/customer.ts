@@ -17,4 +17,58 @@ export type CustomerCreate = Omit<Customer, "id">;
 
 // Body for PATCH /customers/:id
 // All fields are optional since it's a partial update.
-export type CustomerUpdate = Partial<CustomerCreate>;
\ No newline at end of file
+export type CustomerUpdate = Partial<CustomerCreate>;
+
+// Query for GET /customers (one keyset page).
+export interface CustomerPageParams {
+  limit?: number;   // default 50, max 500
+  cursor?: string;  // nextCursor of the previous page
+}
+
+export interface CustomerPage {
+  items: Customer[];
+  nextCursor: string | null;  // null on the last page
+  total: number | null;       // approximate row count, when the server knows it
+}
+
+// One result of GET /customers/search.
+export type CustomerSearchHit = Customer & {
+  match: "prefix" | "fuzzy";
+  score: number;  // 1 for prefix matches, trigram similarity for fuzzy ones
+};
+
+// GET /customers/:id/overview
+export interface CustomerOverviewSale {
+  sale_id: string;
+  date: string;
+  price: number;
+  vehicle_id: string;
+  vin: string;
+  vehicle: string;  // "Make Model"
+  year: number;
+}
+
+export interface CustomerOverviewTestDrive {
+  id: string;
+  date: string;
+  comment: string | null;
+  vehicle_id: string;
+  vehicle: string;  // "Make Model"
+  year: number;
+}
+
+export interface CustomerOverview {
+  customer: Customer & { version: number };
+  sales: CustomerOverviewSale[];          // newest first
+  test_drives: CustomerOverviewTestDrive[]; // newest first
+  stats: {
+    purchase_count: number;
+    lifetime_value: number;
+    first_purchase: string | null;
+    last_purchase: string | null;
+    test_drive_count: number;
+    last_test_drive: string | null;
+    next_test_drive: string | null;
+    last_activity: string | null;
+  };
+}
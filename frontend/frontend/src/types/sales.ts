@@ -6,6 +6,23 @@ export interface SaleSummary {
   customer: string;  // "First Last"
 }
 
+export interface SalesPageParams {
+  from?: string;       // YYYY-MM-DD
+  to?: string;         // YYYY-MM-DD
+  make?: string;
+  min_price?: number;
+  max_price?: number;
+  limit?: number;      // default 50, max 500
+  cursor?: string;     // nextCursor of the previous page
+  count?: "estimate" | "exact";
+}
+
+export interface SalesPage {
+  items: SaleSummary[];
+  nextCursor: string | null;  // null on the last page
+  total: number | null;       // only when count was requested
+}
+
 export interface SaleCreatePayload {
   vehicle_id: string;
   customer_id: string;